@@ -17,6 +17,10 @@ set(eoserv_UNITY_SOURCE_FILES
 set(eoserv_ALL_SOURCE_FILES
 	src/arena.cpp
 	src/arena.hpp
+	src/ban_index.cpp
+	src/ban_index.hpp
+	src/capture.cpp
+	src/capture.hpp
 	src/character.cpp
 	src/character.hpp
 	src/command_source.cpp
@@ -38,15 +42,22 @@ set(eoserv_ALL_SOURCE_FILES
 	src/database.cpp
 	src/database.hpp
 	src/database_impl.hpp
+	src/database_pool.cpp
+	src/database_pool.hpp
+	src/database_stats.cpp
+	src/database_stats.hpp
 	src/dialog.cpp
 	src/dialog.hpp
 	src/eoclient.cpp
 	src/eoclient.hpp
 	src/eodata.cpp
 	src/eodata.hpp
+	src/eoplus/cache.cpp
+	src/eoplus/cache.hpp
 	src/eoplus/context.cpp
 	src/eoplus/context.hpp
 	src/eoplus.cpp
+	src/eoplus/fwd/cache.hpp
 	src/eoplus/fwd/context.hpp
 	src/eoplus/fwd/lex.hpp
 	src/eoplus/fwd/parse.hpp
@@ -57,11 +68,16 @@ set(eoserv_ALL_SOURCE_FILES
 	src/eoplus/parse.hpp
 	src/eoserv_config.cpp
 	src/eoserv_config.hpp
+	src/eoserv_config_keys.hpp
 	src/eoserver.cpp
 	src/eoserver.hpp
 	src/extra/seose_compat.cpp
 	src/extra/seose_compat.hpp
+	src/formula_vars.cpp
+	src/formula_vars.hpp
 	src/fwd/arena.hpp
+	src/fwd/ban_index.hpp
+	src/fwd/capture.hpp
 	src/fwd/character.hpp
 	src/fwd/command_source.hpp
 	src/fwd/config.hpp
@@ -72,20 +88,25 @@ set(eoserv_ALL_SOURCE_FILES
 	src/fwd/eodata.hpp
 	src/fwd/eoplus.hpp
 	src/fwd/eoserver.hpp
+	src/fwd/formula_vars.hpp
 	src/fwd/guild.hpp
 	src/fwd/hook.hpp
 	src/fwd/i18n.hpp
+	src/fwd/journal.hpp
 	src/fwd/map.hpp
+	src/fwd/metrics.hpp
 	src/fwd/nanohttp.hpp
 	src/fwd/npc.hpp
 	src/fwd/npc_data.hpp
 	src/fwd/packet.hpp
 	src/fwd/party.hpp
+	src/fwd/password_hasher.hpp
 	src/fwd/player.hpp
 	src/fwd/quest.hpp
 	src/fwd/sln.hpp
 	src/fwd/socket.hpp
 	src/fwd/timer.hpp
+	src/fwd/watchdog.hpp
 	src/fwd/wedding.hpp
 	src/fwd/world.hpp
 	src/guild.cpp
@@ -136,9 +157,13 @@ set(eoserv_ALL_SOURCE_FILES
 	src/hash.hpp
 	src/i18n.cpp
 	src/i18n.hpp
+	src/journal.cpp
+	src/journal.hpp
 	src/main.cpp
 	src/map.cpp
 	src/map.hpp
+	src/metrics.cpp
+	src/metrics.hpp
 	src/nanohttp.cpp
 	src/nanohttp.hpp
 	src/npc.cpp
@@ -149,6 +174,8 @@ set(eoserv_ALL_SOURCE_FILES
 	src/packet.hpp
 	src/party.cpp
 	src/party.hpp
+	src/password_hasher.cpp
+	src/password_hasher.hpp
 	src/platform.h
 	src/player.cpp
 	src/player.hpp
@@ -167,8 +194,12 @@ set(eoserv_ALL_SOURCE_FILES
 	src/socket_impl.hpp
 	src/timer.cpp
 	src/timer.hpp
+	src/trace.cpp
+	src/trace.hpp
 	src/util.cpp
 	src/util.hpp
+	src/util/histogram.cpp
+	src/util/histogram.hpp
 	src/util/rpn.cpp
 	src/util/rpn.hpp
 	src/util/rpn_lex.cpp
@@ -177,6 +208,8 @@ set(eoserv_ALL_SOURCE_FILES
 	src/util/variant.cpp
 	src/util/variant.hpp
 	src/version.h
+	src/watchdog.cpp
+	src/watchdog.hpp
 	src/wedding.cpp
 	src/wedding.hpp
 	src/world.cpp
@@ -189,6 +222,77 @@ set(eoserv_WIN32_SOURCE_FILES
 	src/extra/ntservice.hpp
 )
 
+set(eoserv_LOADGEN_SOURCE_FILES
+	src/capture.cpp
+	src/capture.hpp
+	src/console.cpp
+	src/console.hpp
+	src/loadgen/bot.cpp
+	src/loadgen/bot.hpp
+	src/loadgen/loadgen.cpp
+	src/loadgen/replay.cpp
+	src/loadgen/replay.hpp
+	src/packet.cpp
+	src/packet.hpp
+	src/platform.h
+	src/socket.cpp
+	src/socket.hpp
+	src/socket_impl.hpp
+	src/trace.cpp
+	src/trace.hpp
+	src/util.cpp
+	src/util.hpp
+	src/util/histogram.cpp
+	src/util/histogram.hpp
+	src/util/variant.cpp
+	src/util/variant.hpp
+)
+
+# Linked with every file in eoserv_ALL_SOURCE_FILES except src/main.cpp
+set(eoserv_BENCH_SOURCE_FILES
+	src/bench/bench.cpp
+	src/bench/bench.hpp
+	src/bench/database.cpp
+	src/bench/formula.cpp
+	src/bench/hash.cpp
+	src/bench/packet.cpp
+	src/bench/timer.cpp
+	src/bench/world.cpp
+)
+
+# Linked with every file in eoserv_ALL_SOURCE_FILES except src/main.cpp
+set(eoserv_SIM_SOURCE_FILES
+	src/sim/sim.cpp
+)
+
+# Linked with every file in eoserv_ALL_SOURCE_FILES except src/main.cpp
+set(eoserv_TEST_SOURCE_FILES
+	src/test/capture.cpp
+	src/test/database.cpp
+	src/test/formula.cpp
+	src/test/journal.cpp
+	src/test/quest.cpp
+	src/test/test.cpp
+	src/test/test.hpp
+)
+
+# Test cases in eoserv-test, each run by CTest on its own
+set(eoserv_TESTS
+	capture_scrub_resetpassword
+	database_pool_fanout
+	database_prepared_statements
+	database_result_empty
+	database_result_multi_row
+	database_result_single_row
+	formula_differential
+	formula_operators
+	formula_parser_version
+	journal_kill_replay
+	journal_torn_write
+	quest_cache_content_hash
+	quest_triggered_rules
+)
+
 # ----------
 
 set(ConfigFiles
@@ -251,6 +355,7 @@ set(ExtraFiles
 	install.sql
 	upgrade/0.5.2_to_0.5.3.sql
 	upgrade/0.6.2_to_0.7.0.sql
+	upgrade/0.7.0_to_0.7.1.sql
 
 	${ConfigFiles}
 	${LangFiles}
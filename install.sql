@@ -1,17 +1,17 @@
 
 CREATE TABLE IF NOT EXISTS `accounts`
 (
-	`username`   VARCHAR(16) NOT NULL,
-	`password`   CHAR(64)    NOT NULL,
-	`fullname`   VARCHAR(64) NOT NULL,
-	`location`   VARCHAR(64) NOT NULL,
-	`email`      VARCHAR(64) NOT NULL,
-	`computer`   VARCHAR(64) NOT NULL,
-	`hdid`       INTEGER     NOT NULL,
-	`regip`      VARCHAR(15) NOT NULL,
-	`lastip`     VARCHAR(15)          DEFAULT NULL,
-	`created`    INTEGER     NOT NULL,
-	`lastused`   INTEGER              DEFAULT NULL,
+	`username`   VARCHAR(16)  NOT NULL,
+	`password`   VARCHAR(128) NOT NULL,
+	`fullname`   VARCHAR(64)  NOT NULL,
+	`location`   VARCHAR(64)  NOT NULL,
+	`email`      VARCHAR(64)  NOT NULL,
+	`computer`   VARCHAR(64)  NOT NULL,
+	`hdid`       INTEGER      NOT NULL,
+	`regip`      VARCHAR(15)  NOT NULL,
+	`lastip`     VARCHAR(15)           DEFAULT NULL,
+	`created`    INTEGER      NOT NULL,
+	`lastused`   INTEGER               DEFAULT NULL,
 
 	PRIMARY KEY (`username`)
 );
@@ -81,11 +81,12 @@ CREATE TABLE IF NOT EXISTS `guilds`
 
 CREATE TABLE IF NOT EXISTS `bans`
 (
-	`ip`       INTEGER              DEFAULT NULL,
-	`hdid`     INTEGER              DEFAULT NULL,
-	`username` VARCHAR(16)          DEFAULT NULL,
-	`setter`   VARCHAR(16)          DEFAULT NULL,
-	`expires`  INTEGER     NOT NULL DEFAULT 0,
+	`ip`        INTEGER              DEFAULT NULL,
+	`ip_prefix` INTEGER              DEFAULT NULL,
+	`hdid`      INTEGER              DEFAULT NULL,
+	`username`  VARCHAR(16)          DEFAULT NULL,
+	`setter`    VARCHAR(16)          DEFAULT NULL,
+	`expires`   INTEGER     NOT NULL DEFAULT 0,
 
 	PRIMARY KEY (`ip`, `hdid`, `username`, `expires`)
 );
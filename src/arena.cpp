@@ -31,7 +31,7 @@ Arena::Arena(Map *map, int time, int block)
 	this->block = block;
 	this->occupants = 0;
 
-	this->spawn_timer = new TimeEvent(arena_spawn, this, time, Timer::FOREVER);
+	this->spawn_timer = new TimeEvent(arena_spawn, this, time, Timer::FOREVER, "arena_spawn");
 	this->map->world->timer.Register(this->spawn_timer);
 }
 
@@ -0,0 +1,234 @@
+/* ban_index.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "ban_index.hpp"
+
+#include "database.hpp"
+#include "socket.hpp"
+
+#include "util.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <utility>
+
+Ban_Index::Ban_Index()
+{
+	this->Clear();
+}
+
+int Ban_Index::Merge(int a, int b)
+{
+	if (a == 0 || b == 0)
+		return 0;
+
+	return std::max(a, b);
+}
+
+void Ban_Index::Load(Database &db)
+{
+	std::string query = "SELECT `username`, `ip`, COALESCE(`ip_prefix`, 32), `hdid`, `expires` FROM `bans` WHERE `expires` = 0 OR `expires` > " + util::to_string(int(std::time(0)));
+
+	Database_Cursor cursor = db.RawCursor(query.c_str());
+
+	// Built separately so a failure part way through keeps the bans already in place
+	Ban_Index index;
+
+	while (cursor.Next())
+	{
+		Database_Result::Row row = cursor.Row();
+
+		std::string username = row[0];
+		std::uint32_t ip = static_cast<unsigned int>(int(row[1]));
+		int prefix = row[2];
+		int hdid = row[3];
+		int expires = row[4];
+
+		if (!username.empty())
+			index.AddUsername(username, expires);
+
+		if (ip != 0 || prefix < 32)
+			index.AddIP(ip, prefix, expires);
+
+		if (hdid != 0)
+			index.AddHDID(hdid, expires);
+	}
+
+	*this = std::move(index);
+}
+
+void Ban_Index::Clear()
+{
+	this->usernames.clear();
+	this->hdids.clear();
+	this->ip_trie.assign(1, IP_Node());
+	this->ip_count = 0;
+}
+
+void Ban_Index::AddUsername(const std::string &username, int expires)
+{
+	auto result = this->usernames.insert({util::lowercase(username), expires});
+
+	if (!result.second)
+		result.first->second = Merge(result.first->second, expires);
+}
+
+void Ban_Index::AddHDID(int hdid, int expires)
+{
+	auto result = this->hdids.insert({hdid, expires});
+
+	if (!result.second)
+		result.first->second = Merge(result.first->second, expires);
+}
+
+void Ban_Index::AddIP(std::uint32_t address, int prefix, int expires)
+{
+	prefix = std::max(0, std::min(32, prefix));
+
+	int node = 0;
+
+	for (int i = 0; i < prefix; ++i)
+	{
+		int bit = (address >> (31 - i)) & 1;
+
+		if (this->ip_trie[node].child[bit] == -1)
+		{
+			this->ip_trie[node].child[bit] = int(this->ip_trie.size());
+			this->ip_trie.emplace_back();
+		}
+
+		node = this->ip_trie[node].child[bit];
+	}
+
+	IP_Node &n = this->ip_trie[node];
+
+	if (n.banned)
+	{
+		n.expires = Merge(n.expires, expires);
+	}
+	else
+	{
+		n.banned = true;
+		n.expires = expires;
+		++this->ip_count;
+	}
+}
+
+int Ban_Index::Check(const std::string *username, const IPAddress *address, const int *hdid, int now) const
+{
+	int result = -1;
+
+	auto consider = [&](int expires)
+	{
+		if (!Active(expires, now))
+			return;
+
+		result = (result == -1) ? expires : Merge(result, expires);
+	};
+
+	if (username && !this->usernames.empty())
+	{
+		auto it = this->usernames.find(util::lowercase(*username));
+
+		if (it != this->usernames.end())
+			consider(it->second);
+	}
+
+	if (address && this->ip_count > 0)
+	{
+		std::uint32_t ip = address->GetInt();
+		int node = 0;
+
+		for (int i = 0; node != -1; ++i)
+		{
+			const IP_Node &n = this->ip_trie[node];
+
+			if (n.banned)
+				consider(n.expires);
+
+			if (i == 32)
+				break;
+
+			node = n.child[(ip >> (31 - i)) & 1];
+		}
+	}
+
+	if (hdid && !this->hdids.empty())
+	{
+		auto it = this->hdids.find(*hdid);
+
+		if (it != this->hdids.end())
+			consider(it->second);
+	}
+
+	return result;
+}
+
+void Ban_Index::Expire(int now)
+{
+	for (auto it = this->usernames.begin(); it != this->usernames.end();)
+	{
+		if (!Active(it->second, now))
+			it = this->usernames.erase(it);
+		else
+			++it;
+	}
+
+	for (auto it = this->hdids.begin(); it != this->hdids.end();)
+	{
+		if (!Active(it->second, now))
+			it = this->hdids.erase(it);
+		else
+			++it;
+	}
+
+	for (IP_Node &n : this->ip_trie)
+	{
+		if (n.banned && !Active(n.expires, now))
+		{
+			n.banned = false;
+			--this->ip_count;
+		}
+	}
+
+	// Reclaim trie nodes once every range ban has gone
+	if (this->ip_count == 0 && this->ip_trie.size() > 1)
+		this->ip_trie.assign(1, IP_Node());
+}
+
+std::size_t Ban_Index::Size() const
+{
+	return this->usernames.size() + this->hdids.size() + this->ip_count;
+}
+
+bool Ban_Index::ParseRange(const std::string &str, std::uint32_t &address, int &prefix)
+{
+	unsigned int o1, o2, o3, o4;
+	int p = 32;
+	char c;
+	int n = std::sscanf(str.c_str(), "%u.%u.%u.%u/%d%c", &o1, &o2, &o3, &o4, &p, &c);
+
+	if (n != 4 && n != 5)
+		return false;
+
+	if (n == 4 && str.find_first_not_of("0123456789.") != std::string::npos)
+		return false;
+
+	if (o1 > 255 || o2 > 255 || o3 > 255 || o4 > 255 || p < 0 || p > 32)
+		return false;
+
+	address = o1 << 24 | o2 << 16 | o3 << 8 | o4;
+	prefix = p;
+
+	// Clear host bits so the range is stored in canonical form
+	if (prefix < 32)
+		address &= prefix == 0 ? 0 : ~((std::uint32_t(1) << (32 - prefix)) - 1);
+
+	return true;
+}
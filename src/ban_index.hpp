@@ -0,0 +1,89 @@
+/* ban_index.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef BAN_INDEX_HPP_INCLUDED
+#define BAN_INDEX_HPP_INCLUDED
+
+#include "fwd/ban_index.hpp"
+
+#include "fwd/database.hpp"
+#include "fwd/socket.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * In-memory copy of the bans table used to check bans without querying the database
+ * Expiry times follow the database convention: 0 is permanent, otherwise a UNIX timestamp.
+ */
+class Ban_Index
+{
+protected:
+	/**
+	 * Binary radix trie node keyed on IPv4 address bits, most significant first
+	 */
+	struct IP_Node
+	{
+		int child[2];
+		int expires;
+		bool banned;
+
+		IP_Node() : child{-1, -1}, expires(0), banned(false) {}
+	};
+
+	std::unordered_map<std::string, int> usernames;
+	std::unordered_map<int, int> hdids;
+	std::vector<IP_Node> ip_trie;
+	std::size_t ip_count;
+
+	/**
+	 * Combines two expiry times, keeping whichever lasts longer
+	 */
+	static int Merge(int a, int b);
+
+	static bool Active(int expires, int now) { return expires == 0 || expires > now; }
+
+public:
+	Ban_Index();
+
+	/**
+	 * Replaces the contents of the index with the active bans in the database, leaving it unchanged if they can't be read
+	 * @throw Database_Exception
+	 */
+	void Load(Database &db);
+
+	void Clear();
+
+	void AddUsername(const std::string &username, int expires);
+	void AddHDID(int hdid, int expires);
+
+	/**
+	 * Bans an address range (eg. prefix 24 for 192.168.0.0/24, 32 for a single address)
+	 */
+	void AddIP(std::uint32_t address, int prefix, int expires);
+
+	/**
+	 * Returns the expiry time of the longest matching active ban, or -1 if none match
+	 */
+	int Check(const std::string *username, const IPAddress *address, const int *hdid, int now) const;
+
+	/**
+	 * Removes bans which have expired
+	 */
+	void Expire(int now);
+
+	std::size_t Size() const;
+
+	/**
+	 * Parses an address with an optional prefix length (eg. 10.0.0.0/8)
+	 * Returns false if the string is not a valid IPv4 address or range
+	 */
+	static bool ParseRange(const std::string &str, std::uint32_t &address, int &prefix);
+};
+
+#endif // BAN_INDEX_HPP_INCLUDED
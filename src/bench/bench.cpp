@@ -0,0 +1,38 @@
+/* bench/bench.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "bench.hpp"
+
+#include "../version.h"
+
+#include <benchmark/benchmark.h>
+
+#include <csignal>
+
+// Normally defined in main.cpp, which isn't linked in to the benchmarks
+volatile std::sig_atomic_t eoserv_sig_abort = false;
+
+/**
+ * Runs the benchmarks, taking the usual Google Benchmark options
+ * Results can be saved for comparison between versions with --benchmark_out=<file> --benchmark_out_format=json.
+ */
+int main(int argc, char *argv[])
+{
+	benchmark::Initialize(&argc, argv);
+
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+		return 1;
+
+	bench_register_formulas("./data/formulas.ini");
+
+	benchmark::AddCustomContext("eoserv_version", EOSERV_VERSION_STRING);
+
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+
+	Bench_World::Cleanup();
+
+	return 0;
+}
@@ -0,0 +1,63 @@
+/* bench/bench.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef BENCH_BENCH_HPP_INCLUDED
+#define BENCH_BENCH_HPP_INCLUDED
+
+#include "../fwd/character.hpp"
+#include "../fwd/eoserver.hpp"
+#include "../fwd/map.hpp"
+#include "../fwd/world.hpp"
+
+#include <string>
+#include <vector>
+
+/**
+ * A server loaded from synthetic pub files, one crowded map and a scratch SQLite database written to the working directory
+ * It is built the first time a benchmark asks for it and shared by every benchmark after that, as loading it takes far
+ * longer than any single case. It is never destroyed, the process exits once the benchmarks are done.
+ * The data files shipped with the server (install.sql, lang, data) must be in the working directory.
+ */
+class Bench_World
+{
+protected:
+	Bench_World();
+
+	void WritePubFiles();
+	void WriteMap();
+
+public:
+	static const int map_size = 100;
+	static const int num_characters = 400;
+	static const int num_npcs = 100;
+
+	EOServer *server;
+	World *world;
+	Map *map;
+
+	/**
+	 * Online characters, spread over the map in a fixed pattern
+	 */
+	std::vector<Character *> characters;
+
+	static Bench_World &Get();
+
+	/**
+	 * Creates an account and character and logs it in to the map, like a client going through Login and Welcome
+	 */
+	Character *Login(const std::string &name, int x, int y);
+
+	/**
+	 * Removes the scratch files written by any of the benchmarks, called at exit whether or not the world was created
+	 */
+	static void Cleanup();
+};
+
+/**
+ * Registers one case per formula in a formulas.ini file, as their names are only known once it is read
+ */
+void bench_register_formulas(const std::string &filename);
+
+#endif // BENCH_BENCH_HPP_INCLUDED
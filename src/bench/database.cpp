@@ -0,0 +1,89 @@
+/* bench/database.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "../character.hpp"
+#include "../database.hpp"
+
+#include "../util.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <list>
+#include <string>
+
+#ifdef DATABASE_SQLITE
+
+/**
+ * Saves a batch of characters in one transaction, as a timed save does, to a fresh SQLite database
+ * tuned:0 leaves SQLite at its defaults, tuned:1 uses the settings recommended in config/database/sqlite.ini.
+ */
+static void bench_database_save(benchmark::State &state)
+{
+	const int batch = 200;
+	bool tuned = state.range(0);
+	std::string filename = "bench-save-" + util::to_string(int(tuned)) + ".sdb";
+
+	// Each run starts from an empty database, the function is run more than once to size the number of iterations
+	std::remove(filename.c_str());
+	std::remove((filename + "-shm").c_str());
+	std::remove((filename + "-wal").c_str());
+
+	Database db(Database::SQLite, filename, 0, "", "", "");
+
+	Database::SQLite_Options options;
+
+	if (tuned)
+	{
+		options.wal = true;
+		options.synchronous = "normal";
+		options.cache_size = 8192;
+		options.mmap_size = 65536;
+	}
+	else
+	{
+		options.prepared_statements = false;
+	}
+
+	db.SetSQLiteOptions(options);
+	db.ExecuteFile("./install.sql");
+
+	std::list<Character_Item> inventory;
+
+	for (int i = 0; i < 30; ++i)
+		inventory.emplace_back(short(i + 1), i * 100 + 1);
+
+	std::string items = ItemSerialize(inventory);
+
+	db.BeginTransaction();
+
+	for (int i = 0; i < batch; ++i)
+		db.Query("INSERT INTO `characters` (`name`, `account`) VALUES ('$', '$')", ("bench" + util::to_string(i)).c_str(), "bench");
+
+	db.Commit();
+
+	int x = 0;
+
+	for (auto _ : state)
+	{
+		db.BeginTransaction();
+
+		for (int i = 0; i < batch; ++i)
+		{
+			db.Query("UPDATE `characters` SET `map` = #, `x` = #, `y` = #, `direction` = #, `level` = #, `exp` = #, `hp` = #, `tp` = #, "
+			         "`inventory` = '$', `bank` = '$', `paperdoll` = '$', `spells` = '$', `quest` = '$' WHERE `name` = '$'",
+			         1, x % 100, i % 100, x % 4, 50, 1000000 + x, 400, 200,
+			         items.c_str(), items.c_str(), "0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,", "1,10;2,10;", "", ("bench" + util::to_string(i)).c_str());
+		}
+
+		db.Commit();
+		++x;
+	}
+
+	state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(bench_database_save)->Name("Database::Query/save_characters:200")->ArgName("tuned")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+#endif // DATABASE_SQLITE
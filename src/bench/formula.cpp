@@ -0,0 +1,93 @@
+/* bench/formula.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "bench.hpp"
+
+#include "../config.hpp"
+#include "../formula_vars.hpp"
+
+#include "../util.hpp"
+#include "../util/rpn.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <stack>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Stats of a mid-level character hitting another, the same every run so results can be compared
+ */
+static Formula_Frame bench_formula_frame()
+{
+	Formula_Frame frame;
+
+	for (int i = 0; i < FV_COUNT; ++i)
+	{
+		frame.Set(Formula_Frame::Self, Formula_Var(i), 10 + (i * 13) % 90);
+		frame.Set(Formula_Frame::Target, Formula_Var(i), 10 + (i * 17) % 90);
+	}
+
+	frame.Set(Formula_Frame::Self, FV_sitting, 0);
+	frame.Set(Formula_Frame::Target, FV_sitting, 0);
+	frame.Set(FE_modifier, 1.0);
+	frame.Set(FE_damage, 40.0);
+	frame.Set(FE_critical, 0.0);
+
+	return frame;
+}
+
+/**
+ * Evaluates by name from a parsed stack, as formulas were evaluated before they were compiled
+ */
+static void bench_formula_eval(benchmark::State &state, const std::stack<std::string> &stack)
+{
+	std::unordered_map<std::string, double> vars;
+	bench_formula_frame().Export(vars);
+
+	for (auto _ : state)
+		benchmark::DoNotOptimize(util::rpn_eval(stack, vars));
+}
+
+static void bench_formula_program(benchmark::State &state, const std::stack<std::string> &stack)
+{
+	util::rpn_program program(stack, Formula_Frame::Resolve);
+	Formula_Frame frame = bench_formula_frame();
+
+	for (auto _ : state)
+		benchmark::DoNotOptimize(program.eval(frame.data()));
+}
+
+void bench_register_formulas(const std::string &filename)
+{
+	Config formulas;
+
+	if (!formulas.Read(filename))
+		return;
+
+	Formula_Parser parser = formula_parser(formulas);
+
+	std::vector<std::string> names;
+
+	UTIL_FOREACH_CREF(formulas, formula)
+	{
+		if (formula.first != "Version")
+			names.push_back(formula.first);
+	}
+
+	// Registered in a fixed order so results line up between runs
+	std::sort(names.begin(), names.end());
+
+	UTIL_FOREACH_CREF(names, name)
+	{
+		std::stack<std::string> stack = parser(formulas[name]);
+
+		benchmark::RegisterBenchmark(("util::rpn_eval/" + name).c_str(), bench_formula_eval, stack);
+		benchmark::RegisterBenchmark(("util::rpn_program/" + name).c_str(), bench_formula_program, stack);
+	}
+}
@@ -0,0 +1,77 @@
+/* bench/hash.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "../hash.hpp"
+#include "../password_hasher.hpp"
+
+#include "../util/secure_string.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+static void bench_sha256(benchmark::State &state)
+{
+	std::string data(std::size_t(state.range(0)), 'x');
+
+	for (auto _ : state)
+		benchmark::DoNotOptimize(sha256(data));
+
+	state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bench_sha256)->Name("sha256")->ArgName("bytes")->Arg(64)->Arg(4096);
+
+static void bench_pbkdf2(benchmark::State &state)
+{
+	for (auto _ : state)
+		benchmark::DoNotOptimize(pbkdf2_sha256("password", "saltsaltsaltsalt", int(state.range(0)), 32));
+}
+BENCHMARK(bench_pbkdf2)->Name("pbkdf2_sha256")->ArgName("iterations")->Arg(1000)->Unit(benchmark::kMillisecond);
+
+static void bench_scrypt(benchmark::State &state)
+{
+	for (auto _ : state)
+		benchmark::DoNotOptimize(scrypt("password", "saltsaltsaltsalt", int(state.range(0)), 8, 1, 32));
+}
+BENCHMARK(bench_scrypt)->Name("scrypt")->ArgName("log2_n")->Arg(10)->Arg(14)->Unit(benchmark::kMillisecond);
+
+/**
+ * A burst of logins verified on the hashing pool, timed until the last callback runs
+ * scheme:0 is the legacy salted SHA-256, scheme:1 is scrypt at the default cost.
+ */
+static void bench_password_verify(benchmark::State &state)
+{
+	const int logins = 500;
+
+	Password_Hasher::Settings settings;
+	settings.salt = "bench";
+	settings.scheme = Password_Hasher::Scheme(state.range(0));
+
+	Password_Hasher hasher(int(state.range(1)));
+	hasher.SetSettings(settings);
+
+	std::string stored = Password_Hasher::HashPassword(settings, "bench", "password");
+
+	for (auto _ : state)
+	{
+		int completed = 0;
+
+		for (int i = 0; i < logins; ++i)
+		{
+			hasher.Verify(&hasher, "bench", util::secure_string(std::string("password")), stored, [&completed](bool, const std::string &)
+			{
+				++completed;
+			});
+		}
+
+		while (completed < logins)
+			hasher.Poll();
+	}
+
+	state.SetItemsProcessed(state.iterations() * logins);
+}
+BENCHMARK(bench_password_verify)->Name("Password_Hasher::Verify/logins:500")->ArgNames({"scheme", "threads"})
+	->Args({Password_Hasher::SHA256, 2})->Args({Password_Hasher::Scrypt, 2})->Args({Password_Hasher::Scrypt, 4})
+	->Unit(benchmark::kMillisecond)->UseRealTime();
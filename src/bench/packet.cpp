@@ -0,0 +1,163 @@
+/* bench/packet.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "../packet.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <random>
+#include <string>
+
+/**
+ * A packet as the server would send it, length and ID in front of random data
+ */
+static std::string bench_raw_packet(std::size_t size)
+{
+	std::mt19937 rng(1);
+	std::string data(size, '\0');
+
+	for (std::size_t i = 0; i < size; ++i)
+		data[i] = char(rng() % 253 + 1);
+
+	PacketBuilder builder(PACKET_WALK, PACKET_PLAYER, size);
+	builder.AddString(data);
+	return builder.Get();
+}
+
+static void bench_packet_encode(benchmark::State &state)
+{
+	PacketProcessor processor;
+	processor.SetEMulti(6, 10);
+	std::string raw = bench_raw_packet(std::size_t(state.range(0)));
+
+	for (auto _ : state)
+		benchmark::DoNotOptimize(processor.Encode(raw));
+
+	state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bench_packet_encode)->Name("PacketProcessor::Encode")->ArgName("bytes")->Arg(8)->Arg(64)->Arg(512)->Arg(4096);
+
+static void bench_packet_decode(benchmark::State &state)
+{
+	PacketProcessor processor;
+	processor.SetEMulti(10, 6);
+	std::string encoded = bench_raw_packet(std::size_t(state.range(0))).substr(2);
+
+	for (auto _ : state)
+		benchmark::DoNotOptimize(processor.Decode(encoded));
+
+	state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bench_packet_decode)->Name("PacketProcessor::Decode")->ArgName("bytes")->Arg(8)->Arg(64)->Arg(512)->Arg(4096);
+
+static void bench_packet_enumber(benchmark::State &state)
+{
+	unsigned int number = 0;
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(PacketProcessor::ENumber(number));
+		number = (number + 7919) % PacketProcessor::MAX3;
+	}
+}
+BENCHMARK(bench_packet_enumber)->Name("PacketProcessor::ENumber");
+
+static void bench_packet_number(benchmark::State &state)
+{
+	unsigned char b = 1;
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(PacketProcessor::Number(b, 254 - b, b, 254));
+		b = b % 253 + 1;
+	}
+}
+BENCHMARK(bench_packet_number)->Name("PacketProcessor::Number");
+
+static void bench_builder_walk(benchmark::State &state)
+{
+	for (auto _ : state)
+	{
+		PacketBuilder builder(PACKET_WALK, PACKET_PLAYER, 5);
+		builder.AddShort(1234);
+		builder.AddChar(2);
+		builder.AddChar(40);
+		builder.AddChar(41);
+		benchmark::DoNotOptimize(builder.Get());
+	}
+}
+BENCHMARK(bench_builder_walk)->Name("PacketBuilder/Walk_Player");
+
+static void bench_builder_talk(benchmark::State &state)
+{
+	const std::string message = "Does anyone want to trade a wolf tooth for some bread?";
+
+	for (auto _ : state)
+	{
+		PacketBuilder builder(PACKET_TALK, PACKET_PLAYER, 2 + message.length());
+		builder.AddShort(1234);
+		builder.AddString(message);
+		benchmark::DoNotOptimize(builder.Get());
+	}
+}
+BENCHMARK(bench_builder_talk)->Name("PacketBuilder/Talk_Player");
+
+/**
+ * The same layout as Character::Refresh, the largest packet sent regularly during play
+ */
+static void bench_builder_refresh(benchmark::State &state)
+{
+	const int characters = int(state.range(0));
+	const int npcs = characters / 2;
+
+	for (auto _ : state)
+	{
+		PacketBuilder builder(PACKET_REFRESH, PACKET_REPLY, 3 + characters * 60 + npcs * 6);
+		builder.AddChar(characters);
+		builder.AddByte(255);
+
+		for (int i = 0; i < characters; ++i)
+		{
+			builder.AddBreakString("character");
+			builder.AddShort(i + 1);
+			builder.AddShort(1);
+			builder.AddShort(i % 100);
+			builder.AddShort(i / 100);
+			builder.AddChar(i % 4);
+			builder.AddChar(6);
+			builder.AddString("   ");
+			builder.AddChar(50);
+			builder.AddChar(i % 2);
+			builder.AddChar(1);
+			builder.AddChar(1);
+			builder.AddChar(0);
+			builder.AddShort(500);
+			builder.AddShort(450);
+			builder.AddShort(200);
+			builder.AddShort(180);
+
+			for (int slot = 0; slot < 9; ++slot)
+				builder.AddShort(slot * 10);
+
+			builder.AddChar(0);
+			builder.AddChar(0);
+			builder.AddByte(255);
+		}
+
+		for (int i = 0; i < npcs; ++i)
+		{
+			builder.AddChar(i);
+			builder.AddShort(i % 20 + 1);
+			builder.AddChar(i % 100);
+			builder.AddChar(i / 100);
+			builder.AddChar(i % 4);
+		}
+
+		builder.AddByte(255);
+		benchmark::DoNotOptimize(builder.Get());
+	}
+}
+BENCHMARK(bench_builder_refresh)->Name("PacketBuilder/Refresh_Reply")->ArgName("characters")->Arg(10)->Arg(50)->Arg(200);
@@ -0,0 +1,34 @@
+/* bench/timer.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "../timer.hpp"
+
+#include <benchmark/benchmark.h>
+
+static void bench_timer_callback(void *param)
+{
+	++*static_cast<long *>(param);
+}
+
+/**
+ * Ticks a timer holding the given number of events, due:1 makes every event fire on every tick
+ * With due:0 they are hours away from firing, which is most events most of the time, as the server ticks far more often than any event runs.
+ */
+static void bench_timer_tick(benchmark::State &state)
+{
+	Timer timer;
+	long called = 0;
+	double speed = state.range(1) ? 0.0 : 3600.0;
+
+	for (int i = 0; i < state.range(0); ++i)
+		timer.Register(new TimeEvent(bench_timer_callback, &called, speed, Timer::FOREVER));
+
+	for (auto _ : state)
+		timer.Tick();
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+	benchmark::DoNotOptimize(called);
+}
+BENCHMARK(bench_timer_tick)->Name("Timer::Tick")->ArgNames({"events", "due"})->ArgsProduct({{10, 100, 1000, 10000}, {0, 1}});
@@ -0,0 +1,409 @@
+/* bench/world.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "bench.hpp"
+
+#include "../character.hpp"
+#include "../config.hpp"
+#include "../eoclient.hpp"
+#include "../eoserv_config.hpp"
+#include "../eoserver.hpp"
+#include "../map.hpp"
+#include "../packet.hpp"
+#include "../player.hpp"
+#include "../world.hpp"
+
+#include "../console.hpp"
+#include "../util.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <random>
+#include <string>
+
+static const char *const bench_files[] = {
+	"bench.sdb",
+	"bench.sdb-journal",
+	"bench.sdb-shm",
+	"bench.sdb-wal",
+	"bench-00001.emf",
+	"bench-dat001.ecf",
+	"bench-dat001.eif",
+	"bench-dsl001.esf",
+	"bench-dtn001.enf",
+	"bench-save-0.sdb",
+	"bench-save-0.sdb-shm",
+	"bench-save-0.sdb-wal",
+	"bench-save-1.sdb",
+	"bench-save-1.sdb-shm",
+	"bench-save-1.sdb-wal"
+};
+
+/**
+ * Writes the EO-encoded contents of a builder, without the packet length and ID in front
+ */
+static void bench_write_file(const char *filename, const PacketBuilder &builder)
+{
+	std::string data = builder.Get().substr(4);
+	std::FILE *fh = std::fopen(filename, "wb");
+
+	if (!fh || std::fwrite(data.data(), 1, data.length(), fh) != data.length())
+	{
+		Console::Err("Could not write %s", filename);
+		std::exit(1);
+	}
+
+	std::fclose(fh);
+}
+
+/**
+ * A pub file holding a single zeroed record, which is all the world needs to load
+ */
+static void bench_write_pub(const char *filename, const char *type, const std::string &name, int data_size, bool shout = false)
+{
+	PacketBuilder builder;
+	builder.AddString(type);
+	builder.AddInt(1); // Revision ID
+	builder.AddShort(1); // Number of records
+	builder.AddChar(0); // Version
+
+	builder.AddChar(name.length());
+
+	if (shout)
+		builder.AddChar(0);
+
+	builder.AddString(name);
+	builder.AddString(std::string(data_size, char(254)));
+
+	bench_write_file(filename, builder);
+}
+
+Bench_World::Bench_World()
+{
+	Cleanup();
+
+	this->WritePubFiles();
+	this->WriteMap();
+
+	// Start from the shipped configuration, as the server would run, and point it at the synthetic data
+	Config config;
+	Config aconfig;
+
+	config.Read("config.ini");
+	aconfig.Read("admin.ini");
+
+	eoserv_config_validate_config(config);
+	eoserv_config_validate_admin(aconfig);
+
+	config["DBType"] = "sqlite";
+	config["DBHost"] = "bench.sdb";
+	config["EIF"] = "./bench-dat001.eif";
+	config["ENF"] = "./bench-dtn001.enf";
+	config["ESF"] = "./bench-dsl001.esf";
+	config["ECF"] = "./bench-dat001.ecf";
+	config["MapDir"] = "./bench-";
+	config["Maps"] = 1;
+	config["QuestDir"] = "./bench-";
+	config["Quests"] = 0;
+	config["SLN"] = false;
+	config["MetricsPort"] = 0;
+	config["PasswordHashThreads"] = 0;
+
+	std::array<std::string, 6> dbinfo;
+	dbinfo[0] = std::string(config["DBType"]);
+	dbinfo[1] = std::string(config["DBHost"]);
+
+	this->server = new EOServer(IPAddress("127.0.0.1"), 0, dbinfo, config, aconfig);
+	this->world = this->server->world;
+
+	this->world->CommitDB();
+	this->world->db.ExecuteFile(this->world->settings.GetString(ConfigKey::InstallSQL));
+	this->world->BeginDB();
+
+	this->map = this->world->GetMap(1);
+
+	if (!this->map->exists)
+	{
+		Console::Err("Could not load the benchmark map");
+		std::exit(1);
+	}
+
+	for (int i = 0; i < num_characters; ++i)
+	{
+		// Spread out in a fixed pattern, stepping off any wall that lands on
+		int x = (i * 37) % map_size;
+		int y = (i * 61 + i / map_size) % map_size;
+
+		if (!this->map->Walkable(x, y))
+			++x;
+
+		std::string name = "bench";
+
+		for (int n = i; name.length() < 9; n /= 26)
+			name += char('a' + n % 26);
+
+		this->characters.push_back(this->Login(name, x, y));
+	}
+
+	Console::Out("Benchmark world ready (%i characters, %i npcs)", int(this->map->characters.size()), int(this->map->npcs.size()));
+}
+
+void Bench_World::WritePubFiles()
+{
+	bench_write_pub("bench-dat001.eif", "EIF", "Item", EIF::DATA_SIZE);
+	bench_write_pub("bench-dsl001.esf", "ESF", "Spell", ESF::DATA_SIZE, true);
+	bench_write_pub("bench-dat001.ecf", "ECF", "Class", ECF::DATA_SIZE);
+
+	// A passive NPC, so the map's NPCs stand still and never attack anyone
+	PacketBuilder builder;
+	builder.AddString("ENF");
+	builder.AddInt(1);
+	builder.AddShort(1);
+	builder.AddChar(0);
+	builder.AddChar(3);
+	builder.AddString("NPC");
+
+	std::string data(ENF::DATA_SIZE, char(254));
+	PacketBuilder fields;
+	fields.AddShort(ENF::Passive);
+	fields.AddThree(100); // HP
+	std::string encoded = fields.Get().substr(4);
+	data.replace(7, 2, encoded, 0, 2);
+	data.replace(11, 3, encoded, 2, 3);
+
+	builder.AddString(data);
+	bench_write_file("bench-dtn001.enf", builder);
+}
+
+void Bench_World::WriteMap()
+{
+	PacketBuilder builder;
+	builder.AddString("EMF");
+	builder.AddInt(1); // Revision ID
+	builder.AddString(std::string(24, char(0))); // Name
+	builder.AddChar(0); // PK
+	builder.AddChar(Map::EffectNone);
+	builder.AddString(std::string(4, char(0)));
+	builder.AddChar(map_size - 1); // Width
+	builder.AddChar(map_size - 1); // Height
+	builder.AddString(std::string(3, char(0)));
+	builder.AddChar(0); // Scroll
+	builder.AddChar(0); // Relog X
+	builder.AddChar(0); // Relog Y
+	builder.AddByte(0);
+
+	// Ten spawn points of stationary NPCs down the middle of the map
+	const int spawns = 10;
+	builder.AddChar(spawns);
+
+	for (int i = 0; i < spawns; ++i)
+	{
+		builder.AddChar(map_size / 2);
+		builder.AddChar(i * map_size / spawns + 2);
+		builder.AddShort(1); // NPC ID
+		builder.AddChar(7); // Spawn type
+		builder.AddShort(60); // Spawn time
+		builder.AddChar(num_npcs / spawns);
+	}
+
+	builder.AddChar(0); // Unknown
+	builder.AddChar(0); // Chests
+
+	// Short walls every 10 tiles, so walking and NPC placement have to check tiles as well as occupants
+	builder.AddChar(map_size * 4 / 10);
+
+	for (int y = 0; y < map_size; ++y)
+	{
+		if (y % 10 < 3 || y % 10 > 6)
+			continue;
+
+		builder.AddChar(y);
+		builder.AddChar(map_size / 10);
+
+		for (int x = 5; x < map_size; x += 10)
+		{
+			builder.AddChar(x);
+			builder.AddChar(Map_Tile::Wall);
+		}
+	}
+
+	builder.AddChar(0); // Warps
+
+	bench_write_file("bench-00001.emf", builder);
+}
+
+Bench_World &Bench_World::Get()
+{
+	static Bench_World *instance = new Bench_World;
+	return *instance;
+}
+
+Character *Bench_World::Login(const std::string &name, int x, int y)
+{
+	this->world->CreatePlayer(name, "", "Benchmark", "", "", "", "", "127.0.0.1");
+
+	// The client is never connected, packets sent to it are built and encoded and then dropped
+	EOClient *client = new EOClient(this->server);
+	client->player = this->world->Login(name);
+	client->player->id = client->id;
+	client->player->client = client;
+	client->player->AddCharacter(name, GENDER_FEMALE, 1, 1, SKIN_WHITE);
+
+	Character *character = client->player->characters.back();
+	client->player->character = character;
+	character->mapid = this->map->id;
+	character->x = x;
+	character->y = y;
+	character->CalculateStats();
+
+	this->world->Login(character);
+	client->state = EOClient::Playing;
+
+	return character;
+}
+
+void Bench_World::Cleanup()
+{
+	UTIL_FOREACH(bench_files, file)
+		std::remove(file);
+}
+
+static void bench_map_walk(benchmark::State &state)
+{
+	Bench_World &bench = Bench_World::Get();
+	std::mt19937 rng(1);
+	std::size_t i = 0;
+	int walked = 0;
+
+	for (auto _ : state)
+	{
+		Character *character = bench.characters[i++ % bench.characters.size()];
+		Direction direction = Direction(rng() % 4);
+
+		if (bench.map->Walk(character, direction) == Map::WalkOK)
+			++walked;
+	}
+
+	state.counters["walked"] = benchmark::Counter(double(walked) / double(state.iterations()));
+}
+BENCHMARK(bench_map_walk)->Name("Map::Walk");
+
+static void bench_map_occupied(benchmark::State &state)
+{
+	Bench_World &bench = Bench_World::Get();
+	Map::OccupiedTarget target = Map::OccupiedTarget(state.range(0));
+	std::mt19937 rng(1);
+
+	for (auto _ : state)
+	{
+		unsigned char x = rng() % Bench_World::map_size;
+		unsigned char y = rng() % Bench_World::map_size;
+		benchmark::DoNotOptimize(bench.map->Occupied(x, y, target));
+	}
+}
+BENCHMARK(bench_map_occupied)->Name("Map::Occupied")->ArgName("target")->Arg(Map::PlayerOnly)->Arg(Map::NPCOnly)->Arg(Map::PlayerAndNPC);
+
+static void bench_world_get_character(benchmark::State &state)
+{
+	Bench_World &bench = Bench_World::Get();
+
+	// The last character to log in is the furthest from the front of the list
+	std::string name = state.range(0) ? util::ucfirst(bench.characters.back()->SourceName()) : "nobody";
+
+	for (auto _ : state)
+		benchmark::DoNotOptimize(bench.world->GetCharacter(name));
+}
+BENCHMARK(bench_world_get_character)->Name("World::GetCharacter")->ArgName("found")->Arg(0)->Arg(1);
+
+static std::list<Character_Item> bench_inventory(int items)
+{
+	std::list<Character_Item> inventory;
+
+	for (int i = 0; i < items; ++i)
+		inventory.emplace_back(short(i * 7 + 1), i % 3 == 0 ? 1 : i * 1000 + 17);
+
+	return inventory;
+}
+
+static void bench_item_serialize(benchmark::State &state)
+{
+	std::list<Character_Item> inventory = bench_inventory(int(state.range(0)));
+
+	for (auto _ : state)
+		benchmark::DoNotOptimize(ItemSerialize(inventory));
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bench_item_serialize)->Name("ItemSerialize")->ArgName("items")->Arg(10)->Arg(100)->Arg(1000);
+
+static void bench_item_unserialize(benchmark::State &state)
+{
+	std::string serialized = ItemSerialize(bench_inventory(int(state.range(0))));
+
+	for (auto _ : state)
+		benchmark::DoNotOptimize(ItemUnserialize(serialized));
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bench_item_unserialize)->Name("ItemUnserialize")->ArgName("items")->Arg(10)->Arg(100)->Arg(1000);
+
+/**
+ * Gives a character a history of completed quests, as a long-time player would have
+ */
+static void bench_complete_quests(Character *character, int quests)
+{
+	character->quests.clear();
+	character->quests_inactive.clear();
+	character->quest_string.clear();
+
+	for (int i = 1; i <= quests; ++i)
+		character->quests_inactive.insert(Character_QuestState{short(i), "end", "{}"});
+
+	character->QuestChanged();
+}
+
+static void bench_quest_serialize(benchmark::State &state)
+{
+	Character *character = Bench_World::Get().characters.front();
+	bench_complete_quests(character, int(state.range(0)));
+
+	for (auto _ : state)
+	{
+		character->QuestChanged();
+		benchmark::DoNotOptimize(character->QuestData());
+	}
+}
+BENCHMARK(bench_quest_serialize)->Name("Character::QuestData")->ArgName("quests")->Arg(50);
+
+/**
+ * Saves in the open timed-save transaction, as world_timed_save does
+ * With changed:1 every save re-serializes the quests first, with changed:0 they come from the cache.
+ */
+static void bench_character_save(benchmark::State &state)
+{
+	Bench_World &bench = Bench_World::Get();
+	Character *character = bench.characters.front();
+	bench_complete_quests(character, 50);
+	bool changed = state.range(0);
+
+	for (auto _ : state)
+	{
+		if (changed)
+			character->QuestChanged();
+
+		character->Save();
+	}
+
+	state.SetItemsProcessed(state.iterations());
+
+	bench.world->CommitDB();
+	bench.world->BeginDB();
+}
+BENCHMARK(bench_character_save)->Name("Character::Save/quests:50")->ArgName("changed")->Arg(0)->Arg(1);
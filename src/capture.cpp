@@ -0,0 +1,275 @@
+/* capture.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "capture.hpp"
+
+#include "packet.hpp"
+
+#include "util.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static const char capture_magic[4] = {'E', 'O', 'C', 'P'};
+static const unsigned char capture_version = 1;
+
+static const std::size_t capture_header_size = 7;
+
+static std::uint32_t capture_get_int(const unsigned char *p, std::size_t size)
+{
+	std::uint32_t value = 0;
+
+	for (std::size_t i = 0; i < size; ++i)
+		value |= std::uint32_t(p[i]) << (i * 8);
+
+	return value;
+}
+
+static void capture_put_int(std::string &out, std::uint32_t value, std::size_t size)
+{
+	for (std::size_t i = 0; i < size; ++i)
+		out += char((value >> (i * 8)) & 0xFF);
+}
+
+/**
+ * Replaces the break-terminated fields at the given positions, counting from the first field after skip bytes
+ */
+static std::string capture_scrub_fields(const std::string &payload, std::size_t skip, const std::vector<std::size_t> &fields)
+{
+	if (payload.length() < skip)
+		return payload;
+
+	std::string result = payload.substr(0, skip);
+	std::size_t pos = skip;
+
+	for (std::size_t field = 0; pos < payload.length(); ++field)
+	{
+		std::size_t end = payload.find(char(0xFF), pos);
+
+		if (end == std::string::npos)
+			end = payload.length();
+
+		bool scrub = std::find(UTIL_CRANGE(fields), field) != fields.end();
+
+		result += scrub ? std::string(Capture_Writer::ScrubbedPassword) : payload.substr(pos, end - pos);
+
+		if (end < payload.length())
+			result += char(0xFF);
+
+		pos = end + 1;
+	}
+
+	return result;
+}
+
+/**
+ * Checks if an admin command name resolves to $resetpassword, matching the aliases and abbreviations registered in commands/char_mod.cpp
+ */
+static bool capture_password_command(const std::string &command)
+{
+	static const std::string name = "resetpassword";
+	static const std::size_t partial_min_chars = 4;
+
+	if (command == "rp" || command == "password" || command == name)
+		return true;
+
+	return command.length() >= partial_min_chars && command.length() < name.length() && name.compare(0, command.length(), command) == 0;
+}
+
+/**
+ * Replaces everything after the username in a password-setting admin command, split on spaces the way Talk_Report splits it
+ */
+static std::string capture_scrub_command(const std::string &message)
+{
+	if (message.empty() || message[0] != '$')
+		return message;
+
+	std::size_t command_end = message.find(' ');
+
+	if (command_end == std::string::npos || !capture_password_command(util::lowercase(message.substr(1, command_end - 1))))
+		return message;
+
+	std::size_t username_end = message.find(' ', command_end + 1);
+
+	if (username_end == std::string::npos)
+		return message;
+
+	return message.substr(0, username_end + 1) + Capture_Writer::ScrubbedPassword;
+}
+
+static std::string capture_scrub(const Capture_Record &record)
+{
+	// Login_Request: username, password
+	if (record.family == PACKET_LOGIN && record.action == PACKET_REQUEST)
+		return capture_scrub_fields(record.payload, 0, {1});
+
+	// Account_Create: session ID (2), 1 byte, username, password, ...
+	if (record.family == PACKET_ACCOUNT && record.action == PACKET_CREATE)
+		return capture_scrub_fields(record.payload, 3, {1});
+
+	// Account_Agree: username, old password, new password
+	if (record.family == PACKET_ACCOUNT && record.action == PACKET_AGREE)
+		return capture_scrub_fields(record.payload, 0, {1, 2});
+
+	// Talk_Report: message, which runs an admin command such as $resetpassword <username> <password> if it starts with $
+	if (record.family == PACKET_TALK && record.action == PACKET_REPORT)
+		return capture_scrub_command(record.payload);
+
+	return record.payload;
+}
+
+const char *const Capture_Writer::ScrubbedPassword = "capture";
+
+Capture_Reader::Capture_Reader()
+	: fh(0)
+{ }
+
+bool Capture_Reader::Open(const std::string &filename)
+{
+	this->Close();
+
+	this->fh = std::fopen(filename.c_str(), "rb");
+
+	if (!this->fh)
+		return false;
+
+	char header[5];
+
+	if (std::fread(header, 1, sizeof header, this->fh) != sizeof header
+	 || std::memcmp(header, capture_magic, sizeof capture_magic) != 0
+	 || (unsigned char)header[4] != capture_version)
+	{
+		this->Close();
+		return false;
+	}
+
+	return true;
+}
+
+void Capture_Reader::Close()
+{
+	if (this->fh)
+	{
+		std::fclose(this->fh);
+		this->fh = 0;
+	}
+}
+
+bool Capture_Reader::Read(Capture_Record &record)
+{
+	if (!this->fh)
+		return false;
+
+	unsigned char header[capture_header_size];
+
+	if (std::fread(header, 1, sizeof header, this->fh) != sizeof header)
+		return false;
+
+	record.type = Capture_Record::Type(header[0]);
+	record.time = capture_get_int(header + 1, 4);
+	record.client = (unsigned short)capture_get_int(header + 5, 2);
+	record.family = PacketFamily(0);
+	record.action = PacketAction(0);
+	record.payload.clear();
+
+	if (record.type == Capture_Record::Close)
+		return true;
+
+	if (record.type != Capture_Record::Packet)
+		return false;
+
+	unsigned char packet_header[4];
+
+	if (std::fread(packet_header, 1, sizeof packet_header, this->fh) != sizeof packet_header)
+		return false;
+
+	record.family = PacketFamily(packet_header[0]);
+	record.action = PacketAction(packet_header[1]);
+
+	std::size_t length = capture_get_int(packet_header + 2, 2);
+	record.payload.resize(length);
+
+	if (length > 0 && std::fread(&record.payload[0], 1, length, this->fh) != length)
+		return false;
+
+	return true;
+}
+
+Capture_Reader::~Capture_Reader()
+{
+	this->Close();
+}
+
+Capture_Writer::Capture_Writer()
+	: fh(0)
+{ }
+
+bool Capture_Writer::Open(const std::string &filename)
+{
+	this->Close();
+
+	this->fh = std::fopen(filename.c_str(), "wb");
+
+	if (!this->fh)
+		return false;
+
+	if (std::fwrite(capture_magic, 1, sizeof capture_magic, this->fh) != sizeof capture_magic
+	 || std::fputc(capture_version, this->fh) == EOF)
+	{
+		this->Close();
+		return false;
+	}
+
+	return true;
+}
+
+void Capture_Writer::Close()
+{
+	if (this->fh)
+	{
+		std::fclose(this->fh);
+		this->fh = 0;
+	}
+}
+
+bool Capture_Writer::Write(const Capture_Record &record)
+{
+	if (!this->fh)
+		return false;
+
+	std::string data;
+	data.reserve(capture_header_size + 4 + record.payload.length());
+
+	data += char(record.type);
+	capture_put_int(data, record.time, 4);
+	capture_put_int(data, record.client, 2);
+
+	if (record.type == Capture_Record::Packet)
+	{
+		std::string payload = capture_scrub(record);
+
+		data += char(record.family);
+		data += char(record.action);
+		capture_put_int(data, std::uint32_t(payload.length()), 2);
+		data += payload;
+	}
+
+	return std::fwrite(data.data(), 1, data.length(), this->fh) == data.length();
+}
+
+bool Capture_Writer::Flush()
+{
+	return this->fh && std::fflush(this->fh) == 0;
+}
+
+Capture_Writer::~Capture_Writer()
+{
+	this->Close();
+}
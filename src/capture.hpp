@@ -0,0 +1,110 @@
+/* capture.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef CAPTURE_HPP_INCLUDED
+#define CAPTURE_HPP_INCLUDED
+
+#include "fwd/capture.hpp"
+
+#include "packet.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/**
+ * One event in a packet capture
+ * A capture file starts with the magic "EOCP" and a version byte, followed by records of:
+ * type (1), time (4), client ID (2), and for packets family (1), action (1), length (2), payload, all little-endian.
+ */
+struct Capture_Record
+{
+	enum Type : unsigned char
+	{
+		Packet = 1,
+		Close = 2
+	};
+
+	Type type;
+
+	/**
+	 * Milliseconds since the capture started
+	 */
+	std::uint32_t time;
+
+	unsigned short client;
+
+	PacketFamily family;
+	PacketAction action;
+
+	/**
+	 * Decoded packet data following the sequence number
+	 */
+	std::string payload;
+};
+
+/**
+ * Reads the records from a capture file in the order they were written
+ */
+class Capture_Reader
+{
+protected:
+	std::FILE *fh;
+
+public:
+	Capture_Reader();
+	Capture_Reader(const Capture_Reader &) = delete;
+
+	/**
+	 * Opens a capture file and checks its header
+	 * @return false if the file could not be opened or is not a capture
+	 */
+	bool Open(const std::string &filename);
+	bool IsOpen() const { return this->fh != 0; }
+	void Close();
+
+	/**
+	 * Reads the next record
+	 * @return false at the end of the file, or at a record cut short by the recorder stopping mid-write
+	 */
+	bool Read(Capture_Record &record);
+
+	~Capture_Reader();
+};
+
+/**
+ * Writes records to a capture file, replacing account passwords on the way
+ */
+class Capture_Writer
+{
+protected:
+	std::FILE *fh;
+
+public:
+	/**
+	 * Written in place of every password sent to log in, create an account, change a password or set one with $resetpassword
+	 */
+	static const char *const ScrubbedPassword;
+
+	Capture_Writer();
+	Capture_Writer(const Capture_Writer &) = delete;
+
+	/**
+	 * Creates or truncates a capture file and writes its header
+	 */
+	bool Open(const std::string &filename);
+	bool IsOpen() const { return this->fh != 0; }
+	void Close();
+
+	/**
+	 * Appends a record, records are buffered until Flush or Close
+	 */
+	bool Write(const Capture_Record &record);
+	bool Flush();
+
+	~Capture_Writer();
+};
+
+#endif // CAPTURE_HPP_INCLUDED
@@ -22,6 +22,7 @@
 #include "world.hpp"
 
 #include "console.hpp"
+#include "trace.hpp"
 #include "util.hpp"
 #include "util/rpn.hpp"
 #include "util/variant.hpp"
@@ -199,7 +200,7 @@ std::string QuestSerialize(const std::map<short, std::shared_ptr<Quest_Context>>
 {
 	std::string serialized;
 
-	UTIL_FOREACH(list, quest)
+	UTIL_FOREACH_CREF(list, quest)
 	{
 		if (!quest.second)
 			continue;
@@ -212,7 +213,7 @@ std::string QuestSerialize(const std::map<short, std::shared_ptr<Quest_Context>>
 		serialized.append(";");
 	}
 
-	UTIL_FOREACH(list_inactive, state)
+	UTIL_FOREACH_CREF(list_inactive, state)
 	{
 		if (list.find(state.quest_id) != list.end())
 		{
@@ -348,8 +349,56 @@ std::vector<std::string> BotListUnserialize(std::string serialized)
 	return bots;
 }
 
+// Column indexes of the character SELECT query in Character::Character
+enum CharacterColumn
+{
+	COL_NAME,
+	COL_TITLE,
+	COL_HOME,
+	COL_FIANCE,
+	COL_PARTNER,
+	COL_ADMIN,
+	COL_CLASS,
+	COL_GENDER,
+	COL_RACE,
+	COL_HAIRSTYLE,
+	COL_HAIRCOLOR,
+	COL_MAP,
+	COL_X,
+	COL_Y,
+	COL_DIRECTION,
+	COL_LEVEL,
+	COL_EXP,
+	COL_HP,
+	COL_TP,
+	COL_STR,
+	COL_INT,
+	COL_WIS,
+	COL_AGI,
+	COL_CON,
+	COL_CHA,
+	COL_STATPOINTS,
+	COL_SKILLPOINTS,
+	COL_KARMA,
+	COL_SITTING,
+	COL_HIDDEN,
+	COL_BANKMAX,
+	COL_GOLDBANK,
+	COL_USAGE,
+	COL_INVENTORY,
+	COL_BANK,
+	COL_PAPERDOLL,
+	COL_SPELLS,
+	COL_GUILD,
+	COL_GUILD_RANK,
+	COL_GUILD_RANK_STRING,
+	COL_QUEST,
+	COL_VARS,
+	COL_NOINTERACT
+};
+
 template <typename T>
-static T GetRow(std::unordered_map<std::string, util::variant> &row, const char *col)
+static T GetRow(const Database_Result::Row &row, CharacterColumn col)
 {
 	return row[col];
 }
@@ -359,12 +408,12 @@ Character::Character(std::string name, World *world)
 	  bot(false),
 	  cosmetic_paperdoll{{}},
 	  world(world),
-	  display_str(this->world->config["UseAdjustedStats"] ? adj_str : str),
-	  display_intl(this->world->config["UseAdjustedStats"] ? adj_intl : intl),
-	  display_wis(this->world->config["UseAdjustedStats"] ? adj_wis : wis),
-	  display_agi(this->world->config["UseAdjustedStats"] ? adj_agi : agi),
-	  display_con(this->world->config["UseAdjustedStats"] ? adj_con : con),
-	  display_cha(this->world->config["UseAdjustedStats"] ? adj_cha : cha),
+	  display_str(this->world->settings.GetBool(ConfigKey::UseAdjustedStats) ? adj_str : str),
+	  display_intl(this->world->settings.GetBool(ConfigKey::UseAdjustedStats) ? adj_intl : intl),
+	  display_wis(this->world->settings.GetBool(ConfigKey::UseAdjustedStats) ? adj_wis : wis),
+	  display_agi(this->world->settings.GetBool(ConfigKey::UseAdjustedStats) ? adj_agi : agi),
+	  display_con(this->world->settings.GetBool(ConfigKey::UseAdjustedStats) ? adj_con : con),
+	  display_cha(this->world->settings.GetBool(ConfigKey::UseAdjustedStats) ? adj_cha : cha),
 	  autoloot_enabled(true),		// Initialize autoloot_enabled to true
 	  last_pot(Timer::GetTime()),	// Initialize last_pot to the current time
 	  auto_potion_enabled(true),	// Initialize auto_potion_enabled to true
@@ -376,7 +425,7 @@ Character::Character(std::string name, World *world)
 	  pet_respawn_time(0.0)			// Initialize pet_respawn_time to 0.0
 {
 	{
-		std::vector<std::string> bot_characters = BotListUnserialize(this->world->config["BotCharacters"]);
+		std::vector<std::string> bot_characters = BotListUnserialize(this->world->settings.GetString(ConfigKey::BotCharacters));
 		auto bot_it = std::find(UTIL_CRANGE(bot_characters), util::lowercase(name));
 		this->bot = bot_it != bot_characters.end();
 	}
@@ -386,7 +435,7 @@ Character::Character(std::string name, World *world)
 												"`karma`, `sitting`, `hidden`, `bankmax`, `goldbank`, `usage`, `inventory`, `bank`, `paperdoll`, `spells`, `guild`, `guild_rank`, `guild_rank_string`, `quest`, `vars`, "
 												"`nointeract` FROM `characters` WHERE `name` = '$'",
 												name.c_str());
-	std::unordered_map<std::string, util::variant> row = res.front();
+	Database_Result::Row row = res.front();
 
 	this->login_time = std::time(0);
 
@@ -394,38 +443,38 @@ Character::Character(std::string name, World *world)
 	this->nowhere = false;
 	this->id = this->world->GenerateCharacterID();
 
-	this->admin = static_cast<AdminLevel>(GetRow<int>(row, "admin"));
-	this->real_name = GetRow<std::string>(row, "name");
-	this->title = GetRow<std::string>(row, "title");
-	this->home = GetRow<std::string>(row, "home");
-	this->fiance = GetRow<std::string>(row, "fiance");
-	this->partner = GetRow<std::string>(row, "partner");
-
-	this->clas = GetRow<int>(row, "class");
-	this->gender = static_cast<Gender>(GetRow<int>(row, "gender"));
-	this->race = static_cast<Skin>(GetRow<int>(row, "race"));
-	this->hairstyle = GetRow<int>(row, "hairstyle");
-	this->haircolor = GetRow<int>(row, "haircolor");
-
-	this->x = GetRow<int>(row, "x");
-	this->y = GetRow<int>(row, "y");
-	this->direction = static_cast<Direction>(GetRow<int>(row, "direction"));
-
-	this->level = GetRow<int>(row, "level");
-	this->exp = GetRow<int>(row, "exp");
-
-	this->hp = GetRow<int>(row, "hp");
-	this->tp = GetRow<int>(row, "tp");
-
-	this->str = GetRow<int>(row, "str");
-	this->intl = GetRow<int>(row, "int");
-	this->wis = GetRow<int>(row, "wis");
-	this->agi = GetRow<int>(row, "agi");
-	this->con = GetRow<int>(row, "con");
-	this->cha = GetRow<int>(row, "cha");
-	this->statpoints = GetRow<int>(row, "statpoints");
-	this->skillpoints = GetRow<int>(row, "skillpoints");
-	this->karma = GetRow<int>(row, "karma");
+	this->admin = static_cast<AdminLevel>(GetRow<int>(row, COL_ADMIN));
+	this->real_name = GetRow<std::string>(row, COL_NAME);
+	this->title = GetRow<std::string>(row, COL_TITLE);
+	this->home = GetRow<std::string>(row, COL_HOME);
+	this->fiance = GetRow<std::string>(row, COL_FIANCE);
+	this->partner = GetRow<std::string>(row, COL_PARTNER);
+
+	this->clas = GetRow<int>(row, COL_CLASS);
+	this->gender = static_cast<Gender>(GetRow<int>(row, COL_GENDER));
+	this->race = static_cast<Skin>(GetRow<int>(row, COL_RACE));
+	this->hairstyle = GetRow<int>(row, COL_HAIRSTYLE);
+	this->haircolor = GetRow<int>(row, COL_HAIRCOLOR);
+
+	this->x = GetRow<int>(row, COL_X);
+	this->y = GetRow<int>(row, COL_Y);
+	this->direction = static_cast<Direction>(GetRow<int>(row, COL_DIRECTION));
+
+	this->level = GetRow<int>(row, COL_LEVEL);
+	this->exp = GetRow<int>(row, COL_EXP);
+
+	this->hp = GetRow<int>(row, COL_HP);
+	this->tp = GetRow<int>(row, COL_TP);
+
+	this->str = GetRow<int>(row, COL_STR);
+	this->intl = GetRow<int>(row, COL_INT);
+	this->wis = GetRow<int>(row, COL_WIS);
+	this->agi = GetRow<int>(row, COL_AGI);
+	this->con = GetRow<int>(row, COL_CON);
+	this->cha = GetRow<int>(row, COL_CHA);
+	this->statpoints = GetRow<int>(row, COL_STATPOINTS);
+	this->skillpoints = GetRow<int>(row, COL_SKILLPOINTS);
+	this->karma = GetRow<int>(row, COL_KARMA);
 
 	this->weight = 0;
 	this->maxweight = 0;
@@ -464,29 +513,29 @@ Character::Character(std::string name, World *world)
 
 	this->warp_anim = WARP_ANIMATION_INVALID;
 
-	this->sitting = static_cast<SitState>(GetRow<int>(row, "sitting"));
-	this->hidden = GetRow<int>(row, "hidden");
+	this->sitting = static_cast<SitState>(GetRow<int>(row, COL_SITTING));
+	this->hidden = GetRow<int>(row, COL_HIDDEN);
 	this->whispers = true;
 
-	this->bankmax = GetRow<int>(row, "bankmax");
+	this->bankmax = GetRow<int>(row, COL_BANKMAX);
 
-	this->goldbank = GetRow<int>(row, "goldbank");
+	this->goldbank = GetRow<int>(row, COL_GOLDBANK);
 
-	this->usage = GetRow<int>(row, "usage");
+	this->usage = GetRow<int>(row, COL_USAGE);
 
-	this->inventory = ItemUnserialize(row["inventory"]);
-	this->bank = ItemUnserialize(row["bank"]);
-	this->paperdoll = DollUnserialize(row["paperdoll"]);
-	this->spells = SpellUnserialize(row["spells"]);
+	this->inventory = ItemUnserialize(GetRow<std::string>(row, COL_INVENTORY));
+	this->bank = ItemUnserialize(GetRow<std::string>(row, COL_BANK));
+	this->paperdoll = DollUnserialize(GetRow<std::string>(row, COL_PAPERDOLL));
+	this->spells = SpellUnserialize(GetRow<std::string>(row, COL_SPELLS));
 
 	this->player = 0;
-	std::string guild_tag = util::trim(static_cast<std::string>(row["guild"]));
+	std::string guild_tag = util::trim(GetRow<std::string>(row, COL_GUILD));
 
 	if (!guild_tag.empty())
 	{
 		this->guild = this->world->guildmanager->GetGuild(guild_tag);
-		this->guild_rank = GetRow<int>(row, "guild_rank");
-		this->guild_rank_string = GetRow<std::string>(row, "guild_rank_string");
+		this->guild_rank = GetRow<int>(row, COL_GUILD_RANK);
+		this->guild_rank_string = GetRow<std::string>(row, COL_GUILD_RANK_STRING);
 	}
 	else
 	{
@@ -494,22 +543,26 @@ Character::Character(std::string name, World *world)
 	}
 
 	this->party = 0;
-	this->map = this->world->GetMap(GetRow<int>(row, "map"));
+	this->map = this->world->GetMap(GetRow<int>(row, COL_MAP));
 	this->mapid = this->map->id;
 
 	this->last_walk = 0.0;
 	this->attacks = 0;
 
-	this->quest_string = GetRow<std::string>(row, "quest");
+	this->quest_string = GetRow<std::string>(row, COL_QUEST);
+	this->quest_data_dirty = true;
 
-	this->nointeract = GetRow<int>(row, "nointeract");
+	this->nointeract = GetRow<int>(row, COL_NOINTERACT);
 
-	if (this->admin >= static_cast<int>(world->config["NoInteractDefaultAdmin"]) && !(this->nointeract & NoInteractCustom))
+	if (this->admin >= world->settings.GetInt(ConfigKey::NoInteractDefaultAdmin) && !(this->nointeract & NoInteractCustom))
 	{
-		this->nointeract = static_cast<int>(world->config["NoInteractDefault"]);
+		this->nointeract = world->settings.GetInt(ConfigKey::NoInteractDefault);
 	}
 
 	this->damagelist.clear(); // Initialize damagelist
+
+	this->journal_dirty = 0;
+	this->journal_stats = this->JournalStats();
 }
 
 int Character::PlayerID() const
@@ -546,6 +599,8 @@ void Character::Login()
 	this->online = true;
 
 	this->CalculateStats();
+
+	this->journal_dirty = 0;
 }
 
 bool Character::ValidName(std::string name)
@@ -576,7 +631,7 @@ bool Character::ValidName(std::string name)
 
 void Character::Msg(Character *from, std::string message)
 {
-	message = util::text_cap(message, static_cast<int>(this->world->config["ChatMaxWidth"]) - util::text_width(util::ucfirst(from->SourceName()) + "  "));
+	message = util::text_cap(message, this->world->settings.GetInt(ConfigKey::ChatMaxWidth) - util::text_width(util::ucfirst(from->SourceName()) + "  "));
 
 	from->AddChatLog("!", "to " + this->SourceName(), message);
 	this->AddChatLog("!", "from " + from->SourceName(), message);
@@ -589,7 +644,7 @@ void Character::Msg(Character *from, std::string message)
 
 void Character::ServerMsg(std::string message)
 {
-	message = util::text_cap(message, static_cast<int>(this->world->config["ChatMaxWidth"]) - util::text_width("Server  "));
+	message = util::text_cap(message, this->world->settings.GetInt(ConfigKey::ChatMaxWidth) - util::text_width("Server  "));
 
 	PacketBuilder builder(PACKET_TALK, PACKET_SERVER, message.length());
 	builder.AddString(message);
@@ -598,7 +653,7 @@ void Character::ServerMsg(std::string message)
 
 void Character::StatusMsg(std::string message)
 {
-	message = util::text_cap(message, static_cast<int>(this->world->config["ChatMaxWidth"]));
+	message = util::text_cap(message, this->world->settings.GetInt(ConfigKey::ChatMaxWidth));
 
 	PacketBuilder builder(PACKET_MESSAGE, PACKET_OPEN, message.length());
 	builder.AddString(message);
@@ -752,9 +807,10 @@ bool Character::AddItem(short item, int amount)
 
 			it->amount += amount;
 
-			it->amount = std::min<int>(it->amount, this->world->config["MaxItem"]);
+			it->amount = std::min<int>(it->amount, this->world->settings.GetInt(ConfigKey::MaxItem));
 
-			this->CalculateStats();
+			this->CalculateStats(false);
+			this->CheckQuestRules(QUEST_TRIGGER_ITEM, item);
 
 			return true;
 		}
@@ -766,7 +822,8 @@ bool Character::AddItem(short item, int amount)
 
 	this->inventory.push_back(newitem);
 
-	this->CalculateStats();
+	this->CalculateStats(false);
+	this->CheckQuestRules(QUEST_TRIGGER_ITEM, item);
 
 	return true;
 }
@@ -791,7 +848,8 @@ bool Character::DelItem(short item, int amount)
 				it->amount -= amount;
 			}
 
-			this->CalculateStats();
+			this->CalculateStats(false);
+			this->CheckQuestRules(QUEST_TRIGGER_ITEM, item);
 
 			return true;
 		}
@@ -807,6 +865,8 @@ std::list<Character_Item>::iterator Character::DelItem(std::list<Character_Item>
 		return ++it;
 	}
 
+	short item = it->id;
+
 	if (it->amount < 0 || it->amount - amount <= 0)
 	{
 		it = this->inventory.erase(it);
@@ -817,7 +877,8 @@ std::list<Character_Item>::iterator Character::DelItem(std::list<Character_Item>
 		++it;
 	}
 
-	this->CalculateStats();
+	this->CalculateStats(false);
+	this->CheckQuestRules(QUEST_TRIGGER_ITEM, item);
 
 	return it;
 }
@@ -826,7 +887,7 @@ int Character::CanHoldItem(short itemid, int max_amount)
 {
 	int amount = max_amount;
 
-	if (int(this->world->config["EnforceWeight"]) >= 2 && SourceDutyAccess() < static_cast<int>(world->config["unlimitedweight"]))
+	if (this->world->settings.GetInt(ConfigKey::EnforceWeight) >= 2 && SourceDutyAccess() < static_cast<int>(world->config["unlimitedweight"]))
 	{
 		const EIF_Data &item = this->world->eif->Get(itemid);
 
@@ -838,12 +899,12 @@ int Character::CanHoldItem(short itemid, int max_amount)
 			amount = std::min((this->maxweight - this->weight) / item.weight, max_amount);
 	}
 
-	return std::min<int>(amount, this->world->config["MaxItem"]);
+	return std::min<int>(amount, this->world->settings.GetInt(ConfigKey::MaxItem));
 }
 
 bool Character::AddTradeItem(short item, int amount)
 {
-	bool trade_add_quantity = bool(this->world->config["TradeAddQuantity"]);
+	bool trade_add_quantity = this->world->settings.GetBool(ConfigKey::TradeAddQuantity);
 
 	if (item <= 0 || static_cast<std::size_t>(item) >= this->world->eif->data.size())
 	{
@@ -854,7 +915,7 @@ bool Character::AddTradeItem(short item, int amount)
 
 	amount = std::min(amount, hasitem);
 
-	if (amount <= 0 || amount > int(this->world->config["MaxTrade"]))
+	if (amount <= 0 || amount > this->world->settings.GetInt(ConfigKey::MaxTrade))
 	{
 		return false;
 	}
@@ -872,7 +933,7 @@ bool Character::AddTradeItem(short item, int amount)
 			}
 		}
 
-		if (tradeitem + amount < 0 || tradeitem + amount > int(this->world->config["MaxTrade"]))
+		if (tradeitem + amount < 0 || tradeitem + amount > this->world->settings.GetInt(ConfigKey::MaxTrade))
 		{
 			return false;
 		}
@@ -896,7 +957,7 @@ bool Character::AddTradeItem(short item, int amount)
 	newitem.amount = amount;
 
 	this->trade_inventory.push_back(newitem);
-	this->CheckQuestRules();
+	this->CheckQuestRules(QUEST_TRIGGER_ITEM, item);
 
 	return true;
 }
@@ -908,7 +969,7 @@ bool Character::DelTradeItem(short item)
 		if (it->id == item)
 		{
 			this->trade_inventory.erase(it);
-			this->CheckQuestRules();
+			this->CheckQuestRules(QUEST_TRIGGER_ITEM, item);
 			return true;
 		}
 	}
@@ -926,7 +987,7 @@ bool Character::AddSpell(short spell)
 
 	this->spells.push_back(Character_Spell(spell, 0));
 
-	this->CheckQuestRules();
+	this->CheckQuestRules(QUEST_TRIGGER_SPELL, spell);
 
 	return true;
 }
@@ -938,7 +999,7 @@ bool Character::DelSpell(short spell)
 	bool removed = (remove_it != this->spells.end());
 	this->spells.erase(remove_it, this->spells.end());
 
-	this->CheckQuestRules();
+	this->CheckQuestRules(QUEST_TRIGGER_SPELL, spell);
 
 	return removed;
 }
@@ -1036,7 +1097,7 @@ void Character::SpellAct()
 
 double Character::SpellCooldownTime() const
 {
-	double cooldown_period = this->world->config["SpellCastCooldown"];
+	double cooldown_period = this->world->settings.GetFloat(ConfigKey::SpellCastCooldown);
 	double cooldown = (this->spell_fired_time + cooldown_period) - Timer::GetTime();
 
 	if (cooldown < 0.0)
@@ -1193,7 +1254,7 @@ bool Character::Equip(short item, unsigned char subloc)
 
 bool Character::InRange(unsigned char x, unsigned char y) const
 {
-	return util::path_length(this->x, this->y, x, y) <= static_cast<int>(this->world->config.at("SeeDistance"));
+	return util::path_length(this->x, this->y, x, y) <= this->world->settings.GetInt(ConfigKey::SeeDistance);
 }
 
 bool Character::InRange(const Character *other) const
@@ -1249,7 +1310,7 @@ void Character::Warp(short map, unsigned char x, unsigned char y, WarpAnimation
 		builder.AddChar(WARP_SWITCH);
 		builder.AddShort(map);
 
-		if (this->world->config["GlobalPK"] && !this->world->PKExcept(map))
+		if (this->world->settings.GetBool(ConfigKey::GlobalPK) && !this->world->PKExcept(map))
 		{
 			builder.AddByte(0xFF);
 			builder.AddByte(0x01);
@@ -1483,9 +1544,9 @@ void Character::ShowBoard(Board *board)
 		board = this->board;
 	}
 
-	const int date_res = (this->world->config["BoardDatePosts"]) ? 17 : 0;
+	const int date_res = (this->world->settings.GetBool(ConfigKey::BoardDatePosts)) ? 17 : 0;
 
-	PacketBuilder builder(PACKET_BOARD, PACKET_OPEN, 2 + board->posts.size() * (17 + int(this->world->config["BoardMaxSubjectLength"]) + date_res));
+	PacketBuilder builder(PACKET_BOARD, PACKET_OPEN, 2 + board->posts.size() * (17 + this->world->settings.GetInt(ConfigKey::BoardMaxSubjectLength) + date_res));
 	builder.AddChar(board->id + 1);
 	builder.AddChar(board->posts.size());
 
@@ -1498,14 +1559,14 @@ void Character::ShowBoard(Board *board)
 		{
 			++post_count;
 
-			if (post->time + static_cast<int>(this->world->config["BoardRecentPostTime"]) > Timer::GetTime())
+			if (post->time + this->world->settings.GetInt(ConfigKey::BoardRecentPostTime) > Timer::GetTime())
 			{
 				++recent_post_count;
 			}
 		}
 	}
 
-	int posts_remaining = std::min(static_cast<int>(this->world->config["BoardMaxUserPosts"]) - post_count, static_cast<int>(this->world->config["BoardMaxUserRecentPosts"]) - recent_post_count);
+	int posts_remaining = std::min(this->world->settings.GetInt(ConfigKey::BoardMaxUserPosts) - post_count, this->world->settings.GetInt(ConfigKey::BoardMaxRecentPosts) - recent_post_count);
 
 	UTIL_FOREACH(board->posts, post)
 	{
@@ -1523,7 +1584,7 @@ void Character::ShowBoard(Board *board)
 
 		std::string subject_extra;
 
-		if (this->world->config["BoardDatePosts"])
+		if (this->world->settings.GetBool(ConfigKey::BoardDatePosts))
 		{
 			subject_extra = " (" + util::timeago(post->time, Timer::GetTime()) + ")";
 		}
@@ -1538,7 +1599,7 @@ std::string Character::PaddedGuildTag()
 {
 	std::string tag;
 
-	if (this->world->config["ShowLevel"])
+	if (this->world->settings.GetBool(ConfigKey::ShowLevel))
 	{
 		tag = util::to_string(this->level);
 		if (tag.length() < 3)
@@ -1569,7 +1630,7 @@ std::string Character::GuildRankString()
 	if (!this->guild)
 		return "";
 
-	if (this->world->config["GuildCustomRanks"] && !this->guild_rank_string.empty())
+	if (this->world->settings.GetBool(ConfigKey::GuildCustomRanks) && !this->guild_rank_string.empty())
 	{
 		return this->guild_rank_string;
 	}
@@ -1615,13 +1676,49 @@ void Character::CheckQuestRules()
 	}
 }
 
+void Character::CheckQuestRules(QuestTrigger trigger, short key)
+{
+	UTIL_FOREACH(this->quests, q)
+	{
+		if (!q.second || q.second->GetQuest()->Disabled())
+			continue;
+
+		q.second->CheckRules(trigger, key);
+	}
+}
+
 void Character::CalculateStats(bool trigger_quests)
+{
+	// Every change to the inventory, bank or paperdoll ends up here
+	this->journal_dirty |= JournalItems;
+
+	this->PrepareStats();
+
+	Formula_Frame formula_vars;
+	this->FormulaVars(formula_vars);
+
+	const ECF_Data &ecf = world->ecf->Get(this->clas);
+	std::string class_formula = "class." + util::to_string(ecf.type);
+
+	Stat_Formulas formulas;
+	formulas.hp = this->world->EvalFormula("hp", formula_vars);
+	formulas.tp = this->world->EvalFormula("tp", formula_vars);
+	formulas.sp = this->world->EvalFormula("sp", formula_vars);
+	formulas.weight = this->world->EvalFormula("weight", formula_vars);
+	formulas.damage = this->world->EvalFormula(class_formula + ".damage", formula_vars);
+	formulas.defence = this->world->EvalFormula(class_formula + ".defence", formula_vars);
+	formulas.accuracy = this->world->EvalFormula(class_formula + ".accuracy", formula_vars);
+	formulas.evade = this->world->EvalFormula(class_formula + ".evade", formula_vars);
+
+	this->ApplyStats(formulas, trigger_quests);
+}
+
+void Character::PrepareStats()
 {
 	const ECF_Data &ecf = world->ecf->Get(this->clas);
 
-	int max_weight = this->world->config["MaxWeight"];
-	int max_hptp = this->world->config["MaxHPTP"];
-	int max_stat = this->world->config["MaxStat"];
+	int max_weight = this->world->settings.GetInt(ConfigKey::MaxWeight);
+	int max_stat = this->world->settings.GetInt(ConfigKey::MaxStat);
 
 	this->adj_str = this->str + ecf.str;
 	this->adj_intl = this->intl + ecf.intl;
@@ -1684,14 +1781,17 @@ void Character::CalculateStats(bool trigger_quests)
 	{
 		this->weight = max_weight;
 	}
+}
 
-	std::unordered_map<std::string, double> formula_vars;
-	this->FormulaVars(formula_vars);
+void Character::ApplyStats(const Stat_Formulas &formulas, bool trigger_quests)
+{
+	int max_weight = this->world->settings.GetInt(ConfigKey::MaxWeight);
+	int max_hptp = this->world->settings.GetInt(ConfigKey::MaxHPTP);
 
-	this->maxhp += this->world->EvalFormula("hp", formula_vars);
-	this->maxtp += this->world->EvalFormula("tp", formula_vars);
-	this->maxsp += this->world->EvalFormula("sp", formula_vars);
-	this->maxweight = this->world->EvalFormula("weight", formula_vars);
+	this->maxhp += formulas.hp;
+	this->maxtp += formulas.tp;
+	this->maxsp += formulas.sp;
+	this->maxweight = formulas.weight;
 
 	this->maxhp = std::min(max_hptp, this->maxhp);
 	this->maxtp = std::min(max_hptp, this->maxtp);
@@ -1716,19 +1816,17 @@ void Character::CalculateStats(bool trigger_quests)
 		this->maxweight = 251;
 	}
 
-	auto dam = this->world->EvalFormula("class." + util::to_string(ecf.type) + ".damage", formula_vars);
+	this->mindam += formulas.damage;
+	this->maxdam += formulas.damage;
+	this->armor += formulas.defence;
+	this->accuracy += formulas.accuracy;
+	this->evade += formulas.evade;
 
-	this->mindam += dam;
-	this->maxdam += dam;
-	this->armor += this->world->EvalFormula("class." + util::to_string(ecf.type) + ".defence", formula_vars);
-	this->accuracy += this->world->EvalFormula("class." + util::to_string(ecf.type) + ".accuracy", formula_vars);
-	this->evade += this->world->EvalFormula("class." + util::to_string(ecf.type) + ".evade", formula_vars);
+	if (this->mindam == 0 || !this->world->settings.GetBool(ConfigKey::BaseDamageAtZero))
+		this->mindam += this->world->settings.GetInt(ConfigKey::BaseMinDamage);
 
-	if (this->mindam == 0 || !this->world->config["BaseDamageAtZero"])
-		this->mindam += int(this->world->config["BaseMinDamage"]);
-
-	if (this->maxdam == 0 || !this->world->config["BaseDamageAtZero"])
-		this->maxdam += int(this->world->config["BaseMaxDamage"]);
+	if (this->maxdam == 0 || !this->world->settings.GetBool(ConfigKey::BaseDamageAtZero))
+		this->maxdam += this->world->settings.GetInt(ConfigKey::BaseMaxDamage);
 
 	this->mindam = std::min(max_hptp, this->mindam);
 	this->maxdam = std::min(max_hptp, this->maxdam);
@@ -1745,6 +1843,33 @@ void Character::CalculateStats(bool trigger_quests)
 	}
 }
 
+void Character::AddStats(PacketBuilder &builder) const
+{
+	builder.AddShort(this->display_str);
+	builder.AddShort(this->display_intl);
+	builder.AddShort(this->display_wis);
+	builder.AddShort(this->display_agi);
+	builder.AddShort(this->display_con);
+	builder.AddShort(this->display_cha);
+	builder.AddShort(this->maxhp);
+	builder.AddShort(this->maxtp);
+	builder.AddShort(this->maxsp);
+	builder.AddShort(this->maxweight);
+	builder.AddShort(this->mindam);
+	builder.AddShort(this->maxdam);
+	builder.AddShort(this->accuracy);
+	builder.AddShort(this->evade);
+	builder.AddShort(this->armor);
+}
+
+void Character::SendStats()
+{
+	PacketBuilder builder(PACKET_RECOVER, PACKET_LIST, 32);
+	builder.AddShort(this->clas);
+	this->AddStats(builder);
+	this->Send(builder);
+}
+
 void Character::DropAll(Character *killer)
 {
 	if (!CanInteractItems())
@@ -1767,12 +1892,12 @@ void Character::DropAll(Character *killer)
 			if (killer)
 			{
 				map_item->owner = killer->PlayerID();
-				map_item->unprotecttime = Timer::GetTime() + static_cast<double>(this->world->config["ProtectPKDrop"]);
+				map_item->unprotecttime = Timer::GetTime() + this->world->settings.GetFloat(ConfigKey::ProtectPKDrop);
 			}
 			else
 			{
 				map_item->owner = this->PlayerID();
-				map_item->unprotecttime = Timer::GetTime() + static_cast<double>(this->world->config["ProtectDeathDrop"]);
+				map_item->unprotecttime = Timer::GetTime() + this->world->settings.GetFloat(ConfigKey::ProtectDeathDrop);
 			}
 
 			PacketBuilder builder(PACKET_ITEM, PACKET_DROP, 15);
@@ -1808,12 +1933,12 @@ void Character::DropAll(Character *killer)
 			if (killer)
 			{
 				map_item->owner = killer->PlayerID();
-				map_item->unprotecttime = Timer::GetTime() + static_cast<double>(this->world->config["ProtectPKDrop"]);
+				map_item->unprotecttime = Timer::GetTime() + this->world->settings.GetFloat(ConfigKey::ProtectPKDrop);
 			}
 			else
 			{
 				map_item->owner = this->PlayerID();
-				map_item->unprotecttime = Timer::GetTime() + static_cast<double>(this->world->config["ProtectDeathDrop"]);
+				map_item->unprotecttime = Timer::GetTime() + this->world->settings.GetFloat(ConfigKey::ProtectDeathDrop);
 			}
 
 			int subloc = 0;
@@ -1913,8 +2038,8 @@ void Character::Reset()
 
 	this->CancelSpell();
 
-	this->statpoints = this->level * int(this->world->config["StatPerLevel"]);
-	this->skillpoints = this->level * int(this->world->config["SkillPerLevel"]);
+	this->statpoints = this->level * this->world->settings.GetInt(ConfigKey::StatPerLevel);
+	this->skillpoints = this->level * this->world->settings.GetInt(ConfigKey::SkillPerLevel);
 
 	this->CalculateStats();
 }
@@ -1931,14 +2056,32 @@ std::shared_ptr<Quest_Context> Character::GetQuest(short id)
 
 void Character::ResetQuest(short id)
 {
+	this->QuestChanged();
 	this->quests[id].reset();
 }
 
+void Character::QuestChanged()
+{
+	this->journal_dirty |= JournalQuest;
+	this->quest_data_dirty = true;
+}
+
+const std::string &Character::QuestData()
+{
+	if (this->quest_data_dirty)
+	{
+		this->quest_data = QuestSerialize(this->quests, this->quests_inactive);
+		this->quest_data_dirty = false;
+	}
+
+	return this->quest_data;
+}
+
 void Character::SpikeDamage(int amount)
 {
 	int limitamount = std::min(amount, int(this->hp));
 
-	if (this->world->config["LimitDamage"])
+	if (this->world->settings.GetBool(ConfigKey::LimitDamage))
 	{
 		amount = limitamount;
 	}
@@ -1959,7 +2102,7 @@ void Character::SpikeDamage(int amount)
 
 	this->Send(builder2);
 
-	for (Character *watcher : this->map->CharactersInRange(this->x, this->y, static_cast<int>(this->world->config["SeeDistance"])))
+	for (Character *watcher : this->map->CharactersInRange(this->x, this->y, this->world->settings.GetInt(ConfigKey::SeeDistance)))
 	{
 		if (watcher == this)
 			continue;
@@ -1970,9 +2113,9 @@ void Character::SpikeDamage(int amount)
 
 void Character::DeathRespawn()
 {
-	this->hp = int(this->maxhp * static_cast<double>(this->world->config["DeathRecover"]) / 100.0);
+	this->hp = int(this->maxhp * this->world->settings.GetFloat(ConfigKey::DeathRecover) / 100.0);
 
-	if (this->world->config["Deadly"])
+	if (this->world->settings.GetBool(ConfigKey::Deadly))
 	{
 		this->DropAll(nullptr);
 	}
@@ -1997,7 +2140,7 @@ void Character::DeathRespawn()
 
 void Character::Mute(const Command_Source *by)
 {
-	this->muted_until = time(0) + int(this->world->config["MuteLength"]);
+	this->muted_until = time(0) + this->world->settings.GetInt(ConfigKey::MuteLength);
 	PacketBuilder builder(PACKET_TALK, PACKET_SPEC, by->SourceName().length());
 	builder.AddString(by->SourceName());
 	this->Send(builder);
@@ -2010,18 +2153,18 @@ void Character::PlaySound(unsigned char id)
 	this->Send(builder);
 }
 
-#define v(x) vars[prefix + #x] = x;
-#define vv(x, n) vars[prefix + n] = x;
+#define v(x) frame.Set(side, FV_##x, x);
+#define vv(x, n) frame.Set(side, FV_##n, x);
 
-void Character::FormulaVars(std::unordered_map<std::string, double> &vars, std::string prefix)
+void Character::FormulaVars(Formula_Frame &frame, Formula_Frame::Side side)
 {
-	v(level) vv(exp, "experience") v(hp) v(maxhp) v(tp) v(maxtp) v(maxsp)
+	v(level) vv(exp, experience) v(hp) v(maxhp) v(tp) v(maxtp) v(maxsp)
 		v(weight) v(maxweight) v(karma) v(mindam) v(maxdam)
-			vv(adj_str, "str") vv(adj_intl, "int") vv(adj_wis, "wis") vv(adj_agi, "agi") vv(adj_con, "con") vv(adj_cha, "cha")
-				vv(str, "base_str") vv(intl, "base_int") vv(wis, "base_wis") vv(agi, "base_agi") vv(con, "base_con") vv(cha, "base_cha")
-					v(display_str) vv(display_intl, "display_int") v(display_wis) v(display_agi) v(display_con) v(display_cha)
+			vv(adj_str, str) vv(adj_intl, int) vv(adj_wis, wis) vv(adj_agi, agi) vv(adj_con, con) vv(adj_cha, cha)
+				vv(str, base_str) vv(intl, base_int) vv(wis, base_wis) vv(agi, base_agi) vv(con, base_con) vv(cha, base_cha)
+					v(display_str) vv(display_intl, display_int) v(display_wis) v(display_agi) v(display_con) v(display_cha)
 						v(accuracy) v(evade) v(armor) v(admin) v(bot) v(usage)
-							vv(clas, "class") v(gender) v(race) v(hairstyle) v(haircolor)
+							vv(clas, class) v(gender) v(race) v(hairstyle) v(haircolor)
 								v(mapid) v(x) v(y) v(direction) v(sitting) v(hidden) v(whispers) v(goldbank)
 									v(statpoints) v(skillpoints)
 }
@@ -2153,7 +2296,7 @@ void Character::AddPaperdollData(PacketBuilder &builder, const char *format)
 
 void Character::AddChatLog(std::string marker, std::string name, std::string msg)
 {
-	if (int(chat_log.size()) >= int(this->world->config["ReportChatLogSize"]))
+	if (int(chat_log.size()) >= this->world->settings.GetInt(ConfigKey::ReportChatLogSize))
 		chat_log.pop_front();
 
 	chat_log.push_back(marker + " " + util::ucfirst(name) + ": " + msg);
@@ -2247,6 +2390,7 @@ void Character::Logout()
 	this->map->Leave(this);
 	this->online = false;
 
+	this->WriteJournal(this->world->journal);
 	this->Save();
 
 	this->world->Logout(this);
@@ -2254,9 +2398,11 @@ void Character::Logout()
 
 void Character::Save()
 {
+	TRACE_SCOPE("Character::Save");
+
 	const std::string &quest_data = (!this->quest_string.empty())
 										? this->quest_string
-										: QuestSerialize(this->quests, this->quests_inactive);
+										: this->QuestData();
 
 	int nointeract = this->nointeract;
 
@@ -2279,9 +2425,45 @@ void Character::Save()
 						  this->guild_rank, this->guild_rank_string.c_str(), quest_data.c_str(), "", this->real_name.c_str());
 }
 
+Journal::Stats Character::JournalStats() const
+{
+	Journal::Stats stats;
+	stats.level = this->level;
+	stats.exp = this->exp;
+	stats.statpoints = this->statpoints;
+	stats.skillpoints = this->skillpoints;
+	stats.base = {{this->str, this->intl, this->wis, this->agi, this->con, this->cha}};
+	return stats;
+}
+
+void Character::WriteJournal(Journal &journal)
+{
+	if (!journal.IsOpen())
+	{
+		this->journal_dirty = 0;
+		return;
+	}
+
+	if (this->journal_dirty & JournalItems)
+		journal.WriteItems(this->real_name, ItemSerialize(this->inventory), ItemSerialize(this->bank), DollSerialize(this->paperdoll), this->goldbank);
+
+	if (this->journal_dirty & JournalQuest)
+		journal.WriteQuest(this->real_name, this->QuestData());
+
+	Journal::Stats stats = this->JournalStats();
+
+	if (stats != this->journal_stats)
+	{
+		journal.WriteStats(this->real_name, stats);
+		this->journal_stats = stats;
+	}
+
+	this->journal_dirty = 0;
+}
+
 AdminLevel Character::SourceAccess() const
 {
-	return world->config["UseDutyAdmin"] ? player->Admin() : admin;
+	return world->settings.GetBool(ConfigKey::UseDutyAdmin) ? player->Admin() : admin;
 }
 
 AdminLevel Character::SourceDutyAccess() const
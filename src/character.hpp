@@ -19,6 +19,8 @@
 #include "fwd/world.hpp"
 #include "command_source.hpp"
 #include "eodata.hpp"
+#include "formula_vars.hpp"
+#include "journal.hpp"
 #include "map.hpp"
 
 #include <array>
@@ -165,6 +167,12 @@ public:
 
 	static constexpr int NoInteractAll = 0xFFFF;
 
+	enum JournalFlag
+	{
+		JournalItems = 0x01,
+		JournalQuest = 0x02
+	};
+
 	int login_time;
 	bool online;
 	bool nowhere;
@@ -281,6 +289,19 @@ public:
 	std::set<Character_QuestState> quests_inactive;
 	std::string quest_string;
 
+	/**
+	 * Serialized form of quests and quests_inactive, regenerated by QuestData() after QuestChanged()
+	 */
+	std::string quest_data;
+	bool quest_data_dirty;
+
+	/**
+	 * Changes not yet written to the journal (JournalFlag)
+	 * Stats are compared against the last written values instead.
+	 */
+	int journal_dirty;
+	Journal::Stats journal_stats;
+
 	double last_pot;				  // Time of the last potion used
 	bool auto_potion_enabled;		  // For auto-potion setting
 	void AutoPotion();				  // Declaration for the auto-potion method
@@ -372,7 +393,41 @@ public:
 	unsigned char SpawnX();
 	unsigned char SpawnY();
 	void CheckQuestRules();
+
+	/**
+	 * Checks only the quest rules that could flip because of a change to the given item, spell or map
+	 */
+	void CheckQuestRules(QuestTrigger trigger, short key);
 	void CalculateStats(bool trigger_quests = true);
+
+	/**
+	 * Results of the stat formulas in data/formulas.ini for one character
+	 */
+	struct Stat_Formulas
+	{
+		double hp, tp, sp, weight;
+		double damage, defence, accuracy, evade;
+	};
+
+	/**
+	 * Totals up base stats and equipment bonuses, the first half of CalculateStats()
+	 */
+	void PrepareStats();
+
+	/**
+	 * Adds the stat formula results and clamps everything, the second half of CalculateStats()
+	 */
+	void ApplyStats(const Stat_Formulas &formulas, bool trigger_quests = true);
+
+	/**
+	 * Appends the displayed stats and everything CalculateStats() derives from them, as the client's stat packets lay them out
+	 */
+	void AddStats(PacketBuilder &builder) const;
+
+	/**
+	 * Tells the client its class and stats, after a call to CalculateStats()
+	 */
+	void SendStats();
 	void DropAll(Character *killer);
 	void Hide(int setflags);
 	void Unhide(int unsetflags);
@@ -380,13 +435,23 @@ public:
 	std::shared_ptr<Quest_Context> GetQuest(short id);
 	void ResetQuest(short id);
 
+	/**
+	 * Marks the quest state as changed so it is journaled and re-serialized on the next save
+	 */
+	void QuestChanged();
+
+	/**
+	 * Returns the serialized quest state, only rebuilding it if a quest context changed since the last call
+	 */
+	const std::string &QuestData();
+
 	void SpikeDamage(int amount);
 	void DeathRespawn();
 
 	void Mute(const Command_Source *by);
 	void PlaySound(unsigned char id);
 
-	void FormulaVars(std::unordered_map<std::string, double> &vars, std::string prefix = "");
+	void FormulaVars(Formula_Frame &frame, Formula_Frame::Side side = Formula_Frame::Self);
 
 	void Dress(EquipLocation, unsigned short gfx_id);
 	void Undress();
@@ -400,6 +465,8 @@ public:
 
 	void Logout();
 	void Save();
+	Journal::Stats JournalStats() const;
+	void WriteJournal(Journal &journal);
 
 	AdminLevel SourceAccess() const;
 	AdminLevel SourceDutyAccess() const;
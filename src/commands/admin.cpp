@@ -29,7 +29,7 @@ namespace Commands
 	{
 		World *world = from->world;
 
-		if (!world->config["UseDutyAdmin"])
+		if (!world->settings.GetBool(ConfigKey::UseDutyAdmin))
 		{
 			from->ServerMsg(from->SourceWorld()->i18n.Format("unknown_command"));
 			return;
@@ -89,7 +89,7 @@ namespace Commands
 			reply.AddInt(swap->id);
 			reply.AddShort(swap->mapid); // Map ID
 
-			if (world->config["GlobalPK"] && !world->PKExcept(swap->mapid))
+			if (world->settings.GetBool(ConfigKey::GlobalPK) && !world->PKExcept(swap->mapid))
 			{
 				reply.AddByte(0xFF);
 				reply.AddByte(0x01);
@@ -182,7 +182,7 @@ namespace Commands
 			reply.AddShort(swap->evade);
 			reply.AddShort(swap->armor);
 
-			if (!world->config["OldVersionCompat"] && player->client->version < 28)
+			if (!world->settings.GetBool(ConfigKey::OldVersionCompat) && player->client->version < 28)
 			{
 				reply.AddChar(swap->display_str);
 				reply.AddChar(swap->display_wis);
@@ -206,9 +206,9 @@ namespace Commands
 				reply.AddShort(item);
 			}
 
-			int leader_rank = std::max(std::max(std::max(static_cast<int>(world->config["GuildEditRank"]), static_cast<int>(world->config["GuildKickRank"])),
-												static_cast<int>(world->config["GuildPromoteRank"])),
-									   static_cast<int>(world->config["GuildDemoteRank"]));
+			int leader_rank = std::max(std::max(std::max(world->settings.GetInt(ConfigKey::GuildEditRank), world->settings.GetInt(ConfigKey::GuildKickRank)),
+												world->settings.GetInt(ConfigKey::GuildPromoteRank)),
+									   world->settings.GetInt(ConfigKey::GuildDemoteRank));
 
 			if (swap->guild_rank <= leader_rank && swap->guild)
 			{
@@ -219,7 +219,7 @@ namespace Commands
 				reply.AddChar(swap->guild_rank);
 			}
 
-			reply.AddShort(static_cast<int>(world->config["JailMap"]));
+			reply.AddShort(world->settings.GetInt(ConfigKey::JailMap));
 			reply.AddShort(4); // ?
 			reply.AddChar(24); // ?
 			reply.AddChar(24); // ?
@@ -20,7 +20,7 @@
 #include <string>
 #include <vector>
 
-#include "../hash.hpp"				 // Ensure this is included for sha256
+#include "../password_hasher.hpp"
 #include "../util/secure_string.hpp" // Ensure secure_string is included
 #include "../player.hpp"			 // Include Player header for access to Player methods
 
@@ -66,29 +66,29 @@ namespace Commands
 			bool skillpoints = false;
 
 			if (set == "level")
-				(level = true, victim->level) = std::min(std::max(util::to_int(arguments[1]), 0), int(from->SourceWorld()->config["MaxLevel"]));
+				(level = true, victim->level) = std::min(std::max(util::to_int(arguments[1]), 0), from->SourceWorld()->settings.GetInt(ConfigKey::MaxLevel));
 			else if (set == "exp")
-				(level = true, victim->exp) = std::min(std::max(util::to_int(arguments[1]), 0), int(from->SourceWorld()->config["MaxExp"]));
+				(level = true, victim->exp) = std::min(std::max(util::to_int(arguments[1]), 0), from->SourceWorld()->settings.GetInt(ConfigKey::MaxExp));
 			else if (set == "str")
-				(stats = true, victim->str) = std::min(std::max(util::to_int(arguments[1]), 0), int(from->SourceWorld()->config["MaxStat"]));
+				(stats = true, victim->str) = std::min(std::max(util::to_int(arguments[1]), 0), from->SourceWorld()->settings.GetInt(ConfigKey::MaxStat));
 			else if (set == "int")
-				(stats = true, victim->intl) = std::min(std::max(util::to_int(arguments[1]), 0), int(from->SourceWorld()->config["MaxStat"]));
+				(stats = true, victim->intl) = std::min(std::max(util::to_int(arguments[1]), 0), from->SourceWorld()->settings.GetInt(ConfigKey::MaxStat));
 			else if (set == "wis")
-				(stats = true, victim->wis) = std::min(std::max(util::to_int(arguments[1]), 0), int(from->SourceWorld()->config["MaxStat"]));
+				(stats = true, victim->wis) = std::min(std::max(util::to_int(arguments[1]), 0), from->SourceWorld()->settings.GetInt(ConfigKey::MaxStat));
 			else if (set == "agi")
-				(stats = true, victim->agi) = std::min(std::max(util::to_int(arguments[1]), 0), int(from->SourceWorld()->config["MaxStat"]));
+				(stats = true, victim->agi) = std::min(std::max(util::to_int(arguments[1]), 0), from->SourceWorld()->settings.GetInt(ConfigKey::MaxStat));
 			else if (set == "con")
-				(stats = true, victim->con) = std::min(std::max(util::to_int(arguments[1]), 0), int(from->SourceWorld()->config["MaxStat"]));
+				(stats = true, victim->con) = std::min(std::max(util::to_int(arguments[1]), 0), from->SourceWorld()->settings.GetInt(ConfigKey::MaxStat));
 			else if (set == "cha")
-				(stats = true, victim->cha) = std::min(std::max(util::to_int(arguments[1]), 0), int(from->SourceWorld()->config["MaxStat"]));
+				(stats = true, victim->cha) = std::min(std::max(util::to_int(arguments[1]), 0), from->SourceWorld()->settings.GetInt(ConfigKey::MaxStat));
 			else if (set == "statpoints")
-				(statpoints = true, victim->statpoints) = std::min(std::max(util::to_int(arguments[1]), 0), int(from->SourceWorld()->config["MaxLevel"]) * int(from->SourceWorld()->config["StatPerLevel"]));
+				(statpoints = true, victim->statpoints) = std::min(std::max(util::to_int(arguments[1]), 0), from->SourceWorld()->settings.GetInt(ConfigKey::MaxLevel) * from->SourceWorld()->settings.GetInt(ConfigKey::StatPerLevel));
 			else if (set == "skillpoints")
-				(skillpoints = true, victim->skillpoints) = std::min(std::max(util::to_int(arguments[1]), 0), int(from->SourceWorld()->config["MaxLevel"]) * int(from->SourceWorld()->config["SkillPerLevel"]));
+				(skillpoints = true, victim->skillpoints) = std::min(std::max(util::to_int(arguments[1]), 0), from->SourceWorld()->settings.GetInt(ConfigKey::MaxLevel) * from->SourceWorld()->settings.GetInt(ConfigKey::SkillPerLevel));
 			else if (set == "admin")
 			{
-				int no_interact_default_admin = victim->world->config["NoInteractDefaultAdmin"];
-				int no_interact_default = victim->world->config["NoInteractDefault"];
+				int no_interact_default_admin = victim->world->settings.GetInt(ConfigKey::NoInteractDefaultAdmin);
+				int no_interact_default = victim->world->settings.GetInt(ConfigKey::NoInteractDefault);
 				int hide_level = victim->world->admin_config["hide"];
 
 				AdminLevel level = std::min(std::max(AdminLevel(util::to_int(arguments[1])), ADMIN_PLAYER), ADMIN_HGM);
@@ -129,11 +129,11 @@ namespace Commands
 			else if (set == "gender")
 				(appearance = true, victim->gender) = Gender(std::min(std::max(util::to_int(arguments[1]), 0), 1));
 			else if (set == "hairstyle")
-				(appearance = true, victim->hairstyle) = std::min(std::max(util::to_int(arguments[1]), 0), int(from->SourceWorld()->config["MaxHairStyle"]));
+				(appearance = true, victim->hairstyle) = std::min(std::max(util::to_int(arguments[1]), 0), from->SourceWorld()->settings.GetInt(ConfigKey::MaxHairStyle));
 			else if (set == "haircolor")
-				(appearance = true, victim->haircolor) = std::min(std::max(util::to_int(arguments[1]), 0), int(from->SourceWorld()->config["MaxHairColor"]));
+				(appearance = true, victim->haircolor) = std::min(std::max(util::to_int(arguments[1]), 0), from->SourceWorld()->settings.GetInt(ConfigKey::MaxHairColor));
 			else if (set == "race")
-				(appearance = true, victim->race) = Skin(std::min(std::max(util::to_int(arguments[1]), 0), int(from->SourceWorld()->config["MaxSkin"])));
+				(appearance = true, victim->race) = Skin(std::min(std::max(util::to_int(arguments[1]), 0), from->SourceWorld()->settings.GetInt(ConfigKey::MaxSkin)));
 			else if (set == "guildrank")
 				victim->guild_rank = std::min(std::max(util::to_int(arguments[1]), 0), 9);
 			else if (set == "karma")
@@ -167,25 +167,7 @@ namespace Commands
 				if (level || stats)
 				{
 					victim->CalculateStats();
-
-					PacketBuilder builder(PACKET_RECOVER, PACKET_LIST, 32);
-					builder.AddShort(victim->clas);
-					builder.AddShort(victim->display_str);
-					builder.AddShort(victim->display_intl);
-					builder.AddShort(victim->display_wis);
-					builder.AddShort(victim->display_agi);
-					builder.AddShort(victim->display_con);
-					builder.AddShort(victim->display_cha);
-					builder.AddShort(victim->maxhp);
-					builder.AddShort(victim->maxtp);
-					builder.AddShort(victim->maxsp);
-					builder.AddShort(victim->maxweight);
-					builder.AddShort(victim->mindam);
-					builder.AddShort(victim->maxdam);
-					builder.AddShort(victim->accuracy);
-					builder.AddShort(victim->evade);
-					builder.AddShort(victim->armor);
-					victim->Send(builder);
+					victim->SendStats();
 				}
 
 				if (karma || level)
@@ -432,24 +414,25 @@ namespace Commands
 			return;
 		}
 
+		World *world = from->SourceCharacter()->world;
 		util::secure_string new_password_secured(std::move(std::string(new_password)));
+		std::string admin_name = from->SourceName();
 
-		{
-			std::string password_salt = from->SourceCharacter()->world->config["PasswordSalt"].GetString();
-			util::secure_string password_buffer(std::move(std::string(password_salt) + username + new_password_secured.str()));
-			new_password_secured = sha256(password_buffer.str());
-		}
+		// Hashed on the pool like any other password, the admin may have logged off by the time it finishes
+		world->password_hasher.Hash(world, username, std::move(new_password_secured),
+			[world, username, admin_name](const std::string &password_hash)
+			{
+				Database_Result result = world->db.Query("UPDATE `accounts` SET `password` = '$' WHERE `username` = '$'", password_hash.c_str(), username.c_str());
+				Character *admin = world->GetCharacter(admin_name);
 
-		Database_Result result = from->SourceCharacter()->world->db.Query("UPDATE `accounts` SET `password` = '$' WHERE `username` = '$'", new_password_secured.str().c_str(), username.c_str());
+				if (!admin)
+					return;
 
-		if (result.Error())
-		{
-			from->StatusMsg("Failed to update the password. Please try again.");
-		}
-		else
-		{
-			from->StatusMsg("Password for " + username + " has been successfully changed.");
-		}
+				if (result.Error())
+					admin->StatusMsg("Failed to update the password. Please try again.");
+				else
+					admin->StatusMsg("Password for " + username + " has been successfully changed.");
+			});
 	}
 
 	COMMAND_HANDLER_REGISTER(char_mod)
@@ -62,7 +62,7 @@ namespace Commands
 			if (item)
 			{
 				item->owner = from->PlayerID();
-				item->unprotecttime = Timer::GetTime() + double(from->world->config["ProtectPlayerDrop"]);
+				item->unprotecttime = Timer::GetTime() + from->world->settings.GetFloat(ConfigKey::ProtectPlayerDrop);
 				from->DelItem(id, amount);
 
 				PacketBuilder reply(PACKET_ITEM, PACKET_DROP, 15);
@@ -83,7 +83,7 @@ namespace Commands
 	{
 		int id = util::to_int(arguments[0]);
 		int amount = (arguments.size() >= 2) ? util::to_int(arguments[1]) : 1;
-		unsigned char speed = (arguments.size() >= 3) ? util::to_int(arguments[2]) : int(from->world->config["SpawnNPCSpeed"]);
+		unsigned char speed = (arguments.size() >= 3) ? util::to_int(arguments[2]) : from->world->settings.GetInt(ConfigKey::SpawnNPCSpeed);
 
 		short direction = DIRECTION_DOWN;
 
@@ -134,7 +134,7 @@ namespace Commands
 		short level = -1;
 
 		if (arguments.size() >= 2)
-			level = std::max(0, std::min<int>(from->world->config["MaxSkillLevel"], util::to_int(arguments[1])));
+			level = std::max(0, std::min<int>(from->world->settings.GetInt(ConfigKey::MaxSkillLevel), util::to_int(arguments[1])));
 
 		if (from->AddSpell(skill_id))
 		{
@@ -116,9 +116,9 @@ namespace Commands
 
 	void Board(const std::vector<std::string> &arguments, Character *from)
 	{
-		short boardid = ((arguments.size() >= 1) ? util::to_int(arguments[0]) : int(from->world->config["AdminBoard"])) - 1;
+		short boardid = ((arguments.size() >= 1) ? util::to_int(arguments[0]) : from->world->settings.GetInt(ConfigKey::AdminBoard)) - 1;
 
-		if (boardid != int(from->world->config["AdminBoard"]) - 1 || from->SourceAccess() >= int(from->world->admin_config["reports"]))
+		if (boardid != from->world->settings.GetInt(ConfigKey::AdminBoard) - 1 || from->SourceAccess() >= int(from->world->admin_config["reports"]))
 		{
 			if (std::size_t(boardid) < from->world->boards.size())
 			{
@@ -5,6 +5,7 @@
 
 #include "commands.hpp"
 
+#include "../ban_index.hpp"
 #include "../character.hpp"
 #include "../command_source.hpp"
 #include "../config.hpp"
@@ -13,6 +14,7 @@
 
 #include "../util.hpp"
 
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <vector>
@@ -59,13 +61,55 @@ namespace Commands
 		}
 		else
 		{
-			duration = int(util::tdparse(from->SourceWorld()->config["DefaultBanLength"]));
+			duration = int(from->SourceWorld()->settings.GetFloat(ConfigKey::DefaultBanLength));
 		}
 
 		do_punishment(from, victim, [duration](World *world, Command_Source *from, Character *victim, bool announce)
 					  { world->Ban(from, victim, duration, announce); }, announce);
 	}
 
+	void BanIP(const std::vector<std::string> &arguments, Command_Source *from)
+	{
+		World *world = from->SourceWorld();
+		std::uint32_t address;
+		int prefix;
+		int duration = -1;
+
+		if (!Ban_Index::ParseRange(arguments[0], address, prefix))
+		{
+			from->ServerMsg(world->i18n.Format("invalid_ip_range"));
+			return;
+		}
+
+		if (arguments.size() >= 2)
+		{
+			if (util::lowercase(arguments[1]) != "forever")
+				duration = int(util::tdparse(arguments[1]));
+		}
+		else
+		{
+			duration = int(world->settings.GetFloat(ConfigKey::DefaultBanLength));
+		}
+
+		world->BanIP(from, address, prefix, duration);
+		from->ServerMsg(world->i18n.Format("ban_added", arguments[0]));
+	}
+
+	void Unban(const std::vector<std::string> &arguments, Command_Source *from)
+	{
+		World *world = from->SourceWorld();
+		std::uint32_t address;
+		int prefix;
+		bool removed;
+
+		if (Ban_Index::ParseRange(arguments[0], address, prefix))
+			removed = world->UnbanIP(address, prefix);
+		else
+			removed = world->Unban(util::lowercase(arguments[0]));
+
+		from->ServerMsg(world->i18n.Format(removed ? "ban_removed" : "ban_not_found", arguments[0]));
+	}
+
 	void Jail(const std::vector<std::string> &arguments, Command_Source *from, bool announce = true)
 	{
 		Character *victim = from->SourceWorld()->GetCharacter(arguments[0]);
@@ -76,7 +120,7 @@ namespace Commands
 	{
 		Character *victim = from->SourceWorld()->GetCharacter(arguments[0]);
 
-		if (victim && victim->mapid != static_cast<int>(from->SourceWorld()->config["JailMap"]))
+		if (victim && victim->mapid != from->SourceWorld()->settings.GetInt(ConfigKey::JailMap))
 		{
 			from->ServerMsg(from->SourceWorld()->i18n.Format("command_access_denied"));
 			return;
@@ -100,6 +144,8 @@ namespace Commands
 	Register({"skick", {"victim"}, {}, 2}, std::bind(Kick, _1, _2, false));
 	Register({"ban", {"victim"}, {"duration"}}, std::bind(Ban, _1, _2, true));
 	Register({"sban", {"victim"}, {"duration"}, 2}, std::bind(Ban, _1, _2, false));
+	Register({"banip", {"address"}, {"duration"}, 4}, BanIP);
+	Register({"unban", {"target"}, {}, 3}, Unban);
 	Register({"jail", {"victim"}, {}}, std::bind(Jail, _1, _2, true));
 	Register({"sjail", {"victim"}, {}, 2}, std::bind(Jail, _1, _2, false));
 	Register({"unjail", {"victim"}, {}}, Unjail);
@@ -8,16 +8,28 @@
 #include "../character.hpp"
 #include "../command_source.hpp"
 #include "../config.hpp"
+#include "../database.hpp"
+#include "../eoclient.hpp"
 #include "../eoserver.hpp"
+#include "../eoserv_config.hpp"
 #include "../map.hpp"
+#include "../packet.hpp"
+#include "../player.hpp"
 #include "../timer.hpp"
 #include "../world.hpp"
+#include "../handlers/handlers.hpp"
 
 #include "../console.hpp"
+#include "../trace.hpp"
 #include "../util.hpp"
 
+#include <algorithm>
 #include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <string>
+#include <utility>
 #include <vector>
 
 extern volatile std::sig_atomic_t eoserv_sig_abort;
@@ -42,7 +54,7 @@ namespace Commands
 			{
 				map = world->maps[mapid - 1];
 			}
-			else if (mapid <= static_cast<int>(world->config["Maps"]))
+			else if (mapid <= world->settings.GetInt(ConfigKey::Maps))
 			{
 				isnew = true;
 
@@ -62,24 +74,58 @@ namespace Commands
 
 	void ReloadPub(const std::vector<std::string> &arguments, Command_Source *from)
 	{
-		(void)arguments;
-
-		Console::Out("Pub files reloaded by %s", from->SourceName().c_str());
-
 		bool quiet = true;
 
 		if (arguments.size() >= 1)
 			quiet = (arguments[0] != "announce");
 
-		from->SourceWorld()->ReloadPub(quiet);
+		if (!from->SourceWorld()->ReloadPub(quiet))
+		{
+			from->ServerMsg("A reload is already in progress");
+			return;
+		}
+
+		Console::Out("Pub files reloaded by %s", from->SourceName().c_str());
 	}
 
 	void ReloadConfig(const std::vector<std::string> &arguments, Command_Source *from)
 	{
 		(void)arguments;
 
+		if (!from->SourceWorld()->Rehash())
+		{
+			from->ServerMsg("A reload is already in progress");
+			return;
+		}
+
 		Console::Out("Config reloaded by %s", from->SourceName().c_str());
-		from->SourceWorld()->Rehash();
+	}
+
+	void ShowConfig(const std::vector<std::string> &arguments, Command_Source *from)
+	{
+		const Config_Registry &settings = from->SourceWorld()->settings;
+		std::string filter = (arguments.size() >= 1) ? util::lowercase(arguments[0]) : "";
+		int shown = 0;
+
+		for (std::size_t i = 0; i < ConfigKey::Count; ++i)
+		{
+			ConfigKey::ID key = ConfigKey::ID(i);
+			const Config_Registry::Key_Info &info = Config_Registry::Info(key);
+
+			// Without a filter only the values changed from their defaults are listed
+			if (filter.empty() ? settings.IsDefault(key) : util::lowercase(info.name).find(filter) == std::string::npos)
+				continue;
+
+			bool secret = (key == ConfigKey::DBPass || key == ConfigKey::PasswordSalt || key == ConfigKey::SeoseCompatKey);
+			std::string value = secret ? "********" : settings.Display(key);
+
+			from->ServerMsg(std::string(info.name) + " = " + value + " (" + Config_Registry::TypeName(info.type)
+							+ (info.reload == Config_Registry::Restart ? ", restart" : "") + ")");
+			++shown;
+		}
+
+		if (shown == 0)
+			from->ServerMsg(filter.empty() ? "All config values are at their defaults" : "No matching config values");
 	}
 
 	void ReloadQuest(const std::vector<std::string> &arguments, Command_Source *from)
@@ -107,11 +153,233 @@ namespace Commands
 		from->ServerMsg(buffer);
 	}
 
+	void DatabaseStats(const std::vector<std::string> &arguments, Command_Source *from)
+	{
+		Database_Stats &stats = from->SourceWorld()->db.stats;
+
+		if (arguments.size() >= 1 && arguments[0] == "reset")
+		{
+			stats.Reset();
+			from->ServerMsg("Database statistics reset");
+			return;
+		}
+
+		typedef std::pair<const std::string, Database_Stats::Statement> statement_t;
+		typedef std::pair<const std::string, Database_Stats::Caller> caller_t;
+
+		std::vector<const statement_t *> statements;
+		std::uint64_t total_calls = 0;
+
+		for (const statement_t &statement : stats.Statements())
+		{
+			statements.push_back(&statement);
+			total_calls += statement.second.calls;
+		}
+
+		std::sort(UTIL_RANGE(statements), [](const statement_t *a, const statement_t *b)
+				  { return a->second.latency.sum() > b->second.latency.sum(); });
+
+		from->ServerMsg("Queries: " + util::to_string(int(total_calls)) + ", slow: " + util::to_string(int(stats.SlowQueries())));
+
+		for (std::size_t i = 0; i < std::min<std::size_t>(5, statements.size()); ++i)
+		{
+			const Database_Stats::Statement &statement = statements[i]->second;
+
+			char buffer[128];
+			std::snprintf(buffer, sizeof buffer, "%ix total %ims p99 %.1fms: ", int(statement.calls),
+						  int(statement.latency.sum() / 1000), double(statement.latency.percentile(99.0)) / 1000.0);
+
+			from->ServerMsg(buffer + statements[i]->first.substr(0, 60));
+		}
+
+		std::vector<const caller_t *> callers;
+
+		for (const caller_t &caller : stats.Callers())
+			callers.push_back(&caller);
+
+		std::sort(UTIL_RANGE(callers), [](const caller_t *a, const caller_t *b)
+				  { return a->second.total_us > b->second.total_us; });
+
+		for (std::size_t i = 0; i < std::min<std::size_t>(3, callers.size()); ++i)
+		{
+			from->ServerMsg(callers[i]->first + ": " + util::to_string(int(callers[i]->second.calls)) + " queries, "
+							+ util::to_string(int(callers[i]->second.total_us / 1000)) + "ms");
+		}
+	}
+
+	void HandlerStats(const std::vector<std::string> &arguments, Command_Source *from)
+	{
+		EOServer *server = from->SourceWorld()->server;
+
+		if (arguments.size() >= 1 && arguments[0] == "reset")
+		{
+			Handlers::ResetStats();
+
+			UTIL_FOREACH(server->clients, client)
+			{
+				EOClient *eoclient = static_cast<EOClient *>(client);
+				eoclient->handler_calls = 0;
+				eoclient->handler_us = 0;
+			}
+
+			from->ServerMsg("Handler statistics reset");
+			return;
+		}
+
+		if (arguments.size() >= 1 && arguments[0] == "clients")
+		{
+			std::vector<EOClient *> clients;
+
+			UTIL_FOREACH(server->clients, client)
+				clients.push_back(static_cast<EOClient *>(client));
+
+			std::sort(UTIL_RANGE(clients), [](const EOClient *a, const EOClient *b)
+					  { return a->handler_us > b->handler_us; });
+
+			for (std::size_t i = 0; i < std::min<std::size_t>(5, clients.size()); ++i)
+			{
+				EOClient *client = clients[i];
+				std::string name = static_cast<std::string>(client->GetRemoteAddr());
+
+				if (client->player && client->player->character)
+					name = client->player->character->SourceName() + " (" + name + ")";
+
+				from->ServerMsg(name + ": " + util::to_string(int(client->handler_calls)) + " packets, "
+								+ util::to_string(int(client->handler_us / 1000)) + "ms");
+			}
+
+			return;
+		}
+
+		std::size_t count = 5;
+
+		if (arguments.size() >= 1)
+			count = std::max(1, std::min(20, util::to_int(arguments[0])));
+
+		std::vector<const Handlers::packet_handler *> handlers = Handlers::Registered();
+		std::uint64_t total_calls = 0;
+
+		UTIL_FOREACH(handlers, handler)
+			total_calls += handler->stats->calls;
+
+		std::sort(UTIL_RANGE(handlers), [](const Handlers::packet_handler *a, const Handlers::packet_handler *b)
+				  { return a->stats->latency.sum() > b->stats->latency.sum(); });
+
+		from->ServerMsg("Packets handled: " + util::to_string(int(total_calls)));
+
+		for (std::size_t i = 0; i < std::min(count, handlers.size()); ++i)
+		{
+			const Handlers::packet_handler::Stats &stats = *handlers[i]->stats;
+
+			if (stats.calls == 0)
+				break;
+
+			char buffer[128];
+			std::snprintf(buffer, sizeof buffer, "%ix total %ims p99 %.2fms: ", int(stats.calls),
+						  int(stats.latency.sum() / 1000), double(stats.latency.percentile(99.0)) / 1000.0);
+
+			from->ServerMsg(buffer + handlers[i]->name);
+		}
+	}
+
+	void StartTrace(const std::vector<std::string> &arguments, Command_Source *from)
+	{
+		World *world = from->SourceWorld();
+
+		if (arguments.size() >= 1 && arguments[0] == "stop")
+		{
+			if (!Trace::Active())
+			{
+				from->ServerMsg("No trace is running");
+				return;
+			}
+
+			Trace::Stop();
+			from->ServerMsg("Trace stopped");
+			return;
+		}
+
+		double seconds = world->settings.GetFloat(ConfigKey::TraceLength);
+
+		if (arguments.size() >= 1)
+			seconds = std::max(1, std::min(600, util::to_int(arguments[0])));
+
+		if (Trace::Active())
+		{
+			from->ServerMsg("A trace is already running");
+			return;
+		}
+
+		if (!world->server->StartTrace(seconds))
+		{
+			from->ServerMsg("Could not create the trace file");
+			return;
+		}
+
+		Console::Out("Trace started by %s", from->SourceName().c_str());
+		from->ServerMsg("Tracing for " + util::to_string(int(seconds)) + " seconds");
+	}
+
+	void StartCapture(const std::vector<std::string> &arguments, Command_Source *from)
+	{
+		World *world = from->SourceWorld();
+
+		if (arguments.size() >= 1 && arguments[0] == "stop")
+		{
+			if (!world->server->Capturing())
+			{
+				from->ServerMsg("No capture is running");
+				return;
+			}
+
+			world->server->StopCapture();
+			from->ServerMsg("Capture stopped");
+			return;
+		}
+
+		double seconds = world->settings.GetFloat(ConfigKey::CaptureLength);
+
+		if (arguments.size() >= 1)
+			seconds = std::max(1, std::min(86400, util::to_int(arguments[0])));
+
+		if (world->server->Capturing())
+		{
+			from->ServerMsg("A capture is already running");
+			return;
+		}
+
+		if (!world->server->StartCapture(seconds))
+		{
+			from->ServerMsg("Could not create the capture file");
+			return;
+		}
+
+		Console::Out("Capture started by %s", from->SourceName().c_str());
+		from->ServerMsg("Capturing for " + util::to_string(int(seconds)) + " seconds");
+	}
+
+	void RecalculateStats(const std::vector<std::string> &arguments, Command_Source *from)
+	{
+		(void)arguments;
+
+		World *world = from->SourceWorld();
+		world->RecalculateStats();
+
+		Console::Out("Stats recalculated by %s", from->SourceName().c_str());
+		from->ServerMsg("Recalculated stats for " + util::to_string(int(world->characters.size())) + " characters");
+	}
+
 	COMMAND_HANDLER_REGISTER(server)
 	RegisterCharacter({"remap", {}, {"mapid"}, 3}, ReloadMap);
 	Register({"repub", {}, {"announce"}, 3}, ReloadPub);
 	Register({"rehash"}, ReloadConfig);
+	Register({"config", {}, {"filter"}, 3}, ShowConfig);
 	Register({"request", {}, {}, 3}, ReloadQuest);
+	Register({"dbstats", {}, {"reset"}, 3}, DatabaseStats);
+	Register({"handlerstats", {}, {"count"}, 4}, HandlerStats);
+	Register({"trace", {}, {"seconds"}, 5}, StartTrace);
+	Register({"capture", {}, {"seconds"}, 4}, StartCapture);
+	Register({"restat", {}, {}, 4}, RecalculateStats);
 	Register({"shutdown", {}, {}, 8}, Shutdown);
 	Register({"uptime"}, Uptime);
 	COMMAND_HANDLER_REGISTER_END(server)
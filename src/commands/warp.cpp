@@ -25,7 +25,7 @@ namespace Commands
 		int x = util::to_int(arguments[1]);
 		int y = util::to_int(arguments[2]);
 
-		bool bubbles = from->world->config["WarpBubbles"] && !from->IsHideWarp();
+		bool bubbles = from->world->settings.GetBool(ConfigKey::WarpBubbles) && !from->IsHideWarp();
 		from->Warp(map, x, y, bubbles ? WARP_ANIMATION_ADMIN : WARP_ANIMATION_NONE);
 	}
 
@@ -41,7 +41,7 @@ namespace Commands
 		{
 			if (victim->SourceAccess() < int(from->world->admin_config["cmdprotect"]) || victim->SourceAccess() <= from->SourceAccess())
 			{
-				bool bubbles = from->world->config["WarpBubbles"] && !from->IsHideWarp() && !victim->IsHideWarp();
+				bool bubbles = from->world->settings.GetBool(ConfigKey::WarpBubbles) && !from->IsHideWarp() && !victim->IsHideWarp();
 				from->Warp(victim->mapid, victim->x, victim->y, bubbles ? WARP_ANIMATION_ADMIN : WARP_ANIMATION_NONE);
 			}
 			else
@@ -63,7 +63,7 @@ namespace Commands
 		{
 			if (victim->SourceAccess() < int(from->world->admin_config["cmdprotect"]) || victim->SourceAccess() <= from->SourceAccess())
 			{
-				bool bubbles = from->world->config["WarpBubbles"] && !from->IsHideWarp() && !victim->IsHideWarp();
+				bool bubbles = from->world->settings.GetBool(ConfigKey::WarpBubbles) && !from->IsHideWarp() && !victim->IsHideWarp();
 				victim->Warp(from->mapid, from->x, from->y, bubbles ? WARP_ANIMATION_ADMIN : WARP_ANIMATION_NONE);
 			}
 			else
@@ -77,7 +77,7 @@ namespace Commands
 	{
 		UTIL_FOREACH(from->world->characters, character)
 		{
-			if (character->mapid != static_cast<int>(from->world->config["JailMap"]))
+			if (character->mapid != from->world->settings.GetInt(ConfigKey::JailMap))
 			{
 				// character->ServerMsg("The Admins has warped everyone for a special reason, listen for details." );
 				character->ServerMsg("Hey " + (util::ucfirst(character->SourceName()) + ", The Admins has warped everyone for a special reason, listen for details."));
@@ -102,7 +102,7 @@ namespace Commands
 		{
 			if (victim->admin < int(from->world->admin_config["cmdprotect"]) || victim->admin <= from->SourceAccess())
 			{
-				victim->Warp(map, x, y, from->world->config["WarpBubbles"] ? WARP_ANIMATION_ADMIN : WARP_ANIMATION_NONE);
+				victim->Warp(map, x, y, from->world->settings.GetBool(ConfigKey::WarpBubbles) ? WARP_ANIMATION_ADMIN : WARP_ANIMATION_NONE);
 			}
 			else
 			{
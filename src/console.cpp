@@ -8,6 +8,7 @@
 #include <cstdarg>
 #include <cstdio>
 #include <ctime>
+#include <mutex>
 #include <string>
 
 #include "platform.h"
@@ -21,6 +22,9 @@ namespace Console
 
 	bool Styled[2] = {true, true};
 
+	// Background loaders log too, keep their lines from interleaving with the game thread's
+	static std::mutex output_mutex;
+
 	static int day = -1;
 
 #ifdef WIN32
@@ -101,6 +105,7 @@ namespace Console
 #define CONSOLE_GENERIC_OUT(prefix, stream, color, bold)     \
 	do                                                       \
 	{                                                        \
+		std::lock_guard<std::mutex> lock(output_mutex);      \
 		FILE *fh = (stream == STREAM_OUT) ? stdout : stderr; \
 		if (Styled[stream])                                  \
 			SetTextColor(stream, COLOR_GREY, false);         \
@@ -11,15 +11,20 @@
 #include "database.hpp"
 
 #include "console.hpp"
+#include "trace.hpp"
 #include "util.hpp"
 #include "util/variant.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <cstdarg>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <exception>
+#include <iterator>
 #include <list>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -35,6 +40,17 @@
 #endif // DATABASE_SQLITE
 #endif // DATABASE_MYSQL
 
+#ifdef DATABASE_SQLITE
+/**
+ * Prepared statement along with the format it was made from, in case the format's memory has since been reused
+ */
+struct SQLite_Statement
+{
+	std::string format;
+	sqlite3_stmt *stmt;
+};
+#endif // DATABASE_SQLITE
+
 struct Database::impl_
 {
 	union
@@ -46,40 +62,259 @@ struct Database::impl_
 		sqlite3 *sqlite_handle;
 #endif // DATABASE_SQLITE
 	};
+
+#ifdef DATABASE_SQLITE
+	std::unordered_map<const char *, SQLite_Statement> sqlite_statements;
+#endif // DATABASE_SQLITE
 };
 
-static int sqlite_callback(void *data, int num, char *fields[], char *columns[])
+struct Database::SQLite_Bind
 {
-	std::unordered_map<std::string, util::variant> result;
-	std::string column;
-	util::variant field;
-	int i;
+	bool is_int;
+	int int_value;
+	const char *text_value;
+};
+
+#ifdef DATABASE_SQLITE
+// Prepared statements kept before the cache is flushed, only reached if many formats are built at runtime
+static const std::size_t sqlite_statement_cache_max = 256;
+
+static void sqlite_clear_statements(std::unordered_map<const char *, SQLite_Statement> &statements)
+{
+	for (auto &statement : statements)
+		sqlite3_finalize(statement.second.stmt);
+
+	statements.clear();
+}
+
+/**
+ * Returns true if a Query() format splices text in with '@' or an unquoted '$', so its statement differs from call to call
+ */
+static bool sqlite_format_spliced(const char *format)
+{
+	for (const char *p = format; *p != '\0'; ++p)
+	{
+		if (p[0] == '\'' && p[1] == '$' && p[2] == '\'')
+			p += 2;
+		else if (*p == '@' || *p == '$')
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * Statement text for a format with no spliced text, with a parameter for every '#' and '$'
+ */
+static std::string sqlite_format_statement(const char *format)
+{
+	std::string query;
 
-	for (i = 0; i < num; ++i)
+	for (const char *p = format; *p != '\0'; ++p)
 	{
-		if (columns[i] == NULL)
+		if (*p == '#')
+		{
+			query += '?';
+		}
+		else if (p[0] == '\'' && p[1] == '$' && p[2] == '\'')
 		{
-			column = "";
+			query += '?';
+			p += 2;
 		}
 		else
 		{
-			column = columns[i];
+			query += *p;
 		}
+	}
+
+	return query;
+}
+#endif // DATABASE_SQLITE
+
+#ifdef DATABASE_SQLITE
+static std::vector<std::string> sqlite_columns(sqlite3_stmt *stmt)
+{
+	int num = sqlite3_column_count(stmt);
+	std::vector<std::string> columns;
+	columns.reserve(num);
+
+	for (int i = 0; i < num; ++i)
+	{
+		const char *name = sqlite3_column_name(stmt, i);
+		columns.push_back(name ? name : "");
+	}
 
-		if (fields[i] == NULL)
+	return columns;
+}
+
+static void sqlite_fetch_row(Database_Result &result, sqlite3_stmt *stmt)
+{
+	int num = sqlite3_column_count(stmt);
+
+	for (int i = 0; i < num; ++i)
+	{
+		if (sqlite3_column_type(stmt, i) == SQLITE_INTEGER)
 		{
-			field = "";
+			result.AddInt(sqlite3_column_int(stmt, i));
 		}
 		else
 		{
-			field = fields[i];
+			const unsigned char *text = sqlite3_column_text(stmt, i);
+			std::size_t length = sqlite3_column_bytes(stmt, i);
+
+			result.AddString(text ? reinterpret_cast<const char *>(text) : "", text ? length : 0);
 		}
+	}
 
-		result.insert(result.begin(), make_pair(column, field));
+	result.EndRow();
+}
+#endif // DATABASE_SQLITE
+
+#ifdef DATABASE_MYSQL
+static std::vector<std::string> mysql_columns(MYSQL_FIELD *fields, int num_fields)
+{
+	std::vector<std::string> columns;
+	columns.reserve(num_fields);
+
+	for (int i = 0; i < num_fields; ++i)
+	{
+		if (!fields[i].name)
+		{
+			throw Database_QueryFailed("libMySQL critical failure!");
+		}
+
+		columns.push_back(fields[i].name);
+	}
+
+	return columns;
+}
+
+static void mysql_fetch_row_into(Database_Result &result, MYSQL_RES *mresult, MYSQL_FIELD *fields, int num_fields, MYSQL_ROW row)
+{
+	unsigned long *lengths = mysql_fetch_lengths(mresult);
+
+	for (int i = 0; i < num_fields; ++i)
+	{
+		if (IS_NUM(fields[i].type))
+		{
+			result.AddInt(row[i] ? util::to_int(row[i]) : 0);
+		}
+		else
+		{
+			result.AddString(row[i] ? row[i] : "", row[i] ? lengths[i] : 0);
+		}
 	}
 
-	static_cast<Database *>(data)->callbackdata.push_back(result);
-	return 0;
+	result.EndRow();
+}
+#endif // DATABASE_MYSQL
+
+int Database_Result::Value::GetInt() const
+{
+	const Cell &c = this->result->cells[this->cell];
+
+	if (!c.is_string)
+		return c.val_int;
+
+	return static_cast<int>(util::tdparse(std::string(this->result->text, c.offset, c.length)));
+}
+
+std::string Database_Result::Value::GetString() const
+{
+	const Cell &c = this->result->cells[this->cell];
+
+	if (c.is_string)
+		return std::string(this->result->text, c.offset, c.length);
+
+	return util::to_string(c.val_int);
+}
+
+bool Database_Result::Value::IsInt() const
+{
+	return !this->result->cells[this->cell].is_string;
+}
+
+util::variant Database_Result::Value::GetVariant() const
+{
+	if (this->IsInt())
+		return util::variant(this->GetInt());
+
+	return util::variant(this->GetString());
+}
+
+std::size_t Database_Result::Row::size() const
+{
+	return this->result->columns.size();
+}
+
+Database_Result::Value Database_Result::Row::operator[](int column) const
+{
+	return Value(this->result, this->row * this->result->columns.size() + column);
+}
+
+util::variant Database_Result::Row::operator[](const char *column) const
+{
+	int i = this->result->ColumnIndex(column);
+
+	if (i == -1)
+		return util::variant("");
+
+	return (*this)[i].GetVariant();
+}
+
+util::variant Database_Result::Row::operator[](const std::string &column) const
+{
+	return (*this)[column.c_str()];
+}
+
+Database_Result::Row::operator std::unordered_map<std::string, util::variant>() const
+{
+	std::unordered_map<std::string, util::variant> result;
+
+	for (std::size_t i = 0; i < this->result->columns.size(); ++i)
+		result[this->result->columns[i]] = (*this)[int(i)].GetVariant();
+
+	return result;
+}
+
+void Database_Result::SetColumns(std::vector<std::string> &&columns)
+{
+	this->columns = std::move(columns);
+	this->ClearRows();
+}
+
+void Database_Result::AddInt(int value)
+{
+	this->cells.push_back(Cell{value, 0, 0, false});
+}
+
+void Database_Result::AddString(const char *value, std::size_t length)
+{
+	this->cells.push_back(Cell{0, std::uint32_t(this->text.size()), std::uint32_t(length), true});
+	this->text.append(value, length);
+}
+
+void Database_Result::EndRow()
+{
+	++this->rows;
+}
+
+void Database_Result::ClearRows()
+{
+	this->cells.clear();
+	this->text.clear();
+	this->rows = 0;
+}
+
+int Database_Result::ColumnIndex(const char *column) const
+{
+	for (std::size_t i = 0; i < this->columns.size(); ++i)
+	{
+		if (this->columns[i] == column)
+			return int(i);
+	}
+
+	return -1;
 }
 
 int Database_Result::AffectedRows()
@@ -92,6 +327,143 @@ bool Database_Result::Error()
 	return this->error;
 }
 
+struct Database_Cursor::impl_
+{
+	Database::Engine engine;
+
+#ifdef DATABASE_MYSQL
+	MYSQL_RES *mresult = nullptr;
+	MYSQL_FIELD *fields = nullptr;
+	int num_fields = 0;
+#endif // DATABASE_MYSQL
+
+#ifdef DATABASE_SQLITE
+	sqlite3_stmt *stmt = nullptr;
+#endif // DATABASE_SQLITE
+};
+
+Database_Cursor::Database_Cursor(Database &db, const char *query)
+	: impl(new impl_)
+{
+	this->impl->engine = db.engine;
+
+	switch (db.engine)
+	{
+#ifdef DATABASE_MYSQL
+	case Database::MySQL:
+		if (mysql_real_query(db.impl->mysql_handle, query, std::strlen(query)) != 0)
+		{
+			throw Database_QueryFailed(mysql_error(db.impl->mysql_handle));
+		}
+
+		if ((this->impl->mresult = mysql_use_result(db.impl->mysql_handle)) == 0)
+		{
+			throw Database_QueryFailed(mysql_field_count(db.impl->mysql_handle) == 0 ? "Query did not return any rows" : mysql_error(db.impl->mysql_handle));
+		}
+
+		this->impl->num_fields = mysql_num_fields(this->impl->mresult);
+		this->impl->fields = mysql_fetch_fields(this->impl->mresult);
+		this->current.SetColumns(mysql_columns(this->impl->fields, this->impl->num_fields));
+		break;
+#endif // DATABASE_MYSQL
+
+#ifdef DATABASE_SQLITE
+	case Database::SQLite:
+		if (sqlite3_prepare_v2(db.impl->sqlite_handle, query, -1, &this->impl->stmt, nullptr) != SQLITE_OK)
+		{
+			throw Database_QueryFailed(sqlite3_errmsg(db.impl->sqlite_handle));
+		}
+
+		if (!this->impl->stmt)
+		{
+			throw Database_QueryFailed("Empty query");
+		}
+
+		this->current.SetColumns(sqlite_columns(this->impl->stmt));
+		break;
+#endif // DATABASE_SQLITE
+
+	default:
+		throw Database_QueryFailed("Unknown database engine");
+	}
+}
+
+Database_Cursor::Database_Cursor(Database_Cursor &&other)
+	: impl(std::move(other.impl)), current(std::move(other.current))
+{
+}
+
+bool Database_Cursor::Next()
+{
+	if (!this->impl)
+		return false;
+
+	this->current.ClearRows();
+
+	switch (this->impl->engine)
+	{
+#ifdef DATABASE_MYSQL
+	case Database::MySQL:
+	{
+		MYSQL_ROW row = mysql_fetch_row(this->impl->mresult);
+
+		if (!row)
+			return false;
+
+		mysql_fetch_row_into(this->current, this->impl->mresult, this->impl->fields, this->impl->num_fields, row);
+		return true;
+	}
+#endif // DATABASE_MYSQL
+
+#ifdef DATABASE_SQLITE
+	case Database::SQLite:
+	{
+		int step_result = sqlite3_step(this->impl->stmt);
+
+		if (step_result == SQLITE_ROW)
+		{
+			sqlite_fetch_row(this->current, this->impl->stmt);
+			return true;
+		}
+		else if (step_result != SQLITE_DONE)
+		{
+			throw Database_QueryFailed(sqlite3_errmsg(sqlite3_db_handle(this->impl->stmt)));
+		}
+
+		return false;
+	}
+#endif // DATABASE_SQLITE
+
+	default:
+		return false;
+	}
+}
+
+Database_Cursor::~Database_Cursor()
+{
+	if (!this->impl)
+		return;
+
+	switch (this->impl->engine)
+	{
+#ifdef DATABASE_MYSQL
+	case Database::MySQL:
+		// Also discards any rows that were not fetched
+		if (this->impl->mresult)
+			mysql_free_result(this->impl->mresult);
+		break;
+#endif // DATABASE_MYSQL
+
+#ifdef DATABASE_SQLITE
+	case Database::SQLite:
+		sqlite3_finalize(this->impl->stmt);
+		break;
+#endif // DATABASE_SQLITE
+
+	default:;
+	}
+}
+
 Database::Bulk_Query_Context::Bulk_Query_Context(Database &db)
 	: db(db), pending(false)
 {
@@ -136,8 +508,8 @@ Database::Database()
 }
 
 Database::Database(Database::Engine type, const std::string &host, unsigned short port, const std::string &user, const std::string &pass, const std::string &db, bool connectnow)
+	: impl(new impl_), connected(false), engine(type), in_transaction(false)
 {
-	this->connected = false;
 
 	if (connectnow)
 	{
@@ -264,13 +636,78 @@ void Database::Close()
 
 #ifdef DATABASE_SQLITE
 	case SQLite:
+		sqlite_clear_statements(this->impl->sqlite_statements);
 		sqlite3_close(this->impl->sqlite_handle);
 		break;
 #endif // DATABASE_SQLITE
 	}
 }
 
+void Database::SetSQLiteOptions(const SQLite_Options &options)
+{
+	this->sqlite_options = options;
+
+	if (this->engine != SQLite || !this->connected)
+		return;
+
+	if (options.wal)
+		this->RawQuery("PRAGMA journal_mode = WAL");
+
+	if (!options.synchronous.empty())
+	{
+		static const char *const levels[] = {"off", "normal", "full", "extra", "0", "1", "2", "3"};
+		std::string synchronous = util::lowercase(options.synchronous);
+
+		if (std::find(std::begin(levels), std::end(levels), synchronous) != std::end(levels))
+			this->RawQuery(("PRAGMA synchronous = " + synchronous).c_str());
+		else
+			Console::Wrn("Unknown SQLite synchronous level: %s (leaving it unchanged)", options.synchronous.c_str());
+	}
+
+	if (options.cache_size != 0)
+		this->RawQuery(("PRAGMA cache_size = " + util::to_string(-options.cache_size)).c_str());
+
+	if (options.mmap_size != 0)
+		this->RawQuery(("PRAGMA mmap_size = " + std::to_string(static_cast<long long>(options.mmap_size) * 1024)).c_str());
+}
+
 Database_Result Database::RawQuery(const char *query, bool tx_control)
+{
+	return this->RawQuery(query, tx_control, 0);
+}
+
+template <class F>
+Database_Result Database::Timed(const char *statement, bool raw, F execute)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	auto elapsed_us = [start]()
+	{
+		return std::uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+	};
+
+	try
+	{
+		Database_Result result = execute();
+		this->stats.Record(statement, raw, elapsed_us(), result.size(), false);
+		return result;
+	}
+	catch (Database_Exception &)
+	{
+		this->stats.Record(statement, raw, elapsed_us(), 0, true);
+		throw;
+	}
+}
+
+Database_Result Database::RawQuery(const char *query, bool tx_control, const char *statement)
+{
+	TRACE_SCOPE("Database::RawQuery");
+
+	return this->Timed(statement ? statement : query, !statement, [&]()
+					   { return this->ExecuteRaw(query, tx_control); });
+}
+
+Database_Result Database::ExecuteRaw(const char *query, [[maybe_unused]] bool tx_control)
 {
 	if (!this->connected)
 	{
@@ -419,47 +856,21 @@ Database_Result Database::RawQuery(const char *query, bool tx_control)
 
 		fields = mysql_fetch_fields(mresult);
 
-		for (int i = 0; i < num_fields; ++i)
+		try
 		{
-			if (!fields[i].name)
-			{
-				throw Database_QueryFailed("libMySQL critical failure!");
-			}
+			result.SetColumns(mysql_columns(fields, num_fields));
+		}
+		catch (...)
+		{
+			mysql_free_result(mresult);
+			throw;
 		}
 
-		result.resize(mysql_num_rows(mresult));
-		int i = 0;
+		result.cells.reserve(std::size_t(mysql_num_rows(mresult)) * num_fields);
+
 		for (MYSQL_ROW row = mysql_fetch_row(mresult); row != 0; row = mysql_fetch_row(mresult))
 		{
-			std::unordered_map<std::string, util::variant> resrow;
-			for (int ii = 0; ii < num_fields; ++ii)
-			{
-				util::variant rescell;
-				if (IS_NUM(fields[ii].type))
-				{
-					if (row[ii])
-					{
-						rescell = util::to_int(row[ii]);
-					}
-					else
-					{
-						rescell = 0;
-					}
-				}
-				else
-				{
-					if (row[ii])
-					{
-						rescell = row[ii];
-					}
-					else
-					{
-						rescell = "";
-					}
-				}
-				resrow[fields[ii].name] = rescell;
-			}
-			result[i++] = resrow;
+			mysql_fetch_row_into(result, mresult, fields, num_fields, row);
 		}
 
 		mysql_free_result(mresult);
@@ -469,13 +880,50 @@ Database_Result Database::RawQuery(const char *query, bool tx_control)
 
 #ifdef DATABASE_SQLITE
 	case SQLite:
-		if (sqlite3_exec(this->impl->sqlite_handle, query, sqlite_callback, (void *)this, 0) != SQLITE_OK)
+	{
+		const char *tail = query;
+
+		while (*tail != '\0')
 		{
-			throw Database_QueryFailed(sqlite3_errmsg(this->impl->sqlite_handle));
+			sqlite3_stmt *stmt = nullptr;
+
+			if (sqlite3_prepare_v2(this->impl->sqlite_handle, tail, -1, &stmt, &tail) != SQLITE_OK)
+			{
+				throw Database_QueryFailed(sqlite3_errmsg(this->impl->sqlite_handle));
+			}
+
+			// Whitespace or comments only
+			if (!stmt)
+				continue;
+
+			int num_fields = sqlite3_column_count(stmt);
+			bool first_rows = result.columns.empty();
+			int step_result;
+
+			while ((step_result = sqlite3_step(stmt)) == SQLITE_ROW)
+			{
+				if (first_rows)
+				{
+					result.SetColumns(sqlite_columns(stmt));
+					first_rows = false;
+				}
+
+				if (std::size_t(num_fields) == result.columns.size())
+					sqlite_fetch_row(result, stmt);
+			}
+
+			sqlite3_finalize(stmt);
+
+			if (step_result != SQLITE_DONE)
+			{
+				throw Database_QueryFailed(sqlite3_errmsg(this->impl->sqlite_handle));
+			}
+
+			if (num_fields == 0)
+				result.affected_rows = sqlite3_changes(this->impl->sqlite_handle);
 		}
-		result = this->callbackdata;
-		this->callbackdata.clear();
-		break;
+	}
+	break;
 #endif // DATABASE_SQLITE
 
 	default:
@@ -495,6 +943,56 @@ Database_Result Database::Query(const char *format, ...)
 	std::va_list ap;
 	va_start(ap, format);
 
+#ifdef DATABASE_SQLITE
+	// Multi-statement formats can not be prepared as one statement
+	if (this->engine == SQLite && this->sqlite_options.prepared_statements && !std::strchr(format, ';'))
+	{
+		// Most formats are cached by their address and only need their arguments collected
+		// The text is only built here for the few that splice text in, which are prepared fresh every time
+		bool spliced = sqlite_format_spliced(format);
+		std::string query;
+		std::vector<SQLite_Bind> binds;
+
+		for (const char *p = format; *p != '\0'; ++p)
+		{
+			if (*p == '#')
+			{
+				if (spliced)
+					query += '?';
+
+				binds.push_back({true, va_arg(ap, int), nullptr});
+			}
+			else if (*p == '@')
+			{
+				query += va_arg(ap, char *);
+			}
+			else if (p[0] == '\'' && p[1] == '$' && p[2] == '\'')
+			{
+				if (spliced)
+					query += '?';
+
+				binds.push_back({false, 0, va_arg(ap, char *)});
+				p += 2;
+			}
+			else if (*p == '$')
+			{
+				char *escaped = sqlite3_mprintf("%q", va_arg(ap, char *));
+				query += escaped;
+				sqlite3_free(escaped);
+			}
+			else if (spliced)
+			{
+				query += *p;
+			}
+		}
+
+		va_end(ap);
+
+		return this->Timed(format, false, [&]()
+						   { return this->ExecutePrepared(format, spliced ? query.c_str() : nullptr, binds); });
+	}
+#endif // DATABASE_SQLITE
+
 	std::string finalquery;
 	int tempi;
 	char *tempc;
@@ -545,7 +1043,181 @@ Database_Result Database::Query(const char *format, ...)
 
 	va_end(ap);
 
-	return this->RawQuery(finalquery.c_str());
+	return this->RawQuery(finalquery.c_str(), false, format);
+}
+
+Database_Result Database::ExecutePrepared(const char *format, const char *query, const std::vector<SQLite_Bind> &binds)
+{
+	if (!this->connected)
+	{
+		throw Database_QueryFailed("Not connected to database.");
+	}
+
+	Database_Result result;
+
+#ifdef DATABASE_DEBUG
+	Console::Dbg("%s", query.c_str());
+#endif // DATABASE_DEBUG
+
+#ifdef DATABASE_SQLITE
+	// Runs the statement once, returning the SQLite result code of the first failure
+	auto execute = [&]() -> int
+	{
+		sqlite3_stmt *stmt = nullptr;
+
+		// Spliced statements are used once and finalized after the reset below
+		std::unique_ptr<sqlite3_stmt, int (*)(sqlite3_stmt *)> uncached(nullptr, sqlite3_finalize);
+
+		if (query)
+		{
+			int prepare_result = sqlite3_prepare_v2(this->impl->sqlite_handle, query, -1, &stmt, nullptr);
+
+			if (prepare_result != SQLITE_OK)
+				return prepare_result;
+
+			uncached.reset(stmt);
+		}
+		else
+		{
+			auto it = this->impl->sqlite_statements.find(format);
+
+			if (it != this->impl->sqlite_statements.end() && it->second.format == format)
+			{
+				stmt = it->second.stmt;
+			}
+			else
+			{
+				std::string statement = sqlite_format_statement(format);
+
+#if SQLITE_VERSION_NUMBER >= 3020000
+				int prepare_result = sqlite3_prepare_v3(this->impl->sqlite_handle, statement.c_str(), int(statement.length()), SQLITE_PREPARE_PERSISTENT, &stmt, nullptr);
+#else  // SQLITE_VERSION_NUMBER >= 3020000
+				int prepare_result = sqlite3_prepare_v2(this->impl->sqlite_handle, statement.c_str(), int(statement.length()), &stmt, nullptr);
+#endif // SQLITE_VERSION_NUMBER >= 3020000
+
+				if (prepare_result != SQLITE_OK)
+					return prepare_result;
+
+				if (it != this->impl->sqlite_statements.end())
+				{
+					sqlite3_finalize(it->second.stmt);
+					this->impl->sqlite_statements.erase(it);
+				}
+
+				if (stmt)
+				{
+					if (this->impl->sqlite_statements.size() >= sqlite_statement_cache_max)
+						sqlite_clear_statements(this->impl->sqlite_statements);
+
+					this->impl->sqlite_statements.emplace(format, SQLite_Statement{format, stmt});
+				}
+			}
+		}
+
+		// Whitespace or comments only
+		if (!stmt)
+			return SQLITE_OK;
+
+		// Statements must be reset before a transaction can be committed
+		struct reset_guard
+		{
+			sqlite3_stmt *stmt;
+
+			~reset_guard()
+			{
+				sqlite3_reset(stmt);
+				sqlite3_clear_bindings(stmt);
+			}
+		} guard{stmt};
+
+		for (std::size_t i = 0; i < binds.size(); ++i)
+		{
+			if (binds[i].is_int)
+				sqlite3_bind_int(stmt, int(i + 1), binds[i].int_value);
+			else
+				sqlite3_bind_text(stmt, int(i + 1), binds[i].text_value, -1, SQLITE_STATIC);
+		}
+
+		int num_fields = sqlite3_column_count(stmt);
+		int step_result;
+
+		while ((step_result = sqlite3_step(stmt)) == SQLITE_ROW)
+		{
+			if (result.columns.empty())
+				result.SetColumns(sqlite_columns(stmt));
+
+			sqlite_fetch_row(result, stmt);
+		}
+
+		if (step_result != SQLITE_DONE)
+			return step_result;
+
+		if (num_fields == 0)
+			result.affected_rows = sqlite3_changes(this->impl->sqlite_handle);
+
+		return SQLITE_OK;
+	};
+
+	for (int recovery_attempt = 0;;)
+	{
+		if (this->connected)
+		{
+			result = Database_Result();
+			int error = execute();
+
+			if (error == SQLITE_OK)
+				break;
+
+			// Only a lost database file is worth re-opening, and not part way through a transaction that can't be replayed
+			int primary_error = error & 0xFF;
+
+			if (this->in_transaction || (primary_error != SQLITE_IOERR && primary_error != SQLITE_CANTOPEN))
+			{
+				throw Database_QueryFailed(sqlite3_errmsg(this->impl->sqlite_handle));
+			}
+		}
+
+		if (++recovery_attempt > 10)
+		{
+			Console::Err("Could not re-connect to database. Halting server.");
+			std::terminate();
+		}
+
+		Console::Wrn("Connection to database lost! Attempting to reconnect... (Attempt %i / 10)", recovery_attempt);
+		this->Close();
+		util::sleep(2.0 * recovery_attempt);
+
+		try
+		{
+			this->Connect(this->engine, this->host, this->port, this->user, this->pass, this->db);
+			this->SetSQLiteOptions(this->sqlite_options);
+		}
+		catch (const Database_Exception &e)
+		{
+			Console::Err("Connection failed: %s", e.error());
+		}
+	}
+#else  // DATABASE_SQLITE
+	(void)format;
+	(void)query;
+	(void)binds;
+#endif // DATABASE_SQLITE
+
+	return result;
+}
+
+Database_Cursor Database::RawCursor(const char *query)
+{
+	if (!this->connected)
+	{
+		throw Database_QueryFailed("Not connected to database.");
+	}
+
+#ifdef DATABASE_DEBUG
+	Console::Dbg("%s", query);
+#endif // DATABASE_DEBUG
+
+	return Database_Cursor(*this, query);
 }
 
 std::string Database::Escape(const std::string &raw)
@@ -6,11 +6,18 @@
 #ifndef DATABASE_HPP_INCLUDED
 #define DATABASE_HPP_INCLUDED
 
+#include "fwd/database.hpp"
+
+#include "database_stats.hpp"
+
 #include "util/variant.hpp"
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <functional>
+#include <iterator>
 #include <list>
 #include <memory>
 #include <string>
@@ -55,19 +62,156 @@ public:
 
 /**
  * Result from a Database Query containing the SELECTed rows, and/or affected row counts and error information
+ * Column names are stored once per result, and cell values are stored contiguously in row-major order.
  */
-class Database_Result : public std::vector<std::unordered_map<std::string, util::variant>>
+class Database_Result
 {
+public:
+	/**
+	 * Read-only view of a single cell in a result
+	 */
+	class Value
+	{
+	protected:
+		const Database_Result *result;
+		std::size_t cell;
+
+	public:
+		Value(const Database_Result *result, std::size_t cell) : result(result), cell(cell) {}
+
+		int GetInt() const;
+		std::string GetString() const;
+
+		/**
+		 * Returns true if the cell was stored as an integer by the database driver
+		 */
+		bool IsInt() const;
+
+		util::variant GetVariant() const;
+
+		operator int() const { return this->GetInt(); }
+		operator std::string() const { return this->GetString(); }
+		operator util::variant() const { return this->GetVariant(); }
+	};
+
+	/**
+	 * Read-only view of a single row in a result
+	 * Index-based access is preferred. Name-based access is provided for compatibility.
+	 */
+	class Row
+	{
+	protected:
+		const Database_Result *result;
+		std::size_t row;
+
+	public:
+		Row(const Database_Result *result, std::size_t row) : result(result), row(row) {}
+
+		std::size_t size() const;
+
+		/**
+		 * Returns the value of the specified column by index
+		 */
+		Value operator[](int column) const;
+
+		/**
+		 * Returns the value of the specified column by name, or an empty string if it does not exist
+		 */
+		util::variant operator[](const char *column) const;
+		util::variant operator[](const std::string &column) const;
+
+		/**
+		 * Converts the row to the legacy map representation
+		 */
+		operator std::unordered_map<std::string, util::variant>() const;
+	};
+
+	class const_iterator
+	{
+	protected:
+		const Database_Result *result;
+		std::size_t row;
+
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef Row value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const Row *pointer;
+		typedef Row reference;
+
+		const_iterator(const Database_Result *result, std::size_t row) : result(result), row(row) {}
+
+		Row operator*() const { return Row(result, row); }
+		const_iterator &operator++() { ++row; return *this; }
+		const_iterator operator++(int) { const_iterator it(*this); ++row; return it; }
+		bool operator==(const const_iterator &other) const { return row == other.row; }
+		bool operator!=(const const_iterator &other) const { return row != other.row; }
+	};
+
+	typedef const_iterator iterator;
+
 protected:
+	struct Cell
+	{
+		int val_int;
+		std::uint32_t offset;
+		std::uint32_t length;
+		bool is_string;
+	};
+
+	std::vector<std::string> columns;
+	std::vector<Cell> cells;
+	std::string text;
+	std::size_t rows;
+
 	int affected_rows;
 	bool error;
 
 public:
 	Database_Result()
-		: affected_rows(0), error(false)
+		: rows(0), affected_rows(0), error(false)
 	{
 	}
 
+	/**
+	 * Used by the database drivers to build a result row by row
+	 */
+	void SetColumns(std::vector<std::string> &&columns);
+	void AddInt(int value);
+	void AddString(const char *value, std::size_t length);
+	void EndRow();
+	void ClearRows();
+
+	/**
+	 * Returns the names of the selected columns in the order they were selected
+	 */
+	const std::vector<std::string> &Columns() const { return this->columns; }
+
+	/**
+	 * Returns the index of a named column, or -1 if it does not exist
+	 */
+	int ColumnIndex(const char *column) const;
+
+	std::size_t size() const { return this->rows; }
+	bool empty() const { return this->rows == 0; }
+
+	/**
+	 * Rows and iterators point back in to the result, so they can't be taken from a temporary one
+	 */
+	Row operator[](std::size_t row) const & { return Row(this, row); }
+	Row front() const & { return Row(this, 0); }
+	Row back() const & { return Row(this, this->rows - 1); }
+
+	Row operator[](std::size_t row) const && = delete;
+	Row front() const && = delete;
+	Row back() const && = delete;
+
+	const_iterator begin() const & { return const_iterator(this, 0); }
+	const_iterator end() const & { return const_iterator(this, this->rows); }
+
+	const_iterator begin() const && = delete;
+	const_iterator end() const && = delete;
+
 	/**
 	 * Returns the number of affected rows from an UPDATE or INSERT query
 	 */
@@ -78,6 +222,46 @@ public:
 	 */
 	bool Error();
 
+	friend class Database;
+	friend class Database_Cursor;
+};
+
+/**
+ * Streams the rows of a SELECT query one at a time instead of buffering the whole result
+ * No other queries may be issued on the same Database while a cursor is open.
+ */
+class Database_Cursor
+{
+protected:
+	struct impl_;
+
+	std::unique_ptr<impl_> impl;
+	Database_Result current;
+
+	Database_Cursor(Database &db, const char *query);
+
+public:
+	Database_Cursor(Database_Cursor &&);
+	Database_Cursor(const Database_Cursor &) = delete;
+
+	/**
+	 * Fetches the next row, returning false when there are no more rows
+	 * @throw Database_QueryFailed
+	 */
+	bool Next();
+
+	/**
+	 * Returns the names of the selected columns in the order they were selected
+	 */
+	const std::vector<std::string> &Columns() const { return this->current.Columns(); }
+
+	/**
+	 * Returns the row fetched by the last call to Next()
+	 */
+	Database_Result::Row Row() const { return this->current.front(); }
+
+	~Database_Cursor();
+
 	friend class Database;
 };
 
@@ -107,7 +291,55 @@ protected:
 	bool in_transaction;
 	std::list<std::string> transaction_log;
 
+	struct SQLite_Bind;
+
+	Database_Result ExecuteRaw(const char *query, bool tx_control);
+	/**
+	 * Runs a Query() format as a prepared statement, cached by the format's address
+	 * @param query Statement text for formats that splice in text, which are not cached, or 0
+	 */
+	Database_Result ExecutePrepared(const char *format, const char *query, const std::vector<SQLite_Bind> &binds);
+
+	template <class F>
+	Database_Result Timed(const char *statement, bool raw, F execute);
+
+	/**
+	 * Executes a raw query and records it in stats under the given statement template
+	 * @param statement Template to record the query as, or 0 to derive one from the query
+	 */
+	Database_Result RawQuery(const char *query, bool tx_control, const char *statement);
+
+public:
+	/**
+	 * Tuning options for SQLite connections, the defaults leave SQLite's own defaults in place
+	 */
+	struct SQLite_Options
+	{
+		bool wal = false;
+
+		/**
+		 * off, normal, full or extra (or 0 to 3), or empty to leave unchanged
+		 */
+		std::string synchronous;
+
+		/**
+		 * Page cache and memory-mapped I/O sizes in KiB, 0 to leave unchanged
+		 */
+		int cache_size = 0;
+		int mmap_size = 0;
+
+		/**
+		 * Keep a prepared statement for each Query() format string and bind its arguments
+		 */
+		bool prepared_statements = true;
+	};
+
+protected:
+	SQLite_Options sqlite_options;
+
 public:
+	Database_Stats stats;
+
 	struct Bulk_Query_Context
 	{
 		Database &db;
@@ -146,7 +378,14 @@ public:
 	void Close();
 
 	/**
-	 * Executes a raw query and returns it's result. Reconnects to the database if required
+	 * Applies tuning options to an SQLite connection, has no effect on other engines
+	 * @throw Database_QueryFailed
+	 */
+	void SetSQLiteOptions(const SQLite_Options &options);
+
+	/**
+	 * Executes a raw query and returns it's result. Reconnects to a MySQL database if required, replaying any open transaction
+	 * SQLite raw queries are never retried, a failure is always thrown.
 	 * @throw Database_QueryFailed
 	 * @throw Database_OpenFailed
 	 */
@@ -154,11 +393,18 @@ public:
 
 	/**
 	 * Executes a formatted query and returns it's result. Reconnects to the database if required
+	 * SQLite only reconnects for prepared statements run outside of a transaction, since the work done so far can't be replayed.
 	 * @throw Database_QueryFailed
 	 * @throw Database_OpenFailed
 	 */
 	Database_Result Query(const char *format, ...);
 
+	/**
+	 * Executes a raw SELECT query and returns a cursor to stream its rows
+	 * @throw Database_QueryFailed
+	 */
+	Database_Cursor RawCursor(const char *query);
+
 	/**
 	 * Escapes a piece of text (including Query replacement tokens)
 	 */
@@ -202,10 +448,7 @@ public:
 	 */
 	~Database();
 
-	/**
-	 * Object used to collect information from an external callback
-	 */
-	Database_Result callbackdata;
+	friend class Database_Cursor;
 };
 
 #endif // DATABASE_HPP_INCLUDED
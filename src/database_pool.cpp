@@ -0,0 +1,299 @@
+/* database_pool.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "database_pool.hpp"
+
+#include "console.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+Database_Pool::Lease::Lease(Lease &&other)
+	: pool(other.pool), connection(other.connection)
+{
+	other.pool = nullptr;
+	other.connection = nullptr;
+}
+
+Database_Pool::Lease &Database_Pool::Lease::operator=(Lease &&other)
+{
+	if (this != &other)
+	{
+		this->Release();
+		this->pool = other.pool;
+		this->connection = other.connection;
+		other.pool = nullptr;
+		other.connection = nullptr;
+	}
+
+	return *this;
+}
+
+void Database_Pool::Lease::Release()
+{
+	if (this->connection)
+		this->pool->Release(this->connection);
+
+	this->pool = nullptr;
+	this->connection = nullptr;
+}
+
+Database_Pool::Lease::~Lease()
+{
+	this->Release();
+}
+
+Database_Pool::Database_Pool()
+	: health_check_interval(std::chrono::seconds(60)), stopping(false)
+{
+}
+
+void Database_Pool::Open(std::size_t size, Database::Engine type, const std::string &host, unsigned short port, const std::string &user, const std::string &pass, const std::string &db, const Database::SQLite_Options &sqlite_options)
+{
+	this->Close();
+
+	std::vector<std::unique_ptr<Connection>> connections;
+	connections.reserve(size);
+
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		std::unique_ptr<Connection> connection(new Connection);
+		connection->db.Connect(type, host, port, user, pass, db);
+		connection->db.SetSQLiteOptions(sqlite_options);
+		connection->last_used = std::chrono::steady_clock::now();
+		connections.push_back(std::move(connection));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->connections = std::move(connections);
+		this->stopping = false;
+	}
+
+	for (std::size_t i = 0; i < size; ++i)
+		this->workers.emplace_back(&Database_Pool::WorkerMain, this);
+}
+
+void Database_Pool::Close()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+
+	this->queued.notify_all();
+
+	// Workers run any jobs already queued before exiting, so a Fanout in progress still completes
+	for (std::thread &worker : this->workers)
+		worker.join();
+
+	this->workers.clear();
+
+	std::unique_lock<std::mutex> lock(this->mutex);
+
+	this->released.wait(lock, [this]()
+	{
+		return std::none_of(this->connections.begin(), this->connections.end(), [](const std::unique_ptr<Connection> &c) { return c->leased; });
+	});
+
+	this->connections.clear();
+}
+
+std::size_t Database_Pool::Size() const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->connections.size();
+}
+
+void Database_Pool::SetHealthCheckInterval(double seconds)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->health_check_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+Database_Pool::Lease Database_Pool::Acquire()
+{
+	Connection *connection = nullptr;
+	bool check;
+
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+
+		if (this->connections.empty())
+			throw Database_Exception("Database pool is empty");
+
+		auto free_connection = [this]()
+		{
+			auto it = std::find_if(this->connections.begin(), this->connections.end(), [](const std::unique_ptr<Connection> &c) { return !c->leased; });
+			return (it != this->connections.end()) ? it->get() : nullptr;
+		};
+
+		this->released.wait(lock, [&]() { return (connection = free_connection()) != nullptr; });
+
+		connection->leased = true;
+		check = std::chrono::steady_clock::now() - connection->last_used > this->health_check_interval;
+	}
+
+	Lease lease(this, connection);
+
+	// A dropped MySQL connection is re-established by RawQuery, the same way World::db recovers
+	if (check)
+		connection->db.RawQuery("SELECT 1");
+
+	return lease;
+}
+
+Database_Pool::Lease Database_Pool::TryAcquire()
+{
+	Connection *connection = nullptr;
+	bool check;
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		auto it = std::find_if(this->connections.begin(), this->connections.end(), [](const std::unique_ptr<Connection> &c) { return !c->leased; });
+
+		if (it == this->connections.end())
+			return Lease();
+
+		connection = it->get();
+		connection->leased = true;
+		check = std::chrono::steady_clock::now() - connection->last_used > this->health_check_interval;
+	}
+
+	Lease lease(this, connection);
+
+	if (check)
+		connection->db.RawQuery("SELECT 1");
+
+	return lease;
+}
+
+void Database_Pool::Release(Connection *connection)
+{
+	if (connection->db.Pending())
+	{
+		Console::Wrn("Pooled database connection returned with a transaction open. Rolling back.");
+
+		try
+		{
+			connection->db.Rollback();
+		}
+		catch (Database_Exception &e)
+		{
+			Console::Err("Rollback failed: %s", e.error());
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		connection->leased = false;
+		connection->last_used = std::chrono::steady_clock::now();
+	}
+
+	this->released.notify_all();
+}
+
+void Database_Pool::WorkerMain()
+{
+	Trace::SetThreadName("database_pool");
+
+	std::unique_lock<std::mutex> lock(this->mutex);
+
+	while (true)
+	{
+		this->queued.wait(lock, [this]() { return this->stopping || !this->jobs.empty(); });
+
+		if (this->jobs.empty())
+			return;
+
+		std::function<void()> job = std::move(this->jobs.front());
+		this->jobs.pop_front();
+
+		lock.unlock();
+		job();
+		lock.lock();
+	}
+}
+
+std::vector<Database_Result> Database_Pool::Fanout(const std::vector<std::string> &queries, Database &fallback)
+{
+	std::vector<Database_Result> results(queries.size());
+	std::atomic<std::size_t> next(0);
+	std::exception_ptr error;
+
+	// Guards error and running, which the jobs update as they finish
+	std::mutex done_mutex;
+	std::condition_variable done;
+	std::size_t running = 0;
+
+	auto job = [&]()
+	{
+		try
+		{
+			Lease lease = this->Acquire();
+
+			for (std::size_t i; (i = next++) < queries.size();)
+				results[i] = lease->RawQuery(queries[i].c_str());
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(done_mutex);
+
+			if (!error)
+				error = std::current_exception();
+
+			next = queries.size();
+		}
+
+		// Notified under the lock, as Fanout returns and destroys done as soon as it sees running reach zero
+		std::lock_guard<std::mutex> lock(done_mutex);
+
+		if (--running == 0)
+			done.notify_one();
+	};
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		if (!this->stopping)
+		{
+			running = std::min(this->connections.size(), queries.size());
+
+			for (std::size_t i = 0; i < running; ++i)
+				this->jobs.push_back(job);
+		}
+	}
+
+	if (running == 0)
+	{
+		for (std::size_t i = 0; i < queries.size(); ++i)
+			results[i] = fallback.RawQuery(queries[i].c_str());
+
+		return results;
+	}
+
+	this->queued.notify_all();
+
+	std::unique_lock<std::mutex> lock(done_mutex);
+	done.wait(lock, [&]() { return running == 0; });
+
+	if (error)
+		std::rethrow_exception(error);
+
+	return results;
+}
+
+Database_Pool::~Database_Pool()
+{
+	this->Close();
+}
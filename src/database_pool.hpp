@@ -0,0 +1,133 @@
+/* database_pool.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef DATABASE_POOL_HPP_INCLUDED
+#define DATABASE_POOL_HPP_INCLUDED
+
+#include "fwd/database.hpp"
+
+#include "database.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * A set of extra connections to the same database that can be leased out to worker threads
+ * A transaction belongs to the lease it was started on and never outlives it. Reads that must see the
+ *   uncommitted writes of another connection (such as World::db during a TimedSave period) must stay on that connection.
+ */
+class Database_Pool
+{
+protected:
+	struct Connection
+	{
+		Database db;
+		std::chrono::steady_clock::time_point last_used;
+		bool leased = false;
+	};
+
+	std::vector<std::unique_ptr<Connection>> connections;
+
+	mutable std::mutex mutex;
+	std::condition_variable released;
+
+	std::chrono::steady_clock::duration health_check_interval;
+
+	// One worker per connection, started by Open and kept for Fanout until Close
+	std::vector<std::thread> workers;
+	std::condition_variable queued;
+	std::deque<std::function<void()>> jobs;
+	bool stopping;
+
+	void Release(Connection *connection);
+	void WorkerMain();
+
+public:
+	/**
+	 * Exclusive use of one pooled connection, returned to the pool when destroyed
+	 */
+	class Lease
+	{
+	protected:
+		Database_Pool *pool;
+		Connection *connection;
+
+		Lease(Database_Pool *pool, Connection *connection) : pool(pool), connection(connection) {}
+
+	public:
+		Lease() : pool(nullptr), connection(nullptr) {}
+		Lease(Lease &&other);
+		Lease(const Lease &) = delete;
+		Lease &operator=(Lease &&other);
+		Lease &operator=(const Lease &) = delete;
+
+		explicit operator bool() const { return this->connection != nullptr; }
+
+		Database &operator*() const { return this->connection->db; }
+		Database *operator->() const { return &this->connection->db; }
+
+		/**
+		 * Returns the connection to the pool early, rolling back any transaction left open on it
+		 */
+		void Release();
+
+		~Lease();
+
+		friend class Database_Pool;
+	};
+
+	Database_Pool();
+
+	/**
+	 * Opens the given number of connections with the same parameters as Database::Connect
+	 * @throw Database_OpenFailed
+	 */
+	void Open(std::size_t size, Database::Engine type, const std::string &host, unsigned short port, const std::string &user, const std::string &pass, const std::string &db, const Database::SQLite_Options &sqlite_options = Database::SQLite_Options());
+
+	/**
+	 * Stops the workers and closes every connection, waiting for outstanding leases to be returned first
+	 */
+	void Close();
+
+	std::size_t Size() const;
+
+	/**
+	 * Connections idle for longer than this are pinged before being leased, reconnecting if the server has gone away
+	 */
+	void SetHealthCheckInterval(double seconds);
+
+	/**
+	 * Waits for a free connection and leases it
+	 * @throw Database_Exception if the pool is empty
+	 * @throw Database_OpenFailed
+	 */
+	Lease Acquire();
+
+	/**
+	 * Leases a free connection without waiting, returns an empty lease if there are none
+	 * @throw Database_OpenFailed
+	 */
+	Lease TryAcquire();
+
+	/**
+	 * Executes a set of independent read queries on the pool's workers and returns their results in the same order
+	 * Runs them one after another on fallback when the pool is empty.
+	 * @throw Database_QueryFailed
+	 * @throw Database_OpenFailed
+	 */
+	std::vector<Database_Result> Fanout(const std::vector<std::string> &queries, Database &fallback);
+
+	~Database_Pool();
+};
+
+#endif // DATABASE_POOL_HPP_INCLUDED
@@ -0,0 +1,88 @@
+/* database_stats.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "database_stats.hpp"
+
+#include "console.hpp"
+
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+Database_Stats::Database_Stats()
+	: caller(0), slow_threshold_us(0), slow_queries(0)
+{ }
+
+void Database_Stats::SetSlowThreshold(double seconds)
+{
+	this->slow_threshold_us = (seconds > 0.0) ? std::uint64_t(seconds * 1000000.0) : 0;
+}
+
+void Database_Stats::Record(const char *statement, bool raw, std::uint64_t elapsed_us, std::size_t rows, bool error)
+{
+	Statement &stats = raw ? this->statements[Normalize(statement)] : this->statements[statement];
+
+	++stats.calls;
+	stats.rows += rows;
+	stats.latency.record(elapsed_us);
+
+	if (error)
+		++stats.errors;
+
+	Caller &caller = this->callers[this->CurrentCaller()];
+	++caller.calls;
+	caller.total_us += elapsed_us;
+
+	if (this->slow_threshold_us != 0 && elapsed_us >= this->slow_threshold_us)
+	{
+		++this->slow_queries;
+		Console::Wrn("Slow query (%i ms) from %s: %s", int(elapsed_us / 1000), this->CurrentCaller(), raw ? Normalize(statement).c_str() : statement);
+	}
+}
+
+void Database_Stats::Reset()
+{
+	this->statements.clear();
+	this->callers.clear();
+	this->slow_queries = 0;
+}
+
+std::string Database_Stats::Normalize(const char *query)
+{
+	std::string result;
+
+	for (const char *p = query; *p != '\0'; ++p)
+	{
+		if (*p == '\'' || *p == '"')
+		{
+			char quote = *p;
+
+			for (++p; *p != '\0' && *p != quote; ++p)
+			{
+				if (*p == '\\' && p[1] != '\0')
+					++p;
+			}
+
+			result += '?';
+
+			if (*p == '\0')
+				break;
+		}
+		else if (std::isdigit(static_cast<unsigned char>(*p)) && (result.empty() || !(std::isalnum(static_cast<unsigned char>(result.back())) || result.back() == '_' || result.back() == '`')))
+		{
+			while (std::isdigit(static_cast<unsigned char>(p[1])) || p[1] == '.')
+				++p;
+
+			result += '?';
+		}
+		else
+		{
+			result += *p;
+		}
+	}
+
+	return result;
+}
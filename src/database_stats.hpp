@@ -0,0 +1,103 @@
+/* database_stats.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef DATABASE_STATS_HPP_INCLUDED
+#define DATABASE_STATS_HPP_INCLUDED
+
+#include "fwd/database.hpp"
+
+#include "util/histogram.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Per-statement query counters and latency histograms for a Database
+ * Statements are identified by their Query() format string, or by a copy of a raw query with its literals replaced by '?'.
+ */
+class Database_Stats
+{
+public:
+	struct Statement
+	{
+		std::uint64_t calls = 0;
+		std::uint64_t errors = 0;
+		std::uint64_t rows = 0;
+
+		/**
+		 * Latency in microseconds
+		 */
+		util::histogram latency;
+	};
+
+	struct Caller
+	{
+		std::uint64_t calls = 0;
+		std::uint64_t total_us = 0;
+	};
+
+	/**
+	 * Marks queries made during its lifetime as coming from the named caller
+	 * The name must outlive the scope.
+	 */
+	struct Caller_Scope
+	{
+		Database_Stats &stats;
+		const char *previous;
+
+		Caller_Scope(Database_Stats &stats, const char *caller)
+			: stats(stats), previous(stats.caller)
+		{
+			stats.caller = caller;
+		}
+
+		Caller_Scope(const Caller_Scope &) = delete;
+
+		~Caller_Scope()
+		{
+			stats.caller = previous;
+		}
+	};
+
+protected:
+	std::unordered_map<std::string, Statement> statements;
+	std::unordered_map<std::string, Caller> callers;
+
+	const char *caller;
+
+	std::uint64_t slow_threshold_us;
+	std::uint64_t slow_queries;
+
+public:
+	Database_Stats();
+
+	/**
+	 * Queries taking at least this long are logged, 0 to disable
+	 */
+	void SetSlowThreshold(double seconds);
+
+	const char *CurrentCaller() const { return this->caller ? this->caller : "other"; }
+
+	/**
+	 * @param statement Statement template or raw query text
+	 * @param raw If true the statement has its literals stripped before being recorded
+	 */
+	void Record(const char *statement, bool raw, std::uint64_t elapsed_us, std::size_t rows, bool error);
+
+	const std::unordered_map<std::string, Statement> &Statements() const { return this->statements; }
+	const std::unordered_map<std::string, Caller> &Callers() const { return this->callers; }
+	std::uint64_t SlowQueries() const { return this->slow_queries; }
+
+	void Reset();
+
+	/**
+	 * Replaces quoted strings and numbers in a query with '?'
+	 */
+	static std::string Normalize(const char *query);
+};
+
+#endif // DATABASE_STATS_HPP_INCLUDED
@@ -55,6 +55,7 @@ void EOClient::Initialize()
 	this->version = 0;
 	this->needpong = false;
 	this->login_attempts = 0;
+	this->password_pending = false;
 	this->start = Timer::GetTime();
 }
 
@@ -79,7 +80,7 @@ void EOClient::Tick()
 			upload_available = std::fread(&this->send_buffer[this->send_buffer_ppos], 1, upload_available, this->upload_fh);
 
 			// Dynamically rewrite the bytes of the map to enable PK
-			if (this->upload_type == FILE_MAP && this->server()->world->config["GlobalPK"] && !this->server()->world->PKExcept(player->character->mapid))
+			if (this->upload_type == FILE_MAP && this->server()->world->settings.GetBool(ConfigKey::GlobalPK) && !this->server()->world->PKExcept(player->character->mapid))
 			{
 				if (this->upload_pos <= 0x03 && this->upload_pos + upload_available > 0x03)
 					this->send_buffer[this->send_buffer_ppos + 0x03 - this->upload_pos] = 0xFF;
@@ -252,11 +253,13 @@ void EOClient::Execute(const std::string &data)
 
 	PacketReader reader(processor.Decode(data));
 
+	this->server()->CountPacketIn(reader.Family(), data.length() + 2);
+
 	if (!this->accepted)
 	{
 		PacketFamily family = reader.Family();
 
-		if (family != PACKET_F_INIT && family != PACKET_CONNECTION && !(family == PACKET_PLAYERS && reader.Action() == PACKET_LIST && this->server()->world->config["AllowStats"]))
+		if (family != PACKET_F_INIT && family != PACKET_CONNECTION && !(family == PACKET_PLAYERS && reader.Action() == PACKET_LIST && this->server()->world->settings.GetBool(ConfigKey::AllowStats)))
 		{
 			// Console::Dbg("packet: %s_%s", PacketProcessor::GetFamilyName(family).c_str(), PacketProcessor::GetActionName(reader.Action()).c_str());
 			// this->server()->RecordClientRejection(this->GetRemoteAddr(), "bad packet");
@@ -287,7 +290,7 @@ void EOClient::Execute(const std::string &data)
 		else
 			client_seq = reader.GetChar();
 
-		if (this->server()->world->config["EnforceSequence"])
+		if (this->server()->world->settings.GetBool(ConfigKey::EnforceSequence))
 		{
 			if (client_seq != server_seq)
 			{
@@ -311,6 +314,36 @@ void EOClient::Execute(const std::string &data)
 		this->GenSequence();
 	}
 
+	if (this->server()->Capturing())
+	{
+		PacketReader payload = reader;
+		this->server()->CapturePacket(this, reader.Family(), reader.Action(), payload.GetEndString());
+	}
+
+	queue.AddAction(reader, 0.02, true);
+}
+
+void EOClient::Inject(PacketFamily family, PacketAction action, const std::string &payload)
+{
+	if (!this->Connected() || family == PACKET_INTERNAL)
+		return;
+
+	std::string data;
+	data.reserve(payload.length() + 2);
+	data += char(action);
+	data += char(family);
+	data += payload;
+
+	PacketReader reader(data);
+
+	this->server()->CountPacketIn(family, data.length() + 2);
+
+	// Keep the sequence in step with a client that sent it
+	if (family == PACKET_CONNECTION && action == PACKET_PING)
+		this->PongNewSequence();
+
+	this->GenSequence();
+
 	queue.AddAction(reader, 0.02, true);
 }
 
@@ -351,7 +384,7 @@ bool EOClient::Upload(FileType type, int id, InitReply init_reply)
 	{
 		char mapbuf[7];
 		std::sprintf(mapbuf, "%05i", int(std::abs(id)));
-		filename = std::string(server()->world->config["MapDir"]) + mapbuf + ".emf";
+		filename = server()->world->settings.GetString(ConfigKey::MapDir) + mapbuf + ".emf";
 	}
 	else if (type == FILE_ITEM)
 	{
@@ -476,6 +509,8 @@ void EOClient::Send(const PacketBuilder &builder)
 {
 	std::string data = this->processor.Encode(builder);
 
+	this->server()->CountPacketOut(PacketFamily(builder.GetID() & 0xFF), data.length());
+
 	if (this->upload_fh)
 	{
 		// Stick any incoming data in to our temporary buffer
@@ -497,12 +532,15 @@ void EOClient::Send(const PacketBuilder &builder)
 	}
 	else
 	{
-		Client::Send(this->processor.Encode(builder));
+		Client::Send(data);
 	}
 }
 
 EOClient::~EOClient()
 {
+	this->server()->world->password_hasher.Cancel(this);
+	this->server()->CaptureClose(this);
+
 	if (this->upload_fh)
 	{
 		std::fclose(this->upload_fh);
@@ -18,6 +18,7 @@
 #include "socket_impl.hpp" // Include SocketImpl
 
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <memory>
 #include <queue>
@@ -106,6 +107,17 @@ public:
 	double start = 0.0;
 	int login_attempts;
 
+	/**
+	 * Set while a password for this client is being hashed or verified
+	 */
+	bool password_pending;
+
+	/**
+	 * Packets handled for this client and the time spent handling them in microseconds
+	 */
+	std::uint64_t handler_calls = 0;
+	std::uint64_t handler_us = 0;
+
 	int next_eif_id = 1;
 	int next_enf_id = 1;
 	int next_esf_id = 1;
@@ -147,6 +159,13 @@ public:
 
 	void Execute(const std::string &data);
 
+	/**
+	 * Queues an already decoded packet as if it had been received with the expected sequence number
+	 * Used to feed recorded packets to a connection with no socket.
+	 * @param payload Packet data following the sequence number
+	 */
+	void Inject(PacketFamily family, PacketAction action, const std::string &payload);
+
 	bool Upload(FileType type, int id, InitReply init_reply);
 	bool Upload(FileType type, const std::string &filename, std::size_t file_start, std::size_t file_length, InitReply init_reply);
 	void Send(const PacketBuilder &packet);
@@ -16,6 +16,7 @@
 #include <map>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace EOPlus
 {
@@ -84,6 +85,17 @@ namespace EOPlus
 		std::deque<Scope> scopes;
 		std::string function;
 		std::deque<util::variant> args;
+
+		/**
+		 * Opcode and integer arguments resolved by the host when the quest is loaded, op is -1 until then
+		 */
+		int op;
+		std::vector<int> int_args;
+
+		Expression()
+			: op(-1)
+		{
+		}
 	};
 
 	struct Action
@@ -149,6 +161,11 @@ namespace EOPlus
 		Info info;
 		std::map<std::string, State> states;
 
+		Quest()
+			: has_info(false)
+		{
+		}
+
 		explicit Quest(std::istream &is);
 	};
 
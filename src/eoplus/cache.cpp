@@ -0,0 +1,395 @@
+/* eoplus/cache.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "cache.hpp"
+
+#include "../eoplus.hpp"
+
+#include "../util.hpp"
+#include "../util/variant.hpp"
+
+#include <sys/stat.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace EOPlus
+{
+	static const char cache_magic[4] = {'E', 'Q', 'C', '\0'};
+
+	// Bump whenever the layout of the tree written below changes
+	static const std::uint32_t cache_version = 1;
+
+	class Cache_Writer
+	{
+	private:
+		std::string data;
+
+	public:
+		void AddInt(std::uint64_t n, int bytes)
+		{
+			for (int i = 0; i < bytes; ++i)
+				this->data += char((n >> (i * 8)) & 0xFF);
+		}
+
+		void AddString(const std::string &s)
+		{
+			this->AddInt(s.length(), 4);
+			this->data += s;
+		}
+
+		void AddVariant(const util::variant &v)
+		{
+			this->AddInt(v.GetType(), 1);
+
+			switch (v.GetType())
+			{
+			case util::variant::type_int:
+				this->AddInt(std::uint32_t(v.GetInt()), 4);
+				break;
+
+			case util::variant::type_float:
+			{
+				double f = v.GetFloat();
+				std::uint64_t n;
+				std::memcpy(&n, &f, sizeof n);
+				this->AddInt(n, 8);
+			}
+			break;
+
+			case util::variant::type_string:
+				this->AddString(v.GetString());
+				break;
+
+			case util::variant::type_bool:
+				this->AddInt(v.GetBool(), 1);
+				break;
+			}
+		}
+
+		void AddArgs(const std::deque<util::variant> &args)
+		{
+			this->AddInt(args.size(), 4);
+
+			UTIL_FOREACH_CREF(args, arg)
+				this->AddVariant(arg);
+		}
+
+		void AddExpression(const Expression &expr)
+		{
+			this->AddInt(expr.scopes.size(), 4);
+
+			UTIL_FOREACH_CREF(expr.scopes, scope)
+			{
+				this->AddInt(scope.type, 1);
+				this->AddArgs(scope.args);
+			}
+
+			this->AddString(expr.function);
+			this->AddArgs(expr.args);
+		}
+
+		void AddAction(const Action &action)
+		{
+			this->AddInt(action.cond, 1);
+			this->AddExpression(action.cond_expr);
+			this->AddExpression(action.expr);
+		}
+
+		void AddRaw(const char *p, std::size_t n)
+		{
+			this->data.append(p, n);
+		}
+
+		const std::string &Get() const
+		{
+			return this->data;
+		}
+	};
+
+	class Cache_Reader
+	{
+	private:
+		const char *p;
+		const char *end;
+		bool ok;
+
+		bool Need(std::size_t n)
+		{
+			if (std::size_t(this->end - this->p) < n)
+				this->ok = false;
+
+			return this->ok;
+		}
+
+	public:
+		Cache_Reader(const std::string &data)
+			: p(data.data()), end(data.data() + data.length()), ok(true)
+		{
+		}
+
+		bool OK() const
+		{
+			return this->ok;
+		}
+
+		bool AtEnd() const
+		{
+			return this->p == this->end;
+		}
+
+		std::uint64_t GetInt(int bytes)
+		{
+			std::uint64_t n = 0;
+
+			if (!this->Need(bytes))
+				return 0;
+
+			for (int i = 0; i < bytes; ++i)
+				n |= std::uint64_t((unsigned char)*this->p++) << (i * 8);
+
+			return n;
+		}
+
+		std::string GetString()
+		{
+			std::size_t length = this->GetInt(4);
+
+			if (!this->Need(length))
+				return std::string();
+
+			std::string s(this->p, length);
+			this->p += length;
+			return s;
+		}
+
+		util::variant GetVariant()
+		{
+			switch (this->GetInt(1))
+			{
+			case util::variant::type_int:
+				return util::variant(int(std::uint32_t(this->GetInt(4))));
+
+			case util::variant::type_float:
+			{
+				std::uint64_t n = this->GetInt(8);
+				double f;
+				std::memcpy(&f, &n, sizeof f);
+				return util::variant(f);
+			}
+
+			case util::variant::type_string:
+				return util::variant(this->GetString());
+
+			case util::variant::type_bool:
+				return util::variant(this->GetInt(1) != 0);
+
+			default:
+				this->ok = false;
+				return util::variant();
+			}
+		}
+
+		// Counts are checked against the bytes left so a corrupt file can't request a huge allocation
+		std::size_t GetCount()
+		{
+			std::size_t count = this->GetInt(4);
+
+			if (count > std::size_t(this->end - this->p))
+				this->ok = false;
+
+			return this->ok ? count : 0;
+		}
+
+		void GetArgs(std::deque<util::variant> &args)
+		{
+			for (std::size_t i = this->GetCount(); i > 0 && this->ok; --i)
+				args.push_back(this->GetVariant());
+		}
+
+		void GetExpression(Expression &expr)
+		{
+			for (std::size_t i = this->GetCount(); i > 0 && this->ok; --i)
+			{
+				Scope scope;
+				scope.type = Scope::Type(this->GetInt(1));
+				this->GetArgs(scope.args);
+				expr.scopes.push_back(std::move(scope));
+			}
+
+			expr.function = this->GetString();
+			this->GetArgs(expr.args);
+		}
+
+		void GetAction(Action &action)
+		{
+			action.cond = Action::ConditionalType(this->GetInt(1));
+			this->GetExpression(action.cond_expr);
+			this->GetExpression(action.expr);
+		}
+	};
+
+	bool StatSource(const std::string &filename, Source_Key &key)
+	{
+		struct stat st;
+
+		if (stat(filename.c_str(), &st) != 0)
+			return false;
+
+		key.mtime = st.st_mtime;
+		key.size = st.st_size;
+
+		return true;
+	}
+
+	bool ReadSource(const std::string &filename, std::string &source)
+	{
+		std::ifstream f(filename, std::ios::binary);
+
+		if (!f)
+			return false;
+
+		source.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+
+		return !f.bad();
+	}
+
+	std::uint64_t HashSource(const std::string &source)
+	{
+		// 64-bit FNV-1a
+		std::uint64_t hash = 0xCBF29CE484222325ULL;
+
+		UTIL_FOREACH(source, c)
+		{
+			hash ^= (unsigned char)c;
+			hash *= 0x100000001B3ULL;
+		}
+
+		return hash;
+	}
+
+	bool ReadCache(const std::string &filename, Source_Key &key, std::unique_ptr<Quest> &quest)
+	{
+		std::string data;
+
+		if (!ReadSource(filename, data))
+			return false;
+
+		if (data.length() < sizeof cache_magic || std::memcmp(data.data(), cache_magic, sizeof cache_magic) != 0)
+			return false;
+
+		Cache_Reader reader(data);
+		reader.GetInt(sizeof cache_magic);
+
+		if (reader.GetInt(4) != cache_version)
+			return false;
+
+		Source_Key cached_key;
+		cached_key.mtime = std::int64_t(reader.GetInt(8));
+		cached_key.size = reader.GetInt(8);
+		cached_key.hash = reader.GetInt(8);
+
+		std::unique_ptr<Quest> cached_quest(new Quest);
+
+		cached_quest->has_info = reader.GetInt(1) != 0;
+		cached_quest->info.name = reader.GetString();
+		cached_quest->info.version = reader.GetInt(4);
+		cached_quest->info.hidden = Info::HiddenType(reader.GetInt(1));
+		cached_quest->info.disabled = reader.GetInt(1) != 0;
+
+		for (std::size_t i = reader.GetCount(); i > 0 && reader.OK(); --i)
+		{
+			std::string id = reader.GetString();
+			State &state = cached_quest->states[id];
+
+			state.name = reader.GetString();
+			state.has_desc = reader.GetInt(1) != 0;
+			state.desc = reader.GetString();
+			state.goal_rule = reader.GetInt(4);
+
+			for (std::size_t j = reader.GetCount(); j > 0 && reader.OK(); --j)
+			{
+				Rule rule;
+				reader.GetExpression(rule.expr);
+				reader.GetAction(rule.action);
+				state.rules.push_back(std::move(rule));
+			}
+
+			for (std::size_t j = reader.GetCount(); j > 0 && reader.OK(); --j)
+			{
+				Action action;
+				reader.GetAction(action);
+				state.actions.push_back(std::move(action));
+			}
+		}
+
+		if (!reader.OK() || !reader.AtEnd())
+			return false;
+
+		key = cached_key;
+		quest = std::move(cached_quest);
+
+		return true;
+	}
+
+	bool WriteCache(const std::string &filename, const Source_Key &key, const Quest &quest)
+	{
+		Cache_Writer writer;
+
+		writer.AddRaw(cache_magic, sizeof cache_magic);
+		writer.AddInt(cache_version, 4);
+		writer.AddInt(std::uint64_t(key.mtime), 8);
+		writer.AddInt(key.size, 8);
+		writer.AddInt(key.hash, 8);
+
+		writer.AddInt(quest.has_info, 1);
+		writer.AddString(quest.info.name);
+		writer.AddInt(quest.info.version, 4);
+		writer.AddInt(quest.info.hidden, 1);
+		writer.AddInt(quest.info.disabled, 1);
+
+		writer.AddInt(quest.states.size(), 4);
+
+		UTIL_FOREACH_CREF(quest.states, it)
+		{
+			const State &state = it.second;
+
+			writer.AddString(it.first);
+			writer.AddString(state.name);
+			writer.AddInt(state.has_desc, 1);
+			writer.AddString(state.desc);
+			writer.AddInt(state.goal_rule, 4);
+
+			writer.AddInt(state.rules.size(), 4);
+
+			UTIL_FOREACH_CREF(state.rules, rule)
+			{
+				writer.AddExpression(rule.expr);
+				writer.AddAction(rule.action);
+			}
+
+			writer.AddInt(state.actions.size(), 4);
+
+			UTIL_FOREACH_CREF(state.actions, action)
+				writer.AddAction(action);
+		}
+
+		std::ofstream f(filename, std::ios::binary | std::ios::trunc);
+
+		if (!f)
+			return false;
+
+		f.write(writer.Get().data(), writer.Get().length());
+
+		return bool(f);
+	}
+}
@@ -0,0 +1,58 @@
+/* eoplus/cache.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef EOPLUS_CACHE_HPP_INCLUDED
+#define EOPLUS_CACHE_HPP_INCLUDED
+
+#include "fwd/cache.hpp"
+
+#include "../fwd/eoplus.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace EOPlus
+{
+	/**
+	 * Identifies the revision of a quest source file that a compiled cache was built from
+	 */
+	struct Source_Key
+	{
+		std::int64_t mtime = 0;
+		std::uint64_t size = 0;
+		std::uint64_t hash = 0;
+
+		bool SameFile(const Source_Key &other) const
+		{
+			return this->mtime == other.mtime && this->size == other.size;
+		}
+	};
+
+	/**
+	 * Fills in the modification time and size of a file, returns false if it can not be found
+	 */
+	bool StatSource(const std::string &filename, Source_Key &key);
+
+	/**
+	 * Reads a whole source file, returns false if it can not be opened
+	 */
+	bool ReadSource(const std::string &filename, std::string &source);
+
+	std::uint64_t HashSource(const std::string &source);
+
+	/**
+	 * Loads a quest compiled by WriteCache along with the key of the source it came from
+	 * Returns false if the file is missing, truncated or from a different cache format.
+	 */
+	bool ReadCache(const std::string &filename, Source_Key &key, std::unique_ptr<Quest> &quest);
+
+	/**
+	 * Stores a parsed quest so it can be loaded again without lexing or parsing the source
+	 */
+	bool WriteCache(const std::string &filename, const Source_Key &key, const Quest &quest);
+}
+
+#endif // EOPLUS_CACHE_HPP_INCLUDED
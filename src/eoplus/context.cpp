@@ -14,6 +14,7 @@
 #include <functional>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace EOPlus
 {
@@ -139,40 +140,28 @@ namespace EOPlus
 		return this->finished;
 	}
 
-	bool Context::QueryRule(std::string rule) const
-	{
-		return this->QueryRule(rule, [](const std::deque<util::variant> &)
-							   { return true; });
-	}
-
-	bool Context::QueryRule(std::string rule, std::function<bool(const std::deque<util::variant> &)> arg_check) const
+	bool Context::QueryRule(int op, std::function<bool(const Expression &)> expr_check) const
 	{
 		if (!this->state)
 			return false;
 
 		UTIL_FOREACH(this->state->rules, check_rule)
 		{
-			if (check_rule.expr.function == rule && arg_check(check_rule.expr.args))
+			if (check_rule.expr.op == op && (!expr_check || expr_check(check_rule.expr)))
 				return true;
 		}
 
 		return false;
 	}
 
-	bool Context::TriggerRule(std::string rule)
-	{
-		return this->TriggerRule(rule, [](const std::deque<util::variant> &)
-								 { return true; });
-	}
-
-	bool Context::TriggerRule(std::string rule, std::function<bool(const std::deque<util::variant> &)> arg_check)
+	bool Context::TriggerRule(int op, std::function<bool(const Expression &)> expr_check)
 	{
 		if (!this->state)
 			return false;
 
 		UTIL_FOREACH(this->state->rules, check_rule)
 		{
-			if (check_rule.expr.function == rule && arg_check(check_rule.expr.args))
+			if (check_rule.expr.op == op && (!expr_check || expr_check(check_rule.expr)))
 			{
 				this->DoAction(check_rule.action);
 				// *this may not be valid here
@@ -184,6 +173,16 @@ namespace EOPlus
 	}
 
 	bool Context::CheckRules()
+	{
+		return this->CheckRuleSet(nullptr, this->state ? this->state->rules.size() : 0);
+	}
+
+	bool Context::CheckRules(const std::vector<std::size_t> &rules)
+	{
+		return this->CheckRuleSet(rules.data(), rules.size());
+	}
+
+	bool Context::CheckRuleSet(const std::size_t *indices, std::size_t count)
 	{
 		if (!this->state)
 		{
@@ -201,8 +200,12 @@ namespace EOPlus
 
 		try
 		{
-			UTIL_FOREACH(this->state->rules, rule)
+			const std::deque<Rule> &rules = this->state->rules;
+
+			for (std::size_t i = 0; i < count; ++i)
 			{
+				const Rule &rule = rules[indices ? indices[i] : i];
+
 				if (this->CheckRule(rule.expr))
 				{
 					if (this->DoAction(rule.action))
@@ -12,9 +12,11 @@
 
 #include "../util/variant.hpp"
 
+#include <cstddef>
 #include <deque>
 #include <functional>
 #include <string>
+#include <vector>
 
 namespace EOPlus
 {
@@ -26,6 +28,8 @@ namespace EOPlus
 		std::string state_name;
 		bool finished;
 
+		bool CheckRuleSet(const std::size_t *indices, std::size_t count);
+
 	protected:
 		virtual void BeginState(const std::string &name, const State &state) = 0;
 		virtual bool DoAction(const Action &action) = 0;
@@ -45,14 +49,19 @@ namespace EOPlus
 
 		bool Finished() const;
 
-		bool QueryRule(std::string rule) const;
-		bool QueryRule(std::string rule, std::function<bool(const std::deque<util::variant> &)> arg_check) const;
-
-		bool TriggerRule(std::string rule);
-		bool TriggerRule(std::string rule, std::function<bool(const std::deque<util::variant> &)> arg_check);
+		/**
+		 * Finds a rule of the current state by the opcode the host resolved it to, optionally also checking its expression
+		 */
+		bool QueryRule(int op, std::function<bool(const Expression &)> expr_check = nullptr) const;
+		bool TriggerRule(int op, std::function<bool(const Expression &)> expr_check = nullptr);
 
 		bool CheckRules();
 
+		/**
+		 * Checks a subset of the current state's rules, given as ascending indexes into State::rules
+		 */
+		bool CheckRules(const std::vector<std::size_t> &rules);
+
 		virtual ~Context();
 	};
 }
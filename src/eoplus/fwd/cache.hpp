@@ -0,0 +1,14 @@
+/* eoplus/fwd/cache.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef EOPLUS_FWD_CACHE_HPP_INCLUDED
+#define EOPLUS_FWD_CACHE_HPP_INCLUDED
+
+namespace EOPlus
+{
+	struct Source_Key;
+}
+
+#endif // EOPLUS_FWD_CACHE_HPP_INCLUDED
@@ -8,6 +8,104 @@
 
 #include "fwd/config.hpp"
 
+#include "eoserv_config_keys.hpp"
+
+#include "util/variant.hpp"
+
+#include <array>
+#include <cstddef>
+#include <string>
+
+namespace ConfigKey
+{
+#define EOSERV_CONFIG_KEY_ID(name, type, value, reload) name,
+
+	/**
+	 * Index of each key in Config_Registry, usable wherever a constant is
+	 */
+	enum ID : unsigned short
+	{
+		EOSERV_CONFIG_KEYS(EOSERV_CONFIG_KEY_ID)
+		Count
+	};
+
+#undef EOSERV_CONFIG_KEY_ID
+}
+
+/**
+ * Typed copy of the server config, each key parsed once when the config is (re)loaded
+ * Values are looked up by ConfigKey::ID instead of hashing the key name on every read.
+ */
+class Config_Registry
+{
+public:
+	enum Type : unsigned char
+	{
+		Bool,
+		Int,
+		Float,
+		Time,
+		String
+	};
+
+	enum Reload : unsigned char
+	{
+		Rehash,
+		Restart
+	};
+
+	struct Key_Info
+	{
+		const char *name;
+		Type type;
+		util::variant value;
+		Reload reload;
+	};
+
+	static const Key_Info &Info(ConfigKey::ID key);
+
+	/**
+	 * Looks up a key by name, returns ConfigKey::Count if it is not registered
+	 */
+	static ConfigKey::ID Find(const std::string &name);
+
+	static const char *TypeName(Type type);
+
+protected:
+	std::array<double, ConfigKey::Count> number;
+	std::array<std::string, ConfigKey::Count> text;
+	bool loaded;
+
+public:
+	Config_Registry();
+
+	/**
+	 * Parses every registered key out of config, which must already have passed eoserv_config_validate_config
+	 * Invalid values are replaced with their default, and changes to Restart keys after the first load are reported.
+	 */
+	void Load(const Config &config);
+
+	/**
+	 * Overrides a value at runtime, keeping config in step with it
+	 */
+	void Set(Config &config, ConfigKey::ID key, const util::variant &value);
+
+	bool GetBool(ConfigKey::ID key) const { return this->number[key] != 0.0; }
+	int GetInt(ConfigKey::ID key) const { return static_cast<int>(this->number[key]); }
+	double GetFloat(ConfigKey::ID key) const { return this->number[key]; }
+	const std::string &GetString(ConfigKey::ID key) const { return this->text[key]; }
+
+	/**
+	 * Value as it would be written in config.ini
+	 */
+	std::string Display(ConfigKey::ID key) const;
+
+	bool IsDefault(ConfigKey::ID key) const;
+};
+
+/**
+ * Fills in registered keys missing from config with their defaults and warns about unregistered ones
+ */
 void eoserv_config_validate_config(Config &);
 void eoserv_config_validate_admin(Config &);
 
@@ -0,0 +1,305 @@
+/* eoserv_config_keys.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef EOSERV_CONFIG_KEYS_HPP_INCLUDED
+#define EOSERV_CONFIG_KEYS_HPP_INCLUDED
+
+/**
+ * Every key read from config.ini: X(name, type, default, reload)
+ * Restart keys are only read at startup, a rehash warns if they change.
+ */
+#define EOSERV_CONFIG_KEYS(X) \
+	X(LogOut, String, "-", Restart) \
+	X(LogErr, String, "error.log", Restart) \
+	X(StyleConsole, Bool, true, Restart) \
+	X(LogCommands, Bool, true, Rehash) \
+	X(Host, String, "0.0.0.0", Restart) \
+	X(Port, Int, 8078, Restart) \
+	X(MaxConnections, Int, 300, Restart) \
+	X(ListenBacklog, Int, 50, Restart) \
+	X(MetricsHost, String, "127.0.0.1", Restart) \
+	X(MetricsPort, Int, 0, Restart) \
+	X(MaxPlayers, Int, 200, Rehash) \
+	X(MaxConnectionsPerIP, Int, 3, Rehash) \
+	X(IPReconnectLimit, Float, 10.0, Rehash) \
+	X(MaxConnectionsPerPC, Int, 1, Rehash) \
+	X(HangupDelay, Float, 10.0, Rehash) \
+	X(QuietConnectionErrors, Bool, false, Rehash) \
+	X(TickBudget, Time, "100ms", Rehash) \
+	X(TraceFile, String, "./trace-%Y%m%d-%H%M%S.json", Rehash) \
+	X(TraceLength, Time, "30s", Rehash) \
+	X(CaptureFile, String, "./capture-%Y%m%d-%H%M%S.eocap", Rehash) \
+	X(CaptureLength, Time, "1h", Rehash) \
+	X(MaxLoginAttempts, Int, 3, Rehash) \
+	X(CheckVersion, Bool, true, Rehash) \
+	X(MinVersion, Int, 0, Rehash) \
+	X(MaxVersion, Int, 0, Rehash) \
+	X(OldVersionCompat, Bool, false, Rehash) \
+	X(TimedSave, Time, "5m", Restart) \
+	X(JournalFile, String, "./journal.bin", Restart) \
+	X(JournalSyncRate, Time, "1s", Restart) \
+	X(IgnoreHDID, Bool, false, Rehash) \
+	X(ServerLanguage, String, "./lang/en.ini", Rehash) \
+	X(PacketQueueMax, Int, 40, Rehash) \
+	X(PingRate, Float, 60.0, Rehash) \
+	X(EnforceSequence, Bool, true, Rehash) \
+	X(EnforceTimestamps, Bool, true, Rehash) \
+	X(EnforceSessions, Bool, true, Rehash) \
+	X(PasswordSalt, String, "ChangeMe", Rehash) \
+	X(PasswordHash, String, "sha256", Rehash) \
+	X(PasswordHashCost, Int, 14, Rehash) \
+	X(PasswordHashThreads, Int, 2, Restart) \
+	X(PasswordHashQueue, Int, 50, Rehash) \
+	X(SeoseCompat, Bool, false, Rehash) \
+	X(SeoseCompatKey, String, "D4q9_f30da%#q02#)8", Rehash) \
+	X(DBType, String, "mysql", Restart) \
+	X(DBHost, String, "localhost", Restart) \
+	X(DBUser, String, "eoserv", Restart) \
+	X(DBPass, String, "eoserv", Restart) \
+	X(DBName, String, "eoserv", Restart) \
+	X(DBPort, Int, 0, Restart) \
+	X(InstallSQL, String, "./install.sql", Restart) \
+	X(SlowQueryThreshold, Time, "100ms", Rehash) \
+	X(DBPoolSize, Int, 0, Restart) \
+	X(DBPoolHealthCheck, Time, "1m", Rehash) \
+	X(SQLiteWAL, Bool, false, Restart) \
+	X(SQLiteSynchronous, String, "", Restart) \
+	X(SQLiteCacheSize, Int, 0, Restart) \
+	X(SQLiteMmapSize, Int, 0, Restart) \
+	X(SQLitePreparedStatements, Bool, true, Restart) \
+	X(EIF, String, "./data/pub/dat001.eif", Rehash) \
+	X(ENF, String, "./data/pub/dtn001.enf", Rehash) \
+	X(ESF, String, "./data/pub/dsl001.esf", Rehash) \
+	X(ECF, String, "./data/pub/dat001.ecf", Rehash) \
+	X(AutoSplitPubFiles, Bool, true, Rehash) \
+	X(NewsFile, String, "./data/news.txt", Rehash) \
+	X(DropsFile, String, "./data/drops.ini", Rehash) \
+	X(ShopsFile, String, "./data/shops.ini", Rehash) \
+	X(ArenasFile, String, "./data/arenas.ini", Rehash) \
+	X(FormulasFile, String, "./data/formulas.ini", Rehash) \
+	X(HomeFile, String, "./data/home.ini", Rehash) \
+	X(SkillsFile, String, "./data/skills.ini", Rehash) \
+	X(MapDir, String, "./data/maps/", Restart) \
+	X(Maps, Int, 278, Restart) \
+	X(QuestDir, String, "./data/quests/", Rehash) \
+	X(QuestCache, Bool, true, Rehash) \
+	X(Quests, Int, 0, Rehash) \
+	X(SLN, Bool, false, Restart) \
+	X(SLNURL, String, "http://www.apollo-games.com/SLN/sln.php/", Rehash) \
+	X(SLNSite, String, "", Rehash) \
+	X(ServerName, String, "Untitled Server", Rehash) \
+	X(SLNPeriod, Int, 300, Rehash) \
+	X(SLNZone, String, "", Rehash) \
+	X(SLNBind, String, "1", Rehash) \
+	X(SLNHost, String, "", Rehash) \
+	X(SLNClient, String, "", Rehash) \
+	X(YouTube, String, "", Rehash) \
+	X(FaceBook, String, "", Rehash) \
+	X(Twitter, String, "", Rehash) \
+	X(Discord, String, "", Rehash) \
+	X(BotCharacters, String, "", Rehash) \
+	X(GuildPrice, Int, 50000, Rehash) \
+	X(RecruitCost, Int, 1000, Rehash) \
+	X(GuildMaxMembers, Int, 5000, Rehash) \
+	X(GuildCreateMembers, Int, 9, Rehash) \
+	X(GuildBankMax, Int, 2000000000, Rehash) \
+	X(GuildDefaultRanks, String, "Leader,Recruiter,,,,,,,New Member", Rehash) \
+	X(GuildShowRecruiters, Bool, true, Rehash) \
+	X(GuildCustomRanks, Bool, false, Rehash) \
+	X(GuildEditRank, Int, 1, Rehash) \
+	X(GuildKickRank, Int, 1, Rehash) \
+	X(GuildPromoteRank, Int, 1, Rehash) \
+	X(GuildPromoteSameRank, Int, 1, Rehash) \
+	X(GuildDemoteRank, Int, 1, Rehash) \
+	X(GuildRecruitRank, Int, 2, Rehash) \
+	X(GuildDisbandRank, Int, 0, Rehash) \
+	X(GuildMultipleFounders, Bool, true, Rehash) \
+	X(GuildAnnounce, Bool, true, Rehash) \
+	X(GuildDateFormat, String, "%Y/%m/%d", Rehash) \
+	X(GuildMinDeposit, Int, 1000, Rehash) \
+	X(GuildMaxNameLength, Int, 24, Rehash) \
+	X(GuildMaxDescLength, Int, 240, Rehash) \
+	X(GuildMaxRankLength, Int, 16, Rehash) \
+	X(GuildMaxWidth, Int, 180, Rehash) \
+	X(GlobalPK, Bool, false, Rehash) \
+	X(PKExcept, String, "", Rehash) \
+	X(NPCChaseMode, Int, 0, Rehash) \
+	X(NPCChaseDistance, Int, 18, Rehash) \
+	X(NPCBoredTimer, Time, 30, Rehash) \
+	X(NPCAdjustMaxDam, Int, 3, Rehash) \
+	X(BoardMaxPosts, Int, 20, Rehash) \
+	X(BoardMaxUserPosts, Int, 6, Rehash) \
+	X(BoardMaxRecentPosts, Int, 2, Rehash) \
+	X(BoardRecentPostTime, Time, 1800, Rehash) \
+	X(BoardMaxSubjectLength, Int, 32, Rehash) \
+	X(BoardMaxPostLength, Int, 2048, Rehash) \
+	X(BoardDatePosts, Bool, true, Rehash) \
+	X(AdminBoard, Int, 8, Rehash) \
+	X(AdminBoardLimit, Int, 100, Rehash) \
+	X(FirstCharacterAdmin, Bool, true, Rehash) \
+	X(ShowLevel, Bool, false, Rehash) \
+	X(WarpBubbles, Bool, true, Rehash) \
+	X(HideGlobal, Bool, false, Rehash) \
+	X(GlobalBuffer, Int, 0, Rehash) \
+	X(AdminPrefix, String, "$", Rehash) \
+	X(StatPerLevel, Int, 3, Rehash) \
+	X(SkillPerLevel, Int, 3, Rehash) \
+	X(EnforceWeight, Int, 2, Rehash) \
+	X(MaxWeight, Int, 250, Rehash) \
+	X(MaxLevel, Int, 250, Rehash) \
+	X(MaxExp, Int, 2000000000, Rehash) \
+	X(MaxStat, Int, 10000, Rehash) \
+	X(MaxHPTP, Int, 64000, Rehash) \
+	X(MaxSkillLevel, Int, 100, Rehash) \
+	X(MaxSkills, Int, 48, Rehash) \
+	X(MaxCharacters, Int, 3, Rehash) \
+	X(MaxShopBuy, Int, 4, Rehash) \
+	X(GhostTimer, Time, 4, Rehash) \
+	X(SpellCastCooldown, Float, 0.6, Rehash) \
+	X(DropTimer, Time, 120, Rehash) \
+	X(DropAmount, Int, 15, Rehash) \
+	X(ProtectPlayerDrop, Time, 5, Rehash) \
+	X(ProtectNPCDrop, Time, 30, Rehash) \
+	X(ProtectPKDrop, Time, 60, Rehash) \
+	X(ProtectDeathDrop, Time, 300, Rehash) \
+	X(SeeDistance, Int, 11, Rehash) \
+	X(DropDistance, Int, 2, Rehash) \
+	X(RangedDistance, Int, 5, Rehash) \
+	X(ItemDespawn, Bool, false, Rehash) \
+	X(ItemDespawnCheck, Time, 60, Rehash) \
+	X(ItemDespawnRate, Time, 600, Rehash) \
+	X(RecoverSpeed, Time, 90, Rehash) \
+	X(NPCRecoverSpeed, Time, 105, Rehash) \
+	X(HPRecoverRate, Float, 0.1, Rehash) \
+	X(SitHPRecoverRate, Float, 0.2, Rehash) \
+	X(TPRecoverRate, Float, 0.1, Rehash) \
+	X(SitTPRecoverRate, Float, 0.2, Rehash) \
+	X(NPCRecoverRate, Float, 0.1, Rehash) \
+	X(SpikeTime, Float, 1.5, Rehash) \
+	X(SpikeDamage, Float, 0.2, Rehash) \
+	X(DrainTime, Time, 15, Rehash) \
+	X(DrainHPDamage, Float, 0.2, Rehash) \
+	X(DrainTPDamage, Float, 0.1, Rehash) \
+	X(QuakeRate, Time, 5, Rehash) \
+	X(Quake1, String, "4,12,0,1", Rehash) \
+	X(Quake2, String, "6,12,0,2", Rehash) \
+	X(Quake3, String, "2,10,3,5", Rehash) \
+	X(Quake4, String, "1,4,6,8", Rehash) \
+	X(AccountCreationTimer, Time, 30, Rehash) \
+	X(ChatLength, Int, 128, Rehash) \
+	X(ShareMode, Int, 2, Rehash) \
+	X(PartyShareMode, Int, 2, Rehash) \
+	X(DropRateMode, Int, 3, Rehash) \
+	X(GhostNPC, Bool, false, Rehash) \
+	X(GhostArena, Bool, false, Rehash) \
+	X(AllowStats, Bool, true, Rehash) \
+	X(StartMap, Int, 0, Rehash) \
+	X(StartX, Int, 0, Rehash) \
+	X(StartY, Int, 0, Rehash) \
+	X(JailMap, Int, 76, Rehash) \
+	X(JailX, Int, 6, Rehash) \
+	X(JailY, Int, 7, Rehash) \
+	X(UnJailX, Int, 8, Rehash) \
+	X(UnJailY, Int, 11, Rehash) \
+	X(StartItems, String, "", Rehash) \
+	X(StartSpells, String, "", Rehash) \
+	X(StartEquipMale, String, "0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,", Rehash) \
+	X(StartEquipFemale, String, "0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,", Rehash) \
+	X(WeddingRing, Int, 374, Rehash) \
+	X(WeddingMinLevel, Int, 5, Rehash) \
+	X(WeddingOutfitMale, Int, 133, Rehash) \
+	X(WeddingOutfitFemale, Int, 163, Rehash) \
+	X(MaxHairStyle, Int, 20, Rehash) \
+	X(MaxHairColor, Int, 9, Rehash) \
+	X(MaxSkin, Int, 6, Rehash) \
+	X(CreateMinHairStyle, Int, 1, Rehash) \
+	X(CreateMaxHairStyle, Int, 20, Rehash) \
+	X(CreateMinHairColor, Int, 0, Rehash) \
+	X(CreateMaxHairColor, Int, 9, Rehash) \
+	X(CreateMinSkin, Int, 0, Rehash) \
+	X(CreateMaxSkin, Int, 3, Rehash) \
+	X(DefaultBanLength, Time, "2h", Rehash) \
+	X(LimitDamage, Bool, true, Rehash) \
+	X(DeathRecover, Float, 0.5, Rehash) \
+	X(Deadly, Bool, false, Rehash) \
+	X(ExpRate, Float, 1.0, Rehash) \
+	X(DropRate, Float, 1.0, Rehash) \
+	X(MobRate, Float, 1.0, Rehash) \
+	X(PKRate, Float, 0.75, Rehash) \
+	X(CriticalRate, Float, 0.00, Rehash) \
+	X(CriticalFirstHit, Bool, false, Rehash) \
+	X(EnableAoE, Bool, true, Rehash) \
+	X(SpawnRate, Float, 1.0, Rehash) \
+	X(BarberBase, Int, 0, Rehash) \
+	X(BarberStep, Int, 200, Rehash) \
+	X(BankUpgradeBase, Int, 1000, Rehash) \
+	X(BankUpgradeStep, Int, 1000, Rehash) \
+	X(JukeboxSongs, Int, 20, Rehash) \
+	X(JukeboxPrice, Int, 25, Rehash) \
+	X(JukeboxTimer, Time, 90, Rehash) \
+	X(MarriagePrice, Int, 500, Rehash) \
+	X(DivorcePrice, Int, 10000, Rehash) \
+	X(RespawnBossChildren, Bool, true, Rehash) \
+	X(OldReports, Bool, false, Rehash) \
+	X(WarpSuck, Int, 15, Rehash) \
+	X(EvacuateSound, Int, 51, Rehash) \
+	X(EvacuateLength, Float, 30.0, Rehash) \
+	X(EvacuateStep, Float, 10.0, Rehash) \
+	X(EvacuateTick, Float, 2.0, Rehash) \
+	X(UseAdjustedStats, Bool, true, Rehash) \
+	X(BaseMinDamage, Int, 0, Rehash) \
+	X(BaseMaxDamage, Int, 1, Rehash) \
+	X(BaseDamageAtZero, Bool, true, Rehash) \
+	X(SilentMute, Bool, true, Rehash) \
+	X(CitizenSubscribeAnytime, Bool, false, Rehash) \
+	X(CitizenUnsubscribeAnywhere, Bool, false, Rehash) \
+	X(InnSleepCostBase, Int, 0, Rehash) \
+	X(InnSleepCostPerHP, Int, 1, Rehash) \
+	X(InnSleepCostPerTP, Int, 1, Rehash) \
+	X(ClockMaxDelta, Int, 1000, Rehash) \
+	X(TradeAddQuantity, Bool, false, Rehash) \
+	X(LogReports, Bool, false, Rehash) \
+	X(ReportChatLogSize, Int, 25, Rehash) \
+	X(UseDutyAdmin, Bool, false, Rehash) \
+	X(NoInteractDefault, Int, 0, Rehash) \
+	X(NoInteractDefaultAdmin, Int, 2, Rehash) \
+	X(NPCMovementRate, String, "0.9, 0.6, 1.3, 1.9, 3.7, 7.5, 15.0", Rehash) \
+	X(SpawnNPCSpeed, Int, 0, Rehash) \
+	X(DoorTimer, Float, 3.0, Rehash) \
+	X(ChatMaxWidth, Int, 1400, Rehash) \
+	X(AccountMinLength, Int, 4, Rehash) \
+	X(AccountMaxLength, Int, 16, Rehash) \
+	X(PasswordMinLength, Int, 6, Rehash) \
+	X(PasswordMaxLength, Int, 12, Rehash) \
+	X(RealNameMaxLength, Int, 64, Rehash) \
+	X(LocationMaxLength, Int, 64, Rehash) \
+	X(EmailMaxLength, Int, 64, Rehash) \
+	X(ComputerNameLength, Int, 64, Rehash) \
+	X(LimitAttack, Int, 251, Rehash) \
+	X(MuteLength, Int, 90, Rehash) \
+	X(InstrumentItems, String, "49, 50", Rehash) \
+	X(MaxBankGold, Int, 2000000000, Rehash) \
+	X(MaxItem, Int, 2000000000, Rehash) \
+	X(MaxDrop, Int, 10000000, Rehash) \
+	X(MaxChest, Int, 10000000, Rehash) \
+	X(ChestSlots, Int, 5, Rehash) \
+	X(MaxBank, Int, 200, Rehash) \
+	X(BaseBankSize, Int, 25, Rehash) \
+	X(BankSizeStep, Int, 5, Rehash) \
+	X(MaxBankUpgrades, Int, 7, Rehash) \
+	X(PacketRateFace, Float, 0.09, Rehash) \
+	X(PacketRateWalk, Float, 0.46, Rehash) \
+	X(PacketRateAttack, Float, 0.58, Rehash) \
+	X(MaxTile, Int, 8, Rehash) \
+	X(MaxMap, Int, 400, Rehash) \
+	X(MaxTrade, Int, 2000000000, Rehash) \
+	X(MaxPets, Int, 1, Rehash) \
+	X(PetRespawnTime, Time, 300, Rehash) \
+	X(PetDamageMultiplier, Float, 1.0, Rehash) \
+	X(PetSpeed, Float, 0.25, Rehash) \
+	X(PetChaseDistance, Int, 8, Rehash) \
+	X(PetGuardDistance, Int, 2, Rehash)
+
+#endif // EOSERV_CONFIG_KEYS_HPP_INCLUDED
@@ -7,19 +7,26 @@
 
 #include "config.hpp"
 #include "eoclient.hpp"
+#include "map.hpp"
+#include "metrics.hpp"
+#include "npc.hpp"
 #include "packet.hpp"
 #include "sln.hpp"
 #include "timer.hpp"
+#include "watchdog.hpp"
 #include "world.hpp"
 #include "handlers/handlers.hpp"
 
 #include "console.hpp"
 #include "socket.hpp"
+#include "trace.hpp"
 #include "util.hpp"
 
 #include <array>
 #include <cerrno>
 #include <cstddef>
+#include <cstdint>
+#include <ctime>
 #include <exception>
 #include <memory>
 #include <stdexcept>
@@ -87,7 +94,10 @@ void server_pump_queue(void *server_void)
 
 		std::size_t size = client->queue.queue.size();
 
-		if (size > std::size_t(int(server->world->config["PacketQueueMax"])))
+		if (size > server->queue_depth_peak)
+			server->queue_depth_peak = size;
+
+		if (size > std::size_t(server->world->settings.GetInt(ConfigKey::PacketQueueMax)))
 		{
 			Console::Wrn("Client was disconnected for filling up the action queue: %s", static_cast<std::string>(client->GetRemoteAddr()).c_str());
 			client->Close();
@@ -148,39 +158,138 @@ void server_pump_queue(void *server_void)
 	}
 }
 
+void server_publish_metrics(void *server_void)
+{
+	EOServer *server = static_cast<EOServer *>(server_void);
+	Metrics &metrics = server->metrics;
+
+	static const char *state_names[] = {"uninitialized", "initialized", "logged_in", "playing"};
+	std::array<int, 4> states{};
+	std::size_t queued = 0;
+
+	UTIL_FOREACH(server->clients, rawclient)
+	{
+		EOClient *client = static_cast<EOClient *>(rawclient);
+
+		++states[client->state];
+		queued += client->queue.queue.size();
+	}
+
+	for (std::size_t i = 0; i < states.size(); ++i)
+		metrics.Get(Metrics::Gauge, "eoserv_clients", "Connected clients by login state", std::string("state=\"") + state_names[i] + "\"").Set(states[i]);
+
+	metrics.Get(Metrics::Gauge, "eoserv_action_queue_depth", "Actions waiting in client action queues").Set(double(queued));
+	metrics.Get(Metrics::Gauge, "eoserv_action_queue_depth_peak", "Longest action queue seen since the last update").Set(double(server->queue_depth_peak));
+	server->queue_depth_peak = 0;
+
+	World *world = server->world;
+	int npcs_alive = 0;
+
+	UTIL_FOREACH(world->maps, map)
+	{
+		UTIL_FOREACH(map->npcs, npc)
+		{
+			if (npc->alive)
+				++npcs_alive;
+		}
+	}
+
+	metrics.Get(Metrics::Gauge, "eoserv_players_online", "Characters logged in to the world").Set(double(world->characters.size()));
+	metrics.Get(Metrics::Gauge, "eoserv_npcs_alive", "NPCs currently spawned").Set(npcs_alive);
+	metrics.Get(Metrics::Counter, "eoserv_timer_callbacks_total", "Timer callbacks executed").Set(double(world->timer.callbacks));
+	metrics.Get(Metrics::Counter, "eoserv_long_ticks_total", "Ticks that ran over TickBudget").Set(double(server->watchdog.LongTicks()));
+
+	// Database_Stats keeps a histogram per statement, the exported one is their sum
+	Metrics::Metric &db_latency = metrics.Get(Metrics::Histogram, "eoserv_database_query_duration_seconds", "Database query latency");
+	db_latency.histogram->reset();
+
+	UTIL_FOREACH_CREF(world->db.stats.Statements(), statement)
+		db_latency.histogram->merge(statement.second.latency);
+
+	UTIL_FOREACH(Handlers::Registered(), handler)
+	{
+		if (handler->stats->calls == 0)
+			continue;
+
+		Metrics::Metric &metric = metrics.Get(Metrics::Histogram, "eoserv_handler_duration_seconds", "Time spent in packet handlers", "handler=\"" + handler->name + "\"");
+		*metric.histogram = handler->stats->latency;
+	}
+
+	metrics.Get(Metrics::Counter, "eoserv_database_slow_queries_total", "Database queries slower than SlowQueryThreshold").Set(double(world->db.stats.SlowQueries()));
+
+	metrics.Publish();
+}
+
+void EOServer::CountPacket(bool sent, PacketFamily family, std::size_t bytes)
+{
+	Metrics::Metric *&count = this->packet_count[sent][family];
+	Metrics::Metric *&size = this->packet_bytes[sent][family];
+
+	if (!count)
+	{
+		std::string labels = "family=\"" + PacketProcessor::GetFamilyName(family) + "\"";
+
+		if (sent)
+		{
+			count = &this->metrics.Get(Metrics::Counter, "eoserv_packets_sent_total", "Packets sent to clients", labels);
+			size = &this->metrics.Get(Metrics::Counter, "eoserv_sent_bytes_total", "Bytes of packets sent to clients", labels);
+		}
+		else
+		{
+			count = &this->metrics.Get(Metrics::Counter, "eoserv_packets_received_total", "Packets received from clients", labels);
+			size = &this->metrics.Get(Metrics::Counter, "eoserv_received_bytes_total", "Bytes of packets received from clients", labels);
+		}
+	}
+
+	count->Add();
+	size->Add(double(bytes));
+}
+
 void EOServer::UpdateConfig()
 {
 	delete ping_timer;
-	ping_timer = new TimeEvent(server_ping_all, this, double(this->world->config["PingRate"]), Timer::FOREVER);
+	ping_timer = new TimeEvent(server_ping_all, this, this->world->settings.GetFloat(ConfigKey::PingRate), Timer::FOREVER, "server_ping_all");
 	this->world->timer.Register(ping_timer);
 
-	this->QuietConnectionErrors = bool(this->world->config["QuietConnectionErrors"]);
-	this->HangupDelay = double(this->world->config["HangupDelay"]);
+	this->QuietConnectionErrors = this->world->settings.GetBool(ConfigKey::QuietConnectionErrors);
+	this->HangupDelay = this->world->settings.GetFloat(ConfigKey::HangupDelay);
+
+	this->watchdog.SetBudget(this->world->settings.GetFloat(ConfigKey::TickBudget));
 
-	this->maxconn = unsigned(int(this->world->config["MaxConnections"]));
+	this->maxconn = unsigned(this->world->settings.GetInt(ConfigKey::MaxConnections));
 
 #if !defined(SOCKET_POLL) || defined(WIN32)
 	if (this->maxconn >= 1000)
 	{
 		this->maxconn = 1000;
-		this->world->config["MaxConnections"] = 1000;
+		this->world->settings.Set(this->world->config, ConfigKey::MaxConnections, 1000);
 	}
 #endif // !defined(SOCKET_POLL) || defined(WIN32)
 }
 
 void EOServer::Initialize(std::array<std::string, 6> dbinfo, const Config &eoserv_config, const Config &admin_config)
 {
+	Trace::SetThreadName("game");
+
 	this->world = new World(dbinfo, eoserv_config, admin_config);
 
-	TimeEvent *event = new TimeEvent(server_check_hangup, this, 1.0, Timer::FOREVER);
+	this->world->timer.watchdog = &this->watchdog;
+
+	TimeEvent *event = new TimeEvent(server_check_hangup, this, 1.0, Timer::FOREVER, "server_check_hangup");
+	this->world->timer.Register(event);
+
+	event = new TimeEvent(server_pump_queue, this, 0.001, Timer::FOREVER, "server_pump_queue");
 	this->world->timer.Register(event);
 
-	event = new TimeEvent(server_pump_queue, this, 0.001, Timer::FOREVER);
+	event = new TimeEvent(server_publish_metrics, this, 1.0, Timer::FOREVER, "server_publish_metrics");
 	this->world->timer.Register(event);
 
+	this->tick_duration = &this->metrics.Get(Metrics::Histogram, "eoserv_tick_duration_seconds", "Time taken by one pass of the main loop, including the Select wait");
+	this->select_wait = &this->metrics.Get(Metrics::Histogram, "eoserv_select_wait_seconds", "Time spent waiting for socket activity in Server::Select");
+
 	this->world->server = this;
 
-	if (this->world->config["SLN"])
+	if (this->world->settings.GetBool(ConfigKey::SLN))
 	{
 		this->sln = new SLN(this);
 	}
@@ -192,6 +301,25 @@ void EOServer::Initialize(std::array<std::string, 6> dbinfo, const Config &eoser
 	this->start = Timer::GetTime();
 
 	this->UpdateConfig();
+
+	int metrics_port = this->world->settings.GetInt(ConfigKey::MetricsPort);
+
+	if (metrics_port != 0)
+	{
+		std::string metrics_host = this->world->settings.GetString(ConfigKey::MetricsHost);
+
+		try
+		{
+			this->metrics_server.reset(new Metrics_Server(metrics_host, metrics_port, this->metrics));
+			this->metrics_server->Start();
+			Console::Out("Metrics listening on %s:%i", metrics_host.c_str(), metrics_port);
+		}
+		catch (Socket_Exception &e)
+		{
+			Console::Err("Could not start the metrics listener: %s", e.error());
+			this->metrics_server.reset();
+		}
+	}
 }
 
 Client *EOServer::ClientFactory(const SocketImpl &sock) // Updated to use SocketImpl
@@ -201,6 +329,10 @@ Client *EOServer::ClientFactory(const SocketImpl &sock) // Updated to use Socket
 
 void EOServer::Tick()
 {
+	TRACE_SCOPE("EOServer::Tick");
+
+	this->watchdog.BeginTick();
+
 	std::vector<Client *> *active_clients = 0;
 	EOClient *newclient = static_cast<EOClient *>(this->Poll());
 
@@ -211,8 +343,8 @@ void EOServer::Tick()
 		bool throttle = false;
 		IPAddress remote_addr = newclient->GetRemoteAddr();
 
-		const double reconnect_limit = double(this->world->config["IPReconnectLimit"]);
-		const int max_per_ip = int(this->world->config["MaxConnectionsPerIP"]);
+		const double reconnect_limit = this->world->settings.GetFloat(ConfigKey::IPReconnectLimit);
+		const int max_per_ip = this->world->settings.GetInt(ConfigKey::MaxConnectionsPerIP);
 
 		UTIL_IFOREACH(connection_log, connection)
 		{
@@ -260,6 +392,8 @@ void EOServer::Tick()
 		}
 	}
 
+	this->watchdog.Mark("accept");
+
 	try
 	{
 		active_clients = this->Select(0.001);
@@ -270,6 +404,8 @@ void EOServer::Tick()
 			throw;
 	}
 
+	this->select_wait->Record(this->watchdog.Mark("select"));
+
 	if (active_clients)
 	{
 		UTIL_FOREACH(*active_clients, client)
@@ -281,9 +417,105 @@ void EOServer::Tick()
 		active_clients->clear();
 	}
 
+	this->watchdog.Mark("clients");
+
 	this->BuryTheDead();
 
+	this->watchdog.Mark("bury");
+
 	this->world->timer.Tick();
+
+	this->watchdog.Mark("timers");
+
+	if (this->capture.IsOpen() && Timer::GetTime() >= this->capture_end)
+		this->StopCapture();
+
+	this->tick_duration->Record(this->watchdog.EndTick());
+}
+
+bool EOServer::StartTrace(double seconds)
+{
+	std::string format = this->world->settings.GetString(ConfigKey::TraceFile);
+	std::time_t rawtime = std::time(0);
+	char filename[256];
+
+	if (std::strftime(filename, sizeof filename, format.c_str(), std::localtime(&rawtime)) == 0)
+		return false;
+
+	if (!Trace::Start(filename, seconds))
+		return false;
+
+	Console::Out("Tracing to %s for %.0f seconds", filename, seconds);
+	return true;
+}
+
+void EOServer::CaptureWrite(Capture_Record &record)
+{
+	record.time = std::uint32_t((Timer::GetTime() - this->capture_start) * 1000.0);
+
+	if (!this->capture.Write(record))
+	{
+		Console::Err("Could not write to the capture file, stopping the capture");
+		this->StopCapture();
+	}
+}
+
+bool EOServer::StartCapture(double seconds)
+{
+	if (this->capture.IsOpen())
+		return false;
+
+	std::string format = this->world->settings.GetString(ConfigKey::CaptureFile);
+	std::time_t rawtime = std::time(0);
+	char filename[256];
+
+	if (std::strftime(filename, sizeof filename, format.c_str(), std::localtime(&rawtime)) == 0)
+		return false;
+
+	if (!this->capture.Open(filename))
+		return false;
+
+	this->capture_start = Timer::GetTime();
+	this->capture_end = this->capture_start + seconds;
+
+	Console::Out("Capturing packets to %s for %.0f seconds", filename, seconds);
+	return true;
+}
+
+void EOServer::StopCapture()
+{
+	if (!this->capture.IsOpen())
+		return;
+
+	this->capture.Close();
+	Console::Out("Packet capture finished after %.0f seconds", Timer::GetTime() - this->capture_start);
+}
+
+void EOServer::CapturePacket(const EOClient *client, PacketFamily family, PacketAction action, const std::string &payload)
+{
+	if (!this->capture.IsOpen())
+		return;
+
+	Capture_Record record;
+	record.type = Capture_Record::Packet;
+	record.client = (unsigned short)client->id;
+	record.family = family;
+	record.action = action;
+	record.payload = payload;
+
+	this->CaptureWrite(record);
+}
+
+void EOServer::CaptureClose(const EOClient *client)
+{
+	if (!this->capture.IsOpen())
+		return;
+
+	Capture_Record record;
+	record.type = Capture_Record::Close;
+	record.client = (unsigned short)client->id;
+
+	this->CaptureWrite(record);
 }
 
 void EOServer::RecordClientRejection(const IPAddress &ip, const char *reason)
@@ -337,6 +569,9 @@ void EOServer::ClearClientRejections(EOServer::connection_log_iterator it)
 
 EOServer::~EOServer()
 {
+	Trace::Stop();
+	this->StopCapture();
+
 	double shutdown_start_time = Timer::GetTime();
 
 	PacketBuilder builder(PACKET_MESSAGE, PACKET_CLOSE);
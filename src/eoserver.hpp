@@ -10,18 +10,27 @@
 
 #include "fwd/config.hpp"
 #include "fwd/eoclient.hpp"
+#include "fwd/metrics.hpp"
+#include "fwd/packet.hpp"
 #include "fwd/timer.hpp"
 #include "fwd/sln.hpp"
+#include "fwd/watchdog.hpp"
 #include "fwd/world.hpp"
 
+#include "capture.hpp"
+#include "metrics.hpp"
 #include "socket.hpp"
+#include "watchdog.hpp"
 
 #include <array>
+#include <cstddef>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
 void server_ping_all(void *server_void);
 void server_pump_queue(void *server_void);
+void server_publish_metrics(void *server_void);
 
 struct ConnectionLogEntry
 {
@@ -42,6 +51,21 @@ private:
 
 	TimeEvent *ping_timer = nullptr;
 
+	Metrics::Metric *tick_duration = nullptr;
+	Metrics::Metric *select_wait = nullptr;
+
+	// Indexed by [sent][family], created the first time a family is seen
+	std::array<std::array<Metrics::Metric *, 256>, 2> packet_count{};
+	std::array<std::array<Metrics::Metric *, 256>, 2> packet_bytes{};
+
+	void CountPacket(bool sent, PacketFamily family, std::size_t bytes);
+
+	Capture_Writer capture;
+	double capture_start = 0.0;
+	double capture_end = 0.0;
+
+	void CaptureWrite(Capture_Record &record);
+
 protected:
 	virtual Client *ClientFactory(const SocketImpl &sock) override; // Updated to use SocketImpl
 
@@ -53,6 +77,16 @@ public:
 	bool QuietConnectionErrors = false;
 	double HangupDelay = 10.0;
 
+	Metrics metrics;
+	std::unique_ptr<Metrics_Server> metrics_server;
+
+	/**
+	 * Longest action queue seen by server_pump_queue since metrics were last published
+	 */
+	std::size_t queue_depth_peak = 0;
+
+	Tick_Watchdog watchdog;
+
 	void UpdateConfig();
 
 	EOServer(IPAddress addr, unsigned short port, std::array<std::string, 6> dbinfo, const Config &eoserv_config, const Config &admin_config) : Server(addr, port)
@@ -62,6 +96,29 @@ public:
 
 	void Tick();
 
+	/**
+	 * Starts a trace written to the file named by TraceFile
+	 * Returns false if a trace is already running or the file could not be created.
+	 */
+	bool StartTrace(double seconds);
+
+	/**
+	 * Starts recording the packets clients send to the file named by CaptureFile
+	 * Returns false if a capture is already running or the file could not be created.
+	 */
+	bool StartCapture(double seconds);
+	void StopCapture();
+	bool Capturing() const { return this->capture.IsOpen(); }
+
+	/**
+	 * Records a packet while a capture is running, the payload follows the sequence number
+	 */
+	void CapturePacket(const EOClient *client, PacketFamily family, PacketAction action, const std::string &payload);
+	void CaptureClose(const EOClient *client);
+
+	void CountPacketIn(PacketFamily family, std::size_t bytes) { this->CountPacket(false, family, bytes); }
+	void CountPacketOut(PacketFamily family, std::size_t bytes) { this->CountPacket(true, family, bytes); }
+
 	void RecordClientRejection(const IPAddress &ip, const char *reason);
 	void ClearClientRejections(const IPAddress &ip);
 	void ClearClientRejections(connection_log_iterator);
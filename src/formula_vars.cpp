@@ -0,0 +1,120 @@
+/* formula_vars.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "formula_vars.hpp"
+
+#include "config.hpp"
+
+#include "util.hpp"
+#include "util/rpn.hpp"
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+struct Formula_Schema
+{
+	std::array<std::string, Formula_Frame::size> names;
+	std::array<double, Formula_Frame::size> defaults;
+	std::unordered_map<std::string, int> index;
+
+	Formula_Schema()
+	{
+		static const char *entity_names[] = {
+#define FORMULA_VAR_NAME(id, name) name,
+			FORMULA_ENTITY_VARS(FORMULA_VAR_NAME)
+		};
+
+		static const char *extra_names[] = {
+			FORMULA_EXTRA_VARS(FORMULA_VAR_NAME)
+#undef FORMULA_VAR_NAME
+		};
+
+		for (std::size_t i = 0; i < FV_COUNT; ++i)
+		{
+			names[i] = entity_names[i];
+			names[FV_COUNT + i] = std::string("target_") + entity_names[i];
+		}
+
+		for (std::size_t i = 0; i < FE_COUNT; ++i)
+			names[FV_COUNT * 2 + i] = extra_names[i];
+
+		for (std::size_t i = 0; i < Formula_Frame::size; ++i)
+		{
+			// Formula evaluation falls back to parsing an unbound variable's name as a number
+			defaults[i] = util::tdparse(names[i]);
+			index.insert({names[i], int(i)});
+		}
+	}
+};
+
+static const Formula_Schema &schema()
+{
+	static const Formula_Schema instance;
+	return instance;
+}
+
+Formula_Frame::Formula_Frame()
+	: values(schema().defaults)
+{
+}
+
+void Formula_Frame::Export(std::unordered_map<std::string, double> &vars) const
+{
+	const Formula_Schema &s = schema();
+
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		if (this->bound.test(i))
+			vars[s.names[i]] = this->values[i];
+	}
+}
+
+int Formula_Frame::Resolve(const std::string &name)
+{
+	const Formula_Schema &s = schema();
+	auto it = s.index.find(name);
+	return (it != s.index.end()) ? it->second : -1;
+}
+
+const std::string &Formula_Frame::Name(std::size_t index)
+{
+	return schema().names[index];
+}
+
+Formula_Batch::Formula_Batch(std::size_t lanes)
+	: lanes(lanes)
+	, values(Formula_Frame::size * lanes)
+{
+}
+
+void Formula_Batch::Store(std::size_t lane, const Formula_Frame &frame)
+{
+	const double *data = frame.data();
+
+	for (std::size_t i = 0; i < Formula_Frame::size; ++i)
+		this->values[i * this->lanes + lane] = data[i];
+}
+
+std::array<const double *, Formula_Frame::size> Formula_Batch::Columns(std::size_t first) const
+{
+	std::array<const double *, Formula_Frame::size> columns;
+
+	for (std::size_t i = 0; i < Formula_Frame::size; ++i)
+		columns[i] = this->values.data() + i * this->lanes + first;
+
+	return columns;
+}
+
+Formula_Parser formula_parser(const Config &formulas_config)
+{
+	auto version = formulas_config.find("Version");
+
+	if (version == formulas_config.end() || int(version->second) < 2)
+		return util::rpn_parse;
+
+	return util::rpn_parse_v2;
+}
@@ -0,0 +1,141 @@
+/* formula_vars.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef FORMULA_VARS_HPP_INCLUDED
+#define FORMULA_VARS_HPP_INCLUDED
+
+#include "fwd/formula_vars.hpp"
+
+#include "fwd/config.hpp"
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <stack>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Variables a Character or NPC provides to formulas, as (identifier, formula name) pairs
+ */
+#define FORMULA_ENTITY_VARS(X) \
+	X(level, "level") X(experience, "experience") X(hp, "hp") X(maxhp, "maxhp") X(tp, "tp") X(maxtp, "maxtp") X(maxsp, "maxsp") \
+	X(weight, "weight") X(maxweight, "maxweight") X(karma, "karma") X(mindam, "mindam") X(maxdam, "maxdam") \
+	X(str, "str") X(int, "int") X(wis, "wis") X(agi, "agi") X(con, "con") X(cha, "cha") \
+	X(base_str, "base_str") X(base_int, "base_int") X(base_wis, "base_wis") X(base_agi, "base_agi") X(base_con, "base_con") X(base_cha, "base_cha") \
+	X(display_str, "display_str") X(display_int, "display_int") X(display_wis, "display_wis") X(display_agi, "display_agi") X(display_con, "display_con") X(display_cha, "display_cha") \
+	X(accuracy, "accuracy") X(evade, "evade") X(armor, "armor") X(admin, "admin") X(bot, "bot") X(usage, "usage") \
+	X(class, "class") X(gender, "gender") X(race, "race") X(hairstyle, "hairstyle") X(haircolor, "haircolor") \
+	X(mapid, "mapid") X(x, "x") X(y, "y") X(direction, "direction") X(sitting, "sitting") X(hidden, "hidden") X(whispers, "whispers") X(goldbank, "goldbank") \
+	X(statpoints, "statpoints") X(skillpoints, "skillpoints") \
+	X(npc, "npc")
+
+/**
+ * Variables describing the attack itself rather than either side of it
+ */
+#define FORMULA_EXTRA_VARS(X) \
+	X(modifier, "modifier") X(damage, "damage") X(critical, "critical")
+
+enum Formula_Var
+{
+#define FORMULA_VAR_ENUM(id, name) FV_##id,
+	FORMULA_ENTITY_VARS(FORMULA_VAR_ENUM)
+#undef FORMULA_VAR_ENUM
+	FV_COUNT
+};
+
+enum Formula_Extra
+{
+#define FORMULA_VAR_ENUM(id, name) FE_##id,
+	FORMULA_EXTRA_VARS(FORMULA_VAR_ENUM)
+#undef FORMULA_VAR_ENUM
+	FE_COUNT
+};
+
+/**
+ * Array-backed set of formula variable values, laid out as the attacker's variables, the target's ("target_" prefixed) variables, then the extras
+ * Compiled formulas read it directly by index, so filling one does no string handling or allocation.
+ */
+class Formula_Frame
+{
+public:
+	enum Side
+	{
+		Self,
+		Target
+	};
+
+	static const std::size_t size = FV_COUNT * 2 + FE_COUNT;
+
+protected:
+	std::array<double, size> values;
+	std::bitset<size> bound;
+
+public:
+	/**
+	 * Starts with every variable unbound, which formulas see the same way as a variable missing from a map
+	 */
+	Formula_Frame();
+
+	void Set(Side side, Formula_Var var, double value)
+	{
+		std::size_t i = side * FV_COUNT + var;
+		this->values[i] = value;
+		this->bound.set(i);
+	}
+
+	void Set(Formula_Extra var, double value)
+	{
+		std::size_t i = FV_COUNT * 2 + var;
+		this->values[i] = value;
+		this->bound.set(i);
+	}
+
+	const double *data() const { return this->values.data(); }
+
+	/**
+	 * Copies the bound variables into a map under their formula names, for evaluators that look variables up by name
+	 */
+	void Export(std::unordered_map<std::string, double> &vars) const;
+
+	/**
+	 * Returns the frame index of a formula variable name, or -1 if it is not part of the schema
+	 */
+	static int Resolve(const std::string &name);
+
+	static const std::string &Name(std::size_t index);
+};
+
+/**
+ * Formula variables for many frames stored column by column, so one formula can be evaluated over a whole population at once
+ */
+class Formula_Batch
+{
+protected:
+	std::size_t lanes;
+	std::vector<double> values;
+
+public:
+	explicit Formula_Batch(std::size_t lanes);
+
+	std::size_t size() const { return this->lanes; }
+
+	void Store(std::size_t lane, const Formula_Frame &frame);
+
+	/**
+	 * Returns a pointer to each variable's column, starting at the given lane
+	 */
+	std::array<const double *, Formula_Frame::size> Columns(std::size_t first = 0) const;
+};
+
+typedef std::stack<std::string> (*Formula_Parser)(std::string expr);
+
+/**
+ * Returns the parser for the expressions in a formulas file, the original RPN-like syntax unless its Version is 2 or later
+ */
+Formula_Parser formula_parser(const Config &formulas_config);
+
+#endif // FORMULA_VARS_HPP_INCLUDED
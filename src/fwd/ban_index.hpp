@@ -0,0 +1,11 @@
+/* fwd/ban_index.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef FWD_BAN_INDEX_HPP_INCLUDED
+#define FWD_BAN_INDEX_HPP_INCLUDED
+
+class Ban_Index;
+
+#endif // FWD_BAN_INDEX_HPP_INCLUDED
@@ -0,0 +1,12 @@
+/* fwd/capture.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef FWD_CAPTURE_HPP_INCLUDED
+#define FWD_CAPTURE_HPP_INCLUDED
+
+struct Capture_Record;
+class Capture_Reader;
+
+#endif // FWD_CAPTURE_HPP_INCLUDED
@@ -10,4 +10,8 @@ class Database;
 
 class Database_Result;
 
+class Database_Cursor;
+
+class Database_Pool;
+
 #endif // FWD_DATABASE_HPP_INCLUDED
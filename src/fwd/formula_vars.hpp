@@ -0,0 +1,13 @@
+/* fwd/formula_vars.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef FWD_FORMULA_VARS_HPP_INCLUDED
+#define FWD_FORMULA_VARS_HPP_INCLUDED
+
+class Formula_Frame;
+
+class Formula_Batch;
+
+#endif // FWD_FORMULA_VARS_HPP_INCLUDED
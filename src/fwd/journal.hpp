@@ -0,0 +1,11 @@
+/* fwd/journal.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef FWD_JOURNAL_HPP_INCLUDED
+#define FWD_JOURNAL_HPP_INCLUDED
+
+class Journal;
+
+#endif // FWD_JOURNAL_HPP_INCLUDED
@@ -0,0 +1,12 @@
+/* fwd/metrics.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef FWD_METRICS_HPP_INCLUDED
+#define FWD_METRICS_HPP_INCLUDED
+
+class Metrics;
+class Metrics_Server;
+
+#endif // FWD_METRICS_HPP_INCLUDED
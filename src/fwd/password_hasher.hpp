@@ -0,0 +1,11 @@
+/* fwd/password_hasher.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef FWD_PASSWORD_HASHER_HPP_INCLUDED
+#define FWD_PASSWORD_HASHER_HPP_INCLUDED
+
+class Password_Hasher;
+
+#endif // FWD_PASSWORD_HASHER_HPP_INCLUDED
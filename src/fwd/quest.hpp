@@ -9,4 +9,11 @@
 class Quest;
 class Quest_Context;
 
+enum QuestTrigger : unsigned char
+{
+	QUEST_TRIGGER_ITEM,
+	QUEST_TRIGGER_SPELL,
+	QUEST_TRIGGER_MOVE
+};
+
 #endif // FWD_QUEST_HPP_INCLUDED
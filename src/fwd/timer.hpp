@@ -6,6 +6,8 @@
 #ifndef FWD_TIMER_HPP_INCLUDED
 #define FWD_TIMER_HPP_INCLUDED
 
+class Clock;
+class Manual_Clock;
 class Timer;
 
 struct TimeEvent;
@@ -0,0 +1,11 @@
+/* fwd/watchdog.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef FWD_WATCHDOG_HPP_INCLUDED
+#define FWD_WATCHDOG_HPP_INCLUDED
+
+class Tick_Watchdog;
+
+#endif // FWD_WATCHDOG_HPP_INCLUDED
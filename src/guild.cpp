@@ -122,14 +122,14 @@ std::shared_ptr<Guild> GuildManager::GetGuild(std::string tag)
 		std::shared_ptr<Guild> guild(new Guild(this));
 		guild->tag = static_cast<std::string>(row["tag"]);
 		guild->name = static_cast<std::string>(row["name"]);
-		guild->description = util::text_word_wrap(static_cast<std::string>(row["description"]), this->world->config["GuildMaxWidth"]);
+		guild->description = util::text_word_wrap(static_cast<std::string>(row["description"]), this->world->settings.GetInt(ConfigKey::GuildMaxWidth));
 		guild->created = static_cast<int>(row["created"]);
 		guild->ranks = RankUnserialize(static_cast<std::string>(row["ranks"]));
 		guild->bank = static_cast<int>(row["bank"]);
 
 		res = this->world->db.Query("SELECT `name`, `guild_rank`, `guild_rank_string` FROM `characters` WHERE `guild` = '$' ORDER BY `guild_rank` ASC, `name` ASC", tag.c_str());
 
-		UTIL_FOREACH_REF(res, row)
+		UTIL_FOREACH_CREF(res, row)
 		{
 			guild->members.push_back(std::make_shared<Guild_Member>(row["name"], row["guild_rank"], row["guild_rank_string"]));
 		}
@@ -171,7 +171,7 @@ std::shared_ptr<Guild> GuildManager::GetGuildName(std::string name)
 
 		res = this->world->db.Query("SELECT `name`, `guild_rank`, `guild_rank_string` FROM `characters` WHERE `guild` = '$' ORDER BY `guild_rank` ASC, `name` ASC", static_cast<std::string>(row["tag"]).c_str());
 
-		UTIL_FOREACH_REF(res, row)
+		UTIL_FOREACH_CREF(res, row)
 		{
 			guild->members.push_back(std::make_shared<Guild_Member>(row["name"], row["guild_rank"], row["guild_rank_string"]));
 		}
@@ -218,9 +218,9 @@ void GuildManager::CancelCreate(std::string create)
 
 std::shared_ptr<Guild> GuildManager::CreateGuild(std::shared_ptr<Guild_Create> create, std::string description)
 {
-	description = util::text_word_wrap(description, this->world->config["GuildMaxWidth"]);
+	description = util::text_word_wrap(description, this->world->settings.GetInt(ConfigKey::GuildMaxWidth));
 
-	this->world->db.Query("INSERT INTO `guilds` (`tag`, `name`, `description`, `created`, `ranks`) VALUES ('$', '$', '$', #, '$')", create->tag.c_str(), create->name.c_str(), description.c_str(), int(std::time(0)), static_cast<std::string>(this->world->config["GuildDefaultRanks"]).c_str());
+	this->world->db.Query("INSERT INTO `guilds` (`tag`, `name`, `description`, `created`, `ranks`) VALUES ('$', '$', '$', #, '$')", create->tag.c_str(), create->name.c_str(), description.c_str(), int(std::time(0)), this->world->settings.GetString(ConfigKey::GuildDefaultRanks).c_str());
 
 	this->create_cache.erase(create->tag);
 
@@ -259,7 +259,7 @@ bool GuildManager::ValidName(std::string name)
 {
 	name = util::lowercase(name);
 
-	if (name.length() < 4 || name.length() > std::size_t(int(this->world->config["GuildMaxNameLength"])))
+	if (name.length() < 4 || name.length() > std::size_t(this->world->settings.GetInt(ConfigKey::GuildMaxNameLength)))
 	{
 		return false;
 	}
@@ -299,7 +299,7 @@ bool GuildManager::ValidRank(std::string rank)
 {
 	rank = util::lowercase(rank);
 
-	if (rank.length() > std::size_t(int(this->world->config["GuildMaxRankLength"])))
+	if (rank.length() > std::size_t(this->world->settings.GetInt(ConfigKey::GuildMaxRankLength)))
 	{
 		return false;
 	}
@@ -319,7 +319,7 @@ bool GuildManager::ValidDescription(std::string description)
 {
 	description = util::lowercase(description);
 
-	if (description.length() > std::size_t(int(this->world->config["GuildMaxDescLength"])))
+	if (description.length() > std::size_t(this->world->settings.GetInt(ConfigKey::GuildMaxDescLength)))
 	{
 		return false;
 	}
@@ -357,14 +357,17 @@ void Guild::AddMember(Character *joined, Character *recruiter, bool alert, int r
 		joined->Send(builder);
 	}
 
-	if (alert && this->manager->world->config["GuildAnnounce"])
+	if (alert && this->manager->world->settings.GetBool(ConfigKey::GuildAnnounce))
 	{
 		std::string name = joined->real_name;
 
 		std::string msg = manager->world->i18n.Format("guild_join", util::ucfirst(name));
 
 		if (recruiter)
-			msg += " " + manager->world->i18n.Format("guild_recruit", util::ucfirst(recruiter->real_name));
+		{
+			msg += ' ';
+			manager->world->i18n.FormatInto(msg, "guild_recruit", util::ucfirst(recruiter->real_name));
+		}
 
 		this->Msg(0, msg);
 	}
@@ -374,12 +377,15 @@ void Guild::DelMember(std::string kicked, Character *kicker, bool alert)
 {
 	kicked = util::lowercase(kicked);
 
-	if (alert && this->manager->world->config["GuildAnnounce"])
+	if (alert && this->manager->world->settings.GetBool(ConfigKey::GuildAnnounce))
 	{
 		std::string msg = manager->world->i18n.Format("guild_leave", util::ucfirst(kicked));
 
 		if (kicker)
-			msg += " " + manager->world->i18n.Format("guild_kick", util::ucfirst(kicker->real_name));
+		{
+			msg += ' ';
+			manager->world->i18n.FormatInto(msg, "guild_kick", util::ucfirst(kicker->real_name));
+		}
 
 		this->Msg(0, msg);
 	}
@@ -470,7 +476,7 @@ void Guild::AddBank(int gold)
 	{
 		this->needs_save = true;
 		this->bank += gold;
-		this->bank = std::min<int>(this->bank, this->manager->world->config["GuildBankMax"]);
+		this->bank = std::min<int>(this->bank, this->manager->world->settings.GetInt(ConfigKey::GuildBankMax));
 	}
 }
 
@@ -487,7 +493,7 @@ void Guild::Disband(Character *disbander)
 {
 	std::vector<std::shared_ptr<Guild_Member>> disband_members = this->members;
 
-	if (this->manager->world->config["GuildAnnounce"])
+	if (this->manager->world->settings.GetBool(ConfigKey::GuildAnnounce))
 	{
 		this->Msg(0, manager->world->i18n.Format("guild_disband", util::ucfirst(disbander->real_name)));
 	}
@@ -527,12 +533,12 @@ void Guild::SetDescription(std::string description)
 		}
 	}
 
-	this->description = util::text_word_wrap(description, this->manager->world->config["GuildMaxWidth"]);
+	this->description = util::text_word_wrap(description, this->manager->world->settings.GetInt(ConfigKey::GuildMaxWidth));
 }
 
 void Guild::Msg(Character *from, std::string message, bool echo)
 {
-	message = util::text_cap(message, static_cast<int>(this->manager->world->config["ChatMaxWidth"]) - util::text_width(util::ucfirst(from ? from->SourceName() : "Server") + "  "));
+	message = util::text_cap(message, this->manager->world->settings.GetInt(ConfigKey::ChatMaxWidth) - util::text_width(util::ucfirst(from ? from->SourceName() : "Server") + "  "));
 
 	std::string from_name = from ? from->SourceName() : "Server";
 
@@ -18,7 +18,6 @@
 #include "../util/secure_string.hpp"
 
 #include <cstddef>
-#include <memory>
 #include <stdexcept>
 #include <string>
 #include <utility>
@@ -58,6 +57,20 @@ namespace Handlers
 		client->Send(reply);
 	}
 
+	static void account_create_reply(EOClient *client, AccountReply account_reply)
+	{
+		PacketBuilder reply(PACKET_ACCOUNT, PACKET_REPLY, 4);
+		reply.AddShort(account_reply);
+		reply.AddString(account_reply == ACCOUNT_CREATED ? "OK" : "NO");
+		client->Send(reply);
+
+		// sends config to control the account creation timer
+		PacketBuilder acc_creation_timer(PACKET_ACCOUNT, PACKET_CONFIG, 2);
+		acc_creation_timer.AddShort(static_cast<int>(client->server()->world->settings.GetFloat(ConfigKey::AccountCreationTimer)));
+
+		client->Send(acc_creation_timer);
+	}
+
 	// Account creation
 	void Account_Create(EOClient *client, PacketReader &reader)
 	{
@@ -71,7 +84,12 @@ namespace Handlers
 		std::string email = reader.GetBreakString();
 		std::string computer = reader.GetBreakString();
 
-		if (username.length() < std::size_t(int(client->server()->world->config["AccountMinLength"])) || username.length() > std::size_t(int(client->server()->world->config["AccountMaxLength"])) || password.str().length() < std::size_t(int(client->server()->world->config["PasswordMinLength"])) || password.str().length() > std::size_t(int(client->server()->world->config["PasswordMaxLength"])) || fullname.length() > std::size_t(int(client->server()->world->config["RealNameMaxLength"])) || location.length() > std::size_t(int(client->server()->world->config["LocationMaxLength"])) || email.length() > std::size_t(int(client->server()->world->config["EmailMaxLength"])) || computer.length() > std::size_t(int(client->server()->world->config["ComputerNameLength"])))
+		if (client->password_pending)
+		{
+			return;
+		}
+
+		if (username.length() < std::size_t(client->server()->world->settings.GetInt(ConfigKey::AccountMinLength)) || username.length() > std::size_t(client->server()->world->settings.GetInt(ConfigKey::AccountMaxLength)) || password.str().length() < std::size_t(client->server()->world->settings.GetInt(ConfigKey::PasswordMinLength)) || password.str().length() > std::size_t(client->server()->world->settings.GetInt(ConfigKey::PasswordMaxLength)) || fullname.length() > std::size_t(client->server()->world->settings.GetInt(ConfigKey::RealNameMaxLength)) || location.length() > std::size_t(client->server()->world->settings.GetInt(ConfigKey::LocationMaxLength)) || email.length() > std::size_t(client->server()->world->settings.GetInt(ConfigKey::EmailMaxLength)) || computer.length() > std::size_t(client->server()->world->settings.GetInt(ConfigKey::ComputerNameLength)))
 		{
 			return;
 		}
@@ -88,37 +106,57 @@ namespace Handlers
 
 		username = util::lowercase(username);
 
-		if (client->server()->world->config["SeoseCompat"])
-			password = std::move(seose_str_hash(password.str(), client->server()->world->config["SeoseCompatKey"]));
-
-		PacketBuilder reply(PACKET_ACCOUNT, PACKET_REPLY, 4);
+		if (client->server()->world->settings.GetBool(ConfigKey::SeoseCompat))
+			password = std::move(seose_str_hash(password.str(), client->server()->world->settings.GetString(ConfigKey::SeoseCompatKey)));
 
 		if (!Player::ValidName(username))
 		{
-			reply.AddShort(ACCOUNT_NOT_APPROVED);
-			reply.AddString("NO");
+			account_create_reply(client, ACCOUNT_NOT_APPROVED);
+			return;
 		}
 		else if (client->server()->world->PlayerExists(username))
 		{
-			reply.AddShort(ACCOUNT_EXISTS);
-			reply.AddString("NO");
+			account_create_reply(client, ACCOUNT_EXISTS);
+			return;
 		}
-		else
-		{
-			username = util::lowercase(username);
 
-			client->server()->world->CreatePlayer(username, std::move(password), fullname, location, email, computer, util::to_string(hdid), static_cast<std::string>(client->GetRemoteAddr()));
-			reply.AddShort(ACCOUNT_CREATED);
-			reply.AddString("OK");
-			Console::Out("New account: %s", username.c_str());
+		// The client has no reply for a busy server
+		if (client->server()->world->password_hasher.Full())
+		{
+			account_create_reply(client, ACCOUNT_NOT_APPROVED);
+			return;
 		}
 
-		client->Send(reply);
-		// sends config to control the account creation timer
-		PacketBuilder acc_creation_timer(PACKET_ACCOUNT, PACKET_CONFIG, 2);
-		acc_creation_timer.AddShort(static_cast<int>(util::tdparse(client->server()->world->config["AccountCreationTimer"])));
+		std::string ip = static_cast<std::string>(client->GetRemoteAddr());
 
-		client->Send(acc_creation_timer);
+		client->password_pending = true;
+
+		client->server()->world->password_hasher.Hash(client, username, std::move(password),
+			[=](const std::string &password_hash)
+			{
+				client->password_pending = false;
+
+				World *world = client->server()->world;
+
+				// Someone else may have registered the name while the password was hashing
+				if (world->PlayerExists(username))
+				{
+					account_create_reply(client, ACCOUNT_EXISTS);
+					return;
+				}
+
+				world->CreatePlayer(username, password_hash, fullname, location, email, computer, util::to_string(hdid), ip);
+				account_create_reply(client, ACCOUNT_CREATED);
+				Console::Out("New account: %s", username.c_str());
+			});
+	}
+
+	static void account_agree_reply(EOClient *client, AccountReply account_reply)
+	{
+		PacketBuilder reply(PACKET_ACCOUNT, PACKET_REPLY, 4);
+		reply.AddShort(account_reply);
+		reply.AddString(account_reply == ACCOUNT_CHANGED ? "OK" : "NO");
+		client->Send(reply);
 	}
 
 	// Change password
@@ -128,7 +166,7 @@ namespace Handlers
 		util::secure_string oldpassword(std::move(reader.GetBreakString()));
 		util::secure_string newpassword(std::move(reader.GetBreakString()));
 
-		if (username.length() < std::size_t(int(player->world->config["AccountMinLength"])) || username.length() > std::size_t(int(player->world->config["AccountMaxLength"])) || oldpassword.str().length() < std::size_t(int(player->world->config["PasswordMinLength"])) || oldpassword.str().length() > std::size_t(int(player->world->config["PasswordMaxLength"])) || newpassword.str().length() < std::size_t(int(player->world->config["PasswordMinLength"])) || newpassword.str().length() > std::size_t(int(player->world->config["PasswordMaxLength"])))
+		if (username.length() < std::size_t(player->world->settings.GetInt(ConfigKey::AccountMinLength)) || username.length() > std::size_t(player->world->settings.GetInt(ConfigKey::AccountMaxLength)) || oldpassword.str().length() < std::size_t(player->world->settings.GetInt(ConfigKey::PasswordMinLength)) || oldpassword.str().length() > std::size_t(player->world->settings.GetInt(ConfigKey::PasswordMaxLength)) || newpassword.str().length() < std::size_t(player->world->settings.GetInt(ConfigKey::PasswordMinLength)) || newpassword.str().length() > std::size_t(player->world->settings.GetInt(ConfigKey::PasswordMaxLength)))
 		{
 			return;
 		}
@@ -146,32 +184,41 @@ namespace Handlers
 			return;
 		}
 
-		if (player->world->config["SeoseCompat"])
-			oldpassword = std::move(seose_str_hash(oldpassword.str(), player->world->config["SeoseCompatKey"]));
+		if (player->world->settings.GetBool(ConfigKey::SeoseCompat))
+			oldpassword = std::move(seose_str_hash(oldpassword.str(), player->world->settings.GetString(ConfigKey::SeoseCompatKey)));
 
-		if (player->world->config["SeoseCompat"])
-			newpassword = std::move(seose_str_hash(newpassword.str(), player->world->config["SeoseCompatKey"]));
+		if (player->world->settings.GetBool(ConfigKey::SeoseCompat))
+			newpassword = std::move(seose_str_hash(newpassword.str(), player->world->settings.GetString(ConfigKey::SeoseCompatKey)));
 
-		{
-			std::unique_ptr<Player> changepass(player->world->Login(username, std::move(oldpassword)));
+		std::string stored_hash = player->world->GetPasswordHash(username);
+		EOClient *client = player->client;
 
-			if (!changepass)
-			{
-				PacketBuilder reply(PACKET_ACCOUNT, PACKET_REPLY, 4);
-				reply.AddShort(ACCOUNT_CHANGE_FAILED);
-				reply.AddString("NO");
-				player->Send(reply);
-				return;
-			}
-
-			changepass->ChangePass(std::move(newpassword));
+		if (stored_hash.empty() || client->password_pending || player->world->password_hasher.Full())
+		{
+			account_agree_reply(client, ACCOUNT_CHANGE_FAILED);
+			return;
 		}
 
-		PacketBuilder reply(PACKET_ACCOUNT, PACKET_REPLY, 4);
-		reply.AddShort(ACCOUNT_CHANGED);
-		reply.AddString("OK");
+		client->password_pending = true;
 
-		player->Send(reply);
+		player->world->password_hasher.Verify(client, username, std::move(oldpassword), stored_hash,
+			[client, username, newpassword](bool match, const std::string &) mutable
+			{
+				if (!match)
+				{
+					client->password_pending = false;
+					account_agree_reply(client, ACCOUNT_CHANGE_FAILED);
+					return;
+				}
+
+				client->server()->world->password_hasher.Hash(client, username, std::move(newpassword),
+					[client, username](const std::string &password_hash)
+					{
+						client->password_pending = false;
+						client->server()->world->SetPasswordHash(username, password_hash);
+						account_agree_reply(client, ACCOUNT_CHANGED);
+					});
+			});
 	}
 
 	PACKET_HANDLER_REGISTER(PACKET_ACCOUNT)
@@ -20,7 +20,7 @@ namespace Handlers
 	{
 		std::string message = reader.GetEndString();
 
-		if (character->world->config["OldReports"])
+		if (character->world->settings.GetBool(ConfigKey::OldReports))
 		{
 			message = character->world->i18n.Format("admin_request", message);
 			character->world->AdminMsg(character, message, static_cast<int>(character->world->admin_config["reports"]));
@@ -37,7 +37,7 @@ namespace Handlers
 		std::string reportee = reader.GetBreakString();
 		std::string message = reader.GetEndString();
 
-		if (character->world->config["OldReports"])
+		if (character->world->settings.GetBool(ConfigKey::OldReports))
 		{
 			message = character->world->i18n.Format("admin_report", reportee, message);
 			character->world->AdminMsg(character, message, static_cast<int>(character->world->admin_config["reports"]));
@@ -22,7 +22,7 @@ namespace Handlers
 
 		int ts_diff = timestamp - character->timestamp;
 
-		if (character->world->config["EnforceTimestamps"])
+		if (character->world->settings.GetBool(ConfigKey::EnforceTimestamps))
 		{
 			if (ts_diff < 48)
 			{
@@ -35,15 +35,15 @@ namespace Handlers
 		if (character->sitting != SIT_STAND)
 			return;
 
-		if (int(character->world->config["EnforceWeight"]) >= 1 && character->weight > character->maxweight)
+		if (character->world->settings.GetInt(ConfigKey::EnforceWeight) >= 1 && character->weight > character->maxweight)
 			return;
 
-		int limit_attack = character->world->config["LimitAttack"];
+		int limit_attack = character->world->settings.GetInt(ConfigKey::LimitAttack);
 
 		if (limit_attack != 0 && character->attacks >= limit_attack)
 			return;
 
-		if (!character->world->config["EnforceTimestamps"] || ts_diff >= 60)
+		if (!character->world->settings.GetBool(ConfigKey::EnforceTimestamps) || ts_diff >= 60)
 		{
 			direction = character->direction;
 		}
@@ -62,7 +62,7 @@ namespace Handlers
 			int newgold = character->goldbank + amount;
 
 			// Correct overflow checking
-			if (newgold < 0 || newgold > static_cast<int>(character->world->config["MaxBankGold"]))
+			if (newgold < 0 || newgold > character->world->settings.GetInt(ConfigKey::MaxBankGold))
 			{
 				character->StatusMsg("Cannot deposit: exceeds bank gold limit.");
 				return;
@@ -50,13 +50,13 @@ namespace Handlers
 		unsigned char style = reader.GetChar();
 		unsigned char color = reader.GetChar();
 
-		if (style > static_cast<int>(character->world->config["MaxHairStyle"]) || color > static_cast<int>(character->world->config["MaxHairColor"]))
+		if (style > character->world->settings.GetInt(ConfigKey::MaxHairStyle) || color > character->world->settings.GetInt(ConfigKey::MaxHairColor))
 		{
 			return;
 		}
 
-		int price = character->world->config["BarberBase"];
-		price += std::max(1, int(character->level)) * static_cast<int>(character->world->config["BarberStep"]);
+		int price = character->world->settings.GetInt(ConfigKey::BarberBase);
+		price += std::max(1, int(character->level)) * character->world->settings.GetInt(ConfigKey::BarberStep);
 
 		if (character->HasItem(1) < price)
 		{
@@ -69,8 +69,8 @@ namespace Handlers
 			}
 		}
 
-		subject = subject.substr(0, static_cast<int>(character->world->config["BoardMaxSubjectLength"]));
-		body = body.substr(0, static_cast<int>(character->world->config["BoardMaxPostLength"]));
+		subject = subject.substr(0, character->world->settings.GetInt(ConfigKey::BoardMaxSubjectLength));
+		body = body.substr(0, character->world->settings.GetInt(ConfigKey::BoardMaxPostLength));
 
 		int post_count = 0;
 		int recent_post_count = 0;
@@ -83,18 +83,18 @@ namespace Handlers
 				{
 					++post_count;
 
-					if (post_count >= static_cast<int>(character->world->config["BoardMaxUserPosts"]))
+					if (post_count >= character->world->settings.GetInt(ConfigKey::BoardMaxUserPosts))
 					{
 						// Not in the official EO servers, but nice to use
 						character->ShowBoard();
 						return;
 					}
 
-					if (post->time + static_cast<int>(character->world->config["BoardRecentPostTime"]) > Timer::GetTime())
+					if (post->time + character->world->settings.GetInt(ConfigKey::BoardRecentPostTime) > Timer::GetTime())
 					{
 						++recent_post_count;
 
-						if (recent_post_count >= static_cast<int>(character->world->config["BoardMaxUserRecentPosts"]))
+						if (recent_post_count >= character->world->settings.GetInt(ConfigKey::BoardMaxRecentPosts))
 						{
 							// Not in the official EO servers, but nice to use
 							character->ShowBoard();
@@ -114,16 +114,16 @@ namespace Handlers
 
 			character->board->posts.push_front(newpost);
 
-			if (character->board->id == static_cast<int>(character->world->config["AdminBoard"]))
+			if (character->board->id == character->world->settings.GetInt(ConfigKey::AdminBoard))
 			{
-				if (character->board->posts.size() > static_cast<std::size_t>(static_cast<int>(character->world->config["AdminBoardLimit"])))
+				if (character->board->posts.size() > static_cast<std::size_t>(character->world->settings.GetInt(ConfigKey::AdminBoardLimit)))
 				{
 					character->board->posts.pop_back();
 				}
 			}
 			else
 			{
-				if (character->board->posts.size() > static_cast<std::size_t>(static_cast<int>(character->world->config["BoardMaxPosts"])))
+				if (character->board->posts.size() > static_cast<std::size_t>(character->world->settings.GetInt(ConfigKey::BoardMaxPosts)))
 				{
 					character->board->posts.pop_back();
 				}
@@ -166,7 +166,7 @@ namespace Handlers
 			return;
 		}
 
-		if (boardid != static_cast<int>(character->world->config["AdminBoard"]) - 1 || character->SourceAccess() >= static_cast<int>(character->world->admin_config["reports"]))
+		if (boardid != character->world->settings.GetInt(ConfigKey::AdminBoard) - 1 || character->SourceAccess() >= static_cast<int>(character->world->admin_config["reports"]))
 		{
 			for (std::size_t y = 0; y < character->map->height; ++y)
 			{
@@ -45,12 +45,12 @@ namespace Handlers
 		std::string name = reader.GetBreakString();
 		name = util::lowercase(name);
 
-		if ((gender != GENDER_MALE && gender != GENDER_FEMALE) || hairstyle < static_cast<int>(player->world->config["CreateMinHairStyle"]) || hairstyle > static_cast<int>(player->world->config["CreateMaxHairStyle"]) || haircolor < static_cast<int>(player->world->config["CreateMinHairColor"]) || haircolor > static_cast<int>(player->world->config["CreateMaxHairColor"]) || race < static_cast<int>(player->world->config["CreateMinSkin"]) || race > static_cast<int>(player->world->config["CreateMaxSkin"]))
+		if ((gender != GENDER_MALE && gender != GENDER_FEMALE) || hairstyle < player->world->settings.GetInt(ConfigKey::CreateMinHairStyle) || hairstyle > player->world->settings.GetInt(ConfigKey::CreateMaxHairStyle) || haircolor < player->world->settings.GetInt(ConfigKey::CreateMinHairColor) || haircolor > player->world->settings.GetInt(ConfigKey::CreateMaxHairColor) || race < player->world->settings.GetInt(ConfigKey::CreateMinSkin) || race > player->world->settings.GetInt(ConfigKey::CreateMaxSkin))
 			return;
 
 		PacketBuilder reply(PACKET_CHARACTER, PACKET_REPLY, 2);
 
-		if (player->characters.size() >= static_cast<std::size_t>(static_cast<int>(player->world->config["MaxCharacters"])))
+		if (player->characters.size() >= static_cast<std::size_t>(player->world->settings.GetInt(ConfigKey::MaxCharacters)))
 		{
 			reply.AddShort(CHARACTER_FULL); // Reply code
 		}
@@ -44,7 +44,7 @@ namespace Handlers
 				{
 					if (chest->x == x && chest->y == y)
 					{
-						amount = std::min(amount, int(character->world->config["MaxChest"]) - chest->HasItem(id));
+						amount = std::min(amount, character->world->settings.GetInt(ConfigKey::MaxChest) - chest->HasItem(id));
 
 						if (character->HasItem(id) >= amount && chest->AddItem(id, amount))
 						{
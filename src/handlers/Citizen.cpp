@@ -34,9 +34,9 @@ namespace Handlers
 			unsigned int missing_tp = static_cast<unsigned int>(character->maxtp - character->tp);
 
 			unsigned int sleep_cost =
-				static_cast<int>(character->world->config["InnSleepCostBase"]) +
-				missing_hp * static_cast<int>(character->world->config["InnSleepCostPerHP"]) +
-				missing_tp * static_cast<int>(character->world->config["InnSleepCostPerTP"]);
+				character->world->settings.GetInt(ConfigKey::InnSleepCostBase) +
+				missing_hp * character->world->settings.GetInt(ConfigKey::InnSleepCostPerHP) +
+				missing_tp * character->world->settings.GetInt(ConfigKey::InnSleepCostPerTP);
 
 			PacketBuilder reply(PACKET_CITIZEN, PACKET_REQUEST, 4);
 			reply.AddInt(sleep_cost);
@@ -57,9 +57,9 @@ namespace Handlers
 			unsigned int missing_tp = static_cast<unsigned int>(character->maxtp - character->tp);
 
 			unsigned int sleep_cost =
-				static_cast<int>(character->world->config["InnSleepCostBase"]) +
-				missing_hp * static_cast<int>(character->world->config["InnSleepCostPerHP"]) +
-				missing_tp * static_cast<int>(character->world->config["InnSleepCostPerTP"]);
+				character->world->settings.GetInt(ConfigKey::InnSleepCostBase) +
+				missing_hp * character->world->settings.GetInt(ConfigKey::InnSleepCostPerHP) +
+				missing_tp * character->world->settings.GetInt(ConfigKey::InnSleepCostPerTP);
 
 			if (static_cast<unsigned int>(character->HasItem(1)) >= sleep_cost)
 			{
@@ -109,7 +109,7 @@ namespace Handlers
 		answers[1] = reader.GetBreakString();
 		answers[2] = reader.GetEndString();
 
-		if (character->npc_type == ENF::Inn && (character->home.size() == 0 || character->world->config["CitizenSubscribeAnytime"]))
+		if (character->npc_type == ENF::Inn && (character->home.size() == 0 || character->world->settings.GetBool(ConfigKey::CitizenSubscribeAnytime)))
 		{
 			int questions_wrong = 0;
 
@@ -143,7 +143,7 @@ namespace Handlers
 		{
 			PacketBuilder reply(PACKET_CITIZEN, PACKET_REMOVE, 1);
 
-			if (character->home == character->npc->Data().citizenship->home || character->world->config["CitizenUnsubscribeAnywhere"])
+			if (character->home == character->npc->Data().citizenship->home || character->world->settings.GetBool(ConfigKey::CitizenUnsubscribeAnywhere))
 			{
 				character->home = "";
 				reply.AddChar(UNSUBSCRIBE_UNSUBSCRIBED);
@@ -180,7 +180,7 @@ namespace Handlers
 
 				reply.AddThree(npc->ENF().vendor_id);
 
-				if (character->world->config["CitizenSubscribeAnytime"] && innkeeper_vend != npc->ENF().vendor_id)
+				if (character->world->settings.GetBool(ConfigKey::CitizenSubscribeAnytime) && innkeeper_vend != npc->ENF().vendor_id)
 					reply.AddChar(0);
 				else
 					reply.AddChar(innkeeper_vend);
@@ -32,7 +32,7 @@ namespace Handlers
 		std::string tag = reader.GetBreakString();
 		std::string name = reader.GetBreakString();
 
-		if (tag.length() > 3 || name.length() > std::size_t(int(character->world->config["GuildMaxNameLength"])))
+		if (tag.length() > 3 || name.length() > std::size_t(character->world->settings.GetInt(ConfigKey::GuildMaxNameLength)))
 		{
 			return;
 		}
@@ -41,7 +41,7 @@ namespace Handlers
 		{
 			if (!character->guild)
 			{
-				if (static_cast<int>(character->world->config["GuildCreateMembers"]) > 0)
+				if (character->world->settings.GetInt(ConfigKey::GuildCreateMembers) > 0)
 				{
 					std::shared_ptr<Guild> guild(character->world->guildmanager->GetGuild(tag));
 
@@ -54,7 +54,7 @@ namespace Handlers
 					{
 						if (character->world->guildmanager->ValidTag(tag) && character->world->guildmanager->ValidName(name))
 						{
-							if (character->HasItem(1) >= static_cast<int>(character->world->config["GuildPrice"]))
+							if (character->HasItem(1) >= character->world->settings.GetInt(ConfigKey::GuildPrice))
 							{
 								std::shared_ptr<class Guild_Create> create = character->world->guildmanager->BeginCreate(tag, name, character);
 								character->guild_create = create;
@@ -76,7 +76,7 @@ namespace Handlers
 									}
 								}
 
-								if (static_cast<int>(character->world->config["GuildCreateMembers"]) == 1)
+								if (character->world->settings.GetInt(ConfigKey::GuildCreateMembers) == 1)
 								{
 									PacketBuilder reply(PACKET_GUILD, PACKET_REPLY, 2);
 									reply.AddShort(GUILD_CREATE_ADD_CONFIRM);
@@ -118,7 +118,7 @@ namespace Handlers
 
 				PacketBuilder builder(PACKET_GUILD, PACKET_REPLY, 2 + character->real_name.length());
 
-				if (create->members.size() == static_cast<std::size_t>(static_cast<int>(character->world->config["GuildCreateMembers"])))
+				if (create->members.size() == static_cast<std::size_t>(character->world->settings.GetInt(ConfigKey::GuildCreateMembers)))
 				{
 					builder.AddShort(GUILD_CREATE_ADD_CONFIRM);
 				}
@@ -164,7 +164,7 @@ namespace Handlers
 				{
 				case GUILD_INFO_DESCRIPTION:
 				{
-					if (character->guild_rank <= static_cast<int>(character->world->config["GuildEditRank"]))
+					if (character->guild_rank <= character->world->settings.GetInt(ConfigKey::GuildEditRank))
 					{
 						std::string description = reader.GetEndString();
 
@@ -182,7 +182,7 @@ namespace Handlers
 
 				case GUILD_INFO_RANKS:
 				{
-					if (character->guild_rank <= static_cast<int>(character->world->config["GuildEditRank"]))
+					if (character->guild_rank <= character->world->settings.GetInt(ConfigKey::GuildEditRank))
 					{
 						decltype(character->guild->ranks) new_ranks(character->guild->ranks);
 
@@ -223,22 +223,22 @@ namespace Handlers
 		std::string name = reader.GetBreakString();
 		std::string description = reader.GetBreakString();
 
-		if (tag.length() > 3 || name.length() > std::size_t(int(character->world->config["GuildMaxNameLength"])) || !character->world->guildmanager->ValidDescription(description))
+		if (tag.length() > 3 || name.length() > std::size_t(character->world->settings.GetInt(ConfigKey::GuildMaxNameLength)) || !character->world->guildmanager->ValidDescription(description))
 		{
 			return;
 		}
 
 		if (character->npc_type == ENF::Guild)
 		{
-			if (!character->guild && character->HasItem(1) >= static_cast<int>(character->world->config["GuildPrice"]))
+			if (!character->guild && character->HasItem(1) >= character->world->settings.GetInt(ConfigKey::GuildPrice))
 			{
 				std::shared_ptr<class Guild_Create> create = character->world->guildmanager->GetCreate(tag);
 
-				if (create && create->leader == character && create->members.size() >= static_cast<std::size_t>(static_cast<int>(character->world->config["GuildCreateMembers"])))
+				if (create && create->leader == character && create->members.size() >= static_cast<std::size_t>(character->world->settings.GetInt(ConfigKey::GuildCreateMembers)))
 				{
 					std::shared_ptr<Guild> guild = character->world->guildmanager->CreateGuild(create, description);
 
-					character->DelItem(1, character->world->config["GuildPrice"]);
+					character->DelItem(1, character->world->settings.GetInt(ConfigKey::GuildPrice));
 
 					std::string rank_str = character->GuildRankString();
 
@@ -282,7 +282,7 @@ namespace Handlers
 					{
 						if (recruiter->guild && recruiter->guild->tag == tag)
 						{
-							if (recruiter->guild_rank <= static_cast<int>(character->world->config["GuildRecruitRank"]))
+							if (recruiter->guild_rank <= character->world->settings.GetInt(ConfigKey::GuildRecruitRank))
 							{
 								character->guild_join = tag;
 
@@ -337,7 +337,7 @@ namespace Handlers
 				{
 				case GUILD_INFO_DESCRIPTION:
 				{
-					if (character->guild_rank <= static_cast<int>(character->world->config["GuildEditRank"]))
+					if (character->guild_rank <= character->world->settings.GetInt(ConfigKey::GuildEditRank))
 					{
 						PacketBuilder reply(PACKET_GUILD, PACKET_TAKE, character->guild->description.length());
 						reply.AddString(character->guild->description);
@@ -349,9 +349,9 @@ namespace Handlers
 
 				case GUILD_INFO_RANKS:
 				{
-					if (character->guild_rank <= static_cast<int>(character->world->config["GuildEditRank"]))
+					if (character->guild_rank <= character->world->settings.GetInt(ConfigKey::GuildEditRank))
 					{
-						PacketBuilder reply(PACKET_GUILD, PACKET_RANK, character->guild->ranks.size() * (1 + int(character->world->config["GuildMaxRankLength"])));
+						PacketBuilder reply(PACKET_GUILD, PACKET_RANK, character->guild->ranks.size() * (1 + character->world->settings.GetInt(ConfigKey::GuildMaxRankLength)));
 
 						for (std::size_t i = 0; i < character->guild->ranks.size(); ++i)
 						{
@@ -383,16 +383,16 @@ namespace Handlers
 
 		Character *joiner = character->world->GetCharacterPID(pid);
 
-		if (character->guild && character->guild_rank <= static_cast<int>(character->world->config["GuildRecruitRank"]) && joiner && !joiner->guild && character->map == joiner->map && joiner->guild_join == character->guild->tag)
+		if (character->guild && character->guild_rank <= character->world->settings.GetInt(ConfigKey::GuildRecruitRank) && joiner && !joiner->guild && character->map == joiner->map && joiner->guild_join == character->guild->tag)
 		{
 			PacketBuilder reply(PACKET_GUILD, PACKET_REPLY, 2);
 
-			if (character->guild->bank >= static_cast<int>(character->world->config["RecruitCost"]))
+			if (character->guild->bank >= character->world->settings.GetInt(ConfigKey::RecruitCost))
 			{
-				if (character->guild->members.size() < static_cast<std::size_t>(static_cast<int>(character->world->config["GuildMaxMembers"])))
+				if (character->guild->members.size() < static_cast<std::size_t>(character->world->settings.GetInt(ConfigKey::GuildMaxMembers)))
 				{
 					character->guild->AddMember(joiner, character, true);
-					character->guild->DelBank(character->world->config["RecruitCost"]);
+					character->guild->DelBank(character->world->settings.GetInt(ConfigKey::RecruitCost));
 					reply.AddShort(GUILD_ACCEPTED);
 				}
 			}
@@ -423,14 +423,14 @@ namespace Handlers
 		{
 			if (character->guild)
 			{
-				int max_deposit = int(character->world->config["GuildBankMax"]) - character->guild->bank;
+				int max_deposit = character->world->settings.GetInt(ConfigKey::GuildBankMax) - character->guild->bank;
 
 				if (max_deposit <= 0)
 					return;
 
 				gold = std::min(gold, max_deposit);
 
-				if (gold >= static_cast<int>(character->world->config["GuildMinDeposit"]) && character->HasItem(1) >= gold)
+				if (gold >= character->world->settings.GetInt(ConfigKey::GuildMinDeposit) && character->HasItem(1) >= gold)
 				{
 					character->DelItem(1, gold);
 					character->guild->AddBank(gold);
@@ -471,7 +471,7 @@ namespace Handlers
 		/*int session = */ reader.GetInt();
 		std::string tag = reader.GetEndString();
 
-		if (tag.length() > std::size_t(int(character->world->config["GuildMaxNameLength"])))
+		if (tag.length() > std::size_t(character->world->settings.GetInt(ConfigKey::GuildMaxNameLength)))
 		{
 			return;
 		}
@@ -507,7 +507,7 @@ namespace Handlers
 				reply.AddByte(255);
 				reply.AddBreakString(member->name);
 
-				if (character->world->config["GuildCustomRanks"] && !member->rank_string.empty())
+				if (character->world->settings.GetBool(ConfigKey::GuildCustomRanks) && !member->rank_string.empty())
 				{
 					reply.AddBreakString(member->rank_string);
 				}
@@ -527,7 +527,7 @@ namespace Handlers
 		/*int session =*/reader.GetInt();
 		std::string tag = reader.GetEndString();
 
-		if (tag.length() > std::size_t(int(character->world->config["GuildMaxNameLength"])))
+		if (tag.length() > std::size_t(character->world->settings.GetInt(ConfigKey::GuildMaxNameLength)))
 		{
 			return;
 		}
@@ -553,8 +553,8 @@ namespace Handlers
 			}
 			else
 			{
-				int leader_rank = std::max(static_cast<int>(character->world->config["GuildEditRank"]), static_cast<int>(character->world->config["GuildKickRank"]));
-				int recruiter_rank = character->world->config["GuildRecruitRank"];
+				int leader_rank = std::max(character->world->settings.GetInt(ConfigKey::GuildEditRank), character->world->settings.GetInt(ConfigKey::GuildKickRank));
+				int recruiter_rank = character->world->settings.GetInt(ConfigKey::GuildRecruitRank);
 
 				std::list<std::shared_ptr<Guild_Member>> leaders;
 				std::list<std::shared_ptr<Guild_Member>> recruiters;
@@ -567,7 +567,7 @@ namespace Handlers
 					}
 				}
 
-				if (character->world->config["GuildShowRecruiters"])
+				if (character->world->settings.GetBool(ConfigKey::GuildShowRecruiters))
 				{
 					UTIL_FOREACH(guild->members, member)
 					{
@@ -582,7 +582,7 @@ namespace Handlers
 				create_date.resize(31);
 
 				tm *local_time = localtime(&guild->created);
-				create_date = create_date.substr(0, strftime(&create_date[0], 31, static_cast<std::string>(character->world->config["GuildDateFormat"]).c_str(), local_time));
+				create_date = create_date.substr(0, strftime(&create_date[0], 31, character->world->settings.GetString(ConfigKey::GuildDateFormat).c_str(), local_time));
 
 				std::string bank_str = util::to_string(guild->bank);
 
@@ -639,7 +639,7 @@ namespace Handlers
 		{
 			if (character->guild)
 			{
-				if (character->guild_rank <= static_cast<int>(character->world->config["GuildDisbandRank"]))
+				if (character->guild_rank <= character->world->settings.GetInt(ConfigKey::GuildDisbandRank))
 				{
 					character->guild->Disband(character);
 				}
@@ -662,7 +662,7 @@ namespace Handlers
 		{
 			if (character->guild)
 			{
-				if (character->guild_rank <= static_cast<int>(character->world->config["GuildKickRank"]))
+				if (character->guild_rank <= character->world->settings.GetInt(ConfigKey::GuildKickRank))
 				{
 					std::shared_ptr<Guild_Member> target = character->guild->GetMember(name);
 
@@ -721,7 +721,7 @@ namespace Handlers
 					}
 					else if (rank == 0)
 					{
-						if (character->guild_rank == 0 && character->world->config["GuildMultipleFounders"])
+						if (character->guild_rank == 0 && character->world->settings.GetBool(ConfigKey::GuildMultipleFounders))
 						{
 							character->guild->SetMemberRank(target->name, 0);
 							PacketBuilder reply(PACKET_GUILD, PACKET_REPLY, 2);
@@ -735,18 +735,18 @@ namespace Handlers
 
 						if (rank <= target->rank)
 						{
-							has_perm = has_perm || (character->guild_rank <= int(character->world->config["GuildPromoteRank"]));
+							has_perm = has_perm || (character->guild_rank <= character->world->settings.GetInt(ConfigKey::GuildPromoteRank));
 						}
 						else if (rank >= target->rank)
 						{
-							has_perm = has_perm || (character->guild_rank <= int(character->world->config["GuildDemoteRank"]));
+							has_perm = has_perm || (character->guild_rank <= character->world->settings.GetInt(ConfigKey::GuildDemoteRank));
 						}
 
 						if (has_perm)
 						{
 							if (character->guild_rank == 0 || character->guild_rank < target->rank)
 							{
-								if (rank > character->guild_rank || (character->guild_rank <= int(character->world->config["GuildPromoteSameRank"]) && character->guild_rank <= rank))
+								if (rank > character->guild_rank || (character->guild_rank <= character->world->settings.GetInt(ConfigKey::GuildPromoteSameRank) && character->guild_rank <= rank))
 								{
 									character->guild->SetMemberRank(target->name, rank);
 									PacketBuilder reply(PACKET_GUILD, PACKET_REPLY, 2);
@@ -78,11 +78,11 @@ namespace Handlers
 			}
 		}
 
-		const bool ignore_hdid = client->server()->world->config["IgnoreHDID"];
+		const bool ignore_hdid = client->server()->world->settings.GetBool(ConfigKey::IgnoreHDID);
 
 		if (!ignore_hdid)
 		{
-			const int max_per_pc = int(client->server()->world->config["MaxConnectionsPerPC"]);
+			const int max_per_pc = client->server()->world->settings.GetInt(ConfigKey::MaxConnectionsPerPC);
 
 			if (max_per_pc != 0 && pc_connections > max_per_pc)
 			{
@@ -116,13 +116,13 @@ namespace Handlers
 			return;
 		}
 
-		int minversion = client->server()->world->config["MinVersion"];
+		int minversion = client->server()->world->settings.GetInt(ConfigKey::MinVersion);
 		if (!minversion)
 		{
-			minversion = client->server()->world->config["OldVersionCompat"] ? 27 : 28;
+			minversion = client->server()->world->settings.GetBool(ConfigKey::OldVersionCompat) ? 27 : 28;
 		}
 
-		int maxversion = client->server()->world->config["MaxVersion"];
+		int maxversion = client->server()->world->settings.GetInt(ConfigKey::MaxVersion);
 		if (!maxversion)
 		{
 			maxversion = 28;
@@ -133,7 +133,7 @@ namespace Handlers
 		if (prot != 112)
 			accepted_version = false;
 
-		if (client->server()->world->config["CheckVersion"] && !accepted_version)
+		if (client->server()->world->settings.GetBool(ConfigKey::CheckVersion) && !accepted_version)
 		{
 			client->server()->RecordClientRejection(client->GetRemoteAddr(), "out of date");
 			reply.AddByte(INIT_OUT_OF_DATE);
@@ -112,7 +112,7 @@ namespace Handlers
 				int hpgain = item.hp;
 				int tpgain = item.tp;
 
-				if (character->world->config["LimitDamage"])
+				if (character->world->settings.GetBool(ConfigKey::LimitDamage))
 				{
 					hpgain = std::min(hpgain, character->maxhp - character->hp);
 					tpgain = std::min(tpgain, character->maxtp - character->tp);
@@ -127,7 +127,7 @@ namespace Handlers
 				character->hp += hpgain;
 				character->tp += tpgain;
 
-				if (!character->world->config["LimitDamage"])
+				if (!character->world->settings.GetBool(ConfigKey::LimitDamage))
 				{
 					character->hp = std::min(character->hp, character->maxhp);
 					character->tp = std::min(character->tp, character->maxtp);
@@ -304,14 +304,14 @@ namespace Handlers
 
 				character->exp += item.expreward;
 
-				character->exp = std::min(character->exp, static_cast<int>(character->map->world->config["MaxExp"]));
+				character->exp = std::min(character->exp, character->map->world->settings.GetInt(ConfigKey::MaxExp));
 
-				while (character->level < static_cast<int>(character->map->world->config["MaxLevel"]) && character->exp >= character->map->world->exp_table[character->level + 1])
+				while (character->level < character->map->world->settings.GetInt(ConfigKey::MaxLevel) && character->exp >= character->map->world->exp_table[character->level + 1])
 				{
 					level_up = true;
 					++character->level;
-					character->statpoints += static_cast<int>(character->map->world->config["StatPerLevel"]);
-					character->skillpoints += static_cast<int>(character->map->world->config["SkillPerLevel"]);
+					character->statpoints += character->map->world->settings.GetInt(ConfigKey::StatPerLevel);
+					character->skillpoints += character->map->world->settings.GetInt(ConfigKey::SkillPerLevel);
 					character->CalculateStats();
 				}
 
@@ -390,7 +390,7 @@ namespace Handlers
 		unsigned char x = reader.GetByte(); // ?
 		unsigned char y = reader.GetByte(); // ?
 
-		amount = std::min<int>(amount, character->world->config["MaxDrop"]);
+		amount = std::min<int>(amount, character->world->settings.GetInt(ConfigKey::MaxDrop));
 
 		if (amount <= 0)
 		{
@@ -410,7 +410,7 @@ namespace Handlers
 
 		int distance = util::path_length(x, y, character->x, character->y);
 
-		if (distance > static_cast<int>(character->world->config["DropDistance"]))
+		if (distance > character->world->settings.GetInt(ConfigKey::DropDistance))
 		{
 			return;
 		}
@@ -420,14 +420,14 @@ namespace Handlers
 			return;
 		}
 
-		if (character->HasItem(id) >= amount && character->mapid != static_cast<int>(character->world->config["JailMap"]))
+		if (character->HasItem(id) >= amount && character->mapid != character->world->settings.GetInt(ConfigKey::JailMap))
 		{
 			std::shared_ptr<Map_Item> item = character->map->AddItem(id, amount, x, y, character);
 
 			if (item)
 			{
 				item->owner = character->PlayerID();
-				item->unprotecttime = Timer::GetTime() + static_cast<double>(character->world->config["ProtectPlayerDrop"]);
+				item->unprotecttime = Timer::GetTime() + character->world->settings.GetFloat(ConfigKey::ProtectPlayerDrop);
 				character->DelItem(id, amount);
 
 				PacketBuilder reply(PACKET_ITEM, PACKET_DROP, 15);
@@ -481,7 +481,7 @@ namespace Handlers
 		{
 			int distance = util::path_length(item->x, item->y, character->x, character->y);
 
-			if (distance > static_cast<int>(character->world->config["DropDistance"]))
+			if (distance > character->world->settings.GetInt(ConfigKey::DropDistance))
 			{
 				return;
 			}
@@ -57,15 +57,15 @@ namespace Handlers
 		reader.GetChar();
 		short track = reader.GetShort();
 
-		if (!character->jukebox_open || character->map->jukebox_protect > Timer::GetTime() || (track < 0 || track > static_cast<int>(character->world->config["JukeboxSongs"])) || character->HasItem(1) < static_cast<int>(character->world->config["JukeboxPrice"]))
+		if (!character->jukebox_open || character->map->jukebox_protect > Timer::GetTime() || (track < 0 || track > character->world->settings.GetInt(ConfigKey::JukeboxSongs)) || character->HasItem(1) < character->world->settings.GetInt(ConfigKey::JukeboxPrice))
 		{
 			return;
 		}
 
-		character->DelItem(1, static_cast<int>(character->world->config["JukeboxPrice"]));
+		character->DelItem(1, character->world->settings.GetInt(ConfigKey::JukeboxPrice));
 
 		character->map->jukebox_player = character->SourceName();
-		character->map->jukebox_protect = Timer::GetTime() + static_cast<int>(character->world->config["JukeboxTimer"]);
+		character->map->jukebox_protect = Timer::GetTime() + character->world->settings.GetInt(ConfigKey::JukeboxTimer);
 
 		PacketBuilder reply(PACKET_JUKEBOX, PACKET_AGREE, 4);
 		reply.AddInt(character->HasItem(1));
@@ -60,7 +60,7 @@ namespace Handlers
 		if (character->HasItem(item) < amount)
 			return;
 
-		std::size_t lockermax = static_cast<int>(character->world->config["BaseBankSize"]) + character->bankmax * static_cast<int>(character->world->config["BankSizeStep"]);
+		std::size_t lockermax = character->world->settings.GetInt(ConfigKey::BaseBankSize) + character->bankmax * character->world->settings.GetInt(ConfigKey::BankSizeStep);
 
 		if (util::path_length(character->x, character->y, x, y) <= 1)
 		{
@@ -75,7 +75,7 @@ namespace Handlers
 							return;
 						}
 
-						amount = std::min<int>(amount, static_cast<int>(character->world->config["MaxBank"]) - it->amount);
+						amount = std::min<int>(amount, character->world->settings.GetInt(ConfigKey::MaxBank) - it->amount);
 
 						it->amount += amount;
 
@@ -90,7 +90,7 @@ namespace Handlers
 					return;
 				}
 
-				amount = std::min<int>(amount, static_cast<int>(character->world->config["MaxBank"]));
+				amount = std::min<int>(amount, character->world->settings.GetInt(ConfigKey::MaxBank));
 
 				Character_Item newitem;
 				newitem.id = item;
@@ -190,9 +190,9 @@ namespace Handlers
 
 		if (character->npc_type == ENF::Bank)
 		{
-			int cost = static_cast<int>(character->world->config["BankUpgradeBase"]) + character->bankmax * static_cast<int>(character->world->config["BankUpgradeStep"]);
+			int cost = character->world->settings.GetInt(ConfigKey::BankUpgradeBase) + character->bankmax * character->world->settings.GetInt(ConfigKey::BankUpgradeStep);
 
-			if (character->bankmax >= static_cast<int>(character->world->config["MaxBankUpgrades"]))
+			if (character->bankmax >= character->world->settings.GetInt(ConfigKey::MaxBankUpgrades))
 			{
 				return;
 			}
@@ -10,6 +10,7 @@
 #include "../eodata.hpp"
 #include "../eoserver.hpp"
 #include "../packet.hpp"
+#include "../password_hasher.hpp"
 #include "../player.hpp"
 #include "../world.hpp"
 #include "../extra/seose_compat.hpp"
@@ -24,21 +25,98 @@
 namespace Handlers
 {
 
+	// Finishes a login request once the password has been checked
+	static void login_complete(EOClient *client, const std::string &username, LoginReply login_reply)
+	{
+		if (login_reply == LOGIN_OK)
+		{
+			if (client->server()->world->PlayerOnline(username))
+			{
+				login_reply = LOGIN_LOGGEDIN;
+			}
+			else if (client->server()->world->characters.size() >= static_cast<std::size_t>(client->server()->world->settings.GetInt(ConfigKey::MaxPlayers)))
+			{
+				PacketBuilder reply(PACKET_LOGIN, PACKET_REPLY, 2);
+				reply.AddShort(LOGIN_BUSY);
+				client->Send(reply);
+				client->Close();
+				return;
+			}
+		}
+
+		if (login_reply != LOGIN_OK)
+		{
+			PacketBuilder reply(PACKET_LOGIN, PACKET_REPLY, 2);
+			reply.AddShort(login_reply);
+			client->Send(reply);
+
+			int max_login_attempts = client->server()->world->settings.GetInt(ConfigKey::MaxLoginAttempts);
+
+			if (max_login_attempts != 0 && ++client->login_attempts >= max_login_attempts)
+			{
+				client->Close();
+			}
+
+			return;
+		}
+
+		client->player = client->server()->world->Login(username);
+
+		if (!client->player)
+		{
+			// Someone deleted the account between checking it and logging in
+			PacketBuilder reply(PACKET_LOGIN, PACKET_REPLY, 2);
+			reply.AddShort(LOGIN_WRONG_USER);
+			client->Send(reply);
+			return;
+		}
+
+		client->player->id = client->id;
+		client->player->client = client;
+		client->state = EOClient::LoggedIn;
+
+		PacketBuilder reply(PACKET_LOGIN, PACKET_REPLY, 5 + client->player->characters.size() * 34);
+		reply.AddShort(LOGIN_OK);
+		reply.AddChar(client->player->characters.size());
+		reply.AddByte(2);
+		reply.AddByte(255);
+		UTIL_FOREACH(client->player->characters, character)
+		{
+			reply.AddBreakString(character->SourceName());
+			reply.AddInt(character->id);
+			reply.AddChar(character->level);
+			reply.AddChar(character->gender);
+			reply.AddChar(character->hairstyle);
+			reply.AddChar(character->haircolor);
+			reply.AddChar(character->race);
+			reply.AddChar(character->admin);
+			character->AddPaperdollData(reply, "BAHSW");
+
+			reply.AddByte(255);
+		}
+		client->Send(reply);
+	}
+
 	// Log in to an account
 	void Login_Request(EOClient *client, PacketReader &reader)
 	{
 		std::string username = reader.GetBreakString();
 		util::secure_string password(std::move(reader.GetBreakString()));
 
-		if (username.length() > std::size_t(int(client->server()->world->config["AccountMaxLength"])) || password.str().length() > std::size_t(int(client->server()->world->config["PasswordMaxLength"])))
+		if (client->password_pending)
+		{
+			return;
+		}
+
+		if (username.length() > std::size_t(client->server()->world->settings.GetInt(ConfigKey::AccountMaxLength)) || password.str().length() > std::size_t(client->server()->world->settings.GetInt(ConfigKey::PasswordMaxLength)))
 		{
 			return;
 		}
 
 		username = util::lowercase(username);
 
-		if (client->server()->world->config["SeoseCompat"])
-			password = std::move(seose_str_hash(password.str(), client->server()->world->config["SeoseCompatKey"]));
+		if (client->server()->world->settings.GetBool(ConfigKey::SeoseCompat))
+			password = std::move(seose_str_hash(password.str(), client->server()->world->settings.GetString(ConfigKey::SeoseCompatKey)));
 
 		if (client->server()->world->CheckBan(&username, 0, 0) != -1)
 		{
@@ -50,7 +128,7 @@ namespace Handlers
 			return;
 		}
 
-		if (username.length() < std::size_t(int(client->server()->world->config["AccountMinLength"])))
+		if (username.length() < std::size_t(client->server()->world->settings.GetInt(ConfigKey::AccountMinLength)))
 		{
 			PacketBuilder reply(PACKET_LOGIN, PACKET_REPLY, 2);
 			reply.AddShort(LOGIN_WRONG_USER);
@@ -58,7 +136,7 @@ namespace Handlers
 			return;
 		}
 
-		if (password.str().length() < std::size_t(int(client->server()->world->config["PasswordMinLength"])))
+		if (password.str().length() < std::size_t(client->server()->world->settings.GetInt(ConfigKey::PasswordMinLength)))
 		{
 			PacketBuilder reply(PACKET_LOGIN, PACKET_REPLY, 2);
 			reply.AddShort(LOGIN_WRONG_USERPASS);
@@ -66,7 +144,7 @@ namespace Handlers
 			return;
 		}
 
-		if (client->server()->world->characters.size() >= static_cast<std::size_t>(static_cast<int>(client->server()->world->config["MaxPlayers"])))
+		if (client->server()->world->characters.size() >= static_cast<std::size_t>(client->server()->world->settings.GetInt(ConfigKey::MaxPlayers)))
 		{
 			PacketBuilder reply(PACKET_LOGIN, PACKET_REPLY, 2);
 			reply.AddShort(LOGIN_BUSY);
@@ -75,59 +153,38 @@ namespace Handlers
 			return;
 		}
 
-		LoginReply login_reply = client->server()->world->LoginCheck(username, std::move(password));
+		Password_Hasher &hasher = client->server()->world->password_hasher;
 
-		if (login_reply != LOGIN_OK)
+		if (hasher.Full())
 		{
 			PacketBuilder reply(PACKET_LOGIN, PACKET_REPLY, 2);
-			reply.AddShort(login_reply);
+			reply.AddShort(LOGIN_BUSY);
 			client->Send(reply);
-
-			int max_login_attempts = int(client->server()->world->config["MaxLoginAttempts"]);
-
-			if (max_login_attempts != 0 && ++client->login_attempts >= max_login_attempts)
-			{
-				client->Close();
-			}
-
 			return;
 		}
 
-		client->player = client->server()->world->Login(username);
+		std::string stored_hash = client->server()->world->GetPasswordHash(username);
+		bool exists = !stored_hash.empty();
 
-		if (!client->player)
-		{
-			// Someone deleted the account between checking it and logging in
-			PacketBuilder reply(PACKET_LOGIN, PACKET_REPLY, 2);
-			reply.AddShort(LOGIN_WRONG_USER);
-			client->Send(reply);
-			return;
-		}
+		// Unknown accounts take as long to reject as a wrong password
+		if (!exists)
+			stored_hash = Password_Hasher::DummyHash(hasher.GetSettings());
 
-		client->player->id = client->id;
-		client->player->client = client;
-		client->state = EOClient::LoggedIn;
+		client->password_pending = true;
 
-		PacketBuilder reply(PACKET_LOGIN, PACKET_REPLY, 5 + client->player->characters.size() * 34);
-		reply.AddShort(LOGIN_OK);
-		reply.AddChar(client->player->characters.size());
-		reply.AddByte(2);
-		reply.AddByte(255);
-		UTIL_FOREACH(client->player->characters, character)
-		{
-			reply.AddBreakString(character->SourceName());
-			reply.AddInt(character->id);
-			reply.AddChar(character->level);
-			reply.AddChar(character->gender);
-			reply.AddChar(character->hairstyle);
-			reply.AddChar(character->haircolor);
-			reply.AddChar(character->race);
-			reply.AddChar(character->admin);
-			character->AddPaperdollData(reply, "BAHSW");
+		hasher.Verify(client, username, std::move(password), stored_hash,
+			[client, username, exists](bool match, const std::string &rehash)
+			{
+				client->password_pending = false;
 
-			reply.AddByte(255);
-		}
-		client->Send(reply);
+				if (exists && !rehash.empty())
+					client->server()->world->SetPasswordHash(username, rehash);
+
+				if (!client->Connected())
+					return;
+
+				login_complete(client, username, (exists && match) ? LOGIN_OK : LOGIN_WRONG_USERPASS);
+			});
 	}
 
 	PACKET_HANDLER_REGISTER(PACKET_LOGIN)
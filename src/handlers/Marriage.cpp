@@ -62,7 +62,7 @@ namespace Handlers
 					return;
 				}
 
-				int marriage_price = character->world->config["MarriagePrice"];
+				int marriage_price = character->world->settings.GetInt(ConfigKey::MarriagePrice);
 
 				if (!character->HasItem(1, marriage_price))
 				{
@@ -91,7 +91,7 @@ namespace Handlers
 					return;
 				}
 
-				int divorce_price = character->world->config["DivorcePrice"];
+				int divorce_price = character->world->settings.GetInt(ConfigKey::DivorcePrice);
 
 				if (!character->HasItem(1, divorce_price))
 				{
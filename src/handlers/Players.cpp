@@ -57,7 +57,7 @@ namespace Handlers
 			return !(from_character && (from_character == character || (from_character->admin >= seehide && character->admin < cmdprotect) || (from_character->admin >= seehide && character->admin >= cmdprotect && from_character->admin > character->admin)));
 		};
 
-		if (!client->server()->world->config["SLN"] && !client->server()->world->config["AllowStats"] && !from_character)
+		if (!client->server()->world->settings.GetBool(ConfigKey::SLN) && !client->server()->world->settings.GetBool(ConfigKey::AllowStats) && !from_character)
 		{
 			return;
 		}
@@ -73,26 +73,31 @@ namespace Handlers
 		}
 
 		bool is_friends_list = (reader.Action() == PACKET_LIST);
-		std::string hidden_admin_suffix = client->server()->world->i18n.Format("hidden_admin_suffix");
+		std::string hidden_admin_suffix = " ";
+		client->server()->world->i18n.FormatInto(hidden_admin_suffix, "hidden_admin_suffix");
 
 		PacketBuilder reply(PACKET_F_INIT, PACKET_A_INIT, 4 + online * (is_friends_list ? 13 : (36 + hidden_admin_suffix.length())));
 		reply.AddChar(is_friends_list ? INIT_FRIEND_LIST_PLAYERS : INIT_PLAYERS);
 		reply.AddShort(online);
 		reply.AddByte(255);
+
+		// Reused for every name, so a full server doesn't allocate a string per player
+		std::string name;
+
 		UTIL_FOREACH(client->server()->world->characters, character)
 		{
 			bool hide_online = character->IsHideOnline();
 			bool hide_admin = character->IsHideAdmin();
 
-			std::string name_suffix;
-
 			if (hide_online && really_hidden(character))
 				continue;
 
+			name = character->SourceName();
+
 			if (hide_online)
-				name_suffix = " " + hidden_admin_suffix;
+				name += hidden_admin_suffix;
 
-			reply.AddBreakString(character->SourceName() + name_suffix);
+			reply.AddBreakString(name);
 
 			// Full information is not sent for friends list requests
 			if (!is_friends_list)
@@ -100,8 +100,8 @@ namespace Handlers
 			int armor = character->paperdoll[Character::EquipLocation::Armor];
 			int partner_armor = partner->paperdoll[Character::EquipLocation::Armor];
 
-			int male_outfit = character->world->config["WeddingOutfitMale"];
-			int female_outfit = character->world->config["WeddingOutfitFemale"];
+			int male_outfit = character->world->settings.GetInt(ConfigKey::WeddingOutfitMale);
+			int female_outfit = character->world->settings.GetInt(ConfigKey::WeddingOutfitFemale);
 
 			if ((character->gender == GENDER_MALE && male_outfit != 0 && armor != male_outfit) || (character->gender == GENDER_FEMALE && female_outfit != 0 && armor != female_outfit))
 			{
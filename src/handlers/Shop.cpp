@@ -77,7 +77,7 @@ namespace Handlers
 		int amount = reader.GetInt();
 		/*int shopid = reader.GetInt();*/
 
-		if (amount <= 0 || amount > static_cast<int>(character->world->config["MaxShopBuy"]))
+		if (amount <= 0 || amount > character->world->settings.GetInt(ConfigKey::MaxShopBuy))
 			return;
 		if (character->weight >= character->maxweight)
 			return;
@@ -100,7 +100,7 @@ namespace Handlers
 
 					std::int_least64_t cost64 = std::int_least64_t(amount) * std::int_least64_t(checkitem->buy);
 
-					if (cost64 < 0 || cost64 > int(character->world->config["MaxItem"]))
+					if (cost64 < 0 || cost64 > character->world->settings.GetInt(ConfigKey::MaxItem))
 						break;
 
 					int cost = int(cost64);
@@ -135,7 +135,7 @@ namespace Handlers
 		int amount = reader.GetInt();
 		/*int shopid = reader.GetInt();*/
 
-		if (amount <= 0 || amount > static_cast<int>(character->world->config["MaxItem"]))
+		if (amount <= 0 || amount > character->world->settings.GetInt(ConfigKey::MaxItem))
 			return;
 
 		if (character->npc_type == ENF::Shop)
@@ -146,7 +146,7 @@ namespace Handlers
 				{
 					std::int_least64_t owed64 = std::int_least64_t(amount) * std::int_least64_t(checkitem->sell);
 
-					if (owed64 < 0 || owed64 > (int(character->world->config["MaxItem"]) - character->HasItem(1)))
+					if (owed64 < 0 || owed64 > (character->world->settings.GetInt(ConfigKey::MaxItem) - character->HasItem(1)))
 						break;
 
 					int owed = int(owed64);
@@ -193,7 +193,7 @@ namespace Handlers
 					reply.AddShort(item->id);
 					reply.AddThree(item->buy);
 					reply.AddThree(item->sell);
-					reply.AddChar(static_cast<int>(character->world->config["MaxShopBuy"]));
+					reply.AddChar(character->world->settings.GetInt(ConfigKey::MaxShopBuy));
 				}
 				reply.AddByte(255);
 
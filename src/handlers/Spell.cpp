@@ -39,7 +39,7 @@ namespace Handlers
 				return;
 
 			character->spell_id = spell_id;
-			character->spell_event = new TimeEvent(character_cast_spell, character, 0.47 * spell.cast_time + character->SpellCooldownTime(), 1);
+			character->spell_event = new TimeEvent(character_cast_spell, character, 0.47 * spell.cast_time + character->SpellCooldownTime(), 1, "character_cast_spell");
 			character->world->timer.Register(character->spell_event);
 
 			PacketBuilder builder(PACKET_SPELL, PACKET_REQUEST, 4);
@@ -69,7 +69,7 @@ namespace Handlers
 		character->spell_target = Character::TargetSelf;
 		character->spell_target_id = 0;
 
-		if (character->world->config["EnforceTimestamps"])
+		if (character->world->settings.GetBool(ConfigKey::EnforceTimestamps))
 		{
 			const ESF_Data &spell = character->world->esf->Get(character->spell_id);
 
@@ -116,7 +116,7 @@ namespace Handlers
 			return;
 		}
 
-		if (character->world->config["EnforceTimestamps"])
+		if (character->world->settings.GetBool(ConfigKey::EnforceTimestamps))
 		{
 			const ESF_Data &spell = character->world->esf->Get(character->spell_id);
 
@@ -145,7 +145,7 @@ namespace Handlers
 		character->spell_target = Character::TargetGroup;
 		character->spell_target_id = 0;
 
-		if (character->world->config["EnforceTimestamps"])
+		if (character->world->settings.GetBool(ConfigKey::EnforceTimestamps))
 		{
 			const ESF_Data &spell = character->world->esf->Get(character->spell_id);
 
@@ -177,7 +177,7 @@ namespace Handlers
 				return;
 			}
 
-			if (*stat >= int(character->world->config["MaxStat"]))
+			if (*stat >= character->world->settings.GetInt(ConfigKey::MaxStat))
 				return;
 
 			++(*stat);
@@ -209,7 +209,7 @@ namespace Handlers
 			break;
 
 		case TRAIN_SKILL:
-			if (character->skillpoints <= 0 || !character->HasSpell(stat_id) || character->SpellLevel(stat_id) >= int(character->world->config["MaxSkillLevel"]))
+			if (character->skillpoints <= 0 || !character->HasSpell(stat_id) || character->SpellLevel(stat_id) >= character->world->settings.GetInt(ConfigKey::MaxSkillLevel))
 			{
 				return;
 			}
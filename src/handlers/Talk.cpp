@@ -45,7 +45,7 @@ namespace Handlers
 			return;
 
 		std::string message = reader.GetEndString(); // message
-		limit_message(message, static_cast<int>(character->world->config["ChatLength"]));
+		limit_message(message, character->world->settings.GetInt(ConfigKey::ChatLength));
 
 		character->guild->Msg(character, message, false);
 	}
@@ -59,7 +59,7 @@ namespace Handlers
 			return;
 
 		std::string message = reader.GetEndString(); // message
-		limit_message(message, static_cast<int>(character->world->config["ChatLength"]));
+		limit_message(message, character->world->settings.GetInt(ConfigKey::ChatLength));
 
 		character->party->Msg(character, message, false);
 	}
@@ -70,13 +70,13 @@ namespace Handlers
 		if (character->muted_until > time(0))
 			return;
 
-		if (character->mapid == static_cast<int>(character->world->config["JailMap"]))
+		if (character->mapid == character->world->settings.GetInt(ConfigKey::JailMap))
 		{
 			return;
 		}
 
 		std::string message = reader.GetEndString();
-		limit_message(message, static_cast<int>(character->world->config["ChatLength"]));
+		limit_message(message, character->world->settings.GetInt(ConfigKey::ChatLength));
 
 		character->world->Msg(character, message, false);
 	}
@@ -89,7 +89,7 @@ namespace Handlers
 
 		std::string name = reader.GetBreakString();
 		std::string message = reader.GetEndString();
-		limit_message(message, static_cast<int>(character->world->config["ChatLength"]));
+		limit_message(message, character->world->settings.GetInt(ConfigKey::ChatLength));
 		Character *to = character->world->GetCharacter(name);
 
 		if (to && !to->IsHideOnline())
@@ -119,7 +119,7 @@ namespace Handlers
 			return;
 
 		std::string message = reader.GetEndString();
-		limit_message(message, static_cast<int>(character->world->config["ChatLength"]));
+		limit_message(message, character->world->settings.GetInt(ConfigKey::ChatLength));
 
 		if (message.empty())
 		{
@@ -128,7 +128,7 @@ namespace Handlers
 
 		if (character->SourceAccess() && message[0] == '$')
 		{
-			if (character->world->config["LogCommands"])
+			if (character->world->settings.GetBool(ConfigKey::LogCommands))
 			{
 				Console::Out("%s: %s", character->real_name.c_str(), message.c_str());
 			}
@@ -164,7 +164,7 @@ namespace Handlers
 			return;
 
 		std::string message = reader.GetEndString(); // message
-		limit_message(message, static_cast<int>(character->world->config["ChatLength"]));
+		limit_message(message, character->world->settings.GetInt(ConfigKey::ChatLength));
 
 		character->world->AdminMsg(character, message, ADMIN_GUARDIAN, false);
 	}
@@ -178,7 +178,7 @@ namespace Handlers
 			return;
 
 		std::string message = reader.GetEndString(); // message
-		limit_message(message, static_cast<int>(character->world->config["ChatLength"]));
+		limit_message(message, character->world->settings.GetInt(ConfigKey::ChatLength));
 
 		character->world->AnnounceMsg(character, message, false);
 	}
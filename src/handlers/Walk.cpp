@@ -23,7 +23,7 @@ namespace Handlers
 		unsigned char y = reader.GetChar();
 		Map::WalkResult walk_result = Map::WalkFail;
 
-		if (character->world->config["EnforceTimestamps"])
+		if (character->world->settings.GetBool(ConfigKey::EnforceTimestamps))
 		{
 			if (timestamp - character->timestamp < 36)
 			{
@@ -55,7 +55,7 @@ namespace Handlers
 		reply.AddInt(player->character->id);
 		reply.AddShort(player->character->mapid); // Map ID
 
-		if (player->world->config["GlobalPK"] && !player->world->PKExcept(player->character->mapid))
+		if (player->world->settings.GetBool(ConfigKey::GlobalPK) && !player->world->PKExcept(player->character->mapid))
 		{
 			reply.AddByte(0xFF);
 			reply.AddByte(0x01);
@@ -148,7 +148,7 @@ namespace Handlers
 		reply.AddShort(player->character->evade);
 		reply.AddShort(player->character->armor);
 
-		if (!player->world->config["OldVersionCompat"] && player->client->version < 28)
+		if (!player->world->settings.GetBool(ConfigKey::OldVersionCompat) && player->client->version < 28)
 		{
 			reply.AddChar(player->character->display_str);
 			reply.AddChar(player->character->display_wis);
@@ -172,9 +172,9 @@ namespace Handlers
 			reply.AddShort(item);
 		}
 
-		int leader_rank = std::max(std::max(std::max(static_cast<int>(player->world->config["GuildEditRank"]), static_cast<int>(player->world->config["GuildKickRank"])),
-											static_cast<int>(player->world->config["GuildPromoteRank"])),
-								   static_cast<int>(player->world->config["GuildDemoteRank"]));
+		int leader_rank = std::max(std::max(std::max(player->world->settings.GetInt(ConfigKey::GuildEditRank), player->world->settings.GetInt(ConfigKey::GuildKickRank)),
+											player->world->settings.GetInt(ConfigKey::GuildPromoteRank)),
+								   player->world->settings.GetInt(ConfigKey::GuildDemoteRank));
 
 		if (player->character->guild_rank <= leader_rank && player->character->guild)
 		{
@@ -185,7 +185,7 @@ namespace Handlers
 			reply.AddChar(player->character->guild_rank);
 		}
 
-		reply.AddShort(static_cast<int>(player->world->config["JailMap"]));
+		reply.AddShort(player->world->settings.GetInt(ConfigKey::JailMap));
 		reply.AddShort(4);										// ?
 		reply.AddChar(24);										// ?
 		reply.AddChar(24);										// ?
@@ -258,7 +258,7 @@ namespace Handlers
 		// MotDs
 		reply.AddByte(255);
 
-		std::string news_file = player->world->config["NewsFile"];
+		std::string news_file = player->world->settings.GetString(ConfigKey::NewsFile);
 
 		char newsbuf[4096] = "";
 		std::FILE *newsfh = std::fopen(news_file.c_str(), "rt");
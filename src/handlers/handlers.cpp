@@ -5,16 +5,61 @@
 
 #include "handlers.hpp"
 
+#include "../database.hpp"
 #include "../eoclient.hpp"
+#include "../eoserver.hpp"
 #include "../player.hpp"
+#include "../watchdog.hpp"
+#include "../world.hpp"
 
 #include "../console.hpp"
+#include "../trace.hpp"
+#include "../util.hpp"
 
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <stdexcept>
+#include <vector>
 
 namespace Handlers
 {
 
+	/**
+	 * Charges the time until it goes out of scope to a handler, its client, the tick watchdog and any running trace, including when the handler throws
+	 */
+	struct handler_timer
+	{
+		packet_handler::Stats &stats;
+		const char *name;
+		EOClient *client;
+		std::chrono::steady_clock::time_point start;
+
+		handler_timer(const packet_handler &handler, EOClient *client)
+			: stats(*handler.stats), name(handler.name.c_str()), client(client), start(std::chrono::steady_clock::now())
+		{
+		}
+
+		handler_timer(const handler_timer &) = delete;
+
+		~handler_timer()
+		{
+			auto end = std::chrono::steady_clock::now();
+			auto us = std::uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+
+			++stats.calls;
+			stats.latency.record(us);
+
+			++client->handler_calls;
+			client->handler_us += us;
+
+			client->server()->watchdog.Record("handler", name, us, client);
+
+			if (Trace::recording.load(std::memory_order_relaxed))
+				Trace::Record(name, start, end);
+		}
+	};
+
 	bool packet_handler_register::StateCheck(EOClient *client, unsigned short allow_states)
 	{
 		switch (client->state)
@@ -67,18 +112,16 @@ namespace Handlers
 		if (handlers[(unsigned char)family][(unsigned char)action])
 			Console::Wrn("Overriding previously registered handler: %s_%s", PacketProcessor::GetFamilyName(family).c_str(), PacketProcessor::GetActionName(action).c_str());
 
+		handler.name = PacketProcessor::GetFamilyName(family) + "_" + PacketProcessor::GetActionName(action);
+		handler.stats = std::make_shared<packet_handler::Stats>();
 		handlers[(unsigned char)family][(unsigned char)action] = handler;
 	}
 
 	void packet_handler_register::Handle(PacketFamily family, PacketAction action, EOClient *client, PacketReader &reader, bool from_queue) const
 	{
-		packet_handler handler;
+		const packet_handler &handler = handlers[(unsigned char)family][(unsigned char)action];
 
-		if (handlers[(unsigned char)family][(unsigned char)action])
-		{
-			handler = handlers[(unsigned char)family][(unsigned char)action];
-		}
-		else
+		if (!handler)
 		{
 #ifdef DEBUG
 			Console::Dbg("Unhandled packet: %s_%s (not registered)", PacketProcessor::GetFamilyName(family).c_str(), PacketProcessor::GetActionName(action).c_str());
@@ -100,6 +143,9 @@ namespace Handlers
 			return;
 		}
 
+		Database_Stats::Caller_Scope db_caller(client->server()->world->db.stats, handler.name.c_str());
+		handler_timer timer(handler, client);
+
 		switch (handler.fn_type)
 		{
 		case packet_handler::Invalid:
@@ -136,6 +182,34 @@ namespace Handlers
 		}
 	}
 
+	std::vector<const packet_handler *> packet_handler_register::Registered() const
+	{
+		std::vector<const packet_handler *> result;
+
+		UTIL_FOREACH_CREF(handlers, family_handlers)
+		{
+			UTIL_FOREACH_CREF(family_handlers, handler)
+			{
+				if (handler)
+					result.push_back(&handler);
+			}
+		}
+
+		return result;
+	}
+
+	void packet_handler_register::ResetStats()
+	{
+		UTIL_FOREACH_REF(handlers, family_handlers)
+		{
+			UTIL_FOREACH_REF(family_handlers, handler)
+			{
+				if (handler.stats)
+					*handler.stats = packet_handler::Stats();
+			}
+		}
+	}
+
 	packet_handler_register *packet_handler_register_instance;
 
 	void packet_handler_register_init::init() const
@@ -11,7 +11,13 @@
 #include "../fwd/player.hpp"
 #include "../packet.hpp"
 
+#include "../util/histogram.hpp"
+
 #include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
 
 #define PACKET_HANDLER_PASTE_AUX2(base, id) base##id
 #define PACKET_HANDLER_PASTE_AUX(base, id) PACKET_HANDLER_PASTE_AUX2(base, id)
@@ -77,6 +83,26 @@ namespace Handlers
 		double delay;
 		void (*f)();
 
+		/**
+		 * FAMILY_ACTION name, filled in when registered
+		 */
+		std::string name;
+
+		struct Stats
+		{
+			std::uint64_t calls = 0;
+
+			/**
+			 * Time spent in the handler in microseconds
+			 */
+			util::histogram latency;
+		};
+
+		/**
+		 * Created when registered, shared so it can be updated through the const handler table
+		 */
+		std::shared_ptr<Stats> stats;
+
 		packet_handler(FunctionType fn_type = Invalid, void_fn_t f = 0, unsigned short allow_states = 0, double delay = 0.0)
 			: fn_type(fn_type), allow_states(allow_states), delay(delay), f(f)
 		{
@@ -101,6 +127,13 @@ namespace Handlers
 		void Handle(PacketFamily family, PacketAction action, EOClient *client, PacketReader &reader, bool from_queue = false) const;
 
 		void SetDelay(PacketFamily family, PacketAction action, double delay);
+
+		/**
+		 * Returns every registered handler
+		 */
+		std::vector<const packet_handler *> Registered() const;
+
+		void ResetStats();
 	};
 
 	extern packet_handler_register *packet_handler_register_instance;
@@ -158,6 +191,16 @@ namespace Handlers
 		packet_handler_register_instance->SetDelay(family, action, delay);
 	}
 
+	inline std::vector<const packet_handler *> Registered()
+	{
+		return packet_handler_register_instance->Registered();
+	}
+
+	inline void ResetStats()
+	{
+		packet_handler_register_instance->ResetStats();
+	}
+
 }
 
 #endif // HANDLERS_HPP_INCLUDED
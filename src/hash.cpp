@@ -7,23 +7,237 @@
 
 #include "sha256.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <string>
+#include <vector>
 
-std::string sha256(const std::string &str)
+static std::string sha256_raw(const std::string &str)
 {
 	sha256_context ctx;
 	char digest[32];
-	char cdigest[64];
 
 	sha256_start(&ctx);
 	sha256_update(&ctx, str.c_str(), str.length());
 	sha256_finish(&ctx, digest);
 
-	for (int i = 0; i < 32; ++i)
+	return std::string(digest, 32);
+}
+
+std::string sha256(const std::string &str)
+{
+	return hex_encode(sha256_raw(str));
+}
+
+std::string hmac_sha256(const std::string &key, const std::string &message)
+{
+	std::string k = (key.length() > SHA256_BLOCK_SIZE) ? sha256_raw(key) : key;
+	k.resize(SHA256_BLOCK_SIZE, '\0');
+
+	std::string ipad(SHA256_BLOCK_SIZE, '\0');
+	std::string opad(SHA256_BLOCK_SIZE, '\0');
+
+	for (std::size_t i = 0; i < SHA256_BLOCK_SIZE; ++i)
 	{
-		cdigest[i * 2] = "0123456789abcdef"[((digest[i] >> 4) & 0x0F)];
-		cdigest[i * 2 + 1] = "0123456789abcdef"[((digest[i]) & 0x0F)];
+		ipad[i] = char(k[i] ^ 0x36);
+		opad[i] = char(k[i] ^ 0x5C);
+	}
+
+	return sha256_raw(opad + sha256_raw(ipad + message));
+}
+
+std::string pbkdf2_sha256(const std::string &password, const std::string &salt, int iterations, std::size_t length)
+{
+	std::string result;
+	result.reserve(length + 32);
+
+	for (std::uint32_t block = 1; result.length() < length; ++block)
+	{
+		char block_index[4] = {char(block >> 24), char(block >> 16), char(block >> 8), char(block)};
+
+		std::string u = hmac_sha256(password, salt + std::string(block_index, 4));
+		std::string t = u;
+
+		for (int i = 1; i < iterations; ++i)
+		{
+			u = hmac_sha256(password, u);
+
+			for (std::size_t j = 0; j < t.length(); ++j)
+				t[j] ^= u[j];
+		}
+
+		result += t;
+	}
+
+	result.resize(length);
+	return result;
+}
+
+#define SCRYPT_ROTL(a, b) (((a) << (b)) | ((a) >> (32 - (b))))
+
+static void salsa20_8(std::uint32_t b[16])
+{
+	std::uint32_t x[16];
+	std::memcpy(x, b, sizeof x);
+
+	for (int i = 0; i < 8; i += 2)
+	{
+		x[4] ^= SCRYPT_ROTL(x[0] + x[12], 7);
+		x[8] ^= SCRYPT_ROTL(x[4] + x[0], 9);
+		x[12] ^= SCRYPT_ROTL(x[8] + x[4], 13);
+		x[0] ^= SCRYPT_ROTL(x[12] + x[8], 18);
+		x[9] ^= SCRYPT_ROTL(x[5] + x[1], 7);
+		x[13] ^= SCRYPT_ROTL(x[9] + x[5], 9);
+		x[1] ^= SCRYPT_ROTL(x[13] + x[9], 13);
+		x[5] ^= SCRYPT_ROTL(x[1] + x[13], 18);
+		x[14] ^= SCRYPT_ROTL(x[10] + x[6], 7);
+		x[2] ^= SCRYPT_ROTL(x[14] + x[10], 9);
+		x[6] ^= SCRYPT_ROTL(x[2] + x[14], 13);
+		x[10] ^= SCRYPT_ROTL(x[6] + x[2], 18);
+		x[3] ^= SCRYPT_ROTL(x[15] + x[11], 7);
+		x[7] ^= SCRYPT_ROTL(x[3] + x[15], 9);
+		x[11] ^= SCRYPT_ROTL(x[7] + x[3], 13);
+		x[15] ^= SCRYPT_ROTL(x[11] + x[7], 18);
+
+		x[1] ^= SCRYPT_ROTL(x[0] + x[3], 7);
+		x[2] ^= SCRYPT_ROTL(x[1] + x[0], 9);
+		x[3] ^= SCRYPT_ROTL(x[2] + x[1], 13);
+		x[0] ^= SCRYPT_ROTL(x[3] + x[2], 18);
+		x[6] ^= SCRYPT_ROTL(x[5] + x[4], 7);
+		x[7] ^= SCRYPT_ROTL(x[6] + x[5], 9);
+		x[4] ^= SCRYPT_ROTL(x[7] + x[6], 13);
+		x[5] ^= SCRYPT_ROTL(x[4] + x[7], 18);
+		x[11] ^= SCRYPT_ROTL(x[10] + x[9], 7);
+		x[8] ^= SCRYPT_ROTL(x[11] + x[10], 9);
+		x[9] ^= SCRYPT_ROTL(x[8] + x[11], 13);
+		x[10] ^= SCRYPT_ROTL(x[9] + x[8], 18);
+		x[12] ^= SCRYPT_ROTL(x[15] + x[14], 7);
+		x[13] ^= SCRYPT_ROTL(x[12] + x[15], 9);
+		x[14] ^= SCRYPT_ROTL(x[13] + x[12], 13);
+		x[15] ^= SCRYPT_ROTL(x[14] + x[13], 18);
+	}
+
+	for (int i = 0; i < 16; ++i)
+		b[i] += x[i];
+}
+
+#undef SCRYPT_ROTL
+
+// b and y are 32 * r words each
+static void scrypt_blockmix(std::uint32_t *b, std::uint32_t *y, int r)
+{
+	std::uint32_t x[16];
+	std::memcpy(x, &b[(2 * r - 1) * 16], sizeof x);
+
+	for (int i = 0; i < 2 * r; ++i)
+	{
+		for (int j = 0; j < 16; ++j)
+			x[j] ^= b[i * 16 + j];
+
+		salsa20_8(x);
+
+		// Even blocks go to the first half of the output, odd blocks to the second
+		std::memcpy(&y[((i / 2) + (i & 1) * r) * 16], x, sizeof x);
+	}
+}
+
+static void scrypt_romix(unsigned char *block, int r, std::uint32_t n, std::vector<std::uint32_t> &v)
+{
+	const std::size_t words = 32 * std::size_t(r);
+	std::vector<std::uint32_t> x(words);
+	std::vector<std::uint32_t> y(words);
+
+	for (std::size_t i = 0; i < words; ++i)
+	{
+		const unsigned char *p = &block[i * 4];
+		x[i] = std::uint32_t(p[0]) | std::uint32_t(p[1]) << 8 | std::uint32_t(p[2]) << 16 | std::uint32_t(p[3]) << 24;
+	}
+
+	for (std::uint32_t i = 0; i < n; ++i)
+	{
+		std::memcpy(&v[i * words], x.data(), words * 4);
+		scrypt_blockmix(x.data(), y.data(), r);
+		x.swap(y);
+	}
+
+	for (std::uint32_t i = 0; i < n; ++i)
+	{
+		std::uint32_t j = x[(2 * r - 1) * 16] & (n - 1);
+
+		for (std::size_t k = 0; k < words; ++k)
+			x[k] ^= v[j * words + k];
+
+		scrypt_blockmix(x.data(), y.data(), r);
+		x.swap(y);
+	}
+
+	for (std::size_t i = 0; i < words; ++i)
+	{
+		unsigned char *p = &block[i * 4];
+		p[0] = (unsigned char)(x[i]);
+		p[1] = (unsigned char)(x[i] >> 8);
+		p[2] = (unsigned char)(x[i] >> 16);
+		p[3] = (unsigned char)(x[i] >> 24);
+	}
+}
+
+std::string scrypt(const std::string &password, const std::string &salt, int log2_n, int r, int p, std::size_t length)
+{
+	const std::uint32_t n = std::uint32_t(1) << log2_n;
+	const std::size_t block_size = 128 * std::size_t(r);
+
+	std::string b = pbkdf2_sha256(password, salt, 1, block_size * p);
+	std::vector<std::uint32_t> v(std::size_t(n) * 32 * r);
+
+	for (int i = 0; i < p; ++i)
+		scrypt_romix(reinterpret_cast<unsigned char *>(&b[i * block_size]), r, n, v);
+
+	return pbkdf2_sha256(password, b, 1, length);
+}
+
+std::string hex_encode(const std::string &str)
+{
+	std::string result(str.length() * 2, '\0');
+
+	for (std::size_t i = 0; i < str.length(); ++i)
+	{
+		result[i * 2] = "0123456789abcdef"[((str[i] >> 4) & 0x0F)];
+		result[i * 2 + 1] = "0123456789abcdef"[((str[i]) & 0x0F)];
+	}
+
+	return result;
+}
+
+std::string hex_decode(const std::string &str)
+{
+	auto nibble = [](char c) -> int
+	{
+		if (c >= '0' && c <= '9')
+			return c - '0';
+		else if (c >= 'a' && c <= 'f')
+			return c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F')
+			return c - 'A' + 10;
+		else
+			return -1;
+	};
+
+	if (str.length() % 2 != 0)
+		return std::string();
+
+	std::string result(str.length() / 2, '\0');
+
+	for (std::size_t i = 0; i < result.length(); ++i)
+	{
+		int hi = nibble(str[i * 2]);
+		int lo = nibble(str[i * 2 + 1]);
+
+		if (hi == -1 || lo == -1)
+			return std::string();
+
+		result[i] = char(hi << 4 | lo);
 	}
 
-	return std::string(cdigest, 64);
+	return result;
 }
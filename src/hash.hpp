@@ -6,6 +6,7 @@
 #ifndef HASH_HPP_INCLUDED
 #define HASH_HPP_INCLUDED
 
+#include <cstddef>
 #include <string>
 
 /**
@@ -13,4 +14,30 @@
  */
 std::string sha256(const std::string &);
 
+/**
+ * Returns the raw (binary) HMAC-SHA256 of a message
+ */
+std::string hmac_sha256(const std::string &key, const std::string &message);
+
+/**
+ * Derives a raw (binary) key of the specified length using PBKDF2-HMAC-SHA256
+ */
+std::string pbkdf2_sha256(const std::string &password, const std::string &salt, int iterations, std::size_t length);
+
+/**
+ * Derives a raw (binary) key of the specified length using the memory-hard scrypt KDF (RFC 7914)
+ * Uses 128 * r * 2^log2_n bytes of memory per call.
+ */
+std::string scrypt(const std::string &password, const std::string &salt, int log2_n, int r, int p, std::size_t length);
+
+/**
+ * Convert a binary string to lower-case hex
+ */
+std::string hex_encode(const std::string &);
+
+/**
+ * Convert a hex string to binary, returns an empty string if the input is not valid hex
+ */
+std::string hex_decode(const std::string &);
+
 #endif // HASH_HPP_INCLUDED
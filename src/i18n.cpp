@@ -10,41 +10,26 @@
 #include "util.hpp"
 
 #include <cstddef>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 I18N::I18N()
+	: templates(std::make_shared<Template_Map>())
 {
 }
 
 I18N::I18N(const std::string &lang_file)
-	: lang_config(new Config(lang_file))
+	: templates(std::make_shared<Template_Map>())
 {
+	this->SetLangFile(lang_file);
 }
 
-void I18N::SetLangFile(const std::string &lang_file)
-{
-	lang_config->Read(lang_file);
-}
-
-std::string I18N::FormatV(const std::string &id, std::vector<util::variant> &&v) const
+I18N::Template I18N::Compile(const std::string &format)
 {
-	auto it = lang_config->find(id);
-
-	if (it == lang_config->end())
-	{
-		std::string result = id;
-
-		UTIL_FOREACH(v, x)
-		{
-			result += " " + std::string(x);
-		}
-
-		return result;
-	}
-
-	std::string result;
-	std::string format = std::string(it->second);
+	Template compiled;
+	std::string text;
 	std::string number_buffer;
 	int state = 0;
 
@@ -58,19 +43,18 @@ std::string I18N::FormatV(const std::string &id, std::vector<util::variant> &&v)
 			}
 			else
 			{
-				result += c;
+				text += c;
 			}
 		}
 		else if (state == 1)
 		{
 			if (c == '}')
 			{
+				// Anything that isn't a valid 1-based index wraps around and renders as #ERROR#
 				std::size_t index = int(util::variant(number_buffer)) - 1;
 
-				if (index >= v.size())
-					result += "#ERROR#";
-				else
-					result += std::string(v[index]);
+				compiled.segments.push_back({std::move(text), true, index});
+				text.clear();
 
 				number_buffer = "";
 				state = 0;
@@ -82,6 +66,66 @@ std::string I18N::FormatV(const std::string &id, std::vector<util::variant> &&v)
 		}
 	}
 
+	if (!text.empty())
+		compiled.segments.push_back({std::move(text), false, 0});
+
+	return compiled;
+}
+
+void I18N::SetLangFile(const std::string &lang_file)
+{
+	Config lang_config;
+
+	// Keep the current language if the new one can't be read
+	if (!lang_config.Read(lang_file))
+		return;
+
+	std::shared_ptr<Template_Map> templates = std::make_shared<Template_Map>();
+
+	templates->reserve(lang_config.size());
+
+	UTIL_FOREACH_CREF(lang_config, entry)
+		templates->emplace(entry.first, Compile(std::string(entry.second)));
+
+	std::atomic_store(&this->templates, std::shared_ptr<const Template_Map>(std::move(templates)));
+}
+
+void I18N::Render(std::string &out, const std::string &id, const util::variant *args, std::size_t count) const
+{
+	std::shared_ptr<const Template_Map> templates = std::atomic_load(&this->templates);
+	auto it = templates->find(id);
+
+	if (it == templates->end())
+	{
+		out += id;
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			out += " ";
+			out += std::string(args[i]);
+		}
+
+		return;
+	}
+
+	UTIL_FOREACH_CREF(it->second.segments, segment)
+	{
+		out += segment.text;
+
+		if (!segment.has_arg)
+			continue;
+
+		if (segment.arg >= count)
+			out += "#ERROR#";
+		else
+			out += std::string(args[segment.arg]);
+	}
+}
+
+std::string I18N::FormatV(const std::string &id, std::vector<util::variant> &&v) const
+{
+	std::string result;
+	this->Render(result, id, v.data(), v.size());
 	return result;
 }
 
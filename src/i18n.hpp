@@ -8,19 +8,41 @@
 
 #include "fwd/i18n.hpp"
 
-#include "fwd/config.hpp"
-
 #include "util/variant.hpp"
 
+#include <cstddef>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 class I18N
 {
 protected:
-	std::unique_ptr<Config> lang_config;
+	/**
+	 * A language string split up at its {n} placeholders when the language file is loaded
+	 */
+	struct Template
+	{
+		struct Segment
+		{
+			std::string text;
+			bool has_arg;
+			std::size_t arg;
+		};
+
+		std::vector<Segment> segments;
+	};
+
+	typedef std::unordered_map<std::string, Template> Template_Map;
+
+	// Replaced as a whole by SetLangFile so a format never sees half of a language
+	std::shared_ptr<const Template_Map> templates;
+
+	static Template Compile(const std::string &format);
+
+	void Render(std::string &out, const std::string &id, const util::variant *args, std::size_t count) const;
 
 public:
 	I18N();
@@ -30,11 +52,23 @@ public:
 
 	std::string FormatV(const std::string &id, std::vector<util::variant> &&v) const;
 
+	/**
+	 * Appends the formatted message to out instead of returning a new string
+	 */
+	template <class... Args>
+	void FormatInto(std::string &out, const std::string &id, Args &&...args) const
+	{
+		// Trailing element keeps the array non-empty for messages with no arguments
+		const util::variant v[] = {args..., util::variant()};
+		Render(out, id, v, sizeof...(Args));
+	}
+
 	template <class... Args>
 	std::string Format(const std::string &id, Args &&...args) const
 	{
-		std::vector<util::variant> v{args...};
-		return FormatV(id, std::move(v));
+		std::string result;
+		FormatInto(result, id, std::forward<Args>(args)...);
+		return result;
 	}
 
 	~I18N();
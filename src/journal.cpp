@@ -0,0 +1,376 @@
+/* journal.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "journal.hpp"
+
+#include "database.hpp"
+
+#include "console.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifdef WIN32
+#include <io.h>
+#else // WIN32
+#include <unistd.h>
+#endif // WIN32
+
+static std::uint32_t crc32(const char *data, std::size_t length)
+{
+	static const std::array<std::uint32_t, 256> table = []()
+	{
+		std::array<std::uint32_t, 256> result;
+
+		for (std::uint32_t i = 0; i < 256; ++i)
+		{
+			std::uint32_t c = i;
+
+			for (int k = 0; k < 8; ++k)
+				c = (c & 1) ? (0xEDB88320U ^ (c >> 1)) : (c >> 1);
+
+			result[i] = c;
+		}
+
+		return result;
+	}();
+
+	std::uint32_t c = 0xFFFFFFFFU;
+
+	for (std::size_t i = 0; i < length; ++i)
+		c = table[(c ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (c >> 8);
+
+	return c ^ 0xFFFFFFFFU;
+}
+
+static bool sync_file(std::FILE *fh)
+{
+	if (std::fflush(fh) != 0)
+		return false;
+
+#if defined(WIN32)
+	return _commit(_fileno(fh)) == 0;
+#elif defined(__APPLE__)
+	return fsync(fileno(fh)) == 0;
+#else
+	return fdatasync(fileno(fh)) == 0;
+#endif
+}
+
+// Reads little-endian fields from a record payload, failing softly past the end
+struct Journal_Reader
+{
+	const std::string &data;
+	std::size_t pos;
+	std::size_t end;
+	bool ok;
+
+	Journal_Reader(const std::string &data, std::size_t pos, std::size_t end)
+		: data(data), pos(pos), end(end), ok(true)
+	{ }
+
+	std::uint32_t GetInt()
+	{
+		if (this->end - this->pos < 4)
+		{
+			this->ok = false;
+			return 0;
+		}
+
+		std::uint32_t value = 0;
+
+		for (int i = 0; i < 4; ++i)
+			value |= std::uint32_t(static_cast<unsigned char>(this->data[this->pos++])) << (i * 8);
+
+		return value;
+	}
+
+	std::string GetString()
+	{
+		std::size_t length = this->GetInt();
+
+		if (!this->ok || this->end - this->pos < length)
+		{
+			this->ok = false;
+			return std::string();
+		}
+
+		std::string value = this->data.substr(this->pos, length);
+		this->pos += length;
+		return value;
+	}
+};
+
+Journal::Journal()
+	: fh(0), records(0), group(0)
+{ }
+
+bool Journal::Open(const std::string &filename)
+{
+	this->Close();
+
+	this->filename = filename;
+	this->fh = std::fopen(filename.c_str(), "ab");
+
+	return this->fh != 0;
+}
+
+void Journal::Close()
+{
+	if (this->fh)
+	{
+		this->Sync();
+		std::fclose(this->fh);
+		this->fh = 0;
+	}
+
+	this->buffer.clear();
+	this->group = 0;
+}
+
+void Journal::BeginRecord(RecordType type, std::size_t &start)
+{
+	start = this->buffer.size();
+	this->AddInt(0);
+	this->buffer += char(type);
+}
+
+void Journal::FinishRecord(std::size_t start)
+{
+	std::size_t length = this->buffer.size() - start - 4;
+
+	for (int i = 0; i < 4; ++i)
+		this->buffer[start + i] = char((length >> (i * 8)) & 0xFF);
+
+	this->AddInt(crc32(this->buffer.data() + start + 4, length));
+}
+
+void Journal::EndRecord(std::size_t start)
+{
+	this->FinishRecord(start);
+	++this->records;
+	++this->group;
+}
+
+void Journal::AddInt(std::uint32_t value)
+{
+	for (int i = 0; i < 4; ++i)
+		this->buffer += char((value >> (i * 8)) & 0xFF);
+}
+
+void Journal::AddString(const std::string &value)
+{
+	this->AddInt(std::uint32_t(value.length()));
+	this->buffer += value;
+}
+
+void Journal::WriteItems(const std::string &name, const std::string &inventory, const std::string &bank, const std::string &paperdoll, int goldbank)
+{
+	std::size_t start;
+	this->BeginRecord(RecordItems, start);
+	this->AddString(name);
+	this->AddString(inventory);
+	this->AddString(bank);
+	this->AddString(paperdoll);
+	this->AddInt(std::uint32_t(goldbank));
+	this->EndRecord(start);
+}
+
+void Journal::WriteStats(const std::string &name, const Stats &stats)
+{
+	std::size_t start;
+	this->BeginRecord(RecordStats, start);
+	this->AddString(name);
+	this->AddInt(std::uint32_t(stats.level));
+	this->AddInt(std::uint32_t(stats.exp));
+	this->AddInt(std::uint32_t(stats.statpoints));
+	this->AddInt(std::uint32_t(stats.skillpoints));
+
+	for (int stat : stats.base)
+		this->AddInt(std::uint32_t(stat));
+
+	this->EndRecord(start);
+}
+
+void Journal::WriteQuest(const std::string &name, const std::string &quest)
+{
+	std::size_t start;
+	this->BeginRecord(RecordQuest, start);
+	this->AddString(name);
+	this->AddString(quest);
+	this->EndRecord(start);
+}
+
+bool Journal::Sync()
+{
+	if (!this->fh || this->buffer.empty())
+		return true;
+
+	std::size_t start;
+	this->BeginRecord(RecordCommit, start);
+	this->AddInt(std::uint32_t(this->group));
+	this->FinishRecord(start);
+
+	bool ok = std::fwrite(this->buffer.data(), 1, this->buffer.size(), this->fh) == this->buffer.size();
+	ok = sync_file(this->fh) && ok;
+
+	this->buffer.clear();
+	this->group = 0;
+
+	return ok;
+}
+
+void Journal::Truncate()
+{
+	this->buffer.clear();
+	this->records = 0;
+	this->group = 0;
+
+	if (!this->fh)
+		return;
+
+	std::fclose(this->fh);
+	this->fh = std::fopen(this->filename.c_str(), "wb");
+
+	if (this->fh)
+		sync_file(this->fh);
+	else
+		Console::Err("Could not reopen journal file: %s", this->filename.c_str());
+}
+
+// Applies one data record, returning false if it is malformed
+static bool journal_apply(Database &db, const std::string &data, Journal::RecordType type, std::size_t begin, std::size_t end)
+{
+	Journal_Reader reader(data, begin, end);
+	std::string name = reader.GetString();
+
+	if (type == Journal::RecordItems)
+	{
+		std::string inventory = reader.GetString();
+		std::string bank = reader.GetString();
+		std::string paperdoll = reader.GetString();
+		int goldbank = int(reader.GetInt());
+
+		if (reader.ok)
+			db.Query("UPDATE `characters` SET `inventory` = '$', `bank` = '$', `paperdoll` = '$', `goldbank` = # WHERE `name` = '$'",
+					 inventory.c_str(), bank.c_str(), paperdoll.c_str(), goldbank, name.c_str());
+	}
+	else if (type == Journal::RecordStats)
+	{
+		std::array<int, 10> v;
+
+		for (int &x : v)
+			x = int(reader.GetInt());
+
+		if (reader.ok)
+			db.Query("UPDATE `characters` SET `level` = #, `exp` = #, `statpoints` = #, `skillpoints` = #, "
+					 "`str` = #, `int` = #, `wis` = #, `agi` = #, `con` = #, `cha` = # WHERE `name` = '$'",
+					 v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8], v[9], name.c_str());
+	}
+	else if (type == Journal::RecordQuest)
+	{
+		std::string quest = reader.GetString();
+
+		if (reader.ok)
+			db.Query("UPDATE `characters` SET `quest` = '$' WHERE `name` = '$'", quest.c_str(), name.c_str());
+	}
+	else
+	{
+		reader.ok = false;
+	}
+
+	return reader.ok;
+}
+
+std::size_t Journal::Replay(const std::string &filename, Database &db)
+{
+	std::FILE *fh = std::fopen(filename.c_str(), "rb");
+
+	if (!fh)
+		return 0;
+
+	std::string data;
+	char buf[4096];
+	std::size_t n;
+
+	while ((n = std::fread(buf, 1, sizeof buf, fh)) > 0)
+		data.append(buf, n);
+
+	std::fclose(fh);
+
+	struct Pending_Record
+	{
+		RecordType type;
+		std::size_t begin;
+		std::size_t end;
+		std::size_t offset;
+	};
+
+	std::vector<Pending_Record> group;
+	std::size_t applied = 0;
+	std::size_t pos = 0;
+
+	while (pos < data.size())
+	{
+		Journal_Reader header(data, pos, data.size());
+		std::size_t length = header.GetInt();
+
+		if (!header.ok || length == 0 || data.size() - header.pos < length + 4)
+			break;
+
+		Journal_Reader crc_reader(data, header.pos + length, data.size());
+
+		if (crc_reader.GetInt() != crc32(data.data() + header.pos, length))
+			break;
+
+		RecordType type = RecordType(static_cast<unsigned char>(data[header.pos]));
+
+		if (type == RecordCommit)
+		{
+			Journal_Reader reader(data, header.pos + 1, header.pos + length);
+			std::size_t count = reader.GetInt();
+
+			if (!reader.ok || count != group.size())
+			{
+				Console::Wrn("Discarding %i journal records with a mismatched commit record at offset %i", int(group.size()), int(pos));
+			}
+			else
+			{
+				for (const Pending_Record &record : group)
+				{
+					if (journal_apply(db, data, record.type, record.begin, record.end))
+						++applied;
+					else
+						Console::Wrn("Skipping malformed journal record at offset %i", int(record.offset));
+				}
+			}
+
+			group.clear();
+		}
+		else
+		{
+			group.push_back({type, header.pos + 1, header.pos + length, pos});
+		}
+
+		pos = header.pos + length + 4;
+	}
+
+	if (!group.empty())
+		Console::Wrn("Journal ends with %i records that were never committed (discarded)", int(group.size()));
+
+	if (pos < data.size())
+		Console::Wrn("Journal ends with %i bytes of incomplete data (discarded)", int(data.size() - pos));
+
+	return applied;
+}
+
+Journal::~Journal()
+{
+	this->Close();
+}
@@ -0,0 +1,116 @@
+/* journal.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef JOURNAL_HPP_INCLUDED
+#define JOURNAL_HPP_INCLUDED
+
+#include "fwd/journal.hpp"
+
+#include "fwd/database.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/**
+ * Append-only log of character changes made since the last database commit
+ * Records hold absolute values so replaying a record more than once is harmless.
+ * Each record is framed as: length (4), type (1), payload, CRC-32 (4), all little-endian.
+ * Every sync ends with a commit record holding the number of records before it, and replay only applies groups that
+ * reached their commit record, so changes to several characters made together (such as a trade) are never half applied.
+ */
+class Journal
+{
+public:
+	enum RecordType : unsigned char
+	{
+		RecordItems = 1,
+		RecordStats = 2,
+		RecordQuest = 3,
+		RecordCommit = 4
+	};
+
+	struct Stats
+	{
+		int level;
+		int exp;
+		int statpoints;
+		int skillpoints;
+		std::array<int, 6> base;
+
+		bool operator==(const Stats &other) const
+		{
+			return level == other.level && exp == other.exp && statpoints == other.statpoints && skillpoints == other.skillpoints && base == other.base;
+		}
+
+		bool operator!=(const Stats &other) const { return !(*this == other); }
+	};
+
+protected:
+	std::string filename;
+	std::FILE *fh;
+
+	std::string buffer;
+	std::size_t records;
+
+	/**
+	 * Records buffered since the last commit record
+	 */
+	std::size_t group;
+
+	void BeginRecord(RecordType type, std::size_t &start);
+	void FinishRecord(std::size_t start);
+	void EndRecord(std::size_t start);
+
+	void AddInt(std::uint32_t value);
+	void AddString(const std::string &value);
+
+public:
+	Journal();
+	Journal(const Journal &) = delete;
+
+	/**
+	 * Opens (or creates) the journal file for appending
+	 * @return false if the file could not be opened
+	 */
+	bool Open(const std::string &filename);
+	bool IsOpen() const { return this->fh != 0; }
+	void Close();
+
+	void WriteItems(const std::string &name, const std::string &inventory, const std::string &bank, const std::string &paperdoll, int goldbank);
+	void WriteStats(const std::string &name, const Stats &stats);
+	void WriteQuest(const std::string &name, const std::string &quest);
+
+	/**
+	 * Writes all buffered records as one group and waits for them to reach the disk
+	 * @return false if the write failed
+	 */
+	bool Sync();
+
+	/**
+	 * Discards every record, to be called once the database has committed them
+	 */
+	void Truncate();
+
+	/**
+	 * Number of records written since the last truncation
+	 */
+	std::size_t Records() const { return this->records; }
+
+	/**
+	 * Applies the committed groups in a journal file to the database
+	 * Reading stops at the first incomplete or corrupt record, which is expected after a crash mid-write, and the records
+	 * of a group with no commit record are discarded.
+	 * @return Number of records applied
+	 * @throw Database_Exception
+	 */
+	static std::size_t Replay(const std::string &filename, Database &db);
+
+	~Journal();
+};
+
+#endif // JOURNAL_HPP_INCLUDED
@@ -0,0 +1,800 @@
+/* loadgen/bot.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "bot.hpp"
+
+#include "../fwd/character.hpp"
+#include "../fwd/eoclient.hpp"
+#include "../fwd/player.hpp"
+#include "../fwd/world.hpp"
+
+#include "../packet.hpp"
+
+#include "../socket.hpp"
+#include "../util.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const char *loadgen_chat[] = {
+	"hello",
+	"anyone want to trade?",
+	"where is the shop",
+	"brb",
+	"nice drop",
+	"lol",
+	"party up?",
+	"selling 2 wolf skins"
+};
+
+/**
+ * Names have to be letters only, so the player number is written in base 26
+ */
+static std::string loadgen_letters(int number)
+{
+	std::string result(4, 'a');
+
+	for (int i = 3; i >= 0; --i)
+	{
+		result[i] = char('a' + number % 26);
+		number /= 26;
+	}
+
+	return result;
+}
+
+static const char *loadgen_state_name(Loadgen_Bot::State state)
+{
+	switch (state)
+	{
+	case Loadgen_Bot::Playing:
+		return "in_game";
+
+	case Loadgen_Bot::Idle:
+	case Loadgen_Bot::Initializing:
+		return "connecting";
+
+	default:
+		return "logging_in";
+	}
+}
+
+void Loadgen_Stats::Merge(const Loadgen_Stats &other)
+{
+	UTIL_FOREACH_CREF(other.latency, entry)
+		this->latency[entry.first].merge(entry.second);
+
+	UTIL_FOREACH_CREF(other.timeouts, entry)
+		this->timeouts[entry.first] += entry.second;
+
+	UTIL_FOREACH_CREF(other.actions, entry)
+		this->actions[entry.first] += entry.second;
+
+	UTIL_FOREACH_CREF(other.errors, entry)
+		this->errors[entry.first] += entry.second;
+
+	this->packets_sent += other.packets_sent;
+	this->packets_received += other.packets_received;
+	this->bytes_sent += other.bytes_sent;
+	this->bytes_received += other.bytes_received;
+
+	this->connected += other.connected;
+	this->in_world += other.in_world;
+	this->disconnected += other.disconnected;
+}
+
+const char *Loadgen_Bot::ProfileName(Profile profile)
+{
+	switch (profile)
+	{
+	case ProfileWalk:
+		return "walk";
+
+	case ProfileChat:
+		return "chat";
+
+	case ProfileAttack:
+		return "attack";
+
+	case ProfileWarp:
+		return "warp";
+	}
+
+	return "unknown";
+}
+
+bool Loadgen_Bot::ParseProfile(const std::string &name, Profile &profile)
+{
+	for (int i = ProfileWalk; i <= ProfileWarp; ++i)
+	{
+		if (name == ProfileName(Profile(i)))
+		{
+			profile = Profile(i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+Loadgen_Bot::Loadgen_Bot(const Loadgen_Config &config, Loadgen_Stats &stats, int number, Profile profile, unsigned int seed)
+	: config(config), stats(stats), profile(profile), rng(seed), state(Idle), seq_start(0), seq(0),
+	  player_id(0), character_id(0), map(0), x(0), y(0), direction(0), warp_index(0)
+{
+	this->username = config.prefix + loadgen_letters(number);
+	this->character_name = this->username;
+}
+
+void Loadgen_Bot::Fail(const char *error)
+{
+	++this->stats.errors[error];
+	this->Stop();
+}
+
+PacketBuilder Loadgen_Bot::Packet(PacketFamily family, PacketAction action)
+{
+	PacketBuilder builder(family, action);
+
+	int sequence = this->seq_start + this->seq;
+	this->seq = (this->seq + 1) % 10;
+
+	if (sequence >= 253)
+		builder.AddShort(sequence);
+	else
+		builder.AddChar(sequence);
+
+	return builder;
+}
+
+void Loadgen_Bot::Send(const PacketBuilder &builder)
+{
+	std::string data = this->processor.Encode(builder.Get());
+
+	this->client->Send(data);
+
+	++this->stats.packets_sent;
+	this->stats.bytes_sent += data.length();
+}
+
+void Loadgen_Bot::Expect(const char *name, unsigned short reply_id, unsigned short alt_reply_id)
+{
+	this->pending.push_back({name, {reply_id, alt_reply_id}, loadgen_clock::now()});
+}
+
+void Loadgen_Bot::Resolve(unsigned short reply_id, loadgen_clock::time_point now)
+{
+	UTIL_IFOREACH(this->pending, it)
+	{
+		if (it->reply_id[0] == reply_id || it->reply_id[1] == reply_id)
+		{
+			std::uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(now - it->sent).count();
+			this->stats.latency[it->name].record(us);
+			this->pending.erase(it);
+			return;
+		}
+	}
+}
+
+int Loadgen_Bot::Timestamp(loadgen_clock::time_point now) const
+{
+	// Hundredths of a second, the server only looks at the difference between two of them
+	return int((std::chrono::duration_cast<std::chrono::milliseconds>(now - this->start).count() / 10) % PacketProcessor::MAX3);
+}
+
+void Loadgen_Bot::Start(loadgen_clock::time_point now)
+{
+	this->start = now;
+	this->client.reset(new Client);
+	this->client->SetRecvBuffer(64 * 1024);
+	this->client->SetSendBuffer(16 * 1024);
+
+	if (!this->client->Connect(this->config.host, this->config.port))
+	{
+		this->Fail("connect_failed");
+		return;
+	}
+
+	++this->stats.connected;
+
+	// Each player gets its own hardware ID so MaxConnectionsPerPC doesn't apply to them
+	std::string hdid = util::to_string(int(this->rng() % 900000000 + 100000000));
+
+	PacketBuilder builder(PACKET_F_INIT, PACKET_A_INIT, 7 + hdid.length());
+	builder.AddThree(int(this->rng() % 11092003) + 1); // Challenge
+	builder.AddChar(0); // ?
+	builder.AddChar(0); // ?
+	builder.AddChar(28); // Version
+	builder.AddChar(112); // Protocol
+	builder.AddChar(hdid.length());
+	builder.AddString(hdid);
+
+	this->Send(builder);
+
+	// The server counts the init packet as the first in the sequence
+	this->seq = 1;
+	this->state = Initializing;
+	this->Expect("init", PacketProcessor::PID(PACKET_F_INIT, PACKET_A_INIT));
+}
+
+void Loadgen_Bot::HandleInit(PacketReader &reader)
+{
+	int reply = reader.GetByte();
+
+	if (reply != INIT_OK)
+	{
+		this->Fail(reply == INIT_OUT_OF_DATE ? "init_out_of_date" : reply == INIT_BANNED ? "init_banned" : "init_rejected");
+		return;
+	}
+
+	int seq1 = reader.GetByte();
+	int seq2 = reader.GetByte();
+	int emulti_e = reader.GetByte();
+	int emulti_d = reader.GetByte();
+	this->player_id = reader.GetShort();
+	reader.GetThree(); // Challenge response
+
+	this->seq_start = seq1 * 7 + seq2 - 13;
+
+	// What the server encodes with we decode with, and the other way around
+	this->processor.SetEMulti(emulti_d, emulti_e);
+
+	PacketBuilder accept = this->Packet(PACKET_CONNECTION, PACKET_ACCEPT);
+	accept.AddShort(emulti_d);
+	accept.AddShort(emulti_e);
+	accept.AddShort(this->player_id);
+	this->Send(accept);
+
+	PacketBuilder request = this->Packet(PACKET_ACCOUNT, PACKET_REQUEST);
+	request.AddString(this->username);
+	this->Send(request);
+
+	this->state = CheckingAccount;
+	this->Expect("account_request", PacketProcessor::PID(PACKET_ACCOUNT, PACKET_REPLY));
+}
+
+void Loadgen_Bot::HandleAccount(PacketReader &reader)
+{
+	int reply = reader.GetShort();
+
+	if (this->state == CheckingAccount)
+	{
+		if (reply == ACCOUNT_CONTINUE)
+		{
+			this->seq_start = reader.GetChar();
+
+			PacketBuilder builder = this->Packet(PACKET_ACCOUNT, PACKET_CREATE);
+			builder.AddShort(1000); // Session ID
+			builder.AddByte(255);
+			builder.AddBreakString(this->username);
+			builder.AddBreakString(this->config.password);
+			builder.AddBreakString("Load Generator");
+			builder.AddBreakString("localhost");
+			builder.AddBreakString("loadgen@localhost");
+			builder.AddBreakString("loadgen");
+			builder.AddBreakString(util::to_string(int(this->rng() % 900000000 + 100000000)));
+			this->Send(builder);
+
+			this->state = CreatingAccount;
+			this->Expect("account_create", PacketProcessor::PID(PACKET_ACCOUNT, PACKET_REPLY));
+			return;
+		}
+
+		// Accounts are kept between runs
+		if (reply != ACCOUNT_EXISTS)
+		{
+			this->Fail("account_not_approved");
+			return;
+		}
+	}
+	else if (this->state == CreatingAccount)
+	{
+		if (reply != ACCOUNT_CREATED && reply != ACCOUNT_EXISTS)
+		{
+			this->Fail("account_create_failed");
+			return;
+		}
+	}
+	else
+	{
+		return;
+	}
+
+	PacketBuilder builder = this->Packet(PACKET_LOGIN, PACKET_REQUEST);
+	builder.AddBreakString(this->username);
+	builder.AddBreakString(this->config.password);
+	this->Send(builder);
+
+	this->state = LoggingIn;
+	this->Expect("login", PacketProcessor::PID(PACKET_LOGIN, PACKET_REPLY));
+}
+
+void Loadgen_Bot::HandleLogin(PacketReader &reader)
+{
+	if (this->state != LoggingIn)
+		return;
+
+	int reply = reader.GetShort();
+
+	if (reply != LOGIN_OK)
+	{
+		this->Fail(reply == LOGIN_LOGGEDIN ? "login_logged_in" : reply == LOGIN_BUSY ? "login_busy" : "login_failed");
+		return;
+	}
+
+	int characters = reader.GetChar();
+	reader.GetByte();
+	reader.GetByte();
+
+	if (characters > 0)
+	{
+		this->SelectCharacter(reader);
+		return;
+	}
+
+	PacketBuilder builder = this->Packet(PACKET_CHARACTER, PACKET_REQUEST);
+	builder.AddString("NEW");
+	this->Send(builder);
+
+	this->state = RequestingCharacter;
+	this->Expect("character_request", PacketProcessor::PID(PACKET_CHARACTER, PACKET_REPLY));
+}
+
+void Loadgen_Bot::HandleCharacter(PacketReader &reader)
+{
+	int reply = reader.GetShort();
+
+	if (this->state == RequestingCharacter)
+	{
+		PacketBuilder builder = this->Packet(PACKET_CHARACTER, PACKET_CREATE);
+		builder.AddShort(reply); // Create ID
+		builder.AddShort(int(this->rng() % 2) ? GENDER_MALE : GENDER_FEMALE);
+		builder.AddShort(1); // Hair style
+		builder.AddShort(0); // Hair color
+		builder.AddShort(0); // Skin
+		builder.AddByte(255);
+		builder.AddBreakString(this->character_name);
+		this->Send(builder);
+
+		this->state = CreatingCharacter;
+		this->Expect("character_create", PacketProcessor::PID(PACKET_CHARACTER, PACKET_REPLY));
+	}
+	else if (this->state == CreatingCharacter)
+	{
+		if (reply != CHARACTER_OK)
+		{
+			this->Fail(reply == CHARACTER_EXISTS ? "character_exists" : reply == CHARACTER_FULL ? "character_full" : "character_not_approved");
+			return;
+		}
+
+		reader.GetChar();
+		reader.GetByte();
+		reader.GetByte();
+
+		this->SelectCharacter(reader);
+	}
+}
+
+void Loadgen_Bot::SelectCharacter(PacketReader &reader)
+{
+	reader.GetBreakString(); // Name
+	this->character_id = reader.GetInt();
+
+	PacketBuilder builder = this->Packet(PACKET_WELCOME, PACKET_REQUEST);
+	builder.AddInt(this->character_id);
+	this->Send(builder);
+
+	this->state = Selecting;
+	this->Expect("select_character", PacketProcessor::PID(PACKET_WELCOME, PACKET_REPLY));
+}
+
+void Loadgen_Bot::HandleWelcome(PacketReader &reader, loadgen_clock::time_point now)
+{
+	int reply = reader.GetShort();
+
+	if (reply == 1 && this->state == Selecting)
+	{
+		this->player_id = reader.GetShort();
+		this->character_id = reader.GetInt();
+		this->map = reader.GetShort();
+
+		// The rest is pub file checksums and stats, the pub files are not needed to play
+
+		PacketBuilder builder = this->Packet(PACKET_WELCOME, PACKET_MSG);
+		builder.AddThree(this->player_id);
+		builder.AddInt(this->character_id);
+		this->Send(builder);
+
+		this->state = EnteringWorld;
+		this->Expect("enter_world", PacketProcessor::PID(PACKET_WELCOME, PACKET_REPLY));
+	}
+	else if (reply == 2 && this->state == EnteringWorld)
+	{
+		reader.GetByte();
+
+		for (int i = 0; i < 9; ++i)
+			reader.GetBreakString(); // News
+
+		reader.GetChar(); // Weight
+		reader.GetChar(); // Max weight
+		reader.GetBreakString(); // Inventory
+		reader.GetBreakString(); // Spells
+
+		this->ReadNearby(reader);
+
+		this->state = Playing;
+		++this->stats.in_world;
+
+		// Spread the players' actions out rather than having them all act on the same tick
+		std::uniform_int_distribution<int> spread(0, 1000);
+		this->next_action = now + std::chrono::milliseconds(spread(this->rng));
+		this->next_refresh = now + std::chrono::seconds(3) + std::chrono::milliseconds(spread(this->rng));
+		this->next_ping = now + std::chrono::seconds(1) + std::chrono::milliseconds(spread(this->rng) * 4);
+	}
+}
+
+void Loadgen_Bot::ReadNearby(PacketReader &reader)
+{
+	int characters = reader.GetChar();
+	reader.GetByte();
+
+	for (int i = 0; i < characters; ++i)
+	{
+		reader.GetBreakString(); // Name
+		int id = reader.GetShort();
+		int map = reader.GetShort();
+		int x = reader.GetShort();
+		int y = reader.GetShort();
+		reader.GetBreakString(); // Appearance
+
+		if (id == this->player_id)
+		{
+			this->map = map;
+			this->x = x;
+			this->y = y;
+		}
+	}
+
+	std::string npc_data = reader.GetBreakString();
+	this->npcs.clear();
+
+	// Index, ID (2 bytes), X, Y, direction
+	for (std::size_t i = 0; i + 6 <= npc_data.length(); i += 6)
+	{
+		this->npcs.push_back({
+			int(PacketProcessor::Number(npc_data[i])),
+			int(PacketProcessor::Number(npc_data[i + 3])),
+			int(PacketProcessor::Number(npc_data[i + 4]))
+		});
+	}
+}
+
+void Loadgen_Bot::Handle(PacketReader &reader, loadgen_clock::time_point now)
+{
+	PacketFamily family = reader.Family();
+	PacketAction action = reader.Action();
+
+	this->Resolve(PacketProcessor::PID(family, action), now);
+
+	switch (family)
+	{
+	case PACKET_F_INIT:
+		if (action == PACKET_A_INIT && this->state == Initializing)
+			this->HandleInit(reader);
+
+		break;
+
+	case PACKET_CONNECTION:
+		if (action == PACKET_PLAYER)
+		{
+			int seq1 = reader.GetShort();
+			int seq2 = reader.GetChar();
+
+			// The new sequence starts with our reply
+			this->seq_start = seq1 - seq2;
+
+			PacketBuilder builder = this->Packet(PACKET_CONNECTION, PACKET_PING);
+			builder.AddString("k");
+			this->Send(builder);
+		}
+
+		break;
+
+	case PACKET_ACCOUNT:
+		if (action == PACKET_REPLY)
+			this->HandleAccount(reader);
+
+		break;
+
+	case PACKET_LOGIN:
+		if (action == PACKET_REPLY)
+			this->HandleLogin(reader);
+
+		break;
+
+	case PACKET_CHARACTER:
+		if (action == PACKET_REPLY)
+			this->HandleCharacter(reader);
+
+		break;
+
+	case PACKET_WELCOME:
+		if (action == PACKET_REPLY)
+			this->HandleWelcome(reader, now);
+
+		break;
+
+	case PACKET_REFRESH:
+		if (action == PACKET_REPLY)
+			this->ReadNearby(reader);
+
+		break;
+
+	case PACKET_WARP:
+		if (action == PACKET_REQUEST)
+		{
+			reader.GetChar(); // Warp type
+			int map = reader.GetShort();
+
+			PacketBuilder builder = this->Packet(PACKET_WARP, PACKET_ACCEPT);
+			builder.AddShort(map);
+			this->Send(builder);
+		}
+		else if (action == PACKET_AGREE)
+		{
+			reader.GetChar();
+			this->map = reader.GetShort();
+			reader.GetChar(); // Animation
+
+			this->ReadNearby(reader);
+		}
+
+		break;
+
+	default:
+		break;
+	}
+}
+
+void Loadgen_Bot::Walk(int direction, loadgen_clock::time_point now)
+{
+	static const int dx[4] = {0, -1, 0, 1};
+	static const int dy[4] = {1, 0, -1, 0};
+
+	int new_x = this->x + dx[direction];
+	int new_y = this->y + dy[direction];
+
+	// Turn around at the top and left edges, the server corrects us at the others
+	if (new_x < 0 || new_y < 0)
+	{
+		direction = (direction + 2) % 4;
+		new_x = this->x + dx[direction];
+		new_y = this->y + dy[direction];
+	}
+
+	PacketBuilder builder = this->Packet(PACKET_WALK, PACKET_PLAYER);
+	builder.AddChar(direction);
+	builder.AddThree(this->Timestamp(now));
+	builder.AddChar(new_x);
+	builder.AddChar(new_y);
+	this->Send(builder);
+
+	this->x = new_x;
+	this->y = new_y;
+	this->direction = direction;
+
+	++this->stats.actions["walk"];
+
+	// A blocked step is answered with a refresh instead
+	this->Expect("walk", PacketProcessor::PID(PACKET_WALK, PACKET_REPLY), PacketProcessor::PID(PACKET_REFRESH, PACKET_REPLY));
+}
+
+bool Loadgen_Bot::Attack(loadgen_clock::time_point now)
+{
+	const NPC_Position *nearest = nullptr;
+	int nearest_distance = 0;
+
+	UTIL_FOREACH_CREF(this->npcs, npc)
+	{
+		int distance = std::abs(npc.x - this->x) + std::abs(npc.y - this->y);
+
+		if (!nearest || distance < nearest_distance)
+		{
+			nearest = &npc;
+			nearest_distance = distance;
+		}
+	}
+
+	if (!nearest)
+		return false;
+
+	int dx = nearest->x - this->x;
+	int dy = nearest->y - this->y;
+	int direction;
+
+	if (std::abs(dx) > std::abs(dy))
+		direction = dx > 0 ? DIRECTION_RIGHT : DIRECTION_LEFT;
+	else
+		direction = dy > 0 ? DIRECTION_DOWN : DIRECTION_UP;
+
+	if (nearest_distance > 1)
+	{
+		this->Walk(direction, now);
+		return true;
+	}
+
+	PacketBuilder builder = this->Packet(PACKET_ATTACK, PACKET_USE);
+	builder.AddChar(direction);
+	builder.AddThree(this->Timestamp(now));
+	this->Send(builder);
+
+	this->direction = direction;
+	++this->stats.actions["attack"];
+
+	return true;
+}
+
+void Loadgen_Bot::Act(loadgen_clock::time_point now)
+{
+	// Timestamps closer than this are dropped by the server when EnforceTimestamps is on
+	std::uniform_int_distribution<int> step(650, 850);
+	std::uniform_int_distribution<int> pause(2000, 5000);
+	std::uniform_int_distribution<int> turn(0, 3);
+
+	int delay = step(this->rng);
+
+	// Keep going the same way most of the time, like a player would
+	int direction = (this->rng() % 4 == 0) ? turn(this->rng) : this->direction;
+
+	switch (this->profile)
+	{
+	case ProfileWalk:
+		this->Walk(direction, now);
+		break;
+
+	case ProfileChat:
+	{
+		PacketBuilder builder = this->Packet(PACKET_TALK, PACKET_REPORT);
+		builder.AddString(loadgen_chat[this->rng() % (sizeof loadgen_chat / sizeof loadgen_chat[0])]);
+		this->Send(builder);
+
+		++this->stats.actions["chat"];
+		delay = pause(this->rng);
+		break;
+	}
+
+	case ProfileAttack:
+		if (!this->Attack(now))
+			this->Walk(direction, now);
+
+		break;
+
+	case ProfileWarp:
+		if (!this->config.warp_maps.empty() && this->rng() % 10 == 0)
+		{
+			int map = this->config.warp_maps[this->warp_index++ % this->config.warp_maps.size()];
+
+			PacketBuilder builder = this->Packet(PACKET_TALK, PACKET_REPORT);
+			builder.AddString("$warp " + util::to_string(map) + " " + util::to_string(this->x) + " " + util::to_string(this->y));
+			this->Send(builder);
+
+			++this->stats.actions["warp"];
+			this->Expect("warp", PacketProcessor::PID(PACKET_WARP, PACKET_AGREE));
+		}
+		else
+		{
+			this->Walk(direction, now);
+		}
+
+		break;
+	}
+
+	this->next_action = now + std::chrono::milliseconds(delay);
+
+	if (now >= this->next_ping)
+	{
+		PacketBuilder builder = this->Packet(PACKET_MESSAGE, PACKET_PING);
+		builder.AddShort(2);
+		this->Send(builder);
+
+		this->Expect("ping", PacketProcessor::PID(PACKET_MESSAGE, PACKET_PONG));
+		this->next_ping = now + std::chrono::seconds(5);
+	}
+
+	// Attackers lose track of NPCs as they move, so they look around more often
+	if (now >= this->next_refresh)
+	{
+		this->Send(this->Packet(PACKET_REFRESH, PACKET_REQUEST));
+
+		++this->stats.actions["refresh"];
+		this->Expect("refresh", PacketProcessor::PID(PACKET_REFRESH, PACKET_REPLY));
+		this->next_refresh = now + std::chrono::seconds(this->profile == ProfileAttack ? 3 : 30);
+	}
+}
+
+bool Loadgen_Bot::Tick(loadgen_clock::time_point now)
+{
+	if (this->state == Idle || this->state == Closed)
+		return false;
+
+	bool handled = false;
+
+	try
+	{
+		if (this->state == Playing && now >= this->next_action)
+			this->Act(now);
+
+		this->client->Select(0.0);
+		this->inbuf += this->client->Recv(64 * 1024);
+
+		while (this->inbuf.length() >= 2 && this->state != Closed)
+		{
+			std::size_t length = PacketProcessor::Number(this->inbuf[0], this->inbuf[1]);
+
+			if (this->inbuf.length() < length + 2)
+				break;
+
+			std::string data = this->inbuf.substr(2, length);
+			this->inbuf.erase(0, length + 2);
+
+			++this->stats.packets_received;
+			this->stats.bytes_received += length + 2;
+
+			if (data.length() < 2)
+				continue;
+
+			PacketReader reader(this->processor.Decode(data));
+
+			try
+			{
+				this->Handle(reader, now);
+			}
+			catch (std::out_of_range &)
+			{
+				// Reading past the end of a packet that doesn't have the layout we expect
+				++this->stats.errors["bad_packet"];
+			}
+
+			handled = true;
+		}
+	}
+	catch (Socket_Exception &)
+	{
+		this->Fail("socket_error");
+		return handled;
+	}
+
+	if (this->state != Closed && !this->client->Connected())
+	{
+		++this->stats.disconnected;
+		++this->stats.errors[std::string("disconnected_") + loadgen_state_name(this->state)];
+		this->state = Closed;
+	}
+
+	while (!this->pending.empty() && now - this->pending.front().sent > std::chrono::duration<double>(this->config.timeout))
+	{
+		++this->stats.timeouts[this->pending.front().name];
+		this->pending.pop_front();
+	}
+
+	return handled;
+}
+
+void Loadgen_Bot::Stop()
+{
+	if (this->client && this->client->Connected())
+		this->client->Close(true);
+
+	this->state = Closed;
+}
+
+Loadgen_Bot::~Loadgen_Bot()
+{
+	this->Stop();
+}
@@ -0,0 +1,213 @@
+/* loadgen/bot.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef LOADGEN_BOT_HPP_INCLUDED
+#define LOADGEN_BOT_HPP_INCLUDED
+
+#include "../fwd/packet.hpp"
+
+#include "../packet.hpp"
+#include "../socket.hpp"
+
+#include "../util/histogram.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock loadgen_clock;
+
+/**
+ * Settings shared by every simulated player
+ */
+struct Loadgen_Config
+{
+	IPAddress host;
+	unsigned short port = 8078;
+
+	/**
+	 * Account and character names are the prefix followed by the player number written in letters
+	 */
+	std::string prefix = "lg";
+	std::string password = "loadgen";
+
+	/**
+	 * Maps visited by the warp profile with $warp, which requires the characters to have admin access
+	 */
+	std::vector<int> warp_maps;
+
+	/**
+	 * Requests that get no reply within this many seconds count as timed out
+	 */
+	double timeout = 10.0;
+};
+
+/**
+ * Counters collected by the players on one worker thread, merged in to the report when the run ends
+ */
+struct Loadgen_Stats
+{
+	/**
+	 * Round trip times in microseconds, from sending a request to receiving its reply
+	 */
+	std::map<std::string, util::histogram> latency;
+	std::map<std::string, std::uint64_t> timeouts;
+	std::map<std::string, std::uint64_t> actions;
+	std::map<std::string, std::uint64_t> errors;
+
+	std::uint64_t packets_sent = 0;
+	std::uint64_t packets_received = 0;
+	std::uint64_t bytes_sent = 0;
+	std::uint64_t bytes_received = 0;
+
+	int connected = 0;
+	int in_world = 0;
+	int disconnected = 0;
+
+	void Merge(const Loadgen_Stats &other);
+};
+
+/**
+ * One simulated player, driving the same login sequence and packets as the game client
+ */
+class Loadgen_Bot
+{
+public:
+	enum State
+	{
+		Idle,
+		Initializing,
+		CheckingAccount,
+		CreatingAccount,
+		LoggingIn,
+		RequestingCharacter,
+		CreatingCharacter,
+		Selecting,
+		EnteringWorld,
+		Playing,
+		Closed
+	};
+
+	enum Profile
+	{
+		ProfileWalk,
+		ProfileChat,
+		ProfileAttack,
+		ProfileWarp
+	};
+
+	static const char *ProfileName(Profile profile);
+
+	/**
+	 * Returns false if the name does not match a profile
+	 */
+	static bool ParseProfile(const std::string &name, Profile &profile);
+
+protected:
+	struct Pending
+	{
+		const char *name;
+		unsigned short reply_id[2];
+		loadgen_clock::time_point sent;
+	};
+
+	struct NPC_Position
+	{
+		int index;
+		int x;
+		int y;
+	};
+
+	const Loadgen_Config &config;
+	Loadgen_Stats &stats;
+
+	Profile profile;
+	std::mt19937 rng;
+
+	std::unique_ptr<Client> client;
+	PacketProcessor processor;
+	std::string inbuf;
+
+	State state;
+
+	int seq_start;
+	int seq;
+
+	std::string username;
+	std::string character_name;
+
+	int player_id;
+	unsigned int character_id;
+
+	int map;
+	int x;
+	int y;
+	int direction;
+	int warp_index;
+
+	std::vector<NPC_Position> npcs;
+
+	std::deque<Pending> pending;
+
+	loadgen_clock::time_point start;
+	loadgen_clock::time_point next_action;
+	loadgen_clock::time_point next_refresh;
+	loadgen_clock::time_point next_ping;
+
+	void Fail(const char *error);
+
+	PacketBuilder Packet(PacketFamily family, PacketAction action);
+	void Send(const PacketBuilder &builder);
+
+	void Expect(const char *name, unsigned short reply_id, unsigned short alt_reply_id = 0);
+	void Resolve(unsigned short reply_id, loadgen_clock::time_point now);
+
+	int Timestamp(loadgen_clock::time_point now) const;
+
+	void Handle(PacketReader &reader, loadgen_clock::time_point now);
+	void HandleInit(PacketReader &reader);
+	void HandleAccount(PacketReader &reader);
+	void HandleLogin(PacketReader &reader);
+	void HandleCharacter(PacketReader &reader);
+	void HandleWelcome(PacketReader &reader, loadgen_clock::time_point now);
+
+	/**
+	 * Reads the characters and NPCs in range, the same list is sent by Welcome, Refresh and Warp replies
+	 */
+	void ReadNearby(PacketReader &reader);
+
+	void SelectCharacter(PacketReader &reader);
+
+	void Act(loadgen_clock::time_point now);
+	void Walk(int direction, loadgen_clock::time_point now);
+	bool Attack(loadgen_clock::time_point now);
+
+public:
+	Loadgen_Bot(const Loadgen_Config &config, Loadgen_Stats &stats, int number, Profile profile, unsigned int seed);
+
+	/**
+	 * Connects and sends the first packet of the login sequence
+	 */
+	void Start(loadgen_clock::time_point now);
+
+	/**
+	 * Sends and receives anything pending and performs the next action when it is due
+	 * Returns true if any packets were handled.
+	 */
+	bool Tick(loadgen_clock::time_point now);
+
+	void Stop();
+
+	State GetState() const { return this->state; }
+
+	~Loadgen_Bot();
+};
+
+#endif // LOADGEN_BOT_HPP_INCLUDED
@@ -0,0 +1,754 @@
+/* loadgen/loadgen.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "bot.hpp"
+#include "replay.hpp"
+
+#include "../capture.hpp"
+
+#include "../console.hpp"
+#include "../socket.hpp"
+#include "../util.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+volatile std::sig_atomic_t loadgen_sig_abort = false;
+
+static void loadgen_terminate(int signal)
+{
+	(void)signal;
+	loadgen_sig_abort = true;
+}
+
+struct Loadgen_Options
+{
+	Loadgen_Config config;
+
+	int players = 10;
+	int threads = 2;
+	double duration = 60.0;
+	double ramp = 10.0;
+	unsigned int seed = 0;
+
+	std::vector<Loadgen_Bot::Profile> mix;
+
+	std::string metrics_host;
+	unsigned short metrics_port = 0;
+
+	std::string report = "loadgen-report.json";
+
+	/**
+	 * Capture to replay instead of running simulated players
+	 */
+	std::string capture;
+	double speed = 1.0;
+};
+
+/**
+ * A share of the players, driven from one thread
+ */
+struct Loadgen_Worker
+{
+	std::vector<std::unique_ptr<Loadgen_Bot>> bots;
+	std::vector<loadgen_clock::time_point> start_at;
+	Loadgen_Stats stats;
+	int online = 0;
+	std::thread thread;
+};
+
+/**
+ * Cumulative bucket counts of one histogram series scraped from the server
+ */
+struct Loadgen_Server_Histogram
+{
+	std::map<double, double> buckets;
+	double count = 0.0;
+	double sum = 0.0;
+};
+
+typedef std::map<std::string, Loadgen_Server_Histogram> loadgen_histograms;
+
+static void loadgen_usage()
+{
+	std::puts(
+		"Usage: eoserv-loadgen [option=value ...]\n"
+		"\n"
+		"Logs simulated players in to a running server and reports the latency they see.\n"
+		"\n"
+		"  host=127.0.0.1         Server address\n"
+		"  port=8078              Server port\n"
+		"  players=10             Number of simulated players\n"
+		"  threads=2              Threads to drive the players from\n"
+		"  duration=60s           Length of the run, including the ramp\n"
+		"  ramp=10s               Time over which the players connect\n"
+		"  mix=walk:4,chat:2,attack:3,warp:1\n"
+		"                         Relative share of each behaviour profile\n"
+		"  warp=                  Comma separated maps for the warp profile to $warp between\n"
+		"  prefix=lg              Account and character name prefix (letters, up to 8)\n"
+		"  password=loadgen       Account password\n"
+		"  timeout=10s            Time after which an unanswered request is counted as timed out\n"
+		"  metrics=               host:port of the server's metrics listener (MetricsPort), for server-side latency\n"
+		"  report=loadgen-report.json\n"
+		"                         Where to write the JSON report, - for standard output\n"
+		"  seed=                  Random seed, for repeatable runs\n"
+		"  capture=               Replay a capture recorded with $capture instead of simulating players\n"
+		"  speed=1                Replay speed, 1 for the speed it was recorded at\n"
+		"\n"
+		"Accounts and characters are created on first use and reused afterwards.\n"
+		"Running many players from one address needs MaxConnectionsPerIP and IPReconnectLimit set to 0 on the server.\n"
+		"The warp profile needs its characters to have access to $warp.\n"
+		"\n"
+		"A replay opens a connection for each one recorded and sends what it sent, answering only pings. It runs\n"
+		"until the capture ends, or for duration if one is given. Captured passwords are replaced with \"capture\",\n"
+		"so replay against a copy of the database that eoserv-sim passwords=reset has been run on.\n"
+		"Values handed out by the server, such as player IDs in trade requests, are sent as they were recorded.\n"
+	);
+}
+
+static bool loadgen_parse(int argc, char *argv[], Loadgen_Options &options)
+{
+	options.seed = unsigned(std::time(0));
+	std::string mix = "walk:4,chat:2,attack:3,warp:1";
+	bool duration_set = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		std::size_t eq = arg.find('=');
+
+		if (eq == std::string::npos)
+			return false;
+
+		std::string key = arg.substr(0, eq);
+		std::string value = arg.substr(eq + 1);
+
+		if (key == "host")
+			options.config.host = IPAddress::Lookup(value);
+		else if (key == "port")
+			options.config.port = (unsigned short)util::to_int(value);
+		else if (key == "players")
+			options.players = util::to_int(value);
+		else if (key == "threads")
+			options.threads = util::to_int(value);
+		else if (key == "duration")
+		{
+			options.duration = util::tdparse(value);
+			duration_set = true;
+		}
+		else if (key == "ramp")
+			options.ramp = util::tdparse(value);
+		else if (key == "mix")
+			mix = value;
+		else if (key == "prefix")
+			options.config.prefix = value;
+		else if (key == "password")
+			options.config.password = value;
+		else if (key == "timeout")
+			options.config.timeout = util::tdparse(value);
+		else if (key == "report")
+			options.report = value;
+		else if (key == "seed")
+			options.seed = unsigned(util::to_int(value));
+		else if (key == "capture")
+			options.capture = value;
+		else if (key == "speed")
+			options.speed = util::to_float(value);
+		else if (key == "warp")
+		{
+			UTIL_FOREACH(util::explode(',', value), map)
+			{
+				if (!map.empty())
+					options.config.warp_maps.push_back(util::to_int(map));
+			}
+		}
+		else if (key == "metrics")
+		{
+			std::size_t colon = value.rfind(':');
+
+			if (colon == std::string::npos)
+				return false;
+
+			options.metrics_host = value.substr(0, colon);
+			options.metrics_port = (unsigned short)util::to_int(value.substr(colon + 1));
+		}
+		else
+		{
+			Console::Err("Unknown option: %s", key.c_str());
+			return false;
+		}
+	}
+
+	UTIL_FOREACH(util::explode(',', mix), entry)
+	{
+		std::vector<std::string> parts = util::explode(':', entry);
+		Loadgen_Bot::Profile profile;
+
+		if (!Loadgen_Bot::ParseProfile(util::trim(parts[0]), profile))
+		{
+			Console::Err("Unknown profile: %s", parts[0].c_str());
+			return false;
+		}
+
+		int weight = parts.size() > 1 ? util::to_int(parts[1]) : 1;
+
+		for (int i = 0; i < weight; ++i)
+			options.mix.push_back(profile);
+	}
+
+	// A replay runs until the capture ends unless told otherwise
+	if (!options.capture.empty() && !duration_set)
+		options.duration = 0.0;
+
+	if (!options.capture.empty())
+		return options.speed > 0.0 && options.duration >= 0.0;
+
+	if (options.mix.empty() || options.players < 1 || options.threads < 1 || options.duration <= 0.0)
+		return false;
+
+	if (options.config.prefix.empty() || options.config.prefix.length() > 8
+	 || options.config.prefix.find_first_not_of("abcdefghijklmnopqrstuvwxyz") != std::string::npos)
+	{
+		Console::Err("Name prefix must be 1 to 8 lowercase letters");
+		return false;
+	}
+
+	return true;
+}
+
+static void loadgen_run(Loadgen_Worker *worker, loadgen_clock::time_point deadline, const std::atomic<bool> *stop)
+{
+	while (!*stop && loadgen_clock::now() < deadline)
+	{
+		loadgen_clock::time_point now = loadgen_clock::now();
+		bool busy = false;
+
+		for (std::size_t i = 0; i < worker->bots.size(); ++i)
+		{
+			Loadgen_Bot &bot = *worker->bots[i];
+
+			if (bot.GetState() == Loadgen_Bot::Idle && now >= worker->start_at[i])
+				bot.Start(now);
+
+			busy |= bot.Tick(now);
+		}
+
+		if (!busy)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	UTIL_FOREACH_CREF(worker->bots, bot)
+	{
+		if (bot->GetState() == Loadgen_Bot::Playing)
+			++worker->online;
+
+		bot->Stop();
+	}
+}
+
+/**
+ * Fetches the server's metrics, returning each series by its name and labels
+ */
+static bool loadgen_scrape(const Loadgen_Options &options, std::map<std::string, double> &series)
+{
+	Client client;
+	client.SetRecvBuffer(1024 * 1024);
+	client.SetSendBuffer(1024);
+
+	if (!client.Connect(IPAddress::Lookup(options.metrics_host), options.metrics_port))
+		return false;
+
+	client.Send("GET /metrics HTTP/1.0\r\n\r\n");
+
+	std::string response;
+	loadgen_clock::time_point deadline = loadgen_clock::now() + std::chrono::seconds(5);
+
+	try
+	{
+		while (client.Connected() && loadgen_clock::now() < deadline)
+		{
+			client.Select(0.1);
+			response += client.Recv(1024 * 1024);
+		}
+	}
+	catch (Socket_Exception &)
+	{
+		return false;
+	}
+
+	response += client.Recv(1024 * 1024);
+
+	std::size_t body = response.find("\r\n\r\n");
+
+	if (response.compare(0, 12, "HTTP/1.0 200") != 0 || body == std::string::npos)
+		return false;
+
+	UTIL_FOREACH(util::explode('\n', response.substr(body + 4)), line)
+	{
+		std::size_t space = line.rfind(' ');
+
+		if (line.empty() || line[0] == '#' || space == std::string::npos)
+			continue;
+
+		series[line.substr(0, space)] = std::strtod(line.c_str() + space + 1, nullptr);
+	}
+
+	return true;
+}
+
+/**
+ * Runs the simulated players on their worker threads, scraping the server's metrics before they stop
+ * Returns the number of players still in the game at the end.
+ */
+static int loadgen_players(const Loadgen_Options &options, Loadgen_Stats &stats, std::map<std::string, double> &server_after, bool &scraped)
+{
+	std::vector<std::unique_ptr<Loadgen_Worker>> workers;
+	loadgen_clock::time_point start = loadgen_clock::now();
+	loadgen_clock::time_point deadline = start + std::chrono::duration_cast<loadgen_clock::duration>(std::chrono::duration<double>(options.duration));
+	std::atomic<bool> stop(false);
+
+	for (int i = 0; i < options.threads; ++i)
+		workers.emplace_back(new Loadgen_Worker);
+
+	for (int i = 0; i < options.players; ++i)
+	{
+		Loadgen_Worker &worker = *workers[i % options.threads];
+		Loadgen_Bot::Profile profile = options.mix[i % options.mix.size()];
+		double offset = options.ramp * double(i) / double(options.players);
+
+		worker.bots.emplace_back(new Loadgen_Bot(options.config, worker.stats, i, profile, options.seed + unsigned(i)));
+		worker.start_at.push_back(start + std::chrono::duration_cast<loadgen_clock::duration>(std::chrono::duration<double>(offset)));
+	}
+
+	Console::Out("Running %i players against %s:%i for %.0fs", options.players, std::string(options.config.host).c_str(), int(options.config.port), options.duration);
+
+	UTIL_FOREACH_CREF(workers, worker)
+		worker->thread = std::thread(loadgen_run, worker.get(), deadline, &stop);
+
+	while (!loadgen_sig_abort && loadgen_clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+	// Scraped while the load is still on, the server publishes once a second
+	if (scraped)
+		scraped = loadgen_scrape(options, server_after);
+
+	stop = true;
+
+	int online = 0;
+
+	UTIL_FOREACH_CREF(workers, worker)
+	{
+		worker->thread.join();
+		stats.Merge(worker->stats);
+		online += worker->online;
+	}
+
+	return online;
+}
+
+/**
+ * Replays a capture from this thread, scraping the server's metrics before the connections close
+ * Returns the number of connections still open at the end.
+ */
+static int loadgen_replay(Loadgen_Options &options, Capture_Reader &capture, Loadgen_Stats &stats, std::map<std::string, double> &server_after, bool &scraped)
+{
+	std::map<unsigned short, std::unique_ptr<Loadgen_Replay>> connections;
+	loadgen_clock::time_point start = loadgen_clock::now();
+	loadgen_clock::time_point deadline = loadgen_clock::time_point::max();
+	loadgen_clock::time_point tail = loadgen_clock::time_point::max();
+
+	if (options.duration > 0.0)
+		deadline = start + std::chrono::duration_cast<loadgen_clock::duration>(std::chrono::duration<double>(options.duration));
+
+	options.players = 0;
+
+	Capture_Record record;
+	bool more = capture.Read(record);
+
+	if (!more)
+		tail = start;
+
+	while (!loadgen_sig_abort)
+	{
+		loadgen_clock::time_point now = loadgen_clock::now();
+
+		if (now >= deadline || now >= tail)
+			break;
+
+		while (more && now >= start + std::chrono::duration_cast<loadgen_clock::duration>(std::chrono::duration<double>(double(record.time) / 1000.0 / options.speed)))
+		{
+			auto it = connections.find(record.client);
+
+			if (record.type == Capture_Record::Close)
+			{
+				if (it != connections.end())
+					connections.erase(it);
+			}
+			else if (record.family == PACKET_F_INIT)
+			{
+				// Replaces a connection whose close went unrecorded
+				std::unique_ptr<Loadgen_Replay> connection(new Loadgen_Replay(options.config, stats));
+				connection->Start(record);
+				connections[record.client] = std::move(connection);
+				++options.players;
+			}
+			else if (it != connections.end())
+			{
+				it->second->Deliver(record);
+			}
+			else
+			{
+				// Sent by a client that connected before the capture started
+				++stats.errors["connected_before_capture"];
+			}
+
+			more = capture.Read(record);
+
+			// Give the server a moment to answer the last packets
+			if (!more)
+				tail = now + std::chrono::seconds(5);
+		}
+
+		bool busy = false;
+
+		UTIL_FOREACH_CREF(connections, connection)
+			busy |= connection.second->Tick();
+
+		if (!busy)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	if (scraped)
+		scraped = loadgen_scrape(options, server_after);
+
+	int online = 0;
+
+	UTIL_FOREACH_CREF(connections, connection)
+	{
+		if (!connection.second->Closed())
+			++online;
+	}
+
+	return online;
+}
+
+static std::string loadgen_label(const std::string &labels, const std::string &name)
+{
+	std::size_t start = labels.find(name + "=\"");
+
+	if (start == std::string::npos)
+		return std::string();
+
+	start += name.length() + 2;
+
+	return labels.substr(start, labels.find('"', start) - start);
+}
+
+/**
+ * Collects the histograms called name from a scrape, keyed by the value of the given label
+ */
+static loadgen_histograms loadgen_find_histograms(const std::map<std::string, double> &series, const std::string &name, const std::string &label)
+{
+	loadgen_histograms result;
+
+	UTIL_FOREACH_CREF(series, entry)
+	{
+		const std::string &key = entry.first;
+		std::size_t brace = key.find('{');
+		std::string metric = key.substr(0, brace);
+		std::string labels = brace == std::string::npos ? std::string() : key.substr(brace);
+		std::string group = label.empty() ? std::string() : loadgen_label(labels, label);
+
+		if (metric == name + "_bucket")
+			result[group].buckets[std::strtod(loadgen_label(labels, "le").c_str(), nullptr)] = entry.second;
+		else if (metric == name + "_count")
+			result[group].count = entry.second;
+		else if (metric == name + "_sum")
+			result[group].sum = entry.second;
+	}
+
+	return result;
+}
+
+static double loadgen_sum_series(const std::map<std::string, double> &series, const std::string &name)
+{
+	double total = 0.0;
+
+	UTIL_FOREACH_CREF(series, entry)
+	{
+		if (entry.first.compare(0, entry.first.find('{'), name) == 0)
+			total += entry.second;
+	}
+
+	return total;
+}
+
+/**
+ * Cumulative count at or below a bound, empty buckets are left out of the exposition so the nearest lower one is used
+ */
+static double loadgen_cumulative(const Loadgen_Server_Histogram &h, double le)
+{
+	auto it = h.buckets.upper_bound(le);
+
+	if (it == h.buckets.begin())
+		return 0.0;
+
+	return (--it)->second;
+}
+
+static std::string loadgen_json_number(double n)
+{
+	char buf[32];
+	std::snprintf(buf, sizeof buf, "%.3f", n);
+	return buf;
+}
+
+static std::string loadgen_json_count(double n)
+{
+	char buf[32];
+	std::snprintf(buf, sizeof buf, "%.0f", n);
+	return buf;
+}
+
+static std::string loadgen_json_client_latency(const util::histogram &h, std::uint64_t timeouts)
+{
+	return "{\"count\":" + loadgen_json_count(double(h.count()))
+		+ ",\"timeouts\":" + loadgen_json_count(double(timeouts))
+		+ ",\"mean_ms\":" + loadgen_json_number(h.mean() / 1000.0)
+		+ ",\"p50_ms\":" + loadgen_json_number(double(h.percentile(50)) / 1000.0)
+		+ ",\"p90_ms\":" + loadgen_json_number(double(h.percentile(90)) / 1000.0)
+		+ ",\"p99_ms\":" + loadgen_json_number(double(h.percentile(99)) / 1000.0)
+		+ ",\"max_ms\":" + loadgen_json_number(double(h.max()) / 1000.0) + "}";
+}
+
+/**
+ * Percentiles of what was recorded between two scrapes, accurate to the server's bucket bounds
+ */
+static std::string loadgen_json_server_latency(const Loadgen_Server_Histogram &before, const Loadgen_Server_Histogram &after)
+{
+	double count = after.count - before.count;
+	double sum = after.sum - before.sum;
+	std::string result = "{\"count\":" + loadgen_json_count(count) + ",\"mean_ms\":" + loadgen_json_number(count > 0 ? sum * 1000.0 / count : 0.0);
+
+	static const double percentiles[] = {50.0, 90.0, 99.0};
+
+	UTIL_FOREACH(percentiles, p)
+	{
+		double value = 0.0;
+
+		UTIL_FOREACH_CREF(after.buckets, bucket)
+		{
+			if (bucket.second - loadgen_cumulative(before, bucket.first) >= count * p / 100.0)
+			{
+				value = bucket.first;
+				break;
+			}
+		}
+
+		// Anything past the last bucket is reported as the last finite bound
+		if (std::isinf(value) && after.buckets.size() > 1)
+			value = std::prev(after.buckets.end(), 2)->first;
+
+		result += ",\"p" + util::to_string(int(p)) + "_ms\":" + loadgen_json_number(count > 0 ? value * 1000.0 : 0.0);
+	}
+
+	return result + "}";
+}
+
+static std::string loadgen_report(const Loadgen_Options &options, const Loadgen_Stats &stats, int online, double elapsed,
+	const std::map<std::string, double> &server_before, const std::map<std::string, double> &server_after, bool scraped)
+{
+	std::string json = "{\n";
+
+	json += "\"config\":{\"host\":\"" + std::string(options.config.host) + "\",\"port\":" + util::to_string(options.config.port)
+		+ ",\"players\":" + util::to_string(options.players) + ",\"threads\":" + util::to_string(options.threads)
+		+ ",\"duration\":" + loadgen_json_number(options.duration) + ",\"ramp\":" + loadgen_json_number(options.ramp)
+		+ ",\"seed\":" + util::to_string(int(options.seed)) + "},\n";
+
+	json += "\"elapsed\":" + loadgen_json_number(elapsed) + ",\n";
+
+	json += "\"players\":{\"requested\":" + util::to_string(options.players) + ",\"connected\":" + util::to_string(stats.connected)
+		+ ",\"in_world\":" + util::to_string(stats.in_world) + ",\"online_at_end\":" + util::to_string(online)
+		+ ",\"disconnected\":" + util::to_string(stats.disconnected) + "},\n";
+
+	json += "\"packets\":{\"sent\":" + loadgen_json_count(double(stats.packets_sent)) + ",\"received\":" + loadgen_json_count(double(stats.packets_received))
+		+ ",\"bytes_sent\":" + loadgen_json_count(double(stats.bytes_sent)) + ",\"bytes_received\":" + loadgen_json_count(double(stats.bytes_received))
+		+ ",\"sent_per_second\":" + loadgen_json_number(double(stats.packets_sent) / elapsed)
+		+ ",\"received_per_second\":" + loadgen_json_number(double(stats.packets_received) / elapsed) + "},\n";
+
+	std::string section;
+
+	UTIL_FOREACH_CREF(stats.actions, action)
+		section += (section.empty() ? "\"" : ",\"") + action.first + "\":" + loadgen_json_count(double(action.second));
+
+	json += "\"actions\":{" + section + "},\n";
+	section.clear();
+
+	UTIL_FOREACH_CREF(stats.errors, error)
+		section += (section.empty() ? "\"" : ",\"") + error.first + "\":" + loadgen_json_count(double(error.second));
+
+	json += "\"errors\":{" + section + "},\n";
+	section.clear();
+
+	std::map<std::string, util::histogram> latency = stats.latency;
+
+	// Requests that never got a reply still belong in the table
+	UTIL_FOREACH_CREF(stats.timeouts, timeout)
+		latency[timeout.first];
+
+	UTIL_FOREACH_CREF(latency, entry)
+	{
+		auto timeouts = stats.timeouts.find(entry.first);
+		section += (section.empty() ? "\n\"" : ",\n\"") + entry.first + "\":"
+			+ loadgen_json_client_latency(entry.second, timeouts == stats.timeouts.end() ? 0 : timeouts->second);
+	}
+
+	json += "\"client_latency\":{" + section + "\n},\n";
+	section.clear();
+
+	json += "\"server\":";
+
+	if (!scraped)
+	{
+		json += "null\n}\n";
+		return json;
+	}
+
+	loadgen_histograms handlers_before = loadgen_find_histograms(server_before, "eoserv_handler_duration_seconds", "handler");
+	loadgen_histograms handlers_after = loadgen_find_histograms(server_after, "eoserv_handler_duration_seconds", "handler");
+
+	UTIL_FOREACH_CREF(handlers_after, entry)
+	{
+		const Loadgen_Server_Histogram &before = handlers_before[entry.first];
+
+		if (entry.second.count - before.count <= 0)
+			continue;
+
+		section += (section.empty() ? "\n\"" : ",\n\"") + entry.first + "\":" + loadgen_json_server_latency(before, entry.second);
+	}
+
+	loadgen_histograms tick_before = loadgen_find_histograms(server_before, "eoserv_tick_duration_seconds", "");
+	loadgen_histograms tick_after = loadgen_find_histograms(server_after, "eoserv_tick_duration_seconds", "");
+
+	json += "{\"handlers\":{" + section + "\n},\n"
+		"\"tick\":" + loadgen_json_server_latency(tick_before[""], tick_after[""]) + ",\n"
+		"\"packets_received\":" + loadgen_json_count(loadgen_sum_series(server_after, "eoserv_packets_received_total") - loadgen_sum_series(server_before, "eoserv_packets_received_total"))
+		+ ",\"packets_sent\":" + loadgen_json_count(loadgen_sum_series(server_after, "eoserv_packets_sent_total") - loadgen_sum_series(server_before, "eoserv_packets_sent_total"))
+		+ ",\"long_ticks\":" + loadgen_json_count(loadgen_sum_series(server_after, "eoserv_long_ticks_total") - loadgen_sum_series(server_before, "eoserv_long_ticks_total"))
+		+ "}\n}\n";
+
+	return json;
+}
+
+int main(int argc, char *argv[])
+{
+	Loadgen_Options options;
+	options.config.host = IPAddress(127, 0, 0, 1);
+
+	if (argc >= 2 && (std::string(argv[1]) == "help" || std::string(argv[1]) == "--help" || std::string(argv[1]) == "-h"))
+	{
+		loadgen_usage();
+		return 0;
+	}
+
+	if (!loadgen_parse(argc, argv, options))
+	{
+		loadgen_usage();
+		return 1;
+	}
+
+	std::signal(SIGINT, loadgen_terminate);
+	std::signal(SIGTERM, loadgen_terminate);
+
+	std::map<std::string, double> server_before;
+	std::map<std::string, double> server_after;
+	bool scraped = false;
+
+	if (options.metrics_port != 0)
+	{
+		scraped = loadgen_scrape(options, server_before);
+
+		if (!scraped)
+			Console::Wrn("Could not read metrics from %s:%i, server-side latency will not be reported", options.metrics_host.c_str(), int(options.metrics_port));
+	}
+
+	Loadgen_Stats stats;
+	int online = 0;
+	loadgen_clock::time_point start = loadgen_clock::now();
+
+	if (!options.capture.empty())
+	{
+		Capture_Reader capture;
+
+		if (!capture.Open(options.capture))
+		{
+			Console::Err("Could not read capture file %s", options.capture.c_str());
+			return 1;
+		}
+
+		Console::Out("Replaying %s against %s:%i at %gx speed", options.capture.c_str(), std::string(options.config.host).c_str(), int(options.config.port), options.speed);
+		online = loadgen_replay(options, capture, stats, server_after, scraped);
+	}
+	else
+	{
+		online = loadgen_players(options, stats, server_after, scraped);
+	}
+
+	double elapsed = std::chrono::duration<double>(loadgen_clock::now() - start).count();
+	std::string report = loadgen_report(options, stats, online, elapsed, server_before, server_after, scraped);
+
+	if (options.report == "-")
+	{
+		std::fputs(report.c_str(), stdout);
+	}
+	else
+	{
+		std::FILE *fh = std::fopen(options.report.c_str(), "w");
+
+		if (!fh)
+		{
+			Console::Err("Could not write report to %s", options.report.c_str());
+			return 1;
+		}
+
+		std::fputs(report.c_str(), fh);
+		std::fclose(fh);
+		Console::Out("Report written to %s", options.report.c_str());
+	}
+
+	if (!options.capture.empty())
+	{
+		Console::Out("%i connections replayed, %i disconnected by the server, %.0f packets/s sent, %.0f packets/s received",
+			options.players, stats.disconnected, double(stats.packets_sent) / elapsed, double(stats.packets_received) / elapsed);
+	}
+	else
+	{
+		Console::Out("%i/%i players reached the game, %i disconnected, %.0f packets/s sent, %.0f packets/s received",
+			stats.in_world, options.players, stats.disconnected, double(stats.packets_sent) / elapsed, double(stats.packets_received) / elapsed);
+	}
+
+	UTIL_FOREACH_CREF(stats.latency, entry)
+	{
+		Console::Out("  %-18s %6i  p50 %7.2fms  p99 %7.2fms", entry.first.c_str(), int(entry.second.count()),
+			double(entry.second.percentile(50)) / 1000.0, double(entry.second.percentile(99)) / 1000.0);
+	}
+
+	return 0;
+}
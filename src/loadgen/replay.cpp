@@ -0,0 +1,237 @@
+/* loadgen/replay.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "replay.hpp"
+
+#include "../fwd/eoclient.hpp"
+#include "../fwd/world.hpp"
+
+#include "../capture.hpp"
+#include "../packet.hpp"
+
+#include "../socket.hpp"
+#include "../util.hpp"
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+Loadgen_Replay::Loadgen_Replay(const Loadgen_Config &config, Loadgen_Stats &stats)
+	: config(config), stats(stats), initialized(false), closed(false), seq_start(0), seq(0), player_id(0), emulti_e(0), emulti_d(0)
+{ }
+
+void Loadgen_Replay::Fail(const char *error)
+{
+	++this->stats.errors[error];
+	this->Stop();
+}
+
+PacketBuilder Loadgen_Replay::Packet(PacketFamily family, PacketAction action)
+{
+	PacketBuilder builder(family, action);
+
+	int sequence = this->seq_start + this->seq;
+	this->seq = (this->seq + 1) % 10;
+
+	if (sequence >= 253)
+		builder.AddShort(sequence);
+	else
+		builder.AddChar(sequence);
+
+	return builder;
+}
+
+void Loadgen_Replay::Send(const PacketBuilder &builder)
+{
+	std::string data = this->processor.Encode(builder.Get());
+
+	this->client->Send(data);
+
+	++this->stats.packets_sent;
+	this->stats.bytes_sent += data.length();
+}
+
+void Loadgen_Replay::Start(const Capture_Record &init)
+{
+	this->client.reset(new Client);
+	this->client->SetRecvBuffer(64 * 1024);
+	this->client->SetSendBuffer(64 * 1024);
+
+	if (!this->client->Connect(this->config.host, this->config.port))
+	{
+		this->Fail("connect_failed");
+		return;
+	}
+
+	++this->stats.connected;
+
+	PacketBuilder builder(PACKET_F_INIT, PACKET_A_INIT, init.payload.length());
+	builder.AddString(init.payload);
+	this->Send(builder);
+
+	// The server counts the init packet as the first in the sequence
+	this->seq = 1;
+}
+
+void Loadgen_Replay::Deliver(const Capture_Record &record)
+{
+	if (this->closed)
+		return;
+
+	if (!this->initialized)
+	{
+		this->held.push_back(record);
+		return;
+	}
+
+	this->Forward(record);
+}
+
+void Loadgen_Replay::Forward(const Capture_Record &record)
+{
+	// Pings are answered as they arrive, the recorded answers were to pings sent at other times
+	if (record.family == PACKET_CONNECTION && record.action == PACKET_PING)
+		return;
+
+	PacketBuilder builder = this->Packet(record.family, record.action);
+
+	// The client echoes back the encoding and player ID it was given, which differ from the recorded connection's
+	if (record.family == PACKET_CONNECTION && record.action == PACKET_ACCEPT)
+	{
+		builder.AddShort(this->emulti_d);
+		builder.AddShort(this->emulti_e);
+		builder.AddShort(this->player_id);
+	}
+	else
+	{
+		builder.AddString(record.payload);
+	}
+
+	this->Send(builder);
+	++this->stats.actions[PacketProcessor::GetFamilyName(record.family) + "_" + PacketProcessor::GetActionName(record.action)];
+}
+
+void Loadgen_Replay::Handle(PacketReader &reader)
+{
+	PacketFamily family = reader.Family();
+	PacketAction action = reader.Action();
+
+	if (family == PACKET_F_INIT && action == PACKET_A_INIT && !this->initialized)
+	{
+		int reply = reader.GetByte();
+
+		if (reply != INIT_OK)
+		{
+			this->Fail(reply == INIT_OUT_OF_DATE ? "init_out_of_date" : reply == INIT_BANNED ? "init_banned" : "init_rejected");
+			return;
+		}
+
+		int seq1 = reader.GetByte();
+		int seq2 = reader.GetByte();
+		this->emulti_e = reader.GetByte();
+		this->emulti_d = reader.GetByte();
+		this->player_id = reader.GetShort();
+
+		this->seq_start = seq1 * 7 + seq2 - 13;
+
+		// What the server encodes with we decode with, and the other way around
+		this->processor.SetEMulti(this->emulti_d, this->emulti_e);
+		this->initialized = true;
+
+		while (!this->held.empty() && !this->closed)
+		{
+			this->Forward(this->held.front());
+			this->held.pop_front();
+		}
+	}
+	else if (family == PACKET_ACCOUNT && action == PACKET_REPLY)
+	{
+		if (reader.GetShort() == ACCOUNT_CONTINUE)
+			this->seq_start = reader.GetChar();
+	}
+	else if (family == PACKET_CONNECTION && action == PACKET_PLAYER)
+	{
+		int seq1 = reader.GetShort();
+		int seq2 = reader.GetChar();
+
+		// The new sequence starts with our reply
+		this->seq_start = seq1 - seq2;
+
+		PacketBuilder builder = this->Packet(PACKET_CONNECTION, PACKET_PING);
+		builder.AddString("k");
+		this->Send(builder);
+	}
+}
+
+bool Loadgen_Replay::Tick()
+{
+	if (!this->client || this->closed)
+		return false;
+
+	bool handled = false;
+
+	try
+	{
+		this->client->Select(0.0);
+		this->inbuf += this->client->Recv(64 * 1024);
+
+		while (this->inbuf.length() >= 2 && !this->closed)
+		{
+			std::size_t length = PacketProcessor::Number(this->inbuf[0], this->inbuf[1]);
+
+			if (this->inbuf.length() < length + 2)
+				break;
+
+			std::string data = this->inbuf.substr(2, length);
+			this->inbuf.erase(0, length + 2);
+
+			++this->stats.packets_received;
+			this->stats.bytes_received += length + 2;
+
+			if (data.length() < 2)
+				continue;
+
+			PacketReader reader(this->processor.Decode(data));
+
+			try
+			{
+				this->Handle(reader);
+			}
+			catch (std::out_of_range &)
+			{
+				++this->stats.errors["bad_packet"];
+			}
+
+			handled = true;
+		}
+	}
+	catch (Socket_Exception &)
+	{
+		this->Fail("socket_error");
+		return handled;
+	}
+
+	if (!this->closed && !this->client->Connected())
+	{
+		++this->stats.disconnected;
+		++this->stats.errors["disconnected_by_server"];
+		this->closed = true;
+	}
+
+	return handled;
+}
+
+void Loadgen_Replay::Stop()
+{
+	if (this->client && this->client->Connected())
+		this->client->Close(true);
+
+	this->closed = true;
+}
+
+Loadgen_Replay::~Loadgen_Replay()
+{
+	this->Stop();
+}
@@ -0,0 +1,81 @@
+/* loadgen/replay.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef LOADGEN_REPLAY_HPP_INCLUDED
+#define LOADGEN_REPLAY_HPP_INCLUDED
+
+#include "bot.hpp"
+
+#include "../capture.hpp"
+#include "../packet.hpp"
+#include "../socket.hpp"
+
+#include <deque>
+#include <memory>
+#include <string>
+
+/**
+ * One recorded connection, sending what its client sent and answering only what keeps the connection alive
+ */
+class Loadgen_Replay
+{
+protected:
+	const Loadgen_Config &config;
+	Loadgen_Stats &stats;
+
+	std::unique_ptr<Client> client;
+	PacketProcessor processor;
+	std::string inbuf;
+
+	bool initialized;
+	bool closed;
+
+	int seq_start;
+	int seq;
+
+	int player_id;
+	int emulti_e;
+	int emulti_d;
+
+	/**
+	 * Packets recorded before the server's reply to the init packet, sent once it arrives
+	 */
+	std::deque<Capture_Record> held;
+
+	void Fail(const char *error);
+
+	PacketBuilder Packet(PacketFamily family, PacketAction action);
+	void Send(const PacketBuilder &builder);
+
+	void Forward(const Capture_Record &record);
+	void Handle(PacketReader &reader);
+
+public:
+	Loadgen_Replay(const Loadgen_Config &config, Loadgen_Stats &stats);
+
+	/**
+	 * Connects and sends the recorded init packet
+	 */
+	void Start(const Capture_Record &init);
+
+	/**
+	 * Sends a recorded packet, re-sequenced for this connection
+	 */
+	void Deliver(const Capture_Record &record);
+
+	/**
+	 * Receives and handles anything pending
+	 * Returns true if any packets were handled.
+	 */
+	bool Tick();
+
+	void Stop();
+
+	bool Closed() const { return this->closed; }
+
+	~Loadgen_Replay();
+};
+
+#endif // LOADGEN_REPLAY_HPP_INCLUDED
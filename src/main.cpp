@@ -11,6 +11,8 @@
 
 #include "console.hpp"
 #include "socket.hpp"
+#include "trace.hpp"
+#include "util.hpp"
 
 #include <array>
 #include <csignal>
@@ -21,6 +23,7 @@
 #include <limits>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "platform.h"
 #include "version.h"
@@ -32,6 +35,7 @@
 
 volatile std::sig_atomic_t eoserv_sig_abort = false;
 volatile std::sig_atomic_t eoserv_sig_rehash = false;
+volatile std::sig_atomic_t eoserv_sig_trace = false;
 volatile bool eoserv_running = true;
 
 #ifdef SIGHUP
@@ -42,6 +46,14 @@ static void eoserv_rehash(int signal)
 }
 #endif // SIGHUP
 
+#ifdef SIGUSR1
+static void eoserv_trace(int signal)
+{
+	(void)signal;
+	eoserv_sig_trace = true;
+}
+#endif // SIGUSR1
+
 static void eoserv_terminate(int signal)
 {
 	(void)signal;
@@ -212,6 +224,10 @@ int eoserv_main(int argc, char *argv[])
 	std::signal(SIGHUP, eoserv_rehash);
 #endif // SIGHUP
 
+#ifdef SIGUSR1
+	std::signal(SIGUSR1, eoserv_trace);
+#endif // SIGUSR1
+
 	std::signal(SIGABRT, eoserv_terminate);
 	std::signal(SIGTERM, eoserv_terminate);
 	std::signal(SIGINT, eoserv_terminate);
@@ -330,13 +346,26 @@ int eoserv_main(int argc, char *argv[])
 
 			try
 			{
-				Database_Result acc_count = server.world->db.Query("SELECT COUNT(1) AS `count` FROM `accounts`");
-				Database_Result character_count = server.world->db.Query("SELECT COUNT(1) AS `count` FROM `characters`");
-				Database_Result admin_character_count = server.world->db.Query("SELECT COUNT(1) AS `count` FROM `characters` WHERE `admin` > 0");
-				Database_Result guild_count = server.world->db.Query("SELECT COUNT(1) AS `count` FROM `guilds`");
-				Database_Result ban_count = server.world->db.Query("SELECT COUNT(1) AS `count` FROM `bans`");
-				Database_Result ban_active_count = server.world->db.Query("SELECT COUNT(1) AS `count` FROM `bans` WHERE `expires` <= # AND `expires` <> 0", int(std::time(0)));
-				Database_Result ban_perm_count = server.world->db.Query("SELECT COUNT(1) AS `count` FROM `bans` WHERE `expires` = 0");
+				// Counting rows is a full scan on some engines, so the counts are spread over the pool when there is one
+				std::string now = util::to_string(int(std::time(0)));
+
+				std::vector<Database_Result> counts = server.world->db_pool.Fanout({
+					"SELECT COUNT(1) AS `count` FROM `accounts`",
+					"SELECT COUNT(1) AS `count` FROM `characters`",
+					"SELECT COUNT(1) AS `count` FROM `characters` WHERE `admin` > 0",
+					"SELECT COUNT(1) AS `count` FROM `guilds`",
+					"SELECT COUNT(1) AS `count` FROM `bans`",
+					"SELECT COUNT(1) AS `count` FROM `bans` WHERE `expires` <= " + now + " AND `expires` <> 0",
+					"SELECT COUNT(1) AS `count` FROM `bans` WHERE `expires` = 0"
+				}, server.world->db);
+
+				const Database_Result &acc_count = counts[0];
+				const Database_Result &character_count = counts[1];
+				const Database_Result &admin_character_count = counts[2];
+				const Database_Result &guild_count = counts[3];
+				const Database_Result &ban_count = counts[4];
+				const Database_Result &ban_active_count = counts[5];
+				const Database_Result &ban_perm_count = counts[6];
 
 				Console::Out("Database info:");
 				Console::Out("  Accounts:   %i", int(acc_count.front()["count"]));
@@ -372,7 +401,7 @@ int eoserv_main(int argc, char *argv[])
 				try
 				{
 					server.world->CommitDB();
-					server.world->db.ExecuteFile(config["InstallSQL"]);
+					server.world->db.ExecuteFile(server.world->settings.GetString(ConfigKey::InstallSQL));
 					server.world->BeginDB();
 				}
 				catch (Database_Exception &e)
@@ -384,6 +413,29 @@ int eoserv_main(int argc, char *argv[])
 			}
 		}
 
+		try
+		{
+			server.world->LoadBans();
+			Console::Out("%i active bans loaded.", int(server.world->bans.Size()));
+		}
+		catch (Database_Exception &e)
+		{
+			Console::Err("Could not load bans. Your database may need to be upgraded (see the upgrade directory).");
+			Console::Err(e.error());
+			std::exit(1);
+		}
+
+		try
+		{
+			server.world->OpenJournal();
+		}
+		catch (Database_Exception &e)
+		{
+			Console::Err("Could not replay the journal. Fix the database and restart, the journal file has been left untouched.");
+			Console::Err(e.error());
+			std::exit(1);
+		}
+
 		while (eoserv_running)
 		{
 			if (eoserv_sig_abort)
@@ -397,11 +449,13 @@ int eoserv_main(int argc, char *argv[])
 			{
 				Console::Out("Reloading config");
 
-				std::string old_logerr = config["LogErr"];
-				std::string old_logout = config["LogOut"];
+				std::string old_logerr = server.world->settings.GetString(ConfigKey::LogErr);
+				std::string old_logout = server.world->settings.GetString(ConfigKey::LogOut);
 
 				eoserv_sig_rehash = false;
-				server.world->Rehash();
+
+				if (!server.world->Rehash())
+					Console::Wrn("A reload is already in progress");
 
 				// Does not support changing from file logging back to '-'
 				{
@@ -410,7 +464,7 @@ int eoserv_main(int argc, char *argv[])
 					std::time(&rawtime);
 					std::strftime(timestr, 256, "%c", std::localtime(&rawtime));
 
-					std::string logerr = config["LogErr"];
+					std::string logerr = server.world->settings.GetString(ConfigKey::LogErr);
 					if (!logerr.empty() && logerr.compare("-") != 0)
 					{
 						if (logerr != old_logerr)
@@ -432,7 +486,7 @@ int eoserv_main(int argc, char *argv[])
 						}
 					}
 
-					std::string logout = config["LogOut"];
+					std::string logout = server.world->settings.GetString(ConfigKey::LogOut);
 					if (!logout.empty() && logout.compare("-") != 0)
 					{
 						if (logout != old_logout)
@@ -458,6 +512,16 @@ int eoserv_main(int argc, char *argv[])
 				Console::Out("Config reloaded");
 			}
 
+			if (eoserv_sig_trace)
+			{
+				eoserv_sig_trace = false;
+
+				if (Trace::Active())
+					Trace::Stop();
+				else if (!server.StartTrace(server.world->settings.GetFloat(ConfigKey::TraceLength)))
+					Console::Err("Could not start a trace");
+			}
+
 			server.Tick();
 		}
 #ifndef DEBUG_EXCEPTIONS
@@ -21,6 +21,7 @@
 #include "world.hpp"
 
 #include "console.hpp"
+#include "trace.hpp"
 #include "util.hpp"
 #include "util/rpn.hpp"
 
@@ -154,7 +155,7 @@ void map_evacuate(void *map_evacuate_void)
 {
 	map_evacuate_struct *evac(static_cast<map_evacuate_struct *>(map_evacuate_void));
 
-	int ticks_per_step = int(evac->map->world->config["EvacuateStep"]) / int(evac->map->world->config["EvacuateTick"]);
+	int ticks_per_step = evac->map->world->settings.GetInt(ConfigKey::EvacuateStep) / evac->map->world->settings.GetInt(ConfigKey::EvacuateTick);
 
 	if (evac->step > 0)
 	{
@@ -163,9 +164,9 @@ void map_evacuate(void *map_evacuate_void)
 		UTIL_FOREACH(evac->map->characters, character)
 		{
 			if (step)
-				character->ServerMsg(character->world->i18n.Format("map_evacuate", (evac->step / ticks_per_step) * int(evac->map->world->config["EvacuateStep"])));
+				character->ServerMsg(character->world->i18n.Format("map_evacuate", (evac->step / ticks_per_step) * evac->map->world->settings.GetInt(ConfigKey::EvacuateStep)));
 
-			character->PlaySound(int(evac->map->world->config["EvacuateSound"]));
+			character->PlaySound(evac->map->world->settings.GetInt(ConfigKey::EvacuateSound));
 		}
 
 		--evac->step;
@@ -377,7 +378,7 @@ Map::Map(int id, World *world)
 
 	if (!this->chests.empty())
 	{
-		TimeEvent *event = new TimeEvent(map_spawn_chests, this, 60.0, Timer::FOREVER);
+		TimeEvent *event = new TimeEvent(map_spawn_chests, this, 60.0, Timer::FOREVER, "map_spawn_chests");
 		this->world->timer.Register(event);
 	}
 	for (NPC *npc : this->npcs)
@@ -484,7 +485,7 @@ bool Map::Load()
 		return false;
 	}
 
-	std::string filename = this->world->config["MapDir"];
+	std::string filename = this->world->settings.GetString(ConfigKey::MapDir);
 	std::sprintf(namebuf, "%05i", this->id);
 	filename.append(namebuf);
 	filename.append(".emf");
@@ -569,8 +570,8 @@ bool Map::Load()
 			if (spec == Map_Tile::Chest)
 			{
 				Map_Chest chest;
-				chest.maxchest = static_cast<int>(this->world->config["MaxChest"]);
-				chest.chestslots = static_cast<int>(this->world->config["ChestSlots"]);
+				chest.maxchest = this->world->settings.GetInt(ConfigKey::MaxChest);
+				chest.chestslots = this->world->settings.GetInt(ConfigKey::ChestSlots);
 				chest.x = xloc;
 				chest.y = yloc;
 				chest.slots = 0;
@@ -869,7 +870,7 @@ void Map::Leave(Character *character, WarpAnimation animation, bool silent)
 
 void Map::Msg(Character *from, std::string message, bool echo)
 {
-	message = util::text_cap(message, static_cast<int>(this->world->config["ChatMaxWidth"]) - util::text_width(util::ucfirst(from->SourceName()) + "  "));
+	message = util::text_cap(message, this->world->settings.GetInt(ConfigKey::ChatMaxWidth) - util::text_width(util::ucfirst(from->SourceName()) + "  "));
 
 	PacketBuilder builder(PACKET_TALK, PACKET_PLAYER, 2 + message.length());
 	builder.AddShort(from->PlayerID());
@@ -891,7 +892,7 @@ void Map::Msg(Character *from, std::string message, bool echo)
 
 void Map::Msg(NPC *from, std::string message)
 {
-	message = util::text_cap(message, static_cast<int>(this->world->config["ChatMaxWidth"]) - util::text_width(util::ucfirst(from->ENF().name) + "  "));
+	message = util::text_cap(message, this->world->settings.GetInt(ConfigKey::ChatMaxWidth) - util::text_width(util::ucfirst(from->ENF().name) + "  "));
 
 	PacketBuilder builder(PACKET_NPC, PACKET_PLAYER, 4 + message.length());
 	builder.AddByte(255);
@@ -908,7 +909,9 @@ void Map::Msg(NPC *from, std::string message)
 
 Map::WalkResult Map::Walk(Character *from, Direction direction, bool admin)
 {
-	int seedistance = this->world->config["SeeDistance"];
+	TRACE_SCOPE("Map::Walk");
+
+	int seedistance = this->world->settings.GetInt(ConfigKey::SeeDistance);
 
 	unsigned char target_x = from->x;
 	unsigned char target_y = from->y;
@@ -964,7 +967,7 @@ Map::WalkResult Map::Walk(Character *from, Direction direction, bool admin)
 		if (!this->Walkable(target_x, target_y))
 			return WalkFail;
 
-		if (this->Occupied(target_x, target_y, PlayerOnly) && (from->last_walk + double(this->world->config["GhostTimer"]) > Timer::GetTime()))
+		if (this->Occupied(target_x, target_y, PlayerOnly) && (from->last_walk + this->world->settings.GetFloat(ConfigKey::GhostTimer) > Timer::GetTime()))
 			return WalkFail;
 	}
 
@@ -1248,11 +1251,11 @@ Map::WalkResult Map::Walk(Character *from, Direction direction, bool admin)
 		npc->RemoveFromView(from);
 	}
 
-	from->CheckQuestRules();
+	from->CheckQuestRules(QUEST_TRIGGER_MOVE, this->id);
 
 	Map_Tile::TileSpec spec = this->GetSpec(from->x, from->y);
 
-	double spike_damage = this->world->config["SpikeDamage"];
+	double spike_damage = this->world->settings.GetFloat(ConfigKey::SpikeDamage);
 
 	if (spike_damage > 0.0 && (spec == Map_Tile::Spikes2 || spec == Map_Tile::Spikes3) && !from->IsHideInvisible())
 	{
@@ -1272,7 +1275,9 @@ Map::WalkResult Map::Walk(Character *from, Direction direction, bool admin)
 
 Map::WalkResult Map::Walk(NPC *from, Direction direction)
 {
-	int seedistance = this->world->config["SeeDistance"];
+	TRACE_SCOPE("Map::Walk (NPC)");
+
+	int seedistance = this->world->settings.GetInt(ConfigKey::SeeDistance);
 
 	unsigned char target_x = from->x;
 	unsigned char target_y = from->y;
@@ -1484,7 +1489,7 @@ void Map::Attack(Character *from, Direction direction)
 	int wep_graphic = wepdata.dollgraphic;
 	bool is_instrument = (wep_graphic != 0 && this->world->IsInstrument(wep_graphic));
 
-	if (!is_instrument && (this->pk || (this->world->config["GlobalPK"] && !this->world->PKExcept(this->id))))
+	if (!is_instrument && (this->pk || (this->world->settings.GetBool(ConfigKey::GlobalPK) && !this->world->PKExcept(this->id))))
 	{
 		if (this->AttackPK(from, direction))
 		{
@@ -1524,7 +1529,7 @@ void Map::Attack(Character *from, Direction direction)
 
 	int range = 1;
 
-	if (static_cast<std::string>(from->world->config["EnableAoE"]) == "yes")
+	if (from->world->settings.GetBool(ConfigKey::EnableAoE))
 	{
 		int weapon_id = from->paperdoll[Character::Weapon];
 		std::string weapon_key = util::to_string(weapon_id);
@@ -1553,7 +1558,7 @@ void Map::Attack(Character *from, Direction direction)
 			}
 
 			// Find characters within AoE range (if PK is enabled)
-			if (this->pk || (static_cast<bool>(this->world->config["GlobalPK"]) && !this->world->PKExcept(this->id)))
+			if (this->pk || (this->world->settings.GetBool(ConfigKey::GlobalPK) && !this->world->PKExcept(this->id)))
 			{
 				UTIL_FOREACH(this->characters, character)
 				{
@@ -1613,7 +1618,7 @@ void Map::Attack(Character *from, Direction direction)
 
 	if (wepdata.subtype == EIF::Ranged)
 	{
-		range = static_cast<int>(this->world->config["RangedDistance"]);
+		range = this->world->settings.GetInt(ConfigKey::RangedDistance);
 	}
 
 	for (int i = 0; i < range; ++i)
@@ -1644,18 +1649,18 @@ void Map::Attack(Character *from, Direction direction)
 				int amount = util::rand(from->mindam, from->maxdam);
 				double rand = util::rand(0.0, 1.0);
 				// Checks if target is facing you
-				bool critical = std::abs(int(npc->direction) - from->direction) != 2 || rand < static_cast<double>(this->world->config["CriticalRate"]);
+				bool critical = std::abs(int(npc->direction) - from->direction) != 2 || rand < this->world->settings.GetFloat(ConfigKey::CriticalRate);
 
-				if (this->world->config["CriticalFirstHit"] && npc->hp == npc->ENF().hp)
+				if (this->world->settings.GetBool(ConfigKey::CriticalFirstHit) && npc->hp == npc->ENF().hp)
 					critical = true;
 
-				std::unordered_map<std::string, double> formula_vars;
+				Formula_Frame formula_vars;
 
 				from->FormulaVars(formula_vars);
-				npc->FormulaVars(formula_vars, "target_");
-				formula_vars["modifier"] = this->world->config["MobRate"];
-				formula_vars["damage"] = amount;
-				formula_vars["critical"] = critical;
+				npc->FormulaVars(formula_vars, Formula_Frame::Target);
+				formula_vars.Set(FE_modifier, this->world->settings.GetFloat(ConfigKey::MobRate));
+				formula_vars.Set(FE_damage, amount);
+				formula_vars.Set(FE_critical, critical);
 
 				amount = this->world->EvalFormula("damage", formula_vars);
 				double hit_rate = this->world->EvalFormula("hit_rate", formula_vars);
@@ -1669,7 +1674,7 @@ void Map::Attack(Character *from, Direction direction)
 
 				int limitamount = std::min(amount, int(npc->hp));
 
-				if (this->world->config["LimitDamage"])
+				if (this->world->settings.GetBool(ConfigKey::LimitDamage))
 				{
 					amount = limitamount;
 				}
@@ -1718,7 +1723,7 @@ void Map::PetAttack(NPC *pet, Direction direction)
 		if (target_npc)
 		{
 			// Cast PetDamageMultiplier to double before multiplication
-			double damage_multiplier = static_cast<double>(this->world->config["PetDamageMultiplier"]);
+			double damage_multiplier = this->world->settings.GetFloat(ConfigKey::PetDamageMultiplier);
 			int min_damage = static_cast<int>(pet->PetOwner->mindam * damage_multiplier);
 			int max_damage = static_cast<int>(pet->PetOwner->maxdam * damage_multiplier);
 			int damage = util::rand(min_damage, max_damage);
@@ -1742,7 +1747,7 @@ bool Map::AttackPK(Character *from, Direction direction)
 
 	if (this->world->eif->Get(from->paperdoll[Character::Weapon]).subtype == EIF::Ranged)
 	{
-		range = static_cast<int>(this->world->config["RangedDistance"]);
+		range = this->world->settings.GetInt(ConfigKey::RangedDistance);
 	}
 
 	for (int i = 0; i < range; ++i)
@@ -1773,15 +1778,15 @@ bool Map::AttackPK(Character *from, Direction direction)
 				int amount = util::rand(from->mindam, from->maxdam);
 				double rand = util::rand(0.0, 1.0);
 				// Checks if target is facing you
-				bool critical = std::abs(int(character->direction) - from->direction) != 2 || rand < static_cast<double>(this->world->config["CriticalRate"]);
+				bool critical = std::abs(int(character->direction) - from->direction) != 2 || rand < this->world->settings.GetFloat(ConfigKey::CriticalRate);
 
-				std::unordered_map<std::string, double> formula_vars;
+				Formula_Frame formula_vars;
 
 				from->FormulaVars(formula_vars);
-				character->FormulaVars(formula_vars, "target_");
-				formula_vars["modifier"] = this->world->config["PKRate"];
-				formula_vars["damage"] = amount;
-				formula_vars["critical"] = critical;
+				character->FormulaVars(formula_vars, Formula_Frame::Target);
+				formula_vars.Set(FE_modifier, this->world->settings.GetFloat(ConfigKey::PKRate));
+				formula_vars.Set(FE_damage, amount);
+				formula_vars.Set(FE_critical, critical);
 
 				amount = this->world->EvalFormula("damage", formula_vars);
 				double hit_rate = this->world->EvalFormula("hit_rate", formula_vars);
@@ -1795,7 +1800,7 @@ bool Map::AttackPK(Character *from, Direction direction)
 
 				int limitamount = std::min(amount, int(character->hp));
 
-				if (this->world->config["LimitDamage"])
+				if (this->world->settings.GetBool(ConfigKey::LimitDamage))
 				{
 					amount = limitamount;
 				}
@@ -2025,7 +2030,7 @@ bool Map::OpenDoor(Character *from, unsigned char x, unsigned char y)
 		close->x = x;
 		close->y = y;
 
-		TimeEvent *event = new TimeEvent(map_close_door, close, this->world->config["DoorTimer"], 1);
+		TimeEvent *event = new TimeEvent(map_close_door, close, this->world->settings.GetFloat(ConfigKey::DoorTimer), 1, "map_close_door");
 		this->world->timer.Register(event);
 
 		return true;
@@ -2061,7 +2066,7 @@ void Map::SpellSelf(Character *from, unsigned short spell_id)
 
 	int hpgain = spell.hp;
 
-	if (this->world->config["LimitDamage"])
+	if (this->world->settings.GetBool(ConfigKey::LimitDamage))
 		hpgain = std::min(hpgain, from->maxhp - from->hp);
 
 	hpgain = std::max(hpgain, 0);
@@ -2106,15 +2111,15 @@ void Map::SpellAttack(Character *from, NPC *npc, unsigned short spell_id)
 		int amount = util::rand(from->mindam + spell.mindam, from->maxdam + spell.maxdam);
 		double rand = util::rand(0.0, 1.0);
 
-		bool critical = rand < static_cast<double>(this->world->config["CriticalRate"]);
+		bool critical = rand < this->world->settings.GetFloat(ConfigKey::CriticalRate);
 
-		std::unordered_map<std::string, double> formula_vars;
+		Formula_Frame formula_vars;
 
 		from->FormulaVars(formula_vars);
-		npc->FormulaVars(formula_vars, "target_");
-		formula_vars["modifier"] = this->world->config["MobRate"];
-		formula_vars["damage"] = amount;
-		formula_vars["critical"] = critical;
+		npc->FormulaVars(formula_vars, Formula_Frame::Target);
+		formula_vars.Set(FE_modifier, this->world->settings.GetFloat(ConfigKey::MobRate));
+		formula_vars.Set(FE_damage, amount);
+		formula_vars.Set(FE_critical, critical);
 
 		amount = this->world->EvalFormula("damage", formula_vars);
 		double hit_rate = this->world->EvalFormula("hit_rate", formula_vars);
@@ -2128,7 +2133,7 @@ void Map::SpellAttack(Character *from, NPC *npc, unsigned short spell_id)
 
 		int limitamount = std::min(amount, int(npc->hp));
 
-		if (this->world->config["LimitDamage"])
+		if (this->world->settings.GetBool(ConfigKey::LimitDamage))
 		{
 			amount = limitamount;
 		}
@@ -2145,7 +2150,7 @@ void Map::SpellAttackPK(Character *from, Character *victim, unsigned short spell
 	if (!spell || (spell.type != ESF::Heal && spell.type != ESF::Damage) || from->tp < spell.tp)
 		return;
 
-	if (spell.type == ESF::Damage && (from->map->pk || (this->world->config["GlobalPK"] && !this->world->PKExcept(this->id))))
+	if (spell.type == ESF::Damage && (from->map->pk || (this->world->settings.GetBool(ConfigKey::GlobalPK) && !this->world->PKExcept(this->id))))
 	{
 		if (!from->CanInteractPKCombat())
 			return;
@@ -2155,15 +2160,15 @@ void Map::SpellAttackPK(Character *from, Character *victim, unsigned short spell
 		int amount = util::rand(from->mindam + spell.mindam, from->maxdam + spell.maxdam);
 		double rand = util::rand(0.0, 1.0);
 
-		bool critical = rand < static_cast<double>(this->world->config["CriticalRate"]);
+		bool critical = rand < this->world->settings.GetFloat(ConfigKey::CriticalRate);
 
-		std::unordered_map<std::string, double> formula_vars;
+		Formula_Frame formula_vars;
 
 		from->FormulaVars(formula_vars);
-		victim->FormulaVars(formula_vars, "target_");
-		formula_vars["modifier"] = this->world->config["PKRate"];
-		formula_vars["damage"] = amount;
-		formula_vars["critical"] = critical;
+		victim->FormulaVars(formula_vars, Formula_Frame::Target);
+		formula_vars.Set(FE_modifier, this->world->settings.GetFloat(ConfigKey::PKRate));
+		formula_vars.Set(FE_damage, amount);
+		formula_vars.Set(FE_critical, critical);
 
 		amount = this->world->EvalFormula("damage", formula_vars);
 		double hit_rate = this->world->EvalFormula("hit_rate", formula_vars);
@@ -2177,7 +2182,7 @@ void Map::SpellAttackPK(Character *from, Character *victim, unsigned short spell
 
 		int limitamount = std::min(amount, int(victim->hp));
 
-		if (this->world->config["LimitDamage"])
+		if (this->world->settings.GetBool(ConfigKey::LimitDamage))
 		{
 			amount = limitamount;
 		}
@@ -2231,19 +2236,19 @@ void Map::SpellAttackPK(Character *from, Character *victim, unsigned short spell
 		int displayhp = spell.hp;
 		int hpgain = spell.hp;
 
-		if (this->world->config["LimitDamage"])
+		if (this->world->settings.GetBool(ConfigKey::LimitDamage))
 			hpgain = std::min(hpgain, victim->maxhp - victim->hp);
 
 		hpgain = std::max(hpgain, 0);
 
-		if (!from->CanInteractCombat() && from != victim && !(from->CanInteractPKCombat() && (from->map->pk || (this->world->config["GlobalPK"] && !this->world->PKExcept(this->id)))))
+		if (!from->CanInteractCombat() && from != victim && !(from->CanInteractPKCombat() && (from->map->pk || (this->world->settings.GetBool(ConfigKey::GlobalPK) && !this->world->PKExcept(this->id)))))
 		{
 			displayhp = hpgain = std::min(hpgain, 1);
 		}
 
 		victim->hp += hpgain;
 
-		if (!this->world->config["LimitDamage"])
+		if (!this->world->settings.GetBool(ConfigKey::LimitDamage))
 			victim->hp = std::min(victim->hp, victim->maxhp);
 
 		PacketBuilder builder(PACKET_SPELL, PACKET_TARGET_OTHER, 18);
@@ -2287,7 +2292,7 @@ void Map::SpellGroup(Character *from, unsigned short spell_id)
 
 	int displayhp = spell.hp;
 
-	if (!from->CanInteractCombat() && !(from->CanInteractPKCombat() && (from->map->pk || (this->world->config["GlobalPK"] && !this->world->PKExcept(this->id)))))
+	if (!from->CanInteractCombat() && !(from->CanInteractPKCombat() && (from->map->pk || (this->world->settings.GetBool(ConfigKey::GlobalPK) && !this->world->PKExcept(this->id)))))
 	{
 		displayhp = std::min(displayhp, 1);
 	}
@@ -2308,18 +2313,18 @@ void Map::SpellGroup(Character *from, unsigned short spell_id)
 		int displayhp = spell.hp;
 		int hpgain = spell.hp;
 
-		if (this->world->config["LimitDamage"])
+		if (this->world->settings.GetBool(ConfigKey::LimitDamage))
 			hpgain = std::min(hpgain, member->maxhp - member->hp);
 
 		hpgain = std::max(hpgain, 0);
 
-		if (!from->CanInteractCombat() && !(from->CanInteractPKCombat() && (from->map->pk || (from->world->config["GlobalPK"] && !from->world->PKExcept(from->map->id)))))
+		if (!from->CanInteractCombat() && !(from->CanInteractPKCombat() && (from->map->pk || (from->world->settings.GetBool(ConfigKey::GlobalPK) && !from->world->PKExcept(from->map->id)))))
 
 			hpgain = std::min(hpgain, 1);
 
 		member->hp += hpgain;
 
-		if (!this->world->config["LimitDamage"])
+		if (!this->world->settings.GetBool(ConfigKey::LimitDamage))
 			member->hp = std::min(member->hp, member->maxhp);
 
 		// wat?
@@ -2364,7 +2369,7 @@ std::shared_ptr<Map_Item> Map::AddItem(short id, int amount, unsigned char x, un
 			}
 		}
 
-		if (ontile >= static_cast<int>(this->world->config["MaxTile"]) || onmap >= static_cast<int>(this->world->config["MaxMap"]))
+		if (ontile >= this->world->settings.GetInt(ConfigKey::MaxTile) || onmap >= this->world->settings.GetInt(ConfigKey::MaxMap))
 		{
 			return newitem;
 		}
@@ -2519,7 +2524,7 @@ bool Map::Walkable(unsigned char x, unsigned char y, bool npc) const
 	if (!InBounds(x, y) || !this->GetTile(x, y).Walkable(npc))
 		return false;
 
-	if (this->world->config["GhostArena"] && this->GetTile(x, y).tilespec == Map_Tile::Arena && this->Occupied(x, y, PlayerAndNPC))
+	if (this->world->settings.GetBool(ConfigKey::GhostArena) && this->GetTile(x, y).tilespec == Map_Tile::Arena && this->Occupied(x, y, PlayerAndNPC))
 		return false;
 
 	return true;
@@ -2605,9 +2610,9 @@ bool Map::Evacuate()
 
 		map_evacuate_struct *evac = new map_evacuate_struct;
 		evac->map = this;
-		evac->step = int(evac->map->world->config["EvacuateLength"]) / int(evac->map->world->config["EvacuateTick"]);
+		evac->step = evac->map->world->settings.GetInt(ConfigKey::EvacuateLength) / evac->map->world->settings.GetInt(ConfigKey::EvacuateTick);
 
-		TimeEvent *event = new TimeEvent(map_evacuate, evac, this->world->config["EvacuateTick"], evac->step);
+		TimeEvent *event = new TimeEvent(map_evacuate, evac, this->world->settings.GetFloat(ConfigKey::EvacuateTick), evac->step, "map_evacuate");
 		this->world->timer.Register(event);
 
 		map_evacuate(evac);
@@ -2624,7 +2629,7 @@ bool Map::Reload()
 	char namebuf[10];
 	char checkrid[4];
 
-	std::string filename = this->world->config["MapDir"];
+	std::string filename = this->world->settings.GetString(ConfigKey::MapDir);
 	std::sprintf(namebuf, "%05i", this->id);
 	filename.append(namebuf);
 	filename.append(".emf");
@@ -2715,7 +2720,7 @@ void Map::TimedSpikes()
 	PacketBuilder builder(PACKET_EFFECT, PACKET_REPORT, 1);
 	builder.AddByte(83); // S
 
-	double spike_damage = this->world->config["SpikeDamage"];
+	double spike_damage = this->world->settings.GetFloat(ConfigKey::SpikeDamage);
 
 	std::vector<Character *> killed;
 
@@ -2751,7 +2756,7 @@ void Map::TimedDrains()
 {
 	if (this->effect == EffectHPDrain)
 	{
-		double hpdrain_damage = this->world->config["DrainHPDamage"];
+		double hpdrain_damage = this->world->settings.GetFloat(ConfigKey::DrainHPDamage);
 
 		std::vector<int> damage_map;
 		damage_map.resize(this->characters.size());
@@ -2810,7 +2815,7 @@ void Map::TimedDrains()
 
 	if (this->effect == EffectTPDrain)
 	{
-		double tpdrain_damage = this->world->config["DrainTPDamage"];
+		double tpdrain_damage = this->world->settings.GetFloat(ConfigKey::DrainTPDamage);
 
 		for (Character *character : this->characters)
 		{
@@ -0,0 +1,284 @@
+/* metrics.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "metrics.hpp"
+
+#include "console.hpp"
+#include "socket.hpp"
+#include "trace.hpp"
+#include "util.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+static std::string metrics_number(double n)
+{
+	char buf[32];
+	std::snprintf(buf, sizeof buf, "%.15g", n);
+	return buf;
+}
+
+static std::string metrics_labels(const std::string &labels, const std::string &extra = std::string())
+{
+	if (labels.empty() && extra.empty())
+		return std::string();
+
+	if (labels.empty() || extra.empty())
+		return "{" + labels + extra + "}";
+
+	return "{" + labels + "," + extra + "}";
+}
+
+static const char *metrics_type_name(Metrics::Type type)
+{
+	switch (type)
+	{
+	case Metrics::Counter:
+		return "counter";
+
+	case Metrics::Gauge:
+		return "gauge";
+
+	case Metrics::Histogram:
+		return "histogram";
+	}
+
+	return "untyped";
+}
+
+Metrics::Metrics()
+	: snapshot(std::make_shared<Snapshot>())
+{
+}
+
+Metrics::Metric &Metrics::Get(Type type, const std::string &name, const std::string &help, const std::string &labels)
+{
+	UTIL_FOREACH_REF(this->metrics, metric)
+	{
+		if (metric.name == name && metric.labels == labels)
+			return metric;
+	}
+
+	this->metrics.emplace_back();
+
+	Metric &metric = this->metrics.back();
+	metric.name = name;
+	metric.help = help;
+	metric.type = type;
+	metric.labels = labels;
+
+	if (type == Histogram)
+		metric.histogram = std::make_shared<util::histogram>();
+
+	return metric;
+}
+
+void Metrics::Publish()
+{
+	std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>(this->metrics.begin(), this->metrics.end());
+
+	// The live histograms keep changing, so the snapshot needs its own copies
+	UTIL_FOREACH_REF(*snapshot, metric)
+	{
+		if (metric.histogram)
+			metric.histogram = std::make_shared<util::histogram>(*metric.histogram);
+	}
+
+	std::lock_guard<std::mutex> lock(this->snapshot_mutex);
+	this->snapshot = std::move(snapshot);
+}
+
+std::shared_ptr<const Metrics::Snapshot> Metrics::Latest() const
+{
+	std::lock_guard<std::mutex> lock(this->snapshot_mutex);
+	return this->snapshot;
+}
+
+std::string Metrics::Render(const Snapshot &snapshot)
+{
+	std::string out;
+	std::vector<bool> written(snapshot.size(), false);
+
+	// Every series of a metric has to follow its HELP and TYPE lines, so labelled series are grouped by name
+	for (std::size_t i = 0; i < snapshot.size(); ++i)
+	{
+		if (written[i])
+			continue;
+
+		const Metric &first = snapshot[i];
+
+		out += "# HELP " + first.name + " " + first.help + "\n";
+		out += "# TYPE " + first.name + " " + metrics_type_name(first.type) + "\n";
+
+		for (std::size_t j = i; j < snapshot.size(); ++j)
+		{
+			const Metric &metric = snapshot[j];
+
+			if (written[j] || metric.name != first.name)
+				continue;
+
+			written[j] = true;
+
+			if (metric.type != Histogram)
+			{
+				out += metric.name + metrics_labels(metric.labels) + " " + metrics_number(metric.value) + "\n";
+				continue;
+			}
+
+			const util::histogram &h = *metric.histogram;
+			std::uint64_t cumulative = 0;
+
+			// Empty buckets are left out, the cumulative counts of the remaining ones are unaffected
+			for (std::size_t b = 0; b < util::histogram::num_buckets && cumulative < h.count(); ++b)
+			{
+				if (h.bucket(b) == 0)
+					continue;
+
+				cumulative += h.bucket(b);
+				std::string le = "le=\"" + metrics_number(double(util::histogram::bucket_upper(b)) / 1000000.0) + "\"";
+				out += metric.name + "_bucket" + metrics_labels(metric.labels, le) + " " + metrics_number(double(cumulative)) + "\n";
+			}
+
+			out += metric.name + "_bucket" + metrics_labels(metric.labels, "le=\"+Inf\"") + " " + metrics_number(double(h.count())) + "\n";
+			out += metric.name + "_sum" + metrics_labels(metric.labels) + " " + metrics_number(double(h.sum()) / 1000000.0) + "\n";
+			out += metric.name + "_count" + metrics_labels(metric.labels) + " " + metrics_number(double(h.count())) + "\n";
+		}
+	}
+
+	return out;
+}
+
+/**
+ * A connection to the metrics listener, holding the request until its headers are complete
+ */
+class Metrics_Client : public Client
+{
+public:
+	std::string request;
+	bool responded = false;
+
+	Metrics_Client(const SocketImpl &sock, Server *server) : Client(sock, server) {}
+};
+
+Metrics_Server::Metrics_Server(const IPAddress &addr, unsigned short port, const Metrics &metrics)
+	: Server(addr, port), metrics(metrics), stop(false)
+{
+	this->send_buffer_max = 1024 * 1024;
+	this->recv_buffer_max = 4 * 1024;
+}
+
+Client *Metrics_Server::ClientFactory(const SocketImpl &sock)
+{
+	return new Metrics_Client(sock, this);
+}
+
+void Metrics_Server::Start()
+{
+	this->Listen(8, 8);
+	this->thread = std::thread(&Metrics_Server::Run, this);
+}
+
+void Metrics_Server::Respond(Client *client, const std::string &request)
+{
+	std::string status = "200 OK";
+	std::string body;
+
+	std::size_t line_end = request.find("\r\n");
+	std::vector<std::string> line = util::explode(' ', request.substr(0, line_end));
+
+	if (line.size() < 2 || line[0] != "GET")
+	{
+		status = "405 Method Not Allowed";
+	}
+	else if (line[1] != "/" && line[1] != "/metrics")
+	{
+		status = "404 Not Found";
+	}
+	else
+	{
+		body = Metrics::Render(*this->metrics.Latest());
+	}
+
+	std::string response = "HTTP/1.0 " + status + "\r\n"
+		"Content-Type: text/plain; version=0.0.4\r\n"
+		"Content-Length: " + util::to_string(int(body.length())) + "\r\n"
+		"Connection: close\r\n"
+		"\r\n" + body;
+
+	client->Send(response);
+	client->FinishWriting();
+}
+
+void Metrics_Server::Run()
+{
+	Trace::SetThreadName("metrics");
+
+	while (!this->stop)
+	{
+		try
+		{
+			while (this->Poll())
+				;
+
+			std::vector<Client *> *active_clients = this->Select(0.1);
+
+			UTIL_FOREACH(*active_clients, rawclient)
+			{
+				Metrics_Client *client = static_cast<Metrics_Client *>(rawclient);
+				std::string data = client->Recv(4096);
+
+				if (client->responded)
+					continue;
+
+				client->request += data;
+
+				if (client->request.find("\r\n\r\n") != std::string::npos || client->request.length() >= 4096)
+				{
+					client->responded = true;
+					this->Respond(client, client->request);
+				}
+			}
+
+			active_clients->clear();
+
+			std::time_t now = std::time(0);
+
+			// Scrapers close their end once they have the response, this catches any that don't
+			UTIL_FOREACH(this->clients, client)
+			{
+				if (client->Connected() && client->ConnectTime() + 10 < now)
+					client->Close(true);
+			}
+
+			this->BuryTheDead();
+		}
+		catch (Socket_SelectFailed &e)
+		{
+			if (errno != EINTR)
+				Console::Err("Metrics listener: %s", e.error());
+		}
+		catch (Socket_Exception &e)
+		{
+			Console::Err("Metrics listener: %s: %s", e.what(), e.error());
+		}
+	}
+}
+
+Metrics_Server::~Metrics_Server()
+{
+	this->stop = true;
+
+	if (this->thread.joinable())
+		this->thread.join();
+}
@@ -0,0 +1,126 @@
+/* metrics.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef METRICS_HPP_INCLUDED
+#define METRICS_HPP_INCLUDED
+
+#include "fwd/metrics.hpp"
+
+#include "socket.hpp"
+
+#include "util/histogram.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Named counters, gauges and histograms describing a running server
+ * Metrics are only updated from the game thread. Publish() copies them in to an immutable snapshot
+ *   which other threads can read without touching the world.
+ */
+class Metrics
+{
+public:
+	enum Type
+	{
+		Counter,
+		Gauge,
+		Histogram
+	};
+
+	struct Metric
+	{
+		std::string name;
+		std::string help;
+		Type type;
+
+		/**
+		 * Pre-formatted label set, eg. family="Walk"
+		 */
+		std::string labels;
+
+		double value = 0.0;
+
+		/**
+		 * Samples in microseconds, exported in seconds
+		 */
+		std::shared_ptr<util::histogram> histogram;
+
+		void Add(double n = 1.0) { this->value += n; }
+		void Set(double n) { this->value = n; }
+		void Record(std::uint64_t us) { this->histogram->record(us); }
+	};
+
+	typedef std::vector<Metric> Snapshot;
+
+protected:
+	std::deque<Metric> metrics;
+
+	mutable std::mutex snapshot_mutex;
+	std::shared_ptr<const Snapshot> snapshot;
+
+public:
+	Metrics();
+
+	/**
+	 * Returns the metric with the given name and labels, creating it if it does not exist
+	 * References stay valid for the lifetime of the registry.
+	 */
+	Metric &Get(Type type, const std::string &name, const std::string &help, const std::string &labels = std::string());
+
+	/**
+	 * Copies every metric in to a new snapshot
+	 */
+	void Publish();
+
+	/**
+	 * Returns the most recently published snapshot
+	 */
+	std::shared_ptr<const Snapshot> Latest() const;
+
+	/**
+	 * Formats a snapshot as Prometheus text exposition format
+	 */
+	static std::string Render(const Snapshot &snapshot);
+};
+
+/**
+ * Serves published metrics over HTTP from its own thread
+ */
+class Metrics_Server : public Server
+{
+protected:
+	const Metrics &metrics;
+
+	std::thread thread;
+	std::atomic<bool> stop;
+
+	virtual Client *ClientFactory(const SocketImpl &sock) override;
+
+	void Run();
+	void Respond(Client *client, const std::string &request);
+
+public:
+	/**
+	 * @throw Socket_BindFailed
+	 */
+	Metrics_Server(const IPAddress &addr, unsigned short port, const Metrics &metrics);
+
+	/**
+	 * Starts listening and serving requests in the background
+	 * @throw Socket_ListenFailed
+	 */
+	void Start();
+
+	~Metrics_Server();
+};
+
+#endif // METRICS_HPP_INCLUDED
@@ -17,6 +17,7 @@
 #include "world.hpp"
 
 #include "console.hpp"
+#include "trace.hpp"
 #include "util.hpp"
 #include "util/rpn.hpp"
 
@@ -198,6 +199,8 @@ void NPC::Spawn(NPC *parent)
 
 void NPC::Act()
 {
+	TRACE_SCOPE("NPC::Act");
+
 	// Needed for the server startup spawn to work properly
 	if (this->ENF().child && !this->parent)
 	{
@@ -218,15 +221,6 @@ void NPC::Act()
 		return;
 	}
 
-	// Cache frequently accessed configuration values
-	const auto &config = this->map->world->config;
-	int max_pets = static_cast<int>(config.at("MaxPets"));
-	int respawn_time = static_cast<int>(config.at("PetRespawnTime"));
-	double damage_multiplier = static_cast<double>(config.at("PetDamageMultiplier"));
-	double pet_speed = static_cast<double>(config.at("PetSpeed"));
-	int chase_distance = static_cast<int>(config.at("PetChaseDistance"));
-	int guard_distance = static_cast<int>(config.at("PetGuardDistance"));
-
 	if (this->PetActive && this->PetOwner)
 	{
 		// Check if the owner is on a different map
@@ -287,7 +281,7 @@ void NPC::Act()
 		else if (this->PetGuarding)
 		{
 			NPC *nearby_enemy = this->PetFindNearbyEnemy();
-			if (nearby_enemy && util::path_length(this->x, this->y, nearby_enemy->x, nearby_enemy->y) <= static_cast<int>(this->map->world->config["PetGuardDistance"]))
+			if (nearby_enemy && util::path_length(this->x, this->y, nearby_enemy->x, nearby_enemy->y) <= this->map->world->settings.GetInt(ConfigKey::PetGuardDistance))
 			{
 				this->PetTarget = nearby_enemy;
 				this->PetWalkTo(nearby_enemy->x, nearby_enemy->y);
@@ -323,14 +317,14 @@ void NPC::Act()
 	}
 
 	Character *attacker = 0;
-	unsigned char attacker_distance = static_cast<int>(this->map->world->config["NPCChaseDistance"]);
+	unsigned char attacker_distance = this->map->world->settings.GetInt(ConfigKey::NPCChaseDistance);
 	unsigned short attacker_damage = 0;
 
 	if (this->ENF().type == ENF::Passive || this->ENF().type == ENF::Aggressive)
 	{
 		UTIL_FOREACH_CREF(this->damagelist, opponent)
 		{
-			if (opponent->attacker->map != this->map || opponent->attacker->nowhere || opponent->last_hit < Timer::GetTime() - static_cast<double>(this->map->world->config["NPCBoredTimer"]))
+			if (opponent->attacker->map != this->map || opponent->attacker->nowhere || opponent->last_hit < Timer::GetTime() - this->map->world->settings.GetFloat(ConfigKey::NPCBoredTimer))
 			{
 				continue;
 			}
@@ -352,7 +346,7 @@ void NPC::Act()
 		{
 			UTIL_FOREACH_CREF(this->parent->damagelist, opponent)
 			{
-				if (opponent->attacker->map != this->map || opponent->attacker->nowhere || opponent->last_hit < Timer::GetTime() - static_cast<double>(this->map->world->config["NPCBoredTimer"]))
+				if (opponent->attacker->map != this->map || opponent->attacker->nowhere || opponent->last_hit < Timer::GetTime() - this->map->world->settings.GetFloat(ConfigKey::NPCBoredTimer))
 				{
 					continue;
 				}
@@ -375,7 +369,7 @@ void NPC::Act()
 	if (this->ENF().type == ENF::Aggressive || (this->parent && attacker))
 	{
 		Character *closest = 0;
-		unsigned char closest_distance = static_cast<int>(this->map->world->config["NPCChaseDistance"]);
+		unsigned char closest_distance = this->map->world->settings.GetInt(ConfigKey::NPCChaseDistance);
 
 		if (attacker)
 		{
@@ -508,7 +502,7 @@ void NPC::Damage(Character *from, int amount, int spell_id)
 {
 	int limitamount = std::min(this->hp, amount);
 
-	if (this->map->world->config["LimitDamage"])
+	if (this->map->world->settings.GetBool(ConfigKey::LimitDamage))
 	{
 		amount = limitamount;
 	}
@@ -630,11 +624,11 @@ void NPC::RemoveFromView(Character *target)
 
 void NPC::Killed(Character *from, int amount, int spell_id)
 {
-	double droprate = this->map->world->config["DropRate"];
-	double exprate = this->map->world->config["ExpRate"];
-	int sharemode = this->map->world->config["ShareMode"];
-	int partysharemode = this->map->world->config["PartyShareMode"];
-	int dropratemode = this->map->world->config["DropRateMode"];
+	double droprate = this->map->world->settings.GetFloat(ConfigKey::DropRate);
+	double exprate = this->map->world->settings.GetFloat(ConfigKey::ExpRate);
+	int sharemode = this->map->world->settings.GetInt(ConfigKey::ShareMode);
+	int partysharemode = this->map->world->settings.GetInt(ConfigKey::PartyShareMode);
+	int dropratemode = this->map->world->settings.GetInt(ConfigKey::DropRateMode);
 	std::set<Party *> parties;
 
 	int most_damage_counter = 0;
@@ -707,14 +701,14 @@ void NPC::Killed(Character *from, int amount, int spell_id)
 	if (drop)
 	{
 		dropid = drop->id;
-		dropamount = std::min<int>(util::rand(drop->min, drop->max), this->map->world->config["MaxItem"]);
+		dropamount = std::min<int>(util::rand(drop->min, drop->max), this->map->world->settings.GetInt(ConfigKey::MaxItem));
 
 		if (dropid <= 0 || static_cast<std::size_t>(dropid) >= this->map->world->eif->data.size() || dropamount <= 0)
 			goto abort_drop;
 
 		dropuid = this->map->GenerateItemID();
 
-		std::shared_ptr<Map_Item> newitem(std::make_shared<Map_Item>(dropuid, dropid, dropamount, this->x, this->y, from->PlayerID(), Timer::GetTime() + static_cast<int>(this->map->world->config["ProtectNPCDrop"])));
+		std::shared_ptr<Map_Item> newitem(std::make_shared<Map_Item>(dropuid, dropid, dropamount, this->x, this->y, from->PlayerID(), Timer::GetTime() + this->map->world->settings.GetInt(ConfigKey::ProtectNPCDrop)));
 		this->map->items.push_back(newitem);
 
 		// Selects a random number between 0 and maxhp, and decides the winner based on that
@@ -928,14 +922,14 @@ abort_drop:
 						break;
 					}
 
-					character->exp = std::min(character->exp, static_cast<int>(this->map->world->config["MaxExp"]));
+					character->exp = std::min(character->exp, this->map->world->settings.GetInt(ConfigKey::MaxExp));
 
-					while (character->level < static_cast<int>(this->map->world->config["MaxLevel"]) && character->exp >= this->map->world->exp_table[character->level + 1])
+					while (character->level < this->map->world->settings.GetInt(ConfigKey::MaxLevel) && character->exp >= this->map->world->exp_table[character->level + 1])
 					{
 						level_up = true;
 						++character->level;
-						character->statpoints += static_cast<int>(this->map->world->config["StatPerLevel"]);
-						character->skillpoints += static_cast<int>(this->map->world->config["SkillPerLevel"]);
+						character->statpoints += this->map->world->settings.GetInt(ConfigKey::StatPerLevel);
+						character->skillpoints += this->map->world->settings.GetInt(ConfigKey::SkillPerLevel);
 						character->CalculateStats();
 					}
 
@@ -1075,7 +1069,7 @@ abort_drop:
 	// Set the respawn timer if the pet is killed
 	if (this->PetOwner)
 	{
-		this->PetOwner->SetPetRespawnTime(Timer::GetTime() + static_cast<double>(this->map->world->config["PetRespawnTime"]));
+		this->PetOwner->SetPetRespawnTime(Timer::GetTime() + this->map->world->settings.GetFloat(ConfigKey::PetRespawnTime));
 	}
 
 	if (this->temporary)
@@ -1176,18 +1170,18 @@ void NPC::Die(bool show)
 
 void NPC::Attack(Character *target)
 {
-	int amount = util::rand(this->ENF().mindam, this->ENF().maxdam + static_cast<int>(this->map->world->config["NPCAdjustMaxDam"]));
+	int amount = util::rand(this->ENF().mindam, this->ENF().maxdam + this->map->world->settings.GetInt(ConfigKey::NPCAdjustMaxDam));
 	double rand = util::rand(0.0, 1.0);
 	// Checks if target is facing you
-	bool critical = std::abs(int(target->direction) - this->direction) != 2 || rand < static_cast<double>(this->map->world->config["CriticalRate"]);
+	bool critical = std::abs(int(target->direction) - this->direction) != 2 || rand < this->map->world->settings.GetFloat(ConfigKey::CriticalRate);
 
-	std::unordered_map<std::string, double> formula_vars;
+	Formula_Frame formula_vars;
 
 	this->FormulaVars(formula_vars);
-	target->FormulaVars(formula_vars, "target_");
-	formula_vars["modifier"] = 1.0 / static_cast<double>(this->map->world->config["MobRate"]);
-	formula_vars["damage"] = amount;
-	formula_vars["critical"] = critical;
+	target->FormulaVars(formula_vars, Formula_Frame::Target);
+	formula_vars.Set(FE_modifier, 1.0 / this->map->world->settings.GetFloat(ConfigKey::MobRate));
+	formula_vars.Set(FE_damage, amount);
+	formula_vars.Set(FE_critical, critical);
 
 	amount = this->map->world->EvalFormula("damage", formula_vars);
 	double hit_rate = this->map->world->EvalFormula("hit_rate", formula_vars);
@@ -1201,7 +1195,7 @@ void NPC::Attack(Character *target)
 
 	int limitamount = std::min(amount, int(target->hp));
 
-	if (this->map->world->config["LimitDamage"])
+	if (this->map->world->settings.GetBool(ConfigKey::LimitDamage))
 	{
 		amount = limitamount;
 	}
@@ -1291,17 +1285,17 @@ void NPC::Say(const std::string &message)
 	}
 }
 
-#define v(x) vars[prefix + #x] = x;
-#define vv(x, n) vars[prefix + n] = x;
-#define vd(x) vars[prefix + #x] = data.x;
+#define v(x) frame.Set(side, FV_##x, x);
+#define vv(x, n) frame.Set(side, FV_##n, x);
+#define vd(x) frame.Set(side, FV_##x, data.x);
 
-void NPC::FormulaVars(std::unordered_map<std::string, double> &vars, std::string prefix)
+void NPC::FormulaVars(Formula_Frame &frame, Formula_Frame::Side side)
 {
 	const ENF_Data &data = this->ENF();
-	vv(1, "npc") v(hp) vv(data.hp, "maxhp")
+	vv(1, npc) v(hp) vv(data.hp, maxhp)
 		vd(mindam) vd(maxdam)
 			vd(accuracy) vd(evade) vd(armor)
-				v(x) v(y) v(direction) vv(map->id, "mapid")
+				v(x) v(y) v(direction) vv(map->id, mapid)
 }
 
 #undef vd
@@ -1321,7 +1315,7 @@ void NPC::PetDamage(NPC *from, int amount, int spell_id)
 {
 	int limitamount = std::min(this->hp, amount);
 
-	if (this->map->world->config["LimitDamage"])
+	if (this->map->world->settings.GetBool(ConfigKey::LimitDamage))
 	{
 		amount = limitamount;
 	}
@@ -1453,7 +1447,7 @@ Direction NPC::PetDetermineDirection(int x, int y)
 NPC *NPC::PetFindNearbyEnemy()
 {
 	NPC *closest_enemy = nullptr;
-	unsigned char closest_distance = static_cast<unsigned char>(static_cast<int>(this->map->world->config["PetChaseDistance"]));
+	unsigned char closest_distance = static_cast<unsigned char>(this->map->world->settings.GetInt(ConfigKey::PetChaseDistance));
 
 	UTIL_FOREACH(this->map->npcs, npc)
 	{
@@ -1529,12 +1523,12 @@ void NPC::OwnerLoggedOut()
 
 bool NPC::InRange(const Character *character) const
 {
-	return util::path_length(this->x, this->y, character->x, character->y) <= static_cast<int>(this->map->world->config["SeeDistance"]);
+	return util::path_length(this->x, this->y, character->x, character->y) <= this->map->world->settings.GetInt(ConfigKey::SeeDistance);
 }
 
 bool NPC::InRange(const NPC *npc) const
 {
-	return util::path_length(this->x, this->y, npc->x, npc->y) <= static_cast<int>(this->map->world->config["SeeDistance"]);
+	return util::path_length(this->x, this->y, npc->x, npc->y) <= this->map->world->settings.GetInt(ConfigKey::SeeDistance);
 }
 
 NPC::~NPC()
@@ -13,6 +13,8 @@
 #include "fwd/map.hpp"
 #include "fwd/npc_data.hpp"
 
+#include "formula_vars.hpp"
+
 #include <array>
 #include <list>
 #include <memory>
@@ -100,7 +102,7 @@ public:
 
 	void Say(const std::string &message);
 
-	void FormulaVars(std::unordered_map<std::string, double> &vars, std::string prefix = "");
+	void FormulaVars(Formula_Frame &frame, Formula_Frame::Side side = Formula_Frame::Self);
 
 	void PetSetOwner(Character *character);
 	void Pet(NPC *npc);
@@ -80,7 +80,7 @@ void NPC_Data::LoadShopDrop()
 			{
 				this->drops_chance_total = chance_offset;
 
-				if (static_cast<int>(this->world->config["DropRateMode"]) == 3)
+				if (this->world->settings.GetInt(ConfigKey::DropRateMode) == 3)
 					Console::Wrn("Drop rates for NPC #%i add up to %g%%. They have been scaled down proportionally.", this->id, this->drops_chance_total);
 			}
 			else
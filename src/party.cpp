@@ -37,7 +37,7 @@ Party::Party(World *world, Character *leader, Character *other)
 
 void Party::Msg(Character *from, std::string message, bool echo)
 {
-	message = util::text_cap(message, static_cast<int>(this->world->config["ChatMaxWidth"]) - util::text_width(util::ucfirst(from->SourceName()) + "  "));
+	message = util::text_cap(message, this->world->settings.GetInt(ConfigKey::ChatMaxWidth) - util::text_width(util::ucfirst(from->SourceName()) + "  "));
 
 	PacketBuilder builder(PACKET_TALK, PACKET_OPEN, 2 + message.length());
 
@@ -195,16 +195,16 @@ void Party::ShareEXP(int exp, int sharemode, Map *map)
 
 		member->exp += reward;
 
-		while (member->level < static_cast<int>(this->world->config["MaxLevel"]) && member->exp >= this->world->exp_table[member->level + 1])
+		while (member->level < this->world->settings.GetInt(ConfigKey::MaxLevel) && member->exp >= this->world->exp_table[member->level + 1])
 		{
 			member->exp -= this->world->exp_table[member->level + 1];
 			++member->level;
-			member->statpoints += static_cast<int>(this->world->config["StatPerLevel"]);
-			member->skillpoints += static_cast<int>(this->world->config["SkillPerLevel"]);
+			member->statpoints += this->world->settings.GetInt(ConfigKey::StatPerLevel);
+			member->skillpoints += this->world->settings.GetInt(ConfigKey::SkillPerLevel);
 			member->CalculateStats();
 		}
 
-		bool level_up = (member->level < static_cast<int>(this->world->config["MaxLevel"]) && member->exp >= this->world->exp_table[member->level + 1]);
+		bool level_up = (member->level < this->world->settings.GetInt(ConfigKey::MaxLevel) && member->exp >= this->world->exp_table[member->level + 1]);
 
 		PacketBuilder builder(PACKET_PARTY, PACKET_TARGET_GROUP, 7);
 		builder.AddShort(member->PlayerID());
@@ -0,0 +1,310 @@
+/* password_hasher.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "password_hasher.hpp"
+
+#include "hash.hpp"
+
+#include "trace.hpp"
+#include "util.hpp"
+#include "util/secure_string.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+static const int scrypt_r = 8;
+static const int scrypt_p = 1;
+static const std::size_t scrypt_salt_length = 16;
+static const std::size_t scrypt_hash_length = 32;
+
+struct Scrypt_Hash
+{
+	int log2_n;
+	int r;
+	int p;
+	std::string salt;
+	std::string hash;
+};
+
+// Format: $scrypt$<log2 N>$<r>$<p>$<salt hex>$<hash hex>
+static bool parse_scrypt_hash(const std::string &stored, Scrypt_Hash &result)
+{
+	if (stored.compare(0, 8, "$scrypt$") != 0)
+		return false;
+
+	std::vector<std::string> parts = util::explode('$', stored.substr(8));
+
+	if (parts.size() != 5)
+		return false;
+
+	result.log2_n = util::to_int(parts[0]);
+	result.r = util::to_int(parts[1]);
+	result.p = util::to_int(parts[2]);
+	result.salt = hex_decode(parts[3]);
+	result.hash = hex_decode(parts[4]);
+
+	return result.log2_n > 0 && result.log2_n < 24 && result.r > 0 && result.r <= 32 && result.p > 0 && result.p <= 16 && !result.salt.empty() && !result.hash.empty();
+}
+
+static bool constant_time_equals(const std::string &a, const std::string &b)
+{
+	if (a.length() != b.length())
+		return false;
+
+	unsigned char diff = 0;
+
+	for (std::size_t i = 0; i < a.length(); ++i)
+		diff |= (unsigned char)(a[i] ^ b[i]);
+
+	return diff == 0;
+}
+
+Password_Hasher::Password_Hasher(int threads)
+	: max_pending(0), stopping(false)
+{
+	for (int i = 0; i < threads; ++i)
+		this->workers.emplace_back(&Password_Hasher::WorkerMain, this);
+}
+
+void Password_Hasher::SetSettings(const Settings &settings)
+{
+	this->settings = settings;
+}
+
+void Password_Hasher::SetMaxPending(std::size_t max_pending)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->max_pending = max_pending;
+}
+
+bool Password_Hasher::Full()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->max_pending != 0 && this->pending.size() >= this->max_pending;
+}
+
+void Password_Hasher::Submit(std::unique_ptr<Job> &&job)
+{
+	if (this->workers.empty())
+	{
+		Execute(*job);
+
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->completed.push_back(std::move(job));
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->pending.push_back(std::move(job));
+	}
+
+	this->cv.notify_one();
+}
+
+void Password_Hasher::WorkerMain()
+{
+	Trace::SetThreadName("password_hasher");
+
+	std::unique_lock<std::mutex> lock(this->mutex);
+
+	while (true)
+	{
+		this->cv.wait(lock, [this]() { return this->stopping || !this->pending.empty(); });
+
+		if (this->stopping)
+			return;
+
+		std::unique_ptr<Job> job = std::move(this->pending.front());
+		this->pending.pop_front();
+		auto in_progress_it = this->in_progress.insert(this->in_progress.end(), job.get());
+
+		lock.unlock();
+		Execute(*job);
+		lock.lock();
+
+		this->in_progress.erase(in_progress_it);
+		this->completed.push_back(std::move(job));
+	}
+}
+
+void Password_Hasher::Execute(Job &job)
+{
+	if (job.verify)
+	{
+		job.match = VerifyPassword(job.settings, job.username, job.password.str(), job.stored);
+
+		if (job.match && NeedsRehash(job.settings, job.stored))
+			job.hash = HashPassword(job.settings, job.username, job.password.str());
+	}
+	else
+	{
+		job.hash = HashPassword(job.settings, job.username, job.password.str());
+	}
+
+	job.password.erase();
+}
+
+void Password_Hasher::Hash(const void *owner, const std::string &username, util::secure_string &&password, HashCallback callback)
+{
+	std::unique_ptr<Job> job(new Job);
+	job->owner = owner;
+	job->settings = this->settings;
+	job->username = username;
+	job->password = std::move(password);
+	job->hash_callback = std::move(callback);
+
+	this->Submit(std::move(job));
+}
+
+void Password_Hasher::Verify(const void *owner, const std::string &username, util::secure_string &&password, const std::string &stored, VerifyCallback callback)
+{
+	std::unique_ptr<Job> job(new Job);
+	job->owner = owner;
+	job->verify = true;
+	job->settings = this->settings;
+	job->username = username;
+	job->password = std::move(password);
+	job->stored = stored;
+	job->verify_callback = std::move(callback);
+
+	this->Submit(std::move(job));
+}
+
+void Password_Hasher::Cancel(const void *owner)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	this->pending.erase(std::remove_if(this->pending.begin(), this->pending.end(), [owner](const std::unique_ptr<Job> &job)
+	{
+		return job->owner == owner;
+	}), this->pending.end());
+
+	for (Job *job : this->in_progress)
+	{
+		if (job->owner == owner)
+			job->cancelled = true;
+	}
+
+	for (auto &job : this->completed)
+	{
+		if (job->owner == owner)
+			job->cancelled = true;
+	}
+}
+
+void Password_Hasher::Poll()
+{
+	std::deque<std::unique_ptr<Job>> jobs;
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		if (this->completed.empty())
+			return;
+
+		jobs.swap(this->completed);
+	}
+
+	for (auto &job : jobs)
+	{
+		if (job->cancelled)
+			continue;
+
+		if (job->verify)
+			job->verify_callback(job->match, job->hash);
+		else
+			job->hash_callback(job->hash);
+	}
+}
+
+std::size_t Password_Hasher::Pending()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->pending.size() + this->in_progress.size() + this->completed.size();
+}
+
+std::string Password_Hasher::HashPassword(const Settings &settings, const std::string &username, const std::string &password)
+{
+	util::secure_string password_buffer(std::move(settings.salt + username + password));
+
+	if (settings.scheme == Scrypt)
+	{
+		std::random_device rng;
+		std::string salt(scrypt_salt_length, '\0');
+
+		for (char &c : salt)
+			c = char(rng() & 0xFF);
+
+		std::string hash = scrypt(password_buffer.str(), salt, settings.cost, scrypt_r, scrypt_p, scrypt_hash_length);
+
+		char params[32];
+		std::snprintf(params, sizeof params, "$scrypt$%i$%i$%i$", settings.cost, scrypt_r, scrypt_p);
+
+		return params + hex_encode(salt) + "$" + hex_encode(hash);
+	}
+
+	return sha256(password_buffer.str());
+}
+
+bool Password_Hasher::VerifyPassword(const Settings &settings, const std::string &username, const std::string &password, const std::string &stored)
+{
+	util::secure_string password_buffer(std::move(settings.salt + username + password));
+	Scrypt_Hash scrypt_hash;
+
+	if (parse_scrypt_hash(stored, scrypt_hash))
+	{
+		std::string hash = scrypt(password_buffer.str(), scrypt_hash.salt, scrypt_hash.log2_n, scrypt_hash.r, scrypt_hash.p, scrypt_hash.hash.length());
+		return constant_time_equals(hash, scrypt_hash.hash);
+	}
+
+	// Legacy hashes may be padded by CHAR columns
+	return constant_time_equals(sha256(password_buffer.str()), util::trim(stored));
+}
+
+std::string Password_Hasher::DummyHash(const Settings &settings)
+{
+	if (settings.scheme == Scrypt)
+	{
+		char params[32];
+		std::snprintf(params, sizeof params, "$scrypt$%i$%i$%i$", settings.cost, scrypt_r, scrypt_p);
+
+		return params + hex_encode(std::string(scrypt_salt_length, '\0')) + "$" + hex_encode(std::string(scrypt_hash_length, '\0'));
+	}
+
+	return std::string(64, '0');
+}
+
+bool Password_Hasher::NeedsRehash(const Settings &settings, const std::string &stored)
+{
+	Scrypt_Hash scrypt_hash;
+
+	if (!parse_scrypt_hash(stored, scrypt_hash))
+		return settings.scheme == Scrypt;
+
+	return settings.scheme == Scrypt && scrypt_hash.log2_n < settings.cost;
+}
+
+Password_Hasher::~Password_Hasher()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+
+	this->cv.notify_all();
+
+	for (std::thread &worker : this->workers)
+		worker.join();
+}
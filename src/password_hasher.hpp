@@ -0,0 +1,159 @@
+/* password_hasher.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef PASSWORD_HASHER_HPP_INCLUDED
+#define PASSWORD_HASHER_HPP_INCLUDED
+
+#include "fwd/password_hasher.hpp"
+
+#include "util/secure_string.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Hashes and verifies account passwords on a pool of worker threads
+ * Completion callbacks are always called from Poll() on the main thread.
+ */
+class Password_Hasher
+{
+public:
+	enum Scheme
+	{
+		SHA256,
+		Scrypt
+	};
+
+	struct Settings
+	{
+		std::string salt;
+		Scheme scheme;
+
+		/**
+		 * scrypt work factor as a power of two
+		 */
+		int cost;
+
+		Settings() : scheme(SHA256), cost(14) {}
+	};
+
+	typedef std::function<void(const std::string &hash)> HashCallback;
+
+	/**
+	 * rehash is non-empty if the password matched and should be stored again with the current settings
+	 */
+	typedef std::function<void(bool match, const std::string &rehash)> VerifyCallback;
+
+protected:
+	struct Job
+	{
+		const void *owner;
+		bool cancelled;
+		bool verify;
+
+		Settings settings;
+		std::string username;
+		util::secure_string password;
+		std::string stored;
+
+		bool match;
+		std::string hash;
+
+		HashCallback hash_callback;
+		VerifyCallback verify_callback;
+
+		Job() : owner(0), cancelled(false), verify(false), password(std::string()), match(false) {}
+	};
+
+	Settings settings;
+	std::size_t max_pending;
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable cv;
+	bool stopping;
+
+	std::deque<std::unique_ptr<Job>> pending;
+	std::list<Job *> in_progress;
+	std::deque<std::unique_ptr<Job>> completed;
+
+	void Submit(std::unique_ptr<Job> &&job);
+	void WorkerMain();
+	static void Execute(Job &job);
+
+public:
+	/**
+	 * @param threads Number of worker threads, or 0 to hash on the calling thread
+	 */
+	Password_Hasher(int threads);
+	Password_Hasher(const Password_Hasher &) = delete;
+
+	/**
+	 * Changes the settings used for jobs submitted after this call
+	 */
+	void SetSettings(const Settings &settings);
+	const Settings &GetSettings() const { return this->settings; }
+
+	/**
+	 * Sets how many jobs may wait for a worker before Full() reports the pool as busy, 0 for no limit
+	 */
+	void SetMaxPending(std::size_t max_pending);
+
+	/**
+	 * Returns true if new requests from clients should be turned away until the queue drains
+	 */
+	bool Full();
+
+	/**
+	 * Queues a password to be hashed with the current settings
+	 * @param owner Identifies the requester so its jobs can be cancelled
+	 */
+	void Hash(const void *owner, const std::string &username, util::secure_string &&password, HashCallback callback);
+
+	/**
+	 * Queues a password to be checked against a stored hash
+	 * @param owner Identifies the requester so its jobs can be cancelled
+	 */
+	void Verify(const void *owner, const std::string &username, util::secure_string &&password, const std::string &stored, VerifyCallback callback);
+
+	/**
+	 * Discards all jobs for an owner, their callbacks will never be called
+	 * Jobs still waiting for a worker are removed without being hashed.
+	 */
+	void Cancel(const void *owner);
+
+	/**
+	 * Calls the callbacks of any completed jobs
+	 */
+	void Poll();
+
+	std::size_t Pending();
+
+	static std::string HashPassword(const Settings &settings, const std::string &username, const std::string &password);
+	static bool VerifyPassword(const Settings &settings, const std::string &username, const std::string &password, const std::string &stored);
+
+	/**
+	 * A stored hash that no password matches, costing as much to verify as a real one with the same settings
+	 * Checked in place of accounts that don't exist, so the time taken doesn't reveal which do.
+	 */
+	static std::string DummyHash(const Settings &settings);
+
+	/**
+	 * Returns true if a stored hash was created with weaker settings than the current ones
+	 */
+	static bool NeedsRehash(const Settings &settings, const std::string &stored);
+
+	~Password_Hasher();
+};
+
+#endif // PASSWORD_HASHER_HPP_INCLUDED
@@ -12,9 +12,7 @@
 #include "world.hpp"
 
 #include "console.hpp"
-#include "hash.hpp"
 #include "util.hpp"
-#include "util/secure_string.hpp"
 
 #include <algorithm>
 #include <ctime>
@@ -43,7 +41,7 @@ Player::Player(std::string username, World *world)
 
 	res = this->world->db.Query("SELECT `name` FROM `characters` WHERE `account` = '$' ORDER BY `exp` DESC", username.c_str());
 
-	UTIL_FOREACH_REF(res, row)
+	UTIL_FOREACH_CREF(res, row)
 	{
 		Character *newchar = new Character(row["name"], world);
 		newchar->player = this;
@@ -68,7 +66,7 @@ bool Player::ValidName(std::string username)
 
 bool Player::AddCharacter(std::string name, Gender gender, int hairstyle, int haircolor, Skin race)
 {
-	if (static_cast<int>(this->characters.size()) > static_cast<int>(this->world->config["MaxCharacters"]))
+	if (static_cast<int>(this->characters.size()) > this->world->settings.GetInt(ConfigKey::MaxCharacters))
 	{
 		return false;
 	}
@@ -82,7 +80,7 @@ bool Player::AddCharacter(std::string name, Gender gender, int hairstyle, int ha
 
 	newchar->player = this;
 
-	if (this->world->admin_count == 0 && this->world->config["FirstCharacterAdmin"])
+	if (this->world->admin_count == 0 && this->world->settings.GetBool(ConfigKey::FirstCharacterAdmin))
 	{
 		Console::Out("%s has been given HGM admin status!", newchar->real_name.c_str());
 		newchar->admin = ADMIN_HGM;
@@ -94,14 +92,9 @@ bool Player::AddCharacter(std::string name, Gender gender, int hairstyle, int ha
 	return true;
 }
 
-void Player::ChangePass(util::secure_string &&password)
+void Player::ChangePass(const std::string &password_hash)
 {
-	{
-		util::secure_string password_buffer(std::move(std::string(this->world->config["PasswordSalt"]) + this->username + password.str()));
-		password = sha256(password_buffer.str());
-	}
-
-	this->world->db.Query("UPDATE `accounts` SET `password` = '$' WHERE username = '$'", password.str().c_str(), this->username.c_str());
+	this->world->SetPasswordHash(this->username, password_hash);
 }
 
 AdminLevel Player::Admin() const
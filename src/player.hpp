@@ -38,7 +38,7 @@ public:
 
 	static bool ValidName(std::string username);
 	bool AddCharacter(std::string name, Gender gender, int hairstyle, int haircolor, Skin race);
-	void ChangePass(util::secure_string &&password);
+	void ChangePass(const std::string &password_hash);
 
 	AdminLevel Admin() const;
 
@@ -68,21 +68,7 @@ namespace PlayerCommands
 
 		PacketBuilder builder(PACKET_STATSKILL, PACKET_PLAYER, 32);
 		builder.AddShort(from->statpoints);
-		builder.AddShort(from->display_str);
-		builder.AddShort(from->display_intl);
-		builder.AddShort(from->display_wis);
-		builder.AddShort(from->display_agi);
-		builder.AddShort(from->display_con);
-		builder.AddShort(from->display_cha);
-		builder.AddShort(from->maxhp);
-		builder.AddShort(from->maxtp);
-		builder.AddShort(from->maxsp);
-		builder.AddShort(from->maxweight);
-		builder.AddShort(from->mindam);
-		builder.AddShort(from->maxdam);
-		builder.AddShort(from->accuracy);
-		builder.AddShort(from->evade);
-		builder.AddShort(from->armor);
+		from->AddStats(builder);
 		from->Send(builder);
 	}
 
@@ -9,6 +9,7 @@
 #include "config.hpp"
 #include "dialog.hpp"
 #include "eoplus.hpp"
+#include "formula_vars.hpp"
 #include "map.hpp"
 #include "packet.hpp"
 #include "world.hpp"
@@ -18,6 +19,7 @@
 #include "util/rpn.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <ctime>
 #include <deque>
@@ -26,17 +28,87 @@
 #include <iterator>
 #include <map>
 #include <memory>
+#include <sstream>
 #include <stack>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 static int quest_day()
 {
 	return (std::time(nullptr) / 86400) & 0x7FFF;
 }
 
+enum Quest_Action_Op
+{
+	QUEST_ACTION_SETSTATE,
+	QUEST_ACTION_RESET,
+	QUEST_ACTION_RESETDAILY,
+	QUEST_ACTION_END,
+	QUEST_ACTION_STARTQUEST,
+	QUEST_ACTION_RESETQUEST,
+	QUEST_ACTION_SETQUESTSTATE,
+	QUEST_ACTION_ADDNPCTEXT,
+	QUEST_ACTION_ADDNPCINPUT,
+	QUEST_ACTION_ADDNPCCHAT,
+	QUEST_ACTION_SHOWHINT,
+	QUEST_ACTION_QUAKE,
+	QUEST_ACTION_QUAKEWORLD,
+	QUEST_ACTION_SETCOORD,
+	QUEST_ACTION_PLAYSOUND,
+	QUEST_ACTION_GIVEEXP,
+	QUEST_ACTION_GIVEITEM,
+	QUEST_ACTION_REMOVEITEM,
+	QUEST_ACTION_SETCLASS,
+	QUEST_ACTION_SETRACE,
+	QUEST_ACTION_REMOVEKARMA,
+	QUEST_ACTION_GIVEKARMA,
+	QUEST_ACTION_SETTITLE,
+	QUEST_ACTION_SETFIANCE,
+	QUEST_ACTION_SETPARTNER,
+	QUEST_ACTION_SETHOME,
+	QUEST_ACTION_SETSTAT,
+	QUEST_ACTION_GIVESTAT,
+	QUEST_ACTION_REMOVESTAT,
+	QUEST_ACTION_ROLL,
+};
+
+enum Quest_Rule_Op
+{
+	QUEST_RULE_INPUTNPC,
+	QUEST_RULE_TALKEDTONPC,
+	QUEST_RULE_ALWAYS,
+	QUEST_RULE_DONEDAILY,
+	QUEST_RULE_ENTERMAP,
+	QUEST_RULE_ENTERCOORD,
+	QUEST_RULE_LEAVEMAP,
+	QUEST_RULE_LEAVECOORD,
+	QUEST_RULE_KILLEDNPCS,
+	QUEST_RULE_KILLEDPLAYERS,
+	QUEST_RULE_GOTITEMS,
+	QUEST_RULE_LOSTITEMS,
+	QUEST_RULE_USEDITEM,
+	QUEST_RULE_ISGENDER,
+	QUEST_RULE_ISCLASS,
+	QUEST_RULE_ISRACE,
+	QUEST_RULE_ISWEARING,
+	QUEST_RULE_GOTSPELL,
+	QUEST_RULE_LOSTSPELL,
+	QUEST_RULE_USEDSPELL,
+	QUEST_RULE_CITIZENOF,
+	QUEST_RULE_ROLLED,
+	QUEST_RULE_STATIS,
+	QUEST_RULE_STATNOT,
+	QUEST_RULE_STATGREATER,
+	QUEST_RULE_STATLESS,
+	QUEST_RULE_STATBETWEEN,
+	QUEST_RULE_STATRPN,
+	QUEST_RULE_STATEVAL,
+};
+
 struct Validation_Error : public EOPlus::Runtime_Error
 {
 private:
@@ -58,103 +130,119 @@ public:
 	}
 };
 
-static void validate_state(const EOPlus::Quest &quest, const std::string &name, const EOPlus::State &state)
+static void resolve_expression(EOPlus::Expression &expr, int op)
+{
+	expr.op = op;
+	expr.int_args.clear();
+
+	UTIL_FOREACH(expr.args, arg)
+	{
+		expr.int_args.push_back(int(arg));
+	}
+}
+
+static void validate_state(const EOPlus::Quest &quest, const std::string &name, EOPlus::State &state)
 {
 	struct info_t
 	{
+		int op;
 		int min_args;
 		int max_args;
 
-		info_t(int min_args, int max_args = 0)
-			: min_args(min_args), max_args(max_args < 0 ? max_args : std::max(min_args, max_args))
+		info_t(int op, int min_args, int max_args = 0)
+			: op(op), min_args(min_args), max_args(max_args < 0 ? max_args : std::max(min_args, max_args))
 		{
 		}
 	};
 
 	static std::map<std::string, info_t> action_argument_info{
-		{"setstate", 1},
-		{"reset", 0},
-		{"resetdaily", 0},
-		{"end", 0},
-
-		{"startquest", {1, 2}},
-		{"resetquest", 1},
-		{"setqueststate", 2},
-
-		{"addnpctext", 2},
-		{"addnpcinput", 3},
-
-		{"addnpcchat", 2},
-		{"showhint", 1},
-		{"quake", {0, 1}},
-		{"quakeworld", {0, 1}},
-
-		{"setmap", 3}, // Alias for SetCoord
-		{"setcoord", 3},
-		{"playsound", 1},
-		{"giveexp", 1},
-		{"giveitem", {1, 2}},
-		{"removeitem", {1, 2}},
-		{"setclass", 1},
-		{"setrace", 1},
-		{"removekarma", 1},
-		{"givekarma", 1},
-
-		{"settitle", 1},
-		{"setfiance", 1},
-		{"setpartner", 1},
-		{"sethome", 1},
-
-		{"setstat", 2},
-		{"givestat", 2},
-		{"removestat", 2},
-
-		{"roll", 1},
+		{"setstate", {QUEST_ACTION_SETSTATE, 1}},
+		{"reset", {QUEST_ACTION_RESET, 0}},
+		{"resetdaily", {QUEST_ACTION_RESETDAILY, 0}},
+		{"end", {QUEST_ACTION_END, 0}},
+
+		{"startquest", {QUEST_ACTION_STARTQUEST, 1, 2}},
+		{"resetquest", {QUEST_ACTION_RESETQUEST, 1}},
+		{"setqueststate", {QUEST_ACTION_SETQUESTSTATE, 2}},
+
+		{"addnpctext", {QUEST_ACTION_ADDNPCTEXT, 2}},
+		{"addnpcinput", {QUEST_ACTION_ADDNPCINPUT, 3}},
+
+		{"addnpcchat", {QUEST_ACTION_ADDNPCCHAT, 2}},
+		{"showhint", {QUEST_ACTION_SHOWHINT, 1}},
+		{"quake", {QUEST_ACTION_QUAKE, 0, 1}},
+		{"quakeworld", {QUEST_ACTION_QUAKEWORLD, 0, 1}},
+
+		{"setmap", {QUEST_ACTION_SETCOORD, 3}}, // Alias for SetCoord
+		{"setcoord", {QUEST_ACTION_SETCOORD, 3}},
+		{"playsound", {QUEST_ACTION_PLAYSOUND, 1}},
+		{"giveexp", {QUEST_ACTION_GIVEEXP, 1}},
+		{"giveitem", {QUEST_ACTION_GIVEITEM, 1, 2}},
+		{"removeitem", {QUEST_ACTION_REMOVEITEM, 1, 2}},
+		{"setclass", {QUEST_ACTION_SETCLASS, 1}},
+		{"setrace", {QUEST_ACTION_SETRACE, 1}},
+		{"removekarma", {QUEST_ACTION_REMOVEKARMA, 1}},
+		{"givekarma", {QUEST_ACTION_GIVEKARMA, 1}},
+
+		{"settitle", {QUEST_ACTION_SETTITLE, 1}},
+		{"setfiance", {QUEST_ACTION_SETFIANCE, 1}},
+		{"setpartner", {QUEST_ACTION_SETPARTNER, 1}},
+		{"sethome", {QUEST_ACTION_SETHOME, 1}},
+
+		{"setstat", {QUEST_ACTION_SETSTAT, 2}},
+		{"givestat", {QUEST_ACTION_GIVESTAT, 2}},
+		{"removestat", {QUEST_ACTION_REMOVESTAT, 2}},
+
+		{"roll", {QUEST_ACTION_ROLL, 1}},
 	};
 
 	static std::map<std::string, info_t> rule_argument_info{
-		{"inputnpc", 1},
-		{"talkedtonpc", 1},
+		{"inputnpc", {QUEST_RULE_INPUTNPC, 1}},
+		{"talkedtonpc", {QUEST_RULE_TALKEDTONPC, 1}},
 
-		{"always", 0},
+		{"always", {QUEST_RULE_ALWAYS, 0}},
 
-		{"donedaily", 1},
+		{"donedaily", {QUEST_RULE_DONEDAILY, 1}},
 
-		{"entermap", 1},
-		{"entercoord", 3},
-		{"leavemap", 1},
-		{"leavecoord", 3},
+		{"entermap", {QUEST_RULE_ENTERMAP, 1}},
+		{"entercoord", {QUEST_RULE_ENTERCOORD, 3}},
+		{"leavemap", {QUEST_RULE_LEAVEMAP, 1}},
+		{"leavecoord", {QUEST_RULE_LEAVECOORD, 3}},
 
-		{"killednpcs", {1, 2}},
-		{"killedplayers", 1},
+		{"killednpcs", {QUEST_RULE_KILLEDNPCS, 1, 2}},
+		{"killedplayers", {QUEST_RULE_KILLEDPLAYERS, 1}},
 
-		{"gotitems", {1, 2}},
-		{"lostitems", {1, 2}},
-		{"useditem", {1, 2}},
+		{"gotitems", {QUEST_RULE_GOTITEMS, 1, 2}},
+		{"lostitems", {QUEST_RULE_LOSTITEMS, 1, 2}},
+		{"useditem", {QUEST_RULE_USEDITEM, 1, 2}},
 
-		{"isgender", 1},
-		{"isclass", 1},
-		{"israce", 1},
-		{"iswearing", 1},
+		{"isgender", {QUEST_RULE_ISGENDER, 1}},
+		{"isclass", {QUEST_RULE_ISCLASS, 1}},
+		{"israce", {QUEST_RULE_ISRACE, 1}},
+		{"iswearing", {QUEST_RULE_ISWEARING, 1}},
 
-		{"gotspell", {1, 2}},
-		{"lostspell", 1},
-		{"usedspell", {1, 2}},
+		{"gotspell", {QUEST_RULE_GOTSPELL, 1, 2}},
+		{"lostspell", {QUEST_RULE_LOSTSPELL, 1}},
+		{"usedspell", {QUEST_RULE_USEDSPELL, 1, 2}},
 
-		{"citizenof", 1},
+		{"citizenof", {QUEST_RULE_CITIZENOF, 1}},
 
-		{"rolled", {1, 2}},
+		{"rolled", {QUEST_RULE_ROLLED, 1, 2}},
 
 		// Only needed until expression support is added
-		{"statis", 2},
-		{"statnot", 2},
-		{"statgreater", 2},
-		{"statless", 2},
-		{"statbetween", 3},
-		{"statrpn", 1}};
-
-	auto check = [&](std::string type, std::string function, const std::deque<util::variant> &args, info_t &info)
+		{"statis", {QUEST_RULE_STATIS, 2}},
+		{"statnot", {QUEST_RULE_STATNOT, 2}},
+		{"statgreater", {QUEST_RULE_STATGREATER, 2}},
+		{"statless", {QUEST_RULE_STATLESS, 2}},
+		{"statbetween", {QUEST_RULE_STATBETWEEN, 3}},
+		{"statrpn", {QUEST_RULE_STATRPN, 1}},
+		{"stateval", {QUEST_RULE_STATEVAL, 1}}};
+
+	auto check = [&](std::string type, EOPlus::Expression &expr, const info_t &info)
 	{
+		const std::string &function = expr.function;
+		const std::deque<util::variant> &args = expr.args;
+
 		if (args.size() < std::size_t(info.min_args))
 			throw Validation_Error(type + " " + function + " requires at least " + util::to_string(info.min_args) + " argument(s)", name);
 
@@ -169,44 +257,57 @@ static void validate_state(const EOPlus::Quest &quest, const std::string &name,
 			if (it == quest.states.end())
 				throw Validation_Error("Unknown quest state: " + state, name);
 		}
+
+		resolve_expression(expr, info.op);
 	};
 
-	UTIL_FOREACH(state.actions, action)
+	UTIL_FOREACH_REF(state.actions, action)
 	{
 		const auto it = action_argument_info.find(action.expr.function);
 
 		if (it == action_argument_info.end())
 			throw Validation_Error("Unknown action: " + action.expr.function, name);
 
-		check("Action", action.expr.function, action.expr.args, it->second);
+		check("Action", action.expr, it->second);
+
+		if (action.cond == EOPlus::Action::If || action.cond == EOPlus::Action::ElseIf)
+		{
+			const auto cond_it = rule_argument_info.find(action.cond_expr.function);
+
+			if (cond_it != rule_argument_info.end())
+				resolve_expression(action.cond_expr, cond_it->second.op);
+		}
 	}
 
-	UTIL_FOREACH(state.rules, rule)
+	UTIL_FOREACH_REF(state.rules, rule)
 	{
-		const EOPlus::Action &action = rule.action;
+		EOPlus::Action &action = rule.action;
 
 		const auto it = action_argument_info.find(action.expr.function);
 
 		if (it == action_argument_info.end())
 			throw Validation_Error("Unknown action: " + action.expr.function, name);
 
-		check("Action", action.expr.function, action.expr.args, it->second);
+		check("Action", action.expr, it->second);
 	}
 
-	UTIL_FOREACH(state.rules, rule)
+	UTIL_FOREACH_REF(state.rules, rule)
 	{
 		const auto it = rule_argument_info.find(rule.expr.function);
 
 		if (it == rule_argument_info.end())
 			throw Validation_Error("Unknown rule: " + rule.expr.function, name);
 
-		check("Rule", rule.expr.function, rule.expr.args, it->second);
+		check("Rule", rule.expr, it->second);
 	}
 }
 
-static void validate_quest(const EOPlus::Quest &quest)
+/**
+ * Validates every state of a quest, resolving function names to Quest_Action_Op / Quest_Rule_Op codes
+ */
+static void validate_quest(EOPlus::Quest &quest)
 {
-	UTIL_CIFOREACH(quest.states, it)
+	UTIL_IFOREACH(quest.states, it)
 	{
 		validate_state(quest, it->first, it->second);
 	}
@@ -223,25 +324,25 @@ static bool modify_stat(std::string name, std::function<int(int)> f, Character *
 	bool skillpoints = false;
 
 	if (name == "level")
-		(level = true, victim->level) = util::clamp<int>(f(victim->level), 0, victim->world->config["MaxLevel"]);
+		(level = true, victim->level) = util::clamp<int>(f(victim->level), 0, victim->world->settings.GetInt(ConfigKey::MaxLevel));
 	else if (name == "exp")
-		(level = true, victim->exp) = util::clamp<int>(f(victim->exp), 0, victim->world->config["MaxEXP"]);
+		(level = true, victim->exp) = util::clamp<int>(f(victim->exp), 0, victim->world->settings.GetInt(ConfigKey::MaxExp));
 	else if (name == "str")
-		(stats = true, victim->str) = util::clamp<int>(f(victim->str), 0, victim->world->config["MaxStat"]);
+		(stats = true, victim->str) = util::clamp<int>(f(victim->str), 0, victim->world->settings.GetInt(ConfigKey::MaxStat));
 	else if (name == "int")
-		(stats = true, victim->intl) = util::clamp<int>(f(victim->intl), 0, victim->world->config["MaxStat"]);
+		(stats = true, victim->intl) = util::clamp<int>(f(victim->intl), 0, victim->world->settings.GetInt(ConfigKey::MaxStat));
 	else if (name == "wis")
-		(stats = true, victim->wis) = util::clamp<int>(f(victim->wis), 0, victim->world->config["MaxStat"]);
+		(stats = true, victim->wis) = util::clamp<int>(f(victim->wis), 0, victim->world->settings.GetInt(ConfigKey::MaxStat));
 	else if (name == "agi")
-		(stats = true, victim->agi) = util::clamp<int>(f(victim->agi), 0, victim->world->config["MaxStat"]);
+		(stats = true, victim->agi) = util::clamp<int>(f(victim->agi), 0, victim->world->settings.GetInt(ConfigKey::MaxStat));
 	else if (name == "con")
-		(stats = true, victim->con) = util::clamp<int>(f(victim->con), 0, victim->world->config["MaxStat"]);
+		(stats = true, victim->con) = util::clamp<int>(f(victim->con), 0, victim->world->settings.GetInt(ConfigKey::MaxStat));
 	else if (name == "cha")
-		(stats = true, victim->cha) = util::clamp<int>(f(victim->cha), 0, victim->world->config["MaxStat"]);
+		(stats = true, victim->cha) = util::clamp<int>(f(victim->cha), 0, victim->world->settings.GetInt(ConfigKey::MaxStat));
 	else if (name == "statpoints")
-		(statpoints = true, victim->statpoints) = util::clamp<int>(f(victim->statpoints), 0, int(victim->world->config["MaxLevel"]) * int(victim->world->config["StatPerLevel"]));
+		(statpoints = true, victim->statpoints) = util::clamp<int>(f(victim->statpoints), 0, victim->world->settings.GetInt(ConfigKey::MaxLevel) * victim->world->settings.GetInt(ConfigKey::StatPerLevel));
 	else if (name == "skillpoints")
-		(skillpoints = true, victim->skillpoints) = util::clamp<int>(f(victim->skillpoints), 0, int(victim->world->config["MaxLevel"]) * int(victim->world->config["SkillPerLevel"]));
+		(skillpoints = true, victim->skillpoints) = util::clamp<int>(f(victim->skillpoints), 0, victim->world->settings.GetInt(ConfigKey::MaxLevel) * victim->world->settings.GetInt(ConfigKey::SkillPerLevel));
 	else if (name == "admin")
 	{
 		AdminLevel level = util::clamp<AdminLevel>(AdminLevel(f(victim->admin)), ADMIN_PLAYER, ADMIN_HGM);
@@ -256,11 +357,11 @@ static bool modify_stat(std::string name, std::function<int(int)> f, Character *
 	else if (name == "gender")
 		(appearance = true, victim->gender) = util::clamp<Gender>(Gender(f(victim->gender)), Gender(0), Gender(1));
 	else if (name == "hairstyle")
-		(appearance = true, victim->hairstyle) = util::clamp<int>(f(victim->hairstyle), 0, victim->world->config["MaxHairStyle"]);
+		(appearance = true, victim->hairstyle) = util::clamp<int>(f(victim->hairstyle), 0, victim->world->settings.GetInt(ConfigKey::MaxHairStyle));
 	else if (name == "haircolor")
-		(appearance = true, victim->haircolor) = util::clamp<int>(f(victim->haircolor), 0, victim->world->config["MaxHairColor"]);
+		(appearance = true, victim->haircolor) = util::clamp<int>(f(victim->haircolor), 0, victim->world->settings.GetInt(ConfigKey::MaxHairColor));
 	else if (name == "race")
-		(appearance = true, victim->race) = util::clamp<Skin>(Skin(f(victim->race)), Skin(0), Skin(int(victim->world->config["MaxSkin"])));
+		(appearance = true, victim->race) = util::clamp<Skin>(Skin(f(victim->race)), Skin(0), Skin(victim->world->settings.GetInt(ConfigKey::MaxSkin)));
 	else if (name == "guildrank")
 		victim->guild_rank = util::clamp<int>(f(victim->guild_rank), 0, 9);
 	else if (name == "karma")
@@ -280,37 +381,21 @@ static bool modify_stat(std::string name, std::function<int(int)> f, Character *
 	{
 		victim->CalculateStats();
 
-		PacketBuilder builder(PACKET_RECOVER, PACKET_LIST, 32);
-
 		if (statpoints)
 		{
-			builder.SetID(PACKET_STATSKILL, PACKET_PLAYER);
+			PacketBuilder builder(PACKET_STATSKILL, PACKET_PLAYER, 34);
 			builder.AddShort(victim->statpoints);
 
 			// Update skill points
 			builder.AddShort(victim->skillpoints);
+
+			victim->AddStats(builder);
+			victim->Send(builder);
 		}
 		else
 		{
-			builder.AddShort(victim->clas);
+			victim->SendStats();
 		}
-
-		builder.AddShort(victim->display_str);
-		builder.AddShort(victim->display_intl);
-		builder.AddShort(victim->display_wis);
-		builder.AddShort(victim->display_agi);
-		builder.AddShort(victim->display_con);
-		builder.AddShort(victim->display_cha);
-		builder.AddShort(victim->maxhp);
-		builder.AddShort(victim->maxtp);
-		builder.AddShort(victim->maxsp);
-		builder.AddShort(victim->maxweight);
-		builder.AddShort(victim->mindam);
-		builder.AddShort(victim->maxdam);
-		builder.AddShort(victim->accuracy);
-		builder.AddShort(victim->evade);
-		builder.AddShort(victim->armor);
-		victim->Send(builder);
 	}
 
 	if (karma || level)
@@ -330,48 +415,314 @@ static bool modify_stat(std::string name, std::function<int(int)> f, Character *
 	return true;
 }
 
-Quest::Quest(short id, World *world)
+static std::string quest_filename(const std::string &quest_dir, short id, const char *extension)
+{
+	char namebuf[10];
+	std::sprintf(namebuf, "%05i", id);
+	return quest_dir + namebuf + extension;
+}
+
+Quest::Quest(short id, World *world, const std::string &quest_dir, bool use_cache)
 	: world(world), quest(0), id(id)
 {
-	this->Load();
+	this->Load(quest_dir, use_cache);
 }
 
-void Quest::Load()
+void Quest::Load(const std::string &quest_dir, bool use_cache)
 {
-	char namebuf[10];
+	std::string filename = quest_filename(quest_dir, this->id, ".eqf");
+	std::string cache_filename = quest_filename(quest_dir, this->id, ".eqc");
 
-	std::string filename = this->world->config["QuestDir"];
-	std::sprintf(namebuf, "%05i", this->id);
-	filename += namebuf;
-	filename += ".eqf";
+	if (!EOPlus::StatSource(filename, this->source))
+		throw std::runtime_error("Failed to load quest");
 
-	std::ifstream f(filename);
+	std::string source;
 
-	if (!f)
+	if (!EOPlus::ReadSource(filename, source))
 		throw std::runtime_error("Failed to load quest");
 
-	try
+	this->source.hash = EOPlus::HashSource(source);
+
+	std::unique_ptr<EOPlus::Quest> quest;
+	EOPlus::Source_Key cached;
+	bool have_cache = use_cache && EOPlus::ReadCache(cache_filename, cached, quest);
+
+	// A file can be edited without its time or size changing, so only a matching hash of the contents can skip parsing
+	if (!have_cache || cached.hash != this->source.hash)
 	{
-		this->quest = new EOPlus::Quest(f);
-		validate_quest(*this->quest);
+		std::istringstream is(source);
+		quest.reset(new EOPlus::Quest(is));
 	}
-	catch (EOPlus::Syntax_Error &e)
+
+	// Opcodes are resolved here rather than cached so the cache never outlives a change to them
+	validate_quest(*quest);
+
+	if (use_cache && !(have_cache && cached.SameFile(this->source) && cached.hash == this->source.hash))
+		EOPlus::WriteCache(cache_filename, this->source, *quest);
+
+	this->quest = quest.release();
+	this->IndexRules();
+	this->IndexProgress();
+}
+
+bool Quest::SourceUnchanged(const std::string &filename, const EOPlus::Source_Key &stat)
+{
+	std::string source;
+
+	if (!EOPlus::ReadSource(filename, source) || EOPlus::HashSource(source) != this->source.hash)
+		return false;
+
+	this->source.mtime = stat.mtime;
+	this->source.size = stat.size;
+
+	return true;
+}
+
+std::map<short, std::shared_ptr<Quest>> Quest::LoadAll(World *world, const std::vector<short> &ids, const std::map<short, std::shared_ptr<Quest>> &previous)
+{
+	// Config lookups are not thread-safe, so read everything the workers need up front
+	std::string quest_dir = world->settings.GetString(ConfigKey::QuestDir);
+	bool use_cache = world->settings.GetBool(ConfigKey::QuestCache);
+
+	struct load_result
+	{
+		std::shared_ptr<Quest> quest;
+		std::string filename;
+		std::string error;
+	};
+
+	std::vector<load_result> results(ids.size());
+	std::atomic<std::size_t> next(0);
+
+	auto worker = [&]()
+	{
+		for (std::size_t i; (i = next++) < ids.size();)
+		{
+			load_result &result = results[i];
+			EOPlus::Source_Key stat;
+
+			result.filename = quest_filename(quest_dir, ids[i], ".eqf");
+
+			if (!EOPlus::StatSource(result.filename, stat))
+				continue;
+
+			auto previous_it = previous.find(ids[i]);
+
+			if (previous_it != previous.end() && previous_it->second->SourceUnchanged(result.filename, stat))
+			{
+				result.quest = previous_it->second;
+				continue;
+			}
+
+			try
+			{
+				result.quest = std::make_shared<Quest>(ids[i], world, quest_dir, use_cache);
+			}
+			catch (EOPlus::Syntax_Error &e)
+			{
+				result.error = std::string("Syntax Error: ") + e.what() + " (Line " + util::to_string(e.line()) + ")";
+			}
+			catch (Validation_Error &e)
+			{
+				result.error = std::string("Validation Error: ") + e.what() + " (State: " + e.state() + ")";
+			}
+			catch (std::exception &e)
+			{
+				result.error = e.what();
+			}
+		}
+	};
+
+	std::size_t num_workers = std::max(1U, std::thread::hardware_concurrency());
+	num_workers = std::min(num_workers, ids.size());
+
+	std::vector<std::thread> workers;
+	workers.reserve(num_workers);
+
+	for (std::size_t i = 0; i < num_workers; ++i)
+		workers.emplace_back(worker);
+
+	for (std::thread &t : workers)
+		t.join();
+
+	std::map<short, std::shared_ptr<Quest>> quests;
+
+	for (std::size_t i = 0; i < ids.size(); ++i)
 	{
-		Console::Err("Could not load quest: %s", filename.c_str());
-		Console::Err("Syntax Error: %s (Line %i)", e.what(), e.line());
-		throw;
+		if (!results[i].error.empty())
+		{
+			Console::Err("Could not load quest: %s", results[i].filename.c_str());
+			Console::Err("%s", results[i].error.c_str());
+		}
+		else if (results[i].quest)
+		{
+			quests.insert(std::make_pair(ids[i], std::move(results[i].quest)));
+		}
 	}
-	catch (Validation_Error &e)
+
+	return quests;
+}
+
+void Quest::IndexRules()
+{
+	this->rule_index.clear();
+
+	UTIL_CIFOREACH(this->quest->states, it)
 	{
-		Console::Err("Could not load quest: %s", filename.c_str());
-		Console::Err("Validation Error: %s (State: %s)", e.what(), e.state().c_str());
-		throw;
+		const EOPlus::State &state = it->second;
+		Rule_Index &index = this->rule_index[&state];
+
+		for (std::size_t i = 0; i < state.rules.size(); ++i)
+		{
+			const EOPlus::Expression &expr = state.rules[i].expr;
+
+			switch (Quest_Rule_Op(expr.op))
+			{
+			case QUEST_RULE_GOTITEMS:
+			case QUEST_RULE_LOSTITEMS:
+				index.items[expr.int_args[0]].push_back(i);
+				break;
+
+			case QUEST_RULE_GOTSPELL:
+			case QUEST_RULE_LOSTSPELL:
+				index.spells[expr.int_args[0]].push_back(i);
+				break;
+
+			case QUEST_RULE_ENTERMAP:
+			case QUEST_RULE_ENTERCOORD:
+				index.maps[expr.int_args[0]].push_back(i);
+				break;
+
+			case QUEST_RULE_LEAVEMAP:
+			case QUEST_RULE_LEAVECOORD:
+				index.leave.push_back(i);
+				break;
+
+			case QUEST_RULE_ISGENDER:
+			case QUEST_RULE_ISCLASS:
+			case QUEST_RULE_ISRACE:
+			case QUEST_RULE_ISWEARING:
+			case QUEST_RULE_CITIZENOF:
+			case QUEST_RULE_STATIS:
+			case QUEST_RULE_STATNOT:
+			case QUEST_RULE_STATGREATER:
+			case QUEST_RULE_STATLESS:
+			case QUEST_RULE_STATBETWEEN:
+			case QUEST_RULE_STATRPN:
+			case QUEST_RULE_STATEVAL:
+				index.character.push_back(i);
+				break;
+
+			default:
+				index.other.push_back(i);
+				break;
+			}
+		}
 	}
-	catch (...)
+}
+
+void Quest::IndexProgress()
+{
+	static const char *fixed_names[ProgressFixedSlots] = {"d", "c", "r"};
+
+	this->progress_names.assign(fixed_names, fixed_names + ProgressFixedSlots);
+	this->progress_slots.clear();
+	this->counter_slots.clear();
+
+	UTIL_CIFOREACH(this->quest->states, it)
 	{
-		Console::Err("Could not load quest: %s", filename.c_str());
-		throw;
+		UTIL_FOREACH_CREF(it->second.rules, rule)
+		{
+			const EOPlus::Expression &expr = rule.expr;
+			short id = 0;
+
+			switch (Quest_Rule_Op(expr.op))
+			{
+			case QUEST_RULE_USEDITEM:
+			case QUEST_RULE_USEDSPELL:
+			case QUEST_RULE_KILLEDNPCS:
+				id = expr.int_args[0];
+				break;
+
+			case QUEST_RULE_KILLEDPLAYERS:
+				break;
+
+			default:
+				continue;
+			}
+
+			int key = (expr.op << 16) | static_cast<unsigned short>(id);
+
+			if (this->counter_slots.count(key))
+				continue;
+
+			this->counter_slots[key] = this->progress_names.size();
+			this->progress_names.push_back(expr.op == QUEST_RULE_KILLEDPLAYERS ? expr.function : expr.function + "/" + util::to_string(id));
+		}
 	}
+
+	for (std::size_t i = 0; i < this->progress_names.size(); ++i)
+		this->progress_slots[this->progress_names[i]] = i;
+}
+
+int Quest::ProgressSlot(const std::string &name) const
+{
+	auto it = this->progress_slots.find(name);
+	return (it != this->progress_slots.end()) ? it->second : -1;
+}
+
+int Quest::CounterSlot(int op, short id) const
+{
+	auto it = this->counter_slots.find((op << 16) | static_cast<unsigned short>(id));
+	return (it != this->counter_slots.end()) ? it->second : -1;
+}
+
+void Quest::TriggeredRules(const EOPlus::State *state, QuestTrigger trigger, short key, std::vector<std::size_t> &rules) const
+{
+	rules.clear();
+
+	auto index_it = this->rule_index.find(state);
+
+	if (index_it == this->rule_index.end())
+		return;
+
+	const Rule_Index &index = index_it->second;
+
+	auto add = [&](const std::vector<std::size_t> &bucket)
+	{
+		rules.insert(rules.end(), UTIL_CRANGE(bucket));
+	};
+
+	auto add_key = [&](const std::unordered_map<short, std::vector<std::size_t>> &buckets)
+	{
+		auto it = buckets.find(key);
+
+		if (it != buckets.end())
+			add(it->second);
+	};
+
+	switch (trigger)
+	{
+		case QUEST_TRIGGER_ITEM:
+			add_key(index.items);
+			add(index.character); // weight
+			break;
+
+		case QUEST_TRIGGER_SPELL:
+			add_key(index.spells);
+			break;
+
+		case QUEST_TRIGGER_MOVE:
+			add_key(index.maps);
+			add(index.leave);
+			add(index.character); // x, y, mapid
+			break;
+	}
+
+	add(index.other);
+
+	// Every rule is in at most one bucket, so sorting restores rule order without duplicates
+	std::sort(UTIL_RANGE(rules));
 }
 
 short Quest::ID() const
@@ -396,22 +747,50 @@ Quest::~Quest()
 }
 
 Quest_Context::Quest_Context(Character *character, const Quest *quest)
-	: Context(quest->GetQuest()), character(character), quest(quest)
+	: Context(quest->GetQuest()), character(character), quest(quest), progress(quest->ProgressSlots()), progress_set(quest->ProgressSlots())
+{
+	this->character->QuestChanged();
+}
+
+bool Quest_Context::HasProgress(int slot) const
+{
+	return this->progress_set[slot];
+}
+
+short Quest_Context::GetProgress(int slot) const
+{
+	return this->progress[slot];
+}
+
+void Quest_Context::SetProgress(int slot, short value)
+{
+	this->progress[slot] = value;
+	this->progress_set[slot] = true;
+	this->character->QuestChanged();
+}
+
+void Quest_Context::ClearProgress(int slot)
 {
+	this->progress[slot] = 0;
+	this->progress_set[slot] = false;
+	this->character->QuestChanged();
 }
 
 void Quest_Context::BeginState(const std::string &name, const EOPlus::State &state)
 {
+	this->character->QuestChanged();
+
 	this->state_desc = state.desc;
 
-	for (auto it = this->progress.begin(); it != this->progress.end();)
+	// Only the daily counters survive a state change
+	for (std::size_t i = Quest::ProgressRoll; i < this->progress.size(); ++i)
 	{
-		if (it->first != "d" && it->first != "c")
-			it = this->progress.erase(it);
-		else
-			++it;
+		this->progress[i] = 0;
+		this->progress_set[i] = false;
 	}
 
+	this->progress_extra.clear();
+
 	this->dialogs.clear();
 
 	if (this->quest->Disabled())
@@ -419,20 +798,18 @@ void Quest_Context::BeginState(const std::string &name, const EOPlus::State &sta
 
 	UTIL_FOREACH(state.actions, action)
 	{
-		std::string function_name = action.expr.function;
-
-		if (function_name == "addnpctext" || function_name == "addnpcinput")
+		if (action.expr.op == QUEST_ACTION_ADDNPCTEXT || action.expr.op == QUEST_ACTION_ADDNPCINPUT)
 		{
-			short vendor_id = int(action.expr.args[0]);
+			short vendor_id = action.expr.int_args[0];
 			auto it = this->dialogs.find(vendor_id);
 
 			if (it == this->dialogs.end())
 				it = this->dialogs.insert(std::make_pair(vendor_id, std::shared_ptr<Dialog>(new Dialog()))).first;
 
-			if (function_name == "addnpctext")
+			if (action.expr.op == QUEST_ACTION_ADDNPCTEXT)
 				it->second->AddPage(std::string(action.expr.args[1]));
-			else if (function_name == "addnpcinput")
-				it->second->AddLink(int(action.expr.args[1]), std::string(action.expr.args[2]));
+			else
+				it->second->AddLink(action.expr.int_args[1], std::string(action.expr.args[2]));
 		}
 	}
 }
@@ -442,17 +819,20 @@ bool Quest_Context::DoAction(const EOPlus::Action &action)
 	if (this->quest->Disabled())
 		return false;
 
-	std::string function_name = action.expr.function;
+	this->character->QuestChanged();
 
-	if (function_name == "setstate")
+	switch (Quest_Action_Op(action.expr.op))
+	{
+	case QUEST_ACTION_SETSTATE:
 	{
 		std::string state = util::lowercase(action.expr.args[0]);
 		this->SetState(state);
 		return true;
 	}
-	else if (function_name == "reset")
+
+	case QUEST_ACTION_RESET:
 	{
-		if (this->progress.find("c") == this->progress.end())
+		if (!this->HasProgress(Quest::ProgressDailyCount))
 		{
 			this->character->ResetQuest(this->quest->ID());
 		}
@@ -464,21 +844,24 @@ bool Quest_Context::DoAction(const EOPlus::Action &action)
 		return true;
 		// *this may not be valid after this point
 	}
-	else if (function_name == "resetdaily")
+
+	case QUEST_ACTION_RESETDAILY:
 	{
-		this->progress["d"] = quest_day();
-		++this->progress["c"];
+		this->SetProgress(Quest::ProgressDailyDay, quest_day());
+		this->SetProgress(Quest::ProgressDailyCount, this->GetProgress(Quest::ProgressDailyCount) + 1);
 		this->SetState("done");
 		return true;
 	}
-	else if (function_name == "end")
+
+	case QUEST_ACTION_END:
 	{
 		this->SetState("end");
 		return true;
 	}
-	else if (function_name == "startquest")
+
+	case QUEST_ACTION_STARTQUEST:
 	{
-		short id = int(action.expr.args[0]);
+		short id = action.expr.int_args[0];
 
 		auto context = character->GetQuest(id);
 
@@ -500,16 +883,18 @@ bool Quest_Context::DoAction(const EOPlus::Action &action)
 			context->SetState(action.expr.args.size() >= 2 ? std::string(action.expr.args[1]) : "begin");
 		}
 	}
-	else if (function_name == "resetquest")
+	break;
+
+	case QUEST_ACTION_RESETQUEST:
 	{
 		short this_id = this->quest->ID();
-		short id = int(action.expr.args[0]);
+		short id = action.expr.int_args[0];
 
 		auto context = this->character->GetQuest(id);
 
 		if (context)
 		{
-			if (this->progress.find("c") == this->progress.end())
+			if (!this->HasProgress(Quest::ProgressDailyCount))
 				context->SetState("done");
 			else
 				this->character->ResetQuest(id);
@@ -521,10 +906,12 @@ bool Quest_Context::DoAction(const EOPlus::Action &action)
 			// *this is not valid after this point
 		}
 	}
-	else if (function_name == "setqueststate")
+	break;
+
+	case QUEST_ACTION_SETQUESTSTATE:
 	{
 		short this_id = this->quest->ID();
-		short id = int(action.expr.args[0]);
+		short id = action.expr.int_args[0];
 		std::string state = std::string(action.expr.args[1]);
 
 		// WARNING: holds a non-tracked reference to shared_ptr
@@ -538,25 +925,29 @@ bool Quest_Context::DoAction(const EOPlus::Action &action)
 				return true;
 		}
 	}
-	else if (function_name == "showhint")
-	{
+	break;
+
+	case QUEST_ACTION_SHOWHINT:
 		this->character->StatusMsg(action.expr.args[0]);
-	}
-	else if (function_name == "quake")
+		break;
+
+	case QUEST_ACTION_QUAKE:
 	{
 		int strength = 5;
 
 		if (action.expr.args.size() >= 1)
-			strength = std::max(1, std::min(8, int(action.expr.args[0])));
+			strength = std::max(1, std::min(8, action.expr.int_args[0]));
 
 		this->character->map->Effect(MAP_EFFECT_QUAKE, strength);
 	}
-	else if (function_name == "quakeworld")
+	break;
+
+	case QUEST_ACTION_QUAKEWORLD:
 	{
 		int strength = 5;
 
 		if (action.expr.args.size() >= 1)
-			strength = std::max(1, std::min(8, int(action.expr.args[0])));
+			strength = std::max(1, std::min(8, action.expr.int_args[0]));
 
 		UTIL_FOREACH(this->character->world->maps, map)
 		{
@@ -564,28 +955,30 @@ bool Quest_Context::DoAction(const EOPlus::Action &action)
 				map->Effect(MAP_EFFECT_QUAKE, strength);
 		}
 	}
-	else if (function_name == "setmap" || function_name == "setcoord")
-	{
-		this->character->Warp(int(action.expr.args[0]), int(action.expr.args[1]), int(action.expr.args[2]));
-	}
-	else if (function_name == "playsound")
-	{
-		this->character->PlaySound(int(action.expr.args[0]));
-	}
-	else if (function_name == "giveexp")
+	break;
+
+	case QUEST_ACTION_SETCOORD:
+		this->character->Warp(action.expr.int_args[0], action.expr.int_args[1], action.expr.int_args[2]);
+		break;
+
+	case QUEST_ACTION_PLAYSOUND:
+		this->character->PlaySound(action.expr.int_args[0]);
+		break;
+
+	case QUEST_ACTION_GIVEEXP:
 	{
 		bool level_up = false;
 
-		this->character->exp += int(action.expr.args[0]);
+		this->character->exp += action.expr.int_args[0];
 
-		this->character->exp = std::min(this->character->exp, int(this->character->map->world->config["MaxExp"]));
+		this->character->exp = std::min(this->character->exp, this->character->map->world->settings.GetInt(ConfigKey::MaxExp));
 
-		while (this->character->level < int(this->character->map->world->config["MaxLevel"]) && this->character->exp >= this->character->map->world->exp_table[this->character->level + 1])
+		while (this->character->level < this->character->map->world->settings.GetInt(ConfigKey::MaxLevel) && this->character->exp >= this->character->map->world->exp_table[this->character->level + 1])
 		{
 			level_up = true;
 			++this->character->level;
-			this->character->statpoints += int(this->character->map->world->config["StatPerLevel"]);
-			this->character->skillpoints += int(this->character->map->world->config["SkillPerLevel"]);
+			this->character->statpoints += this->character->map->world->settings.GetInt(ConfigKey::StatPerLevel);
+			this->character->skillpoints += this->character->map->world->settings.GetInt(ConfigKey::SkillPerLevel);
 			this->character->CalculateStats();
 		}
 
@@ -615,10 +1008,12 @@ bool Quest_Context::DoAction(const EOPlus::Action &action)
 			}
 		}
 	}
-	else if (function_name == "giveitem")
+	break;
+
+	case QUEST_ACTION_GIVEITEM:
 	{
-		int id = int(action.expr.args[0]);
-		int amount = (action.expr.args.size() >= 2) ? int(action.expr.args[1]) : 1;
+		int id = action.expr.int_args[0];
+		int amount = (action.expr.args.size() >= 2) ? action.expr.int_args[1] : 1;
 
 		if (this->character->AddItem(id, amount))
 		{
@@ -642,10 +1037,12 @@ bool Quest_Context::DoAction(const EOPlus::Action &action)
 			}
 		}
 	}
-	else if (function_name == "removeitem")
+	break;
+
+	case QUEST_ACTION_REMOVEITEM:
 	{
-		int id = int(action.expr.args[0]);
-		int amount = (action.expr.args.size() >= 2) ? int(action.expr.args[1]) : 1;
+		int id = action.expr.int_args[0];
+		int amount = (action.expr.args.size() >= 2) ? action.expr.int_args[1] : 1;
 
 		if (this->character->DelItem(id, amount))
 		{
@@ -656,41 +1053,27 @@ bool Quest_Context::DoAction(const EOPlus::Action &action)
 			this->character->Send(builder);
 		}
 	}
-	else if (function_name == "setclass")
+	break;
+
+	case QUEST_ACTION_SETCLASS:
 	{
-		this->character->clas = int(action.expr.args[0]);
+		this->character->clas = action.expr.int_args[0];
 
 		this->character->CalculateStats();
-
-		PacketBuilder builder(PACKET_RECOVER, PACKET_LIST, 32);
-
-		builder.AddShort(this->character->clas);
-		builder.AddShort(this->character->display_str);
-		builder.AddShort(this->character->display_intl);
-		builder.AddShort(this->character->display_wis);
-		builder.AddShort(this->character->display_agi);
-		builder.AddShort(this->character->display_con);
-		builder.AddShort(this->character->display_cha);
-		builder.AddShort(this->character->maxhp);
-		builder.AddShort(this->character->maxtp);
-		builder.AddShort(this->character->maxsp);
-		builder.AddShort(this->character->maxweight);
-		builder.AddShort(this->character->mindam);
-		builder.AddShort(this->character->maxdam);
-		builder.AddShort(this->character->accuracy);
-		builder.AddShort(this->character->evade);
-		builder.AddShort(this->character->armor);
-
-		this->character->Send(builder);
+		this->character->SendStats();
 	}
-	else if (function_name == "setrace")
+	break;
+
+	case QUEST_ACTION_SETRACE:
 	{
-		this->character->race = Skin(int(action.expr.args[0]));
+		this->character->race = Skin(action.expr.int_args[0]);
 		this->character->Warp(this->character->map->id, this->character->x, this->character->y);
 	}
-	else if (function_name == "removekarma")
+	break;
+
+	case QUEST_ACTION_REMOVEKARMA:
 	{
-		this->character->karma -= int(action.expr.args[0]);
+		this->character->karma -= action.expr.int_args[0];
 
 		if (this->character->karma < 0)
 			this->character->karma = 0;
@@ -701,9 +1084,11 @@ bool Quest_Context::DoAction(const EOPlus::Action &action)
 		builder.AddChar(0);
 		this->character->Send(builder);
 	}
-	else if (function_name == "givekarma")
+	break;
+
+	case QUEST_ACTION_GIVEKARMA:
 	{
-		this->character->karma += int(action.expr.args[0]);
+		this->character->karma += action.expr.int_args[0];
 
 		if (this->character->karma > 2000)
 			this->character->karma = 2000;
@@ -714,52 +1099,63 @@ bool Quest_Context::DoAction(const EOPlus::Action &action)
 		builder.AddChar(0);
 		this->character->Send(builder);
 	}
-	else if (function_name == "settitle")
-	{
+	break;
+
+	case QUEST_ACTION_SETTITLE:
 		this->character->title = std::string(action.expr.args[0]);
-	}
-	else if (function_name == "setfiance")
-	{
+		break;
+
+	case QUEST_ACTION_SETFIANCE:
 		this->character->fiance = std::string(action.expr.args[0]);
-	}
-	else if (function_name == "setpartner")
-	{
+		break;
+
+	case QUEST_ACTION_SETPARTNER:
 		this->character->partner = std::string(action.expr.args[0]);
-	}
-	else if (function_name == "sethome")
-	{
+		break;
+
+	case QUEST_ACTION_SETHOME:
 		this->character->home = std::string(action.expr.args[0]);
-	}
-	else if (function_name == "setstat")
+		break;
+
+	case QUEST_ACTION_SETSTAT:
 	{
 		std::string stat = action.expr.args[0];
-		int value = action.expr.args[1];
+		int value = action.expr.int_args[1];
 
 		if (!modify_stat(stat, [value](int)
 						 { return value; }, this->character))
 			throw EOPlus::Runtime_Error("Unknown stat: " + stat);
 	}
-	else if (function_name == "givestat")
+	break;
+
+	case QUEST_ACTION_GIVESTAT:
 	{
 		std::string stat = action.expr.args[0];
-		int value = action.expr.args[1];
+		int value = action.expr.int_args[1];
 
 		if (!modify_stat(stat, [value](int x)
 						 { return x + value; }, this->character))
 			throw EOPlus::Runtime_Error("Unknown stat: " + stat);
 	}
-	else if (function_name == "removestat")
+	break;
+
+	case QUEST_ACTION_REMOVESTAT:
 	{
 		std::string stat = action.expr.args[0];
-		int value = action.expr.args[1];
+		int value = action.expr.int_args[1];
 
 		if (!modify_stat(stat, [value](int x)
 						 { return x - value; }, this->character))
 			throw EOPlus::Runtime_Error("Unknown stat: " + stat);
 	}
-	else if (function_name == "roll")
-	{
-		this->progress["r"] = util::rand(1, int(action.expr.args[0]));
+	break;
+
+	case QUEST_ACTION_ROLL:
+		this->SetProgress(Quest::ProgressRoll, util::rand(1, action.expr.int_args[0]));
+		break;
+
+	default:
+		break;
 	}
 
 	return false;
@@ -767,8 +1163,12 @@ bool Quest_Context::DoAction(const EOPlus::Action &action)
 
 static bool rpn_char_eval(std::stack<std::string> &&s, Character *character)
 {
+	Formula_Frame frame;
+	character->FormulaVars(frame);
+
 	std::unordered_map<std::string, double> formula_vars;
-	character->FormulaVars(formula_vars);
+	frame.Export(formula_vars);
+
 	return bool(util::rpn_eval(s, formula_vars));
 }
 
@@ -779,122 +1179,122 @@ static bool rpn_char_eval(std::deque<std::string> &&dq, Character *character)
 	return rpn_char_eval(std::move(s), character);
 }
 
+bool Quest_Context::CheckRules(QuestTrigger trigger, short key)
+{
+	const EOPlus::State *state = this->GetState();
+
+	if (!state)
+		return EOPlus::Context::CheckRules();
+
+	std::vector<std::size_t> rules;
+	this->quest->TriggeredRules(state, trigger, key, rules);
+
+	if (rules.empty())
+		return false;
+
+	return EOPlus::Context::CheckRules(rules);
+}
+
 bool Quest_Context::CheckRule(const EOPlus::Expression &expr)
 {
 	if (this->quest->Disabled())
 		return false;
 
-	std::string function_name = expr.function;
-
-	if (function_name == "always")
+	switch (Quest_Rule_Op(expr.op))
 	{
+	case QUEST_RULE_ALWAYS:
 		return true;
-	}
-	else if (function_name == "donedaily")
+
+	case QUEST_RULE_DONEDAILY:
 	{
-		if (this->progress["d"] == quest_day())
+		if (this->GetProgress(Quest::ProgressDailyDay) == quest_day())
 		{
-			return this->progress["c"] >= int(expr.args[0]);
+			return this->GetProgress(Quest::ProgressDailyCount) >= expr.int_args[0];
 		}
 		else
 		{
-			this->progress["d"] = quest_day();
-			this->progress["c"] = 0;
+			this->SetProgress(Quest::ProgressDailyDay, quest_day());
+			this->SetProgress(Quest::ProgressDailyCount, 0);
 			return false;
 		}
 	}
-	else if (function_name == "entermap")
-	{
-		return this->character->map->id == int(expr.args[0]);
-	}
-	else if (function_name == "entercoord")
-	{
-		return this->character->map->id == int(expr.args[0]) && this->character->x == int(expr.args[1]) && this->character->y == int(expr.args[2]);
-	}
-	else if (function_name == "leavemap")
-	{
-		return this->character->map->id != int(expr.args[0]);
-	}
-	else if (function_name == "leavecoord")
-	{
-		return this->character->map->id != int(expr.args[0]) || this->character->x != int(expr.args[1]) || this->character->y != int(expr.args[2]);
-	}
-	else if (function_name == "gotitems")
-	{
-		return this->character->HasItem(int(expr.args[0])) >= (expr.args.size() >= 2 ? int(expr.args[1]) : 1);
-	}
-	else if (function_name == "lostitems")
-	{
-		return this->character->HasItem(int(expr.args[0])) < (expr.args.size() >= 2 ? int(expr.args[1]) : 1);
-	}
-	else if (function_name == "gotspell")
-	{
-		return this->character->HasSpell(int(expr.args[0])) && (expr.args.size() < 2 || this->character->SpellLevel(int(expr.args[0])) >= int(expr.args[1]));
-	}
-	else if (function_name == "lostspell")
-	{
-		return !this->character->HasSpell(int(expr.args[0]));
-	}
-	else if (function_name == "isgender")
-	{
-		return this->character->gender == Gender(int(expr.args[0]));
-	}
-	else if (function_name == "isclass")
-	{
-		return this->character->clas == int(expr.args[0]);
-	}
-	else if (function_name == "israce")
-	{
-		return this->character->race == int(expr.args[0]);
-	}
-	else if (function_name == "iswearing")
-	{
-		return std::find(UTIL_CRANGE(this->character->paperdoll), int(expr.args[0])) != this->character->paperdoll.end();
-	}
-	else if (function_name == "citizenof")
-	{
+
+	case QUEST_RULE_ENTERMAP:
+		return this->character->map->id == expr.int_args[0];
+
+	case QUEST_RULE_ENTERCOORD:
+		return this->character->map->id == expr.int_args[0] && this->character->x == expr.int_args[1] && this->character->y == expr.int_args[2];
+
+	case QUEST_RULE_LEAVEMAP:
+		return this->character->map->id != expr.int_args[0];
+
+	case QUEST_RULE_LEAVECOORD:
+		return this->character->map->id != expr.int_args[0] || this->character->x != expr.int_args[1] || this->character->y != expr.int_args[2];
+
+	case QUEST_RULE_GOTITEMS:
+		return this->character->HasItem(expr.int_args[0]) >= (expr.args.size() >= 2 ? expr.int_args[1] : 1);
+
+	case QUEST_RULE_LOSTITEMS:
+		return this->character->HasItem(expr.int_args[0]) < (expr.args.size() >= 2 ? expr.int_args[1] : 1);
+
+	case QUEST_RULE_GOTSPELL:
+		return this->character->HasSpell(expr.int_args[0]) && (expr.args.size() < 2 || this->character->SpellLevel(expr.int_args[0]) >= expr.int_args[1]);
+
+	case QUEST_RULE_LOSTSPELL:
+		return !this->character->HasSpell(expr.int_args[0]);
+
+	case QUEST_RULE_ISGENDER:
+		return this->character->gender == Gender(expr.int_args[0]);
+
+	case QUEST_RULE_ISCLASS:
+		return this->character->clas == expr.int_args[0];
+
+	case QUEST_RULE_ISRACE:
+		return this->character->race == expr.int_args[0];
+
+	case QUEST_RULE_ISWEARING:
+		return std::find(UTIL_CRANGE(this->character->paperdoll), expr.int_args[0]) != this->character->paperdoll.end();
+
+	case QUEST_RULE_CITIZENOF:
 		return this->character->home == std::string(expr.args[0]);
-	}
-	else if (function_name == "rolled")
+
+	case QUEST_RULE_ROLLED:
 	{
-		int roll = this->progress["r"];
+		int roll = this->GetProgress(Quest::ProgressRoll);
 
 		if (expr.args.size() < 2)
 		{
-			return roll == int(expr.args[0]);
+			return roll == expr.int_args[0];
 		}
 		else
 		{
-			return roll >= int(expr.args[0]) && roll <= int(expr.args[1]);
+			return roll >= expr.int_args[0] && roll <= expr.int_args[1];
 		}
 	}
-	else if (function_name == "statis")
-	{
+
+	case QUEST_RULE_STATIS:
 		return rpn_char_eval({expr.args[1], expr.args[0], "="}, character);
-	}
-	else if (function_name == "statnot")
-	{
+
+	case QUEST_RULE_STATNOT:
 		return rpn_char_eval({expr.args[1], expr.args[0], "="}, character);
-	}
-	else if (function_name == "statgreater")
-	{
+
+	case QUEST_RULE_STATGREATER:
 		return rpn_char_eval({expr.args[1], expr.args[0], ">"}, character);
-	}
-	else if (function_name == "statless")
-	{
+
+	case QUEST_RULE_STATLESS:
 		return rpn_char_eval({expr.args[1], expr.args[0], "<"}, character);
-	}
-	else if (function_name == "statbetween")
-	{
+
+	case QUEST_RULE_STATBETWEEN:
 		return rpn_char_eval({expr.args[1], expr.args[0], "gte", expr.args[2], expr.args[0], "lte", "and"}, character);
-	}
-	else if (function_name == "statrpn")
-	{
+
+	case QUEST_RULE_STATRPN:
 		return rpn_char_eval(util::rpn_parse(expr.args[0]), character);
-	}
-	else if (function_name == "stateval")
-	{
+
+	case QUEST_RULE_STATEVAL:
 		return rpn_char_eval(util::rpn_parse_v2(expr.args[0]), character);
+
+	default:
+		break;
 	}
 
 	return false;
@@ -927,7 +1327,7 @@ std::string Quest_Context::Desc() const
 Quest_Context::ProgressInfo Quest_Context::Progress() const
 {
 	BookIcon icon = BOOK_ICON_TALK;
-	std::string goal_progress_key;
+	int goal_slot = -1;
 	short goal_progress = 0;
 	short goal_goal = 0;
 
@@ -935,43 +1335,50 @@ Quest_Context::ProgressInfo Quest_Context::Progress() const
 
 	if (goal)
 	{
-		if (goal->expr.function == "gotitems" || goal->expr.function == "gotspell")
+		const EOPlus::Expression &expr = goal->expr;
+
+		switch (Quest_Rule_Op(expr.op))
 		{
+		case QUEST_RULE_GOTITEMS:
+		case QUEST_RULE_GOTSPELL:
 			icon = BOOK_ICON_ITEM;
-			goal_progress = std::min<int>(goal->expr.args[1], this->character->HasItem(int(goal->expr.args[0])));
-			goal_goal = goal->expr.args.size() >= 2 ? int(goal->expr.args[1]) : 1;
-		}
-		else if (goal->expr.function == "useditem" || goal->expr.function == "usedspell")
-		{
+			goal_goal = expr.int_args.size() >= 2 ? expr.int_args[1] : 1;
+			goal_progress = std::min<int>(goal_goal, this->character->HasItem(expr.int_args[0]));
+			break;
+
+		case QUEST_RULE_USEDITEM:
+		case QUEST_RULE_USEDSPELL:
 			icon = BOOK_ICON_ITEM;
-			goal_progress_key = goal->expr.function + "/" + std::string(goal->expr.args[0]);
-			goal_goal = goal->expr.args.size() >= 2 ? int(goal->expr.args[1]) : 1;
-		}
-		else if (goal->expr.function == "killednpcs")
-		{
+			goal_slot = this->quest->CounterSlot(expr.op, expr.int_args[0]);
+			goal_goal = expr.int_args.size() >= 2 ? expr.int_args[1] : 1;
+			break;
+
+		case QUEST_RULE_KILLEDNPCS:
 			icon = BOOK_ICON_KILL;
-			goal_progress_key = goal->expr.function + "/" + std::string(goal->expr.args[0]);
-			goal_goal = goal->expr.args.size() >= 2 ? int(goal->expr.args[1]) : 1;
-		}
-		else if (goal->expr.function == "killedplayers")
-		{
+			goal_slot = this->quest->CounterSlot(expr.op, expr.int_args[0]);
+			goal_goal = expr.int_args.size() >= 2 ? expr.int_args[1] : 1;
+			break;
+
+		case QUEST_RULE_KILLEDPLAYERS:
 			icon = BOOK_ICON_KILL;
-			goal_progress_key = goal->expr.function;
-			goal_goal = int(goal->expr.args[0]);
-		}
-		else if (goal->expr.function == "entercoord" || goal->expr.function == "leavecoord" || goal->expr.function == "entermap" || goal->expr.function == "leavemap")
-		{
+			goal_slot = this->quest->CounterSlot(expr.op, 0);
+			goal_goal = expr.int_args[0];
+			break;
+
+		case QUEST_RULE_ENTERCOORD:
+		case QUEST_RULE_LEAVECOORD:
+		case QUEST_RULE_ENTERMAP:
+		case QUEST_RULE_LEAVEMAP:
 			icon = BOOK_ICON_STEP;
+			break;
+
+		default:
+			break;
 		}
 	}
 
-	if (!goal_progress_key.empty())
-	{
-		auto it = this->progress.find(goal_progress_key);
-
-		if (it != this->progress.end())
-			goal_progress = it->second;
-	}
+	if (goal_slot != -1)
+		goal_progress = this->GetProgress(goal_slot);
 
 	return ProgressInfo{icon, goal_progress, goal_goal};
 }
@@ -980,16 +1387,27 @@ std::string Quest_Context::SerializeProgress() const
 {
 	std::string serialized = "{";
 
-	UTIL_CIFOREACH(this->progress, it)
+	for (std::size_t i = 0; i < this->progress.size(); ++i)
 	{
-		serialized += it->first;
+		if (!this->progress_set[i])
+			continue;
+
+		if (serialized.length() > 1)
+			serialized += ",";
+
+		serialized += this->quest->ProgressName(i);
 		serialized += "=";
-		serialized += util::to_string(it->second);
+		serialized += util::to_string(this->progress[i]);
+	}
 
-		if (it != std::prev(this->progress.cend()))
-		{
+	UTIL_FOREACH(this->progress_extra, extra)
+	{
+		if (serialized.length() > 1)
 			serialized += ",";
-		}
+
+		serialized += extra.first;
+		serialized += "=";
+		serialized += util::to_string(extra.second);
 	}
 
 	serialized += "}";
@@ -1008,6 +1426,16 @@ std::string::const_iterator Quest_Context::UnserializeProgress(std::string::cons
 	short value = 0;
 	int state = 0;
 
+	auto store = [&](const std::string &key, short value)
+	{
+		int slot = this->quest->ProgressSlot(key);
+
+		if (slot != -1)
+			this->SetProgress(slot, value);
+		else
+			this->progress_extra[key] = value;
+	};
+
 	for (; it != end && *it != '}'; ++it)
 	{
 		if (state == 0) // Reading key
@@ -1025,7 +1453,7 @@ std::string::const_iterator Quest_Context::UnserializeProgress(std::string::cons
 		{
 			if (*it == ',')
 			{
-				this->progress[key] = value;
+				store(key, value);
 				key = "";
 				value = 0;
 				state = 0;
@@ -1039,7 +1467,7 @@ std::string::const_iterator Quest_Context::UnserializeProgress(std::string::cons
 	}
 
 	if (state == 1)
-		this->progress[key] = value;
+		store(key, value);
 
 	if (it != end)
 		++it;
@@ -1052,8 +1480,8 @@ bool Quest_Context::DialogInput(char link_id)
 	if (this->quest->Disabled())
 		return false;
 
-	return this->TriggerRule("inputnpc", [link_id](const std::deque<util::variant> &args)
-							 { return int(args[0]) == link_id; });
+	return this->TriggerRule(QUEST_RULE_INPUTNPC, [link_id](const EOPlus::Expression &expr)
+							 { return expr.int_args[0] == link_id; });
 }
 
 bool Quest_Context::TalkedNPC(char vendor_id)
@@ -1061,75 +1489,60 @@ bool Quest_Context::TalkedNPC(char vendor_id)
 	if (this->quest->Disabled())
 		return false;
 
-	return this->TriggerRule("talkedtonpc", [vendor_id](const std::deque<util::variant> &args)
-							 { return int(args[0]) == vendor_id; });
+	return this->TriggerRule(QUEST_RULE_TALKEDTONPC, [vendor_id](const EOPlus::Expression &expr)
+							 { return expr.int_args[0] == vendor_id; });
 }
 
-void Quest_Context::UsedItem(short id)
+void Quest_Context::CountEvent(int op, short id)
 {
 	if (this->quest->Disabled())
 		return;
 
-	bool check = this->QueryRule("useditem", [id](const std::deque<util::variant> &args)
-								 { return int(args[0]) == id; });
-	short amount = 0;
+	// killedplayers counts every kill, the others only events with a matching ID
+	bool any_id = (op == QUEST_RULE_KILLEDPLAYERS);
+	int slot = this->quest->CounterSlot(op, any_id ? 0 : id);
 
-	if (check)
-		amount = ++this->progress["useditem/" + util::to_string(id)];
-
-	if (this->TriggerRule("useditem", [id, amount](const std::deque<util::variant> &args)
-						  { return int(args[0]) == id && amount >= int(args[1]); }))
-		this->progress.erase("useditem/" + util::to_string(id));
-}
-
-void Quest_Context::UsedSpell(short id)
-{
-	if (this->quest->Disabled())
+	if (slot == -1)
 		return;
 
-	bool check = this->QueryRule("usedspell", [id](const std::deque<util::variant> &args)
-								 { return int(args[0]) == id; });
+	bool check = this->QueryRule(op, [id, any_id](const EOPlus::Expression &expr)
+								 { return any_id || expr.int_args[0] == id; });
 	short amount = 0;
 
 	if (check)
-		amount = ++this->progress["usedspell/" + util::to_string(id)];
+	{
+		amount = this->GetProgress(slot) + 1;
+		this->SetProgress(slot, amount);
+	}
+
+	if (this->TriggerRule(op, [id, any_id, amount](const EOPlus::Expression &expr)
+						  {
+							  if (any_id)
+								  return amount >= expr.int_args[0];
 
-	if (this->TriggerRule("usedspell", [id, amount](const std::deque<util::variant> &args)
-						  { return int(args[0]) == id && amount >= int(args[1]); }))
-		this->progress.erase("usedspell/" + util::to_string(id));
+							  return expr.int_args[0] == id && amount >= (expr.int_args.size() >= 2 ? expr.int_args[1] : 1);
+						  }))
+		this->ClearProgress(slot);
 }
 
-void Quest_Context::KilledNPC(short id)
+void Quest_Context::UsedItem(short id)
 {
-	if (this->quest->Disabled())
-		return;
-
-	bool check = this->QueryRule("killednpcs", [id](const std::deque<util::variant> &args)
-								 { return int(args[0]) == id; });
-	short amount = 0;
+	this->CountEvent(QUEST_RULE_USEDITEM, id);
+}
 
-	if (check)
-		amount = ++this->progress["killednpcs/" + util::to_string(id)];
+void Quest_Context::UsedSpell(short id)
+{
+	this->CountEvent(QUEST_RULE_USEDSPELL, id);
+}
 
-	if (this->TriggerRule("killednpcs", [id, amount](const std::deque<util::variant> &args)
-						  { return int(args[0]) == id && amount >= int(args[1]); }))
-		this->progress.erase("killednpcs/" + util::to_string(id));
+void Quest_Context::KilledNPC(short id)
+{
+	this->CountEvent(QUEST_RULE_KILLEDNPCS, id);
 }
 
 void Quest_Context::KilledPlayer()
 {
-	if (this->quest->Disabled())
-		return;
-
-	bool check = this->QueryRule("killedplayers");
-	short amount = 0;
-
-	if (check)
-		amount = ++this->progress["killedplayers"];
-
-	if (this->TriggerRule("killedplayers", [amount](const std::deque<util::variant> &args)
-						  { return amount >= int(args[0]); }))
-		this->progress.erase("killedplayers");
+	this->CountEvent(QUEST_RULE_KILLEDPLAYERS, 0);
 }
 
 bool Quest_Context::IsHidden() const
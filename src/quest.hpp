@@ -11,11 +11,15 @@
 #include "fwd/character.hpp"
 #include "fwd/dialog.hpp"
 #include "fwd/world.hpp"
+#include "eoplus/cache.hpp"
 #include "eoplus/context.hpp"
 
+#include <cstddef>
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 class Quest
 {
@@ -24,10 +28,60 @@ private:
 	const EOPlus::Quest *quest;
 	short id;
 
-	void Load();
+	EOPlus::Source_Key source;
+
+	/**
+	 * A state's rules grouped by what could change their result, as ascending indexes into State::rules
+	 * Rules that don't depend on any one trigger (always, donedaily, rolled, ...) go in other and are checked on every trigger.
+	 */
+	struct Rule_Index
+	{
+		std::unordered_map<short, std::vector<std::size_t>> items;
+		std::unordered_map<short, std::vector<std::size_t>> spells;
+		std::unordered_map<short, std::vector<std::size_t>> maps;
+		std::vector<std::size_t> leave;
+		std::vector<std::size_t> character;
+		std::vector<std::size_t> other;
+	};
+
+	std::unordered_map<const EOPlus::State *, Rule_Index> rule_index;
+
+	std::vector<std::string> progress_names;
+	std::unordered_map<std::string, int> progress_slots;
+	std::unordered_map<int, int> counter_slots;
+
+	void Load(const std::string &quest_dir, bool use_cache);
+	void IndexRules();
+	void IndexProgress();
+
+	/**
+	 * Checks if the file at filename is still the one this quest was loaded from
+	 */
+	bool SourceUnchanged(const std::string &filename, const EOPlus::Source_Key &stat);
 
 public:
-	Quest(short id, World *world);
+	/**
+	 * Progress slots every quest has, the event counters of its rules are numbered after them
+	 */
+	enum ProgressSlot
+	{
+		ProgressDailyDay,
+		ProgressDailyCount,
+		ProgressRoll,
+		ProgressFixedSlots
+	};
+
+	/**
+	 * Loads the quests with the given IDs on a pool of worker threads, skipping IDs with no .eqf file
+	 * Quests in previous whose source is unchanged are carried over as-is instead of being reloaded.
+	 */
+	static std::map<short, std::shared_ptr<Quest>> LoadAll(World *world, const std::vector<short> &ids, const std::map<short, std::shared_ptr<Quest>> &previous = {});
+
+	/**
+	 * Loads quest_dir/<id>.eqf, going through the compiled <id>.eqc next to it when use_cache is set
+	 * @throw std::runtime_error
+	 */
+	Quest(short id, World *world, const std::string &quest_dir, bool use_cache);
 
 	const EOPlus::Quest *GetQuest() const { return quest; }
 
@@ -35,6 +89,28 @@ public:
 	std::string Name() const;
 	bool Disabled() const;
 
+	/**
+	 * Collects the rules of a state that a trigger could flip, in rule order
+	 */
+	void TriggeredRules(const EOPlus::State *state, QuestTrigger trigger, short key, std::vector<std::size_t> &rules) const;
+
+	std::size_t ProgressSlots() const { return this->progress_names.size(); }
+
+	/**
+	 * Name a progress slot is saved under, such as "c" or "killednpcs/12"
+	 */
+	const std::string &ProgressName(int slot) const { return this->progress_names[slot]; }
+
+	/**
+	 * Looks up a progress slot by its saved name, returns -1 if this quest has no such counter
+	 */
+	int ProgressSlot(const std::string &name) const;
+
+	/**
+	 * Looks up the slot counting events for a useditem, usedspell, killednpcs or killedplayers rule, returns -1 if there is none
+	 */
+	int CounterSlot(int op, short id) const;
+
 	~Quest();
 };
 
@@ -55,7 +131,18 @@ private:
 	std::string state_desc;
 	std::map<short, std::shared_ptr<Dialog>> dialogs;
 
-	std::map<std::string, short> progress;
+	std::vector<short> progress;
+	std::vector<bool> progress_set;
+
+	// Saved counters this version of the quest has no slot for, kept until the next state change
+	std::map<std::string, short> progress_extra;
+
+	bool HasProgress(int slot) const;
+	short GetProgress(int slot) const;
+	void SetProgress(int slot, short value);
+	void ClearProgress(int slot);
+
+	void CountEvent(int op, short id);
 
 protected:
 	void BeginState(const std::string &name, const EOPlus::State &state);
@@ -65,6 +152,13 @@ protected:
 public:
 	Quest_Context(Character *character, const Quest *quest);
 
+	using EOPlus::Context::CheckRules;
+
+	/**
+	 * Checks only the rules of the current state that the trigger could flip
+	 */
+	bool CheckRules(QuestTrigger trigger, short key);
+
 	const Quest *GetQuest() const;
 	const Dialog *GetDialog(short id) const;
 
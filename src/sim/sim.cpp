@@ -0,0 +1,425 @@
+/* sim/sim.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "../capture.hpp"
+#include "../character.hpp"
+#include "../config.hpp"
+#include "../database.hpp"
+#include "../eoclient.hpp"
+#include "../eoserv_config.hpp"
+#include "../eoserver.hpp"
+#include "../hash.hpp"
+#include "../map.hpp"
+#include "../npc.hpp"
+#include "../packet.hpp"
+#include "../password_hasher.hpp"
+#include "../timer.hpp"
+#include "../world.hpp"
+
+#include "../console.hpp"
+#include "../socket.hpp"
+#include "../socket_impl.hpp"
+#include "../util.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Normally defined in main.cpp, which isn't linked in to the simulator
+volatile std::sig_atomic_t eoserv_sig_abort = false;
+
+struct Sim_Options
+{
+	std::string capture;
+	std::string database = "sim.sdb";
+	unsigned int seed = 1;
+
+	/**
+	 * Simulated time between server ticks
+	 */
+	double step = 0.01;
+
+	/**
+	 * Simulated time to keep running for after the last record
+	 */
+	double settle = 5.0;
+
+	/**
+	 * Simulated seconds per real second, or 0 to run as fast as possible
+	 */
+	double speed = 0.0;
+
+	/**
+	 * Sets every account's password to the one the recorder writes in place of the real ones
+	 */
+	bool reset_passwords = false;
+};
+
+/**
+ * A server fed from a capture, with no sockets and a clock that only moves between ticks
+ */
+struct Sim_State
+{
+	EOServer *server;
+	Manual_Clock *clock;
+	double step;
+	double speed;
+
+	/**
+	 * Where the clock and the wall clock were when the replay started, for pacing it
+	 */
+	double sim_start = 0.0;
+	std::chrono::steady_clock::time_point wall_start;
+
+	/**
+	 * Clients created for the capture's client IDs
+	 */
+	std::map<unsigned short, EOClient *> clients;
+
+	std::uint64_t ticks = 0;
+	std::uint64_t packets = 0;
+	std::uint64_t skipped = 0;
+	std::uint64_t bytes_sent = 0;
+
+	/**
+	 * Running hash of everything the server sent, in the order it was sent
+	 */
+	std::string output_hash;
+};
+
+static void sim_usage()
+{
+	std::puts(
+		"Usage: eoserv-sim capture=<file> [option=value ...]\n"
+		"\n"
+		"Runs the server without sockets, feeding it the packets from a capture against a clock that only moves\n"
+		"between ticks. The same capture, database and seed always produce the same world and the same work.\n"
+		"\n"
+		"  capture=               Capture file to replay\n"
+		"  database=sim.sdb       SQLite database to run against, created if it does not exist\n"
+		"  seed=1                 Random seed\n"
+		"  step=10ms              Simulated time between ticks\n"
+		"  settle=5s              Simulated time to keep running after the last record\n"
+		"  speed=0                Replay speed, 1 for the speed it was recorded at, 0 for as fast as possible\n"
+		"  passwords=keep         reset to set every account's password to the one captures are recorded with\n"
+		"\n"
+		"The configuration and data files are read from the working directory, as the server reads them.\n"
+		"The database is modified by the run, so replay against a copy to repeat a run.\n"
+		"Captures are recorded with $capture, with each password replaced by \"capture\". Replaying logins against\n"
+		"a copy of the live database needs passwords=reset.\n"
+	);
+}
+
+static bool sim_parse(int argc, char *argv[], Sim_Options &options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		std::size_t eq = arg.find('=');
+
+		if (eq == std::string::npos)
+			return false;
+
+		std::string key = arg.substr(0, eq);
+		std::string value = arg.substr(eq + 1);
+
+		if (key == "capture")
+			options.capture = value;
+		else if (key == "database")
+			options.database = value;
+		else if (key == "seed")
+			options.seed = unsigned(util::to_int(value));
+		else if (key == "step")
+			options.step = util::tdparse(value);
+		else if (key == "settle")
+			options.settle = util::tdparse(value);
+		else if (key == "speed")
+			options.speed = util::to_float(value);
+		else if (key == "passwords" && (value == "keep" || value == "reset"))
+			options.reset_passwords = (value == "reset");
+		else
+			return false;
+	}
+
+	return !options.capture.empty() && options.step > 0.0 && options.speed >= 0.0;
+}
+
+/**
+ * Gives each of the capture's clients its own address, so per-address connection limits see them as they were recorded
+ */
+static EOClient *sim_connect(Sim_State &sim, unsigned short id)
+{
+	sockaddr_in sin = sockaddr_in();
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(0x0A000000U | id);
+
+	EOClient *client = static_cast<EOClient *>(sim.server->Attach(SocketImpl(INVALID_SOCKET, sin)));
+	sim.clients[id] = client;
+
+	return client;
+}
+
+static std::string sim_short(unsigned int value)
+{
+	std::array<unsigned char, 4> bytes = PacketProcessor::ENumber(value);
+	return std::string{char(bytes[0]), char(bytes[1])};
+}
+
+static void sim_tick(Sim_State &sim)
+{
+	sim.clock->Advance(sim.step);
+
+	if (sim.speed > 0.0)
+		std::this_thread::sleep_until(sim.wall_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+			std::chrono::duration<double>((sim.clock->GetTime() - sim.sim_start) / sim.speed)));
+
+	sim.server->world->timer.Tick();
+	++sim.ticks;
+
+	for (auto it = sim.server->clients.begin(); it != sim.server->clients.end(); )
+	{
+		EOClient *client = static_cast<EOClient *>(*it);
+
+		// Clients answer pings straight away, the recorded answers were to pings sent at other times
+		if (client->Connected() && client->needpong)
+			client->Inject(PACKET_CONNECTION, PACKET_PING, "k");
+
+		std::string sent = client->TakeSendBuffer();
+
+		if (!sent.empty())
+		{
+			sim.bytes_sent += sent.length();
+			sim.output_hash = sha256(sim.output_hash + sent);
+		}
+
+		if (client->Connected())
+		{
+			++it;
+			continue;
+		}
+
+		for (auto id = sim.clients.begin(); id != sim.clients.end(); ++id)
+		{
+			if (id->second == client)
+			{
+				sim.clients.erase(id);
+				break;
+			}
+		}
+
+		delete client;
+		it = sim.server->clients.erase(it);
+	}
+}
+
+static void sim_deliver(Sim_State &sim, const Capture_Record &record)
+{
+	auto it = sim.clients.find(record.client);
+	EOClient *client = (it != sim.clients.end()) ? it->second : 0;
+
+	if (record.type == Capture_Record::Close)
+	{
+		if (client)
+			client->Close();
+
+		return;
+	}
+
+	// A connection starts with its init packet, anything else from an unknown client was sent before the capture started
+	if (!client && record.family == PACKET_F_INIT)
+		client = sim_connect(sim, record.client);
+
+	if (!client)
+	{
+		++sim.skipped;
+		return;
+	}
+
+	if (record.family == PACKET_CONNECTION && record.action == PACKET_PING)
+		return;
+
+	// The client echoes back the encoding and player ID it was given, which differ from the recorded connection's
+	if (record.family == PACKET_CONNECTION && record.action == PACKET_ACCEPT)
+	{
+		std::pair<unsigned char, unsigned char> multis = client->processor.GetEMulti();
+		client->Inject(record.family, record.action, sim_short(multis.second) + sim_short(multis.first) + sim_short(client->id));
+	}
+	else
+	{
+		client->Inject(record.family, record.action, record.payload);
+	}
+
+	++sim.packets;
+}
+
+/**
+ * Hashes the state a replay should reproduce: every character, NPC and item on the ground
+ */
+static std::string sim_world_hash(World *world)
+{
+	std::string state;
+
+	std::vector<Character *> characters(UTIL_RANGE(world->characters));
+
+	std::sort(UTIL_RANGE(characters), [](Character *a, Character *b)
+	{
+		return a->SourceName() < b->SourceName();
+	});
+
+	UTIL_FOREACH(characters, character)
+	{
+		state += character->SourceName() + ':' + util::to_string(character->mapid) + ',' + util::to_string(character->x) + ',' + util::to_string(character->y)
+		       + ',' + util::to_string(int(character->direction)) + ',' + util::to_string(character->level) + ',' + util::to_string(character->exp)
+		       + ',' + util::to_string(character->hp) + ',' + util::to_string(character->tp) + ',' + util::to_string(character->goldbank)
+		       + ',' + ItemSerialize(character->inventory) + ';';
+	}
+
+	UTIL_FOREACH(world->maps, map)
+	{
+		state += "map" + util::to_string(map->id) + ':';
+
+		UTIL_FOREACH(map->npcs, npc)
+		{
+			state += util::to_string(npc->index) + ',' + util::to_string(npc->id) + ',' + util::to_string(int(npc->alive)) + ',' + util::to_string(npc->x)
+			       + ',' + util::to_string(npc->y) + ',' + util::to_string(int(npc->direction)) + ',' + util::to_string(npc->hp) + ';';
+		}
+
+		UTIL_FOREACH(map->items, item)
+		{
+			state += util::to_string(item->uid) + ',' + util::to_string(item->id) + ',' + util::to_string(item->amount) + ',' + util::to_string(item->x)
+			       + ',' + util::to_string(item->y) + ';';
+		}
+	}
+
+	return sha256(state);
+}
+
+int main(int argc, char *argv[])
+{
+	Sim_Options options;
+
+	if (argc >= 2 && (std::string(argv[1]) == "help" || std::string(argv[1]) == "--help" || std::string(argv[1]) == "-h"))
+	{
+		sim_usage();
+		return 0;
+	}
+
+	if (!sim_parse(argc, argv, options))
+	{
+		sim_usage();
+		return 1;
+	}
+
+	Capture_Reader capture;
+
+	if (!capture.Open(options.capture))
+	{
+		Console::Err("Could not read capture file %s", options.capture.c_str());
+		return 1;
+	}
+
+	Sim_State sim;
+	sim.step = options.step;
+	sim.speed = options.speed;
+	sim.clock = new Manual_Clock;
+
+	// Both must be in place before the server creates its timer and its first clients
+	Timer::SetClock(std::unique_ptr<Clock>(sim.clock));
+	util::rand_seed(options.seed);
+
+	Config config;
+	Config aconfig;
+
+	config.Read("config.ini");
+	aconfig.Read("admin.ini");
+
+	eoserv_config_validate_config(config);
+	eoserv_config_validate_admin(aconfig);
+
+	config["DBType"] = "sqlite";
+	config["DBHost"] = options.database;
+	config["DBPoolSize"] = 0;
+	config["SLN"] = false;
+	config["MetricsPort"] = 0;
+
+	// Hashes finish in an order set by the thread scheduler when they run in the background
+	config["PasswordHashThreads"] = 0;
+
+	std::FILE *existing = std::fopen(options.database.c_str(), "rb");
+	bool install = !existing;
+
+	if (existing)
+		std::fclose(existing);
+
+	std::array<std::string, 6> dbinfo;
+	dbinfo[0] = std::string(config["DBType"]);
+	dbinfo[1] = std::string(config["DBHost"]);
+
+	EOServer server(IPAddress("127.0.0.1"), 0, dbinfo, config, aconfig);
+	sim.server = &server;
+
+	if (install)
+	{
+		Console::Out("Installing tables in to %s", options.database.c_str());
+		server.world->CommitDB();
+		server.world->db.ExecuteFile(server.world->settings.GetString(ConfigKey::InstallSQL));
+		server.world->BeginDB();
+	}
+
+	if (options.reset_passwords)
+	{
+		Database_Result accounts = server.world->db.Query("SELECT `username` FROM `accounts`");
+
+		UTIL_FOREACH_CREF(accounts, row)
+		{
+			std::string username = static_cast<std::string>(row["username"]);
+			server.world->SetPasswordHash(username, Password_Hasher::HashPassword(server.world->password_hasher.GetSettings(), username, Capture_Writer::ScrubbedPassword));
+		}
+
+		Console::Out("Reset the passwords of %i accounts", int(accounts.size()));
+	}
+
+	double start = sim.clock->GetTime();
+	sim.sim_start = start;
+	sim.wall_start = std::chrono::steady_clock::now();
+	std::uint64_t records = 0;
+	Capture_Record record;
+
+	while (capture.Read(record))
+	{
+		double at = start + double(record.time) / 1000.0;
+
+		while (sim.clock->GetTime() < at)
+			sim_tick(sim);
+
+		sim_deliver(sim, record);
+		++records;
+	}
+
+	double end = sim.clock->GetTime() + options.settle;
+
+	while (sim.clock->GetTime() < end)
+		sim_tick(sim);
+
+	Console::Out("Replayed %i records over %.2fs of simulated time in %i ticks",
+		int(records), sim.clock->GetTime() - start, int(sim.ticks));
+	Console::Out("  packets injected   %i (%i from clients connected before the capture started were skipped)", int(sim.packets), int(sim.skipped));
+	Console::Out("  timer callbacks    %i", int(server.world->timer.callbacks));
+	Console::Out("  bytes sent         %i", int(sim.bytes_sent));
+	Console::Out("  output hash        %s", sim.output_hash.c_str());
+	Console::Out("  world hash         %s", sim_world_hash(server.world).c_str());
+
+	return 0;
+}
@@ -58,66 +58,66 @@ void SLN::Request()
     request->sln = this;
 
     // Construct the SLN check-in URL
-    request->url += std::string(this->server->world->config["SLNURL"]);
+    request->url += this->server->world->settings.GetString(ConfigKey::SLNURL);
     request->url += "check?software=EOSERV&v=" EOSERV_VERSION_STRING; // Version included
-    request->url += std::string("&retry=") + HTTP::URLEncode(util::to_string(int(this->server->world->config["SLNPeriod"])));
+    request->url += std::string("&retry=") + HTTP::URLEncode(util::to_string(this->server->world->settings.GetInt(ConfigKey::SLNPeriod)));
 
-    if (std::string(this->server->world->config["SLNHost"]).length() > 0)
+    if (this->server->world->settings.GetString(ConfigKey::SLNHost).length() > 0)
     {
-        request->url += std::string("&host=") + HTTP::URLEncode(this->server->world->config["SLNHost"]);
+        request->url += std::string("&host=") + HTTP::URLEncode(this->server->world->settings.GetString(ConfigKey::SLNHost));
     }
 
-    request->url += std::string("&port=") + HTTP::URLEncode(this->server->world->config["Port"]);
-    request->url += std::string("&name=") + HTTP::URLEncode(this->server->world->config["ServerName"]);
+    request->url += std::string("&port=") + HTTP::URLEncode(this->server->world->settings.Display(ConfigKey::Port));
+    request->url += std::string("&name=") + HTTP::URLEncode(this->server->world->settings.GetString(ConfigKey::ServerName));
 
-    if (std::string(this->server->world->config["SLNSite"]).length() > 0)
+    if (this->server->world->settings.GetString(ConfigKey::SLNSite).length() > 0)
     {
-        request->url += std::string("&url=") + HTTP::URLEncode(this->server->world->config["SLNSite"]);
+        request->url += std::string("&url=") + HTTP::URLEncode(this->server->world->settings.GetString(ConfigKey::SLNSite));
     }
 
-    if (std::string(this->server->world->config["SLNZone"]).length() > 0)
+    if (this->server->world->settings.GetString(ConfigKey::SLNZone).length() > 0)
     {
-        request->url += std::string("&zone=") + HTTP::URLEncode(this->server->world->config["SLNZone"]);
+        request->url += std::string("&zone=") + HTTP::URLEncode(this->server->world->settings.GetString(ConfigKey::SLNZone));
     }
 
-    if (this->server->world->config["GlobalPK"])
+    if (this->server->world->settings.GetBool(ConfigKey::GlobalPK))
     {
-        request->url += std::string("&pk=") + HTTP::URLEncode(this->server->world->config["GlobalPK"]);
+        request->url += std::string("&pk=") + HTTP::URLEncode(this->server->world->settings.Display(ConfigKey::GlobalPK));
     }
 
-    if (this->server->world->config["Deadly"])
+    if (this->server->world->settings.GetBool(ConfigKey::Deadly))
     {
-        request->url += std::string("&deadly=") + HTTP::URLEncode(this->server->world->config["Deadly"]);
+        request->url += std::string("&deadly=") + HTTP::URLEncode(this->server->world->settings.Display(ConfigKey::Deadly));
     }
 
-    if (std::string(this->server->world->config["SLNClient"]).length() > 0)
+    if (this->server->world->settings.GetString(ConfigKey::SLNClient).length() > 0)
     {
-        request->url += std::string("&clienturl=") + HTTP::URLEncode(this->server->world->config["SLNClient"]);
+        request->url += std::string("&clienturl=") + HTTP::URLEncode(this->server->world->settings.GetString(ConfigKey::SLNClient));
     }
 
-    if (std::string(this->server->world->config["YouTube"]).length() > 0)
+    if (this->server->world->settings.GetString(ConfigKey::YouTube).length() > 0)
     {
-        request->url += std::string("&youtube=") + HTTP::URLEncode(this->server->world->config["YouTube"]);
+        request->url += std::string("&youtube=") + HTTP::URLEncode(this->server->world->settings.GetString(ConfigKey::YouTube));
     }
 
-    if (std::string(this->server->world->config["FaceBook"]).length() > 0)
+    if (this->server->world->settings.GetString(ConfigKey::FaceBook).length() > 0)
     {
-        request->url += std::string("&facebook=") + HTTP::URLEncode(this->server->world->config["FaceBook"]);
+        request->url += std::string("&facebook=") + HTTP::URLEncode(this->server->world->settings.GetString(ConfigKey::FaceBook));
     }
 
-    if (std::string(this->server->world->config["Twitter"]).length() > 0)
+    if (this->server->world->settings.GetString(ConfigKey::Twitter).length() > 0)
     {
-        request->url += std::string("&twitter=") + HTTP::URLEncode(this->server->world->config["Twitter"]);
+        request->url += std::string("&twitter=") + HTTP::URLEncode(this->server->world->settings.GetString(ConfigKey::Twitter));
     }
 
-    if (std::string(this->server->world->config["Discord"]).length() > 0)
+    if (this->server->world->settings.GetString(ConfigKey::Discord).length() > 0)
     {
-        request->url += std::string("&discord=") + HTTP::URLEncode(this->server->world->config["Discord"]);
+        request->url += std::string("&discord=") + HTTP::URLEncode(this->server->world->settings.GetString(ConfigKey::Discord));
     }
 
-    request->bind = std::string(this->server->world->config["SLNBind"]);
-    request->host = std::string(this->server->world->config["Host"]);
-    request->period = int(this->server->world->config["SLNPeriod"]);
+    request->bind = this->server->world->settings.GetString(ConfigKey::SLNBind);
+    request->host = this->server->world->settings.GetString(ConfigKey::Host);
+    request->period = this->server->world->settings.GetInt(ConfigKey::SLNPeriod);
 
     static pthread_t thread;
 
@@ -188,7 +188,7 @@ void *SLN::RequestThread(void *void_request)
     }
 
 end:
-    TimeEvent *event = new TimeEvent(SLN::TimedCleanup, request, 0.0, 1);
+    TimeEvent *event = new TimeEvent(SLN::TimedCleanup, request, 0.0, 1, "SLN::TimedCleanup");
     request->sln->server->world->timer.Register(event);
 
     return 0;
@@ -253,20 +253,20 @@ void SLN::TimedCleanup(void *void_request)
 
                         if (parts.at(2) == "retry")
                         {
-                            int old_period = int(request->sln->server->world->config["SLNPeriod"]);
+                            int old_period = request->sln->server->world->settings.GetInt(ConfigKey::SLNPeriod);
                             int new_period = util::to_int(parts.at(3));
-                            request->sln->server->world->config["SLNPeriod"] = new_period;
+                            request->sln->server->world->settings.Set(request->sln->server->world->config, ConfigKey::SLNPeriod, new_period);
                             request->period += new_period - old_period;
                             resolved = true;
                         }
                         else if (parts.at(2) == "name")
                         {
-                            request->sln->server->world->config["ServerName"] = parts.at(3);
+                            request->sln->server->world->settings.Set(request->sln->server->world->config, ConfigKey::ServerName, parts.at(3));
                             resolved = true;
                         }
                         else if (parts.at(2) == "url")
                         {
-                            request->sln->server->world->config["SLNSite"] = parts.at(3);
+                            request->sln->server->world->settings.Set(request->sln->server->world->config, ConfigKey::SLNSite, parts.at(3));
                             resolved = true;
                         }
                         break;
@@ -305,7 +305,7 @@ void SLN::TimedCleanup(void *void_request)
 
                         if (parts.at(2) == "url")
                         {
-                            request->sln->server->world->config["SLNSite"] = "";
+                            request->sln->server->world->settings.Set(request->sln->server->world->config, ConfigKey::SLNSite, "");
                             resolved = true;
                         }
                         break;
@@ -364,7 +364,7 @@ void SLN::TimedCleanup(void *void_request)
     if (request->period > 900)
         request->period = 900;
 
-    TimeEvent *event = new TimeEvent(SLN::TimedRequest, request->sln, request->period, 1);
+    TimeEvent *event = new TimeEvent(SLN::TimedRequest, request->sln, request->period, 1, "SLN::TimedRequest");
     request->sln->server->world->timer.Register(event);
 
     delete request;
@@ -10,6 +10,7 @@
 
 #include "socket.hpp"
 #include "console.hpp"
+#include "trace.hpp"
 #include "util.hpp"
 
 #include <algorithm>
@@ -347,6 +348,23 @@ void Client::Send(const std::string &data)
 	this->send_buffer_used += data.length();
 }
 
+std::string Client::TakeSendBuffer()
+{
+	std::string data;
+	data.reserve(this->send_buffer_used);
+
+	const std::size_t mask = this->send_buffer.length() - 1;
+
+	while (this->send_buffer_used > 0)
+	{
+		data += this->send_buffer[this->send_buffer_gpos];
+		this->send_buffer_gpos = (this->send_buffer_gpos + 1) & mask;
+		--this->send_buffer_used;
+	}
+
+	return data;
+}
+
 bool Client::DoRecv()
 {
 	char buf[8192];
@@ -640,7 +658,6 @@ Client *Server::Poll()
 	SOCKET newsock;
 	sockaddr_in sin;
 	socklen_t addrsize = sizeof(sockaddr_in);
-	Client *newclient;
 #ifdef WIN32
 	unsigned long nonblocking;
 #endif // WIN32
@@ -711,7 +728,12 @@ Client *Server::Poll()
 	}
 #endif // !defined(SOCKET_POLL) && !defined(WIN32)
 
-	newclient = this->ClientFactory(SocketImpl(newsock, sin)); // Updated to use 'SocketImpl'
+	return this->Attach(SocketImpl(newsock, sin));
+}
+
+Client *Server::Attach(const SocketImpl &sock)
+{
+	Client *newclient = this->ClientFactory(sock); // Updated to use 'SocketImpl'
 	newclient->SetRecvBuffer(this->recv_buffer_max);
 	newclient->SetSendBuffer(this->send_buffer_max);
 
@@ -723,7 +745,10 @@ Client *Server::Poll()
 #if defined(SOCKET_POLL) && !defined(WIN32)
 std::vector<Client *> *Server::Select(double timeout)
 {
-	static std::vector<Client *> selected;
+	TRACE_SCOPE("Server::Select");
+
+	// thread_local so that servers on other threads (see Metrics_Server) don't share it
+	static thread_local std::vector<Client *> selected;
 	std::vector<pollfd> fds;
 	int result;
 	pollfd fd;
@@ -810,9 +835,12 @@ std::vector<Client *> *Server::Select(double timeout)
 #else // defined(SOCKET_POLL) && !defined(WIN32)
 std::vector<Client *> *Server::Select(double timeout)
 {
+	TRACE_SCOPE("Server::Select");
+
 	long tsecs = long(timeout);
 	timeval timeout_val = {tsecs, long((timeout - double(tsecs)) * 1000000)};
-	static std::vector<Client *> selected;
+	// thread_local so that servers on other threads (see Metrics_Server) don't share it
+	static thread_local std::vector<Client *> selected;
 	SOCKET nfds = this->impl->sock;
 	int result;
 
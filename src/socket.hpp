@@ -272,6 +272,11 @@ public:
 	std::string Recv(std::size_t length);
 	void Send(const std::string &data);
 
+	/**
+	 * Removes and returns everything waiting in the send buffer, for a connection with no socket to send it on
+	 */
+	std::string TakeSendBuffer();
+
 	bool DoRecv();
 	bool DoSend();
 
@@ -410,6 +415,12 @@ public:
 	 */
 	Client *Poll();
 
+	/**
+	 * Adds a client for a connection that was not accepted by Poll, such as a simulated one with no socket.
+	 * @return The new Client, as created by ClientFactory.
+	 */
+	Client *Attach(const SocketImpl &sock);
+
 	/**
 	 * Check clients for incoming data and errors, and sends data in their send_buffer.
 	 * If data is recieved, it is added to their recv_buffer.
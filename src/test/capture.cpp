@@ -0,0 +1,89 @@
+/* test/capture.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "test.hpp"
+
+#include "../capture.hpp"
+#include "../packet.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+static Capture_Record test_capture_talk(const std::string &message)
+{
+	Capture_Record record;
+	record.type = Capture_Record::Packet;
+	record.time = 0;
+	record.client = 1;
+	record.family = PACKET_TALK;
+	record.action = PACKET_REPORT;
+	record.payload = message;
+	return record;
+}
+
+/**
+ * Records $resetpassword under each name it answers to and checks no password reaches the file
+ */
+TEST_CASE(capture_scrub_resetpassword)
+{
+	const std::string filename = "test-capture-scrub.eocap";
+	const std::string scrubbed(Capture_Writer::ScrubbedPassword);
+
+	// Sent message, and what the capture should hold
+	const std::vector<std::pair<std::string, std::string>> messages = {
+		{"$rp someone Secret1", "$rp someone " + scrubbed},
+		{"$password someone Secret2", "$password someone " + scrubbed},
+		{"$resetpassword someone Secret3", "$resetpassword someone " + scrubbed},
+		{"$RESETPASSWORD someone Secret4", "$RESETPASSWORD someone " + scrubbed},
+		{"$rese someone Secret5 trailing words", "$rese someone " + scrubbed},
+		{"$rp  Secret6", "$rp  " + scrubbed},
+		{"$rp someone", "$rp someone"},
+		{"$kick someone reason", "$kick someone reason"},
+		{"$res someone not_a_password", "$res someone not_a_password"},
+		{"hello rp someone", "hello rp someone"},
+	};
+
+	Capture_Writer writer;
+	TEST_CHECK(writer.Open(filename));
+
+	for (const auto &message : messages)
+		TEST_CHECK(writer.Write(test_capture_talk(message.first)));
+
+	writer.Close();
+
+	std::string data;
+	std::FILE *fh = std::fopen(filename.c_str(), "rb");
+	TEST_CHECK(fh);
+
+	char buf[4096];
+	std::size_t n;
+
+	while ((n = std::fread(buf, 1, sizeof buf, fh)) > 0)
+		data.append(buf, n);
+
+	std::fclose(fh);
+
+	for (int i = 1; i <= 6; ++i)
+		TEST_CHECK(data.find("Secret" + std::to_string(i)) == std::string::npos);
+
+	Capture_Reader reader;
+	TEST_CHECK(reader.Open(filename));
+
+	Capture_Record record;
+
+	for (const auto &message : messages)
+	{
+		TEST_CHECK(reader.Read(record));
+		TEST_CHECK(record.payload == message.second);
+	}
+
+	TEST_CHECK(!reader.Read(record));
+	reader.Close();
+
+	test_remove(filename);
+}
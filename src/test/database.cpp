@@ -0,0 +1,207 @@
+/* test/database.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "test.hpp"
+
+#include "../database.hpp"
+#include "../database_pool.hpp"
+
+#include "../util/variant.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static void test_result_add_string(Database_Result &result, const char *value)
+{
+	result.AddString(value, std::strlen(value));
+}
+
+/**
+ * A result with columns but no rows has nothing to iterate and reports itself empty
+ */
+TEST_CASE(database_result_empty)
+{
+	Database_Result result;
+	result.SetColumns({"name", "level"});
+
+	TEST_CHECK(result.empty());
+	TEST_CHECK(result.size() == 0);
+	TEST_CHECK(result.begin() == result.end());
+	TEST_CHECK(result.Columns().size() == 2);
+	TEST_CHECK(result.ColumnIndex("level") == 1);
+	TEST_CHECK(result.ColumnIndex("missing") == -1);
+
+	int rows = 0;
+
+	for (Database_Result::Row row : result)
+	{
+		(void)row;
+		++rows;
+	}
+
+	TEST_CHECK(rows == 0);
+}
+
+/**
+ * Every way of reading a single row must agree on the cells' values and types
+ */
+TEST_CASE(database_result_single_row)
+{
+	Database_Result result;
+	result.SetColumns({"name", "level", "exp"});
+	test_result_add_string(result, "Sausage");
+	result.AddInt(25);
+	test_result_add_string(result, "1200");
+	result.EndRow();
+
+	TEST_CHECK(!result.empty());
+	TEST_CHECK(result.size() == 1);
+
+	Database_Result::Row row = result.front();
+	TEST_CHECK(row.size() == 3);
+
+	TEST_CHECK(!row[0].IsInt());
+	TEST_CHECK(row[0].GetString() == "Sausage");
+	TEST_CHECK(row[1].IsInt());
+	TEST_CHECK(int(row[1]) == 25);
+	TEST_CHECK(row[1].GetString() == "25");
+	TEST_CHECK(row[2].GetInt() == 1200);
+
+	TEST_CHECK(std::string(row["name"]) == "Sausage");
+	TEST_CHECK(int(row["level"]) == 25);
+	TEST_CHECK(std::string(row["missing"]).empty());
+
+	std::unordered_map<std::string, util::variant> map = row;
+	TEST_CHECK(map.size() == 3);
+	TEST_CHECK(std::string(map["name"]) == "Sausage");
+	TEST_CHECK(int(map["exp"]) == 1200);
+
+	TEST_CHECK(int(result.back()[1]) == 25);
+}
+
+/**
+ * Rows must be read back in order, whether indexed or iterated, with text cells of different lengths kept apart
+ */
+TEST_CASE(database_result_multi_row)
+{
+	static const char *const names[] = {"a", "", "a much longer name"};
+
+	Database_Result result;
+	result.SetColumns({"id", "name"});
+
+	for (int i = 0; i < 3; ++i)
+	{
+		result.AddInt(i + 1);
+		test_result_add_string(result, names[i]);
+		result.EndRow();
+	}
+
+	TEST_CHECK(result.size() == 3);
+	TEST_CHECK(int(result.front()[0]) == 1);
+	TEST_CHECK(int(result.back()[0]) == 3);
+
+	std::vector<std::string> iterated;
+	int id = 0;
+
+	for (Database_Result::Row row : result)
+	{
+		TEST_CHECK(int(row[0]) == ++id);
+		iterated.push_back(row[1]);
+	}
+
+	TEST_CHECK(id == 3);
+
+	for (std::size_t i = 0; i < 3; ++i)
+	{
+		TEST_CHECK(iterated[i] == names[i]);
+		TEST_CHECK(result[i][1].GetString() == names[i]);
+	}
+
+	// Replacing the columns starts a new set of rows
+	result.SetColumns({"id"});
+	TEST_CHECK(result.empty());
+}
+
+/**
+ * Prepared statements are cached by format address, which must not mix up formats that share an address or splice in text
+ */
+TEST_CASE(database_prepared_statements)
+{
+#ifdef DATABASE_SQLITE
+	static const char *const names[] = {"a", "b", "c"};
+
+	Database db(Database::SQLite, ":memory:", 0, "", "", "");
+	db.RawQuery("CREATE TABLE `items` (`id` INTEGER, `name` TEXT)");
+
+	for (int i = 0; i < 3; ++i)
+		db.Query("INSERT INTO `items` (`id`, `name`) VALUES (#, '$')", i + 1, names[i]);
+
+	for (int i = 0; i < 3; ++i)
+	{
+		Database_Result res = db.Query("SELECT `name` FROM `items` WHERE `id` = #", i + 1);
+		TEST_CHECK(res.size() == 1);
+		TEST_CHECK(res.front()[0].GetString() == names[i]);
+	}
+
+	// A format rebuilt in the same buffer gets a statement for its new text
+	char format[64];
+
+	std::strcpy(format, "SELECT MIN(`id`) FROM `items`");
+	Database_Result min = db.Query(format);
+	TEST_CHECK(min.front()[0].GetInt() == 1);
+
+	std::strcpy(format, "SELECT MAX(`id`) FROM `items`");
+	Database_Result max = db.Query(format);
+	TEST_CHECK(max.front()[0].GetInt() == 3);
+
+	Database_Result spliced_c = db.Query("SELECT `id` FROM `items` WHERE `name` = '@'", "c");
+	TEST_CHECK(spliced_c.front()[0].GetInt() == 3);
+
+	Database_Result spliced_a = db.Query("SELECT `id` FROM `items` WHERE `name` = '@'", "a");
+	TEST_CHECK(spliced_a.front()[0].GetInt() == 1);
+#endif // DATABASE_SQLITE
+}
+
+/**
+ * Fan-out reads come back in query order, and the pool's workers are reused across calls and reopening
+ */
+TEST_CASE(database_pool_fanout)
+{
+#ifdef DATABASE_SQLITE
+	Database fallback(Database::SQLite, ":memory:", 0, "", "", "");
+	Database_Pool pool;
+
+	std::vector<std::string> queries;
+
+	for (int i = 0; i < 10; ++i)
+		queries.push_back("SELECT " + std::to_string(i));
+
+	std::vector<Database_Result> unpooled = pool.Fanout(queries, fallback);
+	TEST_CHECK(unpooled.size() == 10);
+	TEST_CHECK(unpooled[9].front()[0].GetInt() == 9);
+
+	pool.Open(3, Database::SQLite, ":memory:", 0, "", "", "");
+
+	for (int round = 0; round < 2; ++round)
+	{
+		for (int n = 0; n < 3; ++n)
+		{
+			std::vector<Database_Result> results = pool.Fanout(queries, fallback);
+			TEST_CHECK(results.size() == 10);
+
+			for (int i = 0; i < 10; ++i)
+				TEST_CHECK(results[i].front()[0].GetInt() == i);
+		}
+
+		pool.Open(2, Database::SQLite, ":memory:", 0, "", "", "");
+	}
+
+	pool.Close();
+	TEST_CHECK(pool.Fanout(queries, fallback)[4].front()[0].GetInt() == 4);
+#endif // DATABASE_SQLITE
+}
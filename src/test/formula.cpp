@@ -0,0 +1,196 @@
+/* test/formula.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "test.hpp"
+
+#include "../config.hpp"
+#include "../formula_vars.hpp"
+
+#include "../util.hpp"
+#include "../util/rpn.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <stack>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Variable sets every formula is evaluated with, covering unbound variables, zeroes, negatives, fractions and large values
+ */
+static std::vector<Formula_Frame> test_formula_frames()
+{
+	std::vector<Formula_Frame> frames;
+
+	// Nothing bound, so every variable takes its fallback value
+	frames.emplace_back();
+
+	auto fill = [&](double (*value)(int i, int side))
+	{
+		Formula_Frame frame;
+
+		for (int i = 0; i < FV_COUNT; ++i)
+		{
+			frame.Set(Formula_Frame::Self, Formula_Var(i), value(i, 0));
+			frame.Set(Formula_Frame::Target, Formula_Var(i), value(i, 1));
+		}
+
+		for (int i = 0; i < FE_COUNT; ++i)
+			frame.Set(Formula_Extra(i), value(FV_COUNT + i, 2));
+
+		frames.push_back(frame);
+	};
+
+	fill([](int i, int side) { return 10.0 + (i * (13 + side * 4)) % 90; });
+	fill([](int, int) { return 0.0; });
+	fill([](int i, int side) { return (i + side) % 2 ? 1.0 : 0.0; });
+	fill([](int i, int side) { return -3.5 * (i % 7 + 1) + side; });
+	fill([](int i, int side) { return 0.25 + i * 0.5 + side * 0.125; });
+	fill([](int i, int side) { return 2147483647.0 - i * 1000003.0 - side; });
+
+	// Only the attacker's side bound, as some formulas are evaluated without a target
+	Formula_Frame self_only;
+
+	for (int i = 0; i < FV_COUNT; ++i)
+		self_only.Set(Formula_Frame::Self, Formula_Var(i), 20 + i);
+
+	frames.push_back(self_only);
+
+	return frames;
+}
+
+static bool test_formula_same(double a, double b)
+{
+	return a == b || (std::isnan(a) && std::isnan(b));
+}
+
+/**
+ * Evaluates an expression with the reference evaluator and both forms of the compiled program for every variable set
+ */
+static void test_formula_compare(const std::string &name, const std::stack<std::string> &stack, const std::vector<Formula_Frame> &frames)
+{
+	util::rpn_program program(stack, Formula_Frame::Resolve);
+
+	// Results of rand() can't be compared
+	if (!program.deterministic())
+		return;
+
+	Formula_Batch batch(frames.size());
+	std::vector<double> expected(frames.size());
+
+	for (std::size_t i = 0; i < frames.size(); ++i)
+	{
+		std::unordered_map<std::string, double> vars;
+		frames[i].Export(vars);
+
+		expected[i] = util::rpn_eval(stack, vars);
+		double result = program.eval(frames[i].data());
+		double by_name = program.eval(vars);
+
+		if (!test_formula_same(result, expected[i]) || !test_formula_same(by_name, expected[i]))
+		{
+			std::printf("%s (variable set %i): rpn_eval %.17g, rpn_program %.17g, rpn_program by name %.17g\n",
+			            name.c_str(), int(i), expected[i], result, by_name);
+			TEST_CHECK(!"compiled formula differs from rpn_eval");
+		}
+
+		batch.Store(i, frames[i]);
+	}
+
+	std::vector<double> results(frames.size());
+	program.eval(batch.Columns().data(), frames.size(), results.data());
+
+	for (std::size_t i = 0; i < frames.size(); ++i)
+	{
+		if (!test_formula_same(results[i], expected[i]))
+		{
+			std::printf("%s (variable set %i): rpn_eval %.17g, batch %.17g\n", name.c_str(), int(i), expected[i], results[i]);
+			TEST_CHECK(!"batch formula differs from rpn_eval");
+		}
+	}
+}
+
+/**
+ * Every formula in data/formulas.ini must give the same result compiled as it does through util::rpn_eval
+ */
+TEST_CASE(formula_differential)
+{
+	Config formulas;
+	TEST_CHECK(formulas.Read("./data/formulas.ini"));
+
+	Formula_Parser parser = formula_parser(formulas);
+
+	std::vector<Formula_Frame> frames = test_formula_frames();
+	int compared = 0;
+
+	UTIL_FOREACH_CREF(formulas, formula)
+	{
+		if (formula.first == "Version")
+			continue;
+
+		test_formula_compare(formula.first, parser(formula.second), frames);
+		++compared;
+	}
+
+	TEST_CHECK(compared > 0);
+}
+
+/**
+ * The shipped formulas use only some operators, so every other one is compared here too
+ */
+TEST_CASE(formula_operators)
+{
+	static const char *const expressions[] = {
+		"str + int - wis * agi / (con + 1) % 7",
+		"(str & 12) | (int ^ 5) + ~wis",
+		"str && int || !wis",
+		"-str + -(int - 3)",
+		"pow(str, 0.5) + sqrt(int) + log(wis) + exp(agi / 100) + ln(con)",
+		"sin(str) + cos(int) + tan(wis)",
+		"min(str, int) + max(wis, agi)",
+		"ceil(str / 3) + round(int / 3) + floor(wis / 3)",
+		"(str < int) + (str <= int) + (str == int) + (str != int) + (str >= int) + (str > int)",
+		"iif(target_sitting, damage * 2, iif(critical, damage * 1.5, damage))",
+		"iif(1, str, int) + iif(0, wis, agi) + (0 && str) + (1 || int)",
+		"2 * 3 + 4 / 8 - level",
+		"unknown_variable + 1",
+	};
+
+	std::vector<Formula_Frame> frames = test_formula_frames();
+
+	for (const char *expression : expressions)
+		test_formula_compare(expression, util::rpn_parse_v2(expression), frames);
+}
+
+/**
+ * A formulas file with no Version key is read with the original syntax, as it was before the key existed
+ */
+TEST_CASE(formula_parser_version)
+{
+	const std::string filename = "test-formulas-noversion.ini";
+
+	std::FILE *fh = std::fopen(filename.c_str(), "wb");
+	TEST_CHECK(fh);
+	std::fputs("damage = str 1 +\n", fh);
+	std::fclose(fh);
+
+	Config formulas;
+	bool read = formulas.Read(filename);
+	test_remove(filename);
+	TEST_CHECK(read);
+
+	TEST_CHECK(formulas.find("Version") == formulas.end());
+	TEST_CHECK(formula_parser(formulas) == util::rpn_parse);
+
+	std::unordered_map<std::string, double> vars{{"str", 4.0}};
+	TEST_CHECK(util::rpn_eval(formula_parser(formulas)(formulas["damage"]), vars) == 5.0);
+
+	formulas["Version"] = util::variant(2);
+	TEST_CHECK(formula_parser(formulas) == util::rpn_parse_v2);
+}
@@ -0,0 +1,211 @@
+/* test/journal.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "test.hpp"
+
+#include "../database.hpp"
+#include "../journal.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+#ifndef WIN32
+#include <chrono>
+#include <csignal>
+#include <thread>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif // WIN32
+
+#ifdef DATABASE_SQLITE
+
+static const int trade_total = 1000;
+
+// The columns written by journal records, with two characters that trade gold back and forth
+static void test_journal_database(Database &db)
+{
+	db.Query("CREATE TABLE `characters` (`name` VARCHAR(16) PRIMARY KEY, `inventory` TEXT NOT NULL DEFAULT '', `bank` TEXT NOT NULL DEFAULT '', "
+	         "`paperdoll` TEXT NOT NULL DEFAULT '', `goldbank` INTEGER NOT NULL DEFAULT 0, `level` INTEGER NOT NULL DEFAULT 0, "
+	         "`exp` INTEGER NOT NULL DEFAULT 0, `statpoints` INTEGER NOT NULL DEFAULT 0, `skillpoints` INTEGER NOT NULL DEFAULT 0, "
+	         "`str` INTEGER NOT NULL DEFAULT 0, `int` INTEGER NOT NULL DEFAULT 0, `wis` INTEGER NOT NULL DEFAULT 0, `agi` INTEGER NOT NULL DEFAULT 0, "
+	         "`con` INTEGER NOT NULL DEFAULT 0, `cha` INTEGER NOT NULL DEFAULT 0, `quest` TEXT NOT NULL DEFAULT '')");
+	db.Query("INSERT INTO `characters` (`name`, `goldbank`) VALUES ('alice', 0)");
+	db.Query("INSERT INTO `characters` (`name`, `goldbank`) VALUES ('bob', #)", trade_total);
+}
+
+static void test_journal_reset(Database &db)
+{
+	db.Query("UPDATE `characters` SET `goldbank` = 0 WHERE `name` = 'alice'");
+	db.Query("UPDATE `characters` SET `goldbank` = # WHERE `name` = 'bob'", trade_total);
+}
+
+static int test_journal_gold(Database &db, const char *name)
+{
+	Database_Result res = db.Query("SELECT `goldbank` FROM `characters` WHERE `name` = '$'", name);
+	TEST_CHECK(!res.empty());
+	return res.front()["goldbank"];
+}
+
+// One trade: alice ends up with `gold` and bob with the rest, synced as one group like a journal sync tick
+static void test_journal_trade(Journal &journal, int gold)
+{
+	// Long enough that a group spans several writes
+	std::string inventory(2000, 'x');
+
+	journal.WriteItems("alice", inventory, "", "", gold);
+	journal.WriteItems("bob", inventory, "", "", trade_total - gold);
+	journal.Sync();
+}
+
+static std::string test_journal_read(const std::string &filename)
+{
+	std::string data;
+	std::FILE *fh = std::fopen(filename.c_str(), "rb");
+	TEST_CHECK(fh);
+
+	char buf[4096];
+	std::size_t n;
+
+	while ((n = std::fread(buf, 1, sizeof buf, fh)) > 0)
+		data.append(buf, n);
+
+	std::fclose(fh);
+	return data;
+}
+
+static void test_journal_write(const std::string &filename, const std::string &data)
+{
+	std::FILE *fh = std::fopen(filename.c_str(), "wb");
+	TEST_CHECK(fh);
+	TEST_CHECK(std::fwrite(data.data(), 1, data.size(), fh) == data.size());
+	std::fclose(fh);
+}
+
+/**
+ * Replays the journal cut off at every length a crash could leave it at, and with a byte flipped at each of a spread of
+ * offsets, checking no trade is ever half applied and every group written in full before the damage is
+ */
+TEST_CASE(journal_torn_write)
+{
+	const std::string filename = "test-journal-torn.bin";
+	const std::string cut_filename = "test-journal-torn-cut.bin";
+	const int trades = 4;
+
+	test_remove(filename);
+
+	std::size_t group_end[trades];
+
+	{
+		Journal journal;
+		TEST_CHECK(journal.Open(filename));
+
+		for (int i = 0; i < trades; ++i)
+		{
+			test_journal_trade(journal, (i + 1) * 100);
+			group_end[i] = test_journal_read(filename).size();
+		}
+	}
+
+	std::string data = test_journal_read(filename);
+	TEST_CHECK(data.size() == group_end[trades - 1]);
+
+	Database db(Database::SQLite, ":memory:", 0, "", "", "");
+	test_journal_database(db);
+
+	for (std::size_t length = 0; length <= data.size(); ++length)
+	{
+		test_journal_write(cut_filename, data.substr(0, length));
+		test_journal_reset(db);
+
+		std::size_t applied = Journal::Replay(cut_filename, db);
+
+		int complete = 0;
+
+		while (complete < trades && group_end[complete] <= length)
+			++complete;
+
+		int alice = test_journal_gold(db, "alice");
+		int bob = test_journal_gold(db, "bob");
+
+		TEST_CHECK(alice + bob == trade_total);
+		TEST_CHECK(applied == std::size_t(complete) * 2);
+		TEST_CHECK(alice == complete * 100);
+	}
+
+	for (std::size_t offset = 0; offset < data.size(); offset += 97)
+	{
+		std::string damaged = data;
+		damaged[offset] = char(damaged[offset] ^ 0x5A);
+
+		test_journal_write(cut_filename, damaged);
+		test_journal_reset(db);
+
+		std::size_t applied = Journal::Replay(cut_filename, db);
+
+		int intact = 0;
+
+		while (intact < trades && group_end[intact] <= offset)
+			++intact;
+
+		TEST_CHECK(test_journal_gold(db, "alice") + test_journal_gold(db, "bob") == trade_total);
+		TEST_CHECK(applied == std::size_t(intact) * 2);
+	}
+
+	test_remove(filename);
+	test_remove(cut_filename);
+}
+
+#ifndef WIN32
+
+/**
+ * Kills a process while it is writing trades to the journal, then replays what it left behind
+ */
+TEST_CASE(journal_kill_replay)
+{
+	const std::string filename = "test-journal-kill.bin";
+
+	for (int round = 0; round < 5; ++round)
+	{
+		test_remove(filename);
+
+		pid_t pid = fork();
+		TEST_CHECK(pid >= 0);
+
+		if (pid == 0)
+		{
+			Journal journal;
+
+			if (!journal.Open(filename))
+				_exit(1);
+
+			for (int i = 1; ; ++i)
+				test_journal_trade(journal, i % trade_total);
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(20 + round * 15));
+		kill(pid, SIGKILL);
+
+		int status;
+		waitpid(pid, &status, 0);
+		TEST_CHECK(WIFSIGNALED(status));
+
+		Database db(Database::SQLite, ":memory:", 0, "", "", "");
+		test_journal_database(db);
+
+		std::size_t applied = Journal::Replay(filename, db);
+
+		TEST_CHECK(applied % 2 == 0);
+		TEST_CHECK(test_journal_gold(db, "alice") + test_journal_gold(db, "bob") == trade_total);
+	}
+
+	test_remove(filename);
+}
+
+#endif // WIN32
+
+#endif // DATABASE_SQLITE
@@ -0,0 +1,132 @@
+/* test/quest.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "test.hpp"
+
+#include "../eoplus.hpp"
+#include "../quest.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifndef WIN32
+#include <sys/stat.h>
+#include <utime.h>
+#endif // WIN32
+
+// Rule numbers below are positions in the Begin state
+static const char *const test_quest_source =
+	"Main\n"
+	"{\n"
+	"	questname \"Rule dispatch\"\n"
+	"	version 1\n"
+	"}\n"
+	"\n"
+	"state Begin\n"
+	"{\n"
+	"	rule EnterMap(5) goto Done\n"       // 0: map 5 bucket
+	"	rule GotItems(1, 1) goto Done\n"    // 1: item 1 bucket
+	"	rule DoneDaily(2) goto Done\n"      // 2: no bucket
+	"	rule LeaveMap(5) goto Done\n"       // 3: leave bucket
+	"	rule GotSpell(3, 1) goto Done\n"    // 4: spell 3 bucket
+	"	rule IsGender(0) goto Done\n"       // 5: character bucket
+	"	rule Rolled(4) goto Done\n"         // 6: no bucket
+	"	rule Always() goto Done\n"          // 7: no bucket
+	"}\n"
+	"\n"
+	"state Done\n"
+	"{\n"
+	"	action End()\n"
+	"}\n";
+
+/**
+ * Each trigger must bring up its own rules and every rule that doesn't belong to a trigger, such as DoneDaily and Rolled
+ */
+TEST_CASE(quest_triggered_rules)
+{
+	Test_Dir dir("quest_triggered_rules");
+	const std::string &quest_dir = dir.Path();
+	const std::string filename = dir.File("00001.eqf");
+
+	std::FILE *fh = std::fopen(filename.c_str(), "wb");
+	TEST_CHECK(fh);
+	std::fputs(test_quest_source, fh);
+	std::fclose(fh);
+
+	Quest quest(1, nullptr, quest_dir, false);
+
+	auto state_it = quest.GetQuest()->states.find("begin");
+	TEST_CHECK(state_it != quest.GetQuest()->states.end());
+	const EOPlus::State *state = &state_it->second;
+
+	std::vector<std::size_t> rules;
+
+	quest.TriggeredRules(state, QUEST_TRIGGER_MOVE, 5, rules);
+	TEST_CHECK((rules == std::vector<std::size_t>{0, 2, 3, 5, 6, 7}));
+
+	quest.TriggeredRules(state, QUEST_TRIGGER_MOVE, 6, rules);
+	TEST_CHECK((rules == std::vector<std::size_t>{2, 3, 5, 6, 7}));
+
+	quest.TriggeredRules(state, QUEST_TRIGGER_ITEM, 1, rules);
+	TEST_CHECK((rules == std::vector<std::size_t>{1, 2, 5, 6, 7}));
+
+	quest.TriggeredRules(state, QUEST_TRIGGER_SPELL, 3, rules);
+	TEST_CHECK((rules == std::vector<std::size_t>{2, 4, 6, 7}));
+
+	// A state with no rules has nothing to check
+	auto done_it = quest.GetQuest()->states.find("done");
+	TEST_CHECK(done_it != quest.GetQuest()->states.end());
+
+	quest.TriggeredRules(&done_it->second, QUEST_TRIGGER_MOVE, 5, rules);
+	TEST_CHECK(rules.empty());
+}
+
+#ifndef WIN32
+
+static void test_quest_write(const std::string &filename, const char *name)
+{
+	std::FILE *fh = std::fopen(filename.c_str(), "wb");
+	TEST_CHECK(fh);
+	std::fprintf(fh, "Main\n{\n\tquestname \"%s\"\n\tversion 1\n}\n\nstate Begin\n{\n\taction End()\n}\n", name);
+	std::fclose(fh);
+}
+
+/**
+ * An edit that keeps the file's size and modification time must still be picked up instead of the compiled cache
+ */
+TEST_CASE(quest_cache_content_hash)
+{
+	Test_Dir dir("quest_cache_content_hash");
+	const std::string &quest_dir = dir.Path();
+	const std::string filename = dir.File("00002.eqf");
+	dir.File("00002.eqc");
+
+	test_quest_write(filename, "First");
+
+	struct stat original;
+	TEST_CHECK(stat(filename.c_str(), &original) == 0);
+
+	{
+		Quest quest(2, nullptr, quest_dir, true);
+		TEST_CHECK(quest.Name() == "First");
+	}
+
+	test_quest_write(filename, "Other");
+
+	utimbuf times;
+	times.actime = original.st_atime;
+	times.modtime = original.st_mtime;
+	TEST_CHECK(utime(filename.c_str(), &times) == 0);
+
+	{
+		Quest quest(2, nullptr, quest_dir, true);
+		TEST_CHECK(quest.Name() == "Other");
+	}
+}
+
+#endif // WIN32
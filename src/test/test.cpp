@@ -0,0 +1,134 @@
+/* test/test.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "test.hpp"
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef WIN32
+#include <direct.h>
+#include <process.h>
+#else // WIN32
+#include <unistd.h>
+#endif // WIN32
+
+// Normally defined in main.cpp, which isn't linked in to the tests
+volatile std::sig_atomic_t eoserv_sig_abort = false;
+
+static std::map<std::string, Test_Function> &test_list()
+{
+	static std::map<std::string, Test_Function> tests;
+	return tests;
+}
+
+Test_Failure::Test_Failure(const char *file, int line, const char *expr)
+	: std::runtime_error(std::string(file) + ":" + std::to_string(line) + ": check failed: " + expr)
+{ }
+
+Test_Register::Test_Register(const char *name, Test_Function fn)
+{
+	test_list()[name] = fn;
+}
+
+void test_remove(const std::string &filename)
+{
+	std::remove(filename.c_str());
+}
+
+Test_Dir::Test_Dir(const std::string &name)
+{
+#ifdef WIN32
+	const char *tmp = std::getenv("TEMP");
+	this->path = std::string(tmp ? tmp : ".") + "\\eoserv-test-" + name + "-" + std::to_string(_getpid());
+
+	if (_mkdir(this->path.c_str()) != 0)
+		throw std::runtime_error("Could not create " + this->path);
+
+	this->path += '\\';
+#else // WIN32
+	const char *tmp = std::getenv("TMPDIR");
+	std::string pattern = std::string(tmp && *tmp ? tmp : "/tmp") + "/eoserv-test-" + name + "-XXXXXX";
+	std::vector<char> buf(pattern.begin(), pattern.end());
+	buf.push_back('\0');
+
+	if (!mkdtemp(buf.data()))
+		throw std::runtime_error("Could not create " + pattern);
+
+	this->path = std::string(buf.data()) + '/';
+#endif // WIN32
+}
+
+std::string Test_Dir::File(const std::string &filename)
+{
+	this->files.push_back(this->path + filename);
+	return this->files.back();
+}
+
+Test_Dir::~Test_Dir()
+{
+	for (const std::string &file : this->files)
+		test_remove(file);
+
+	std::string dir = this->path.substr(0, this->path.size() - 1);
+
+#ifdef WIN32
+	_rmdir(dir.c_str());
+#else // WIN32
+	rmdir(dir.c_str());
+#endif // WIN32
+}
+
+static bool test_run(const std::string &name, Test_Function fn)
+{
+	try
+	{
+		fn();
+	}
+	catch (std::exception &e)
+	{
+		std::printf("FAIL %s: %s\n", name.c_str(), e.what());
+		return false;
+	}
+
+	std::printf("PASS %s\n", name.c_str());
+	return true;
+}
+
+/**
+ * Runs the tests named on the command line, or every test if none are
+ * Each test is also registered with ctest on its own, running from the build directory.
+ */
+int main(int argc, char *argv[])
+{
+	int failed = 0;
+
+	if (argc < 2)
+	{
+		for (const auto &test : test_list())
+			failed += !test_run(test.first, test.second);
+	}
+
+	for (int i = 1; i < argc; ++i)
+	{
+		auto it = test_list().find(argv[i]);
+
+		if (it == test_list().end())
+		{
+			std::printf("FAIL %s: no such test\n", argv[i]);
+			++failed;
+			continue;
+		}
+
+		failed += !test_run(it->first, it->second);
+	}
+
+	return failed == 0 ? 0 : 1;
+}
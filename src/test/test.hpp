@@ -0,0 +1,75 @@
+/* test/test.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef TEST_TEST_HPP_INCLUDED
+#define TEST_TEST_HPP_INCLUDED
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Thrown by TEST_CHECK, failing the test that is running
+ */
+class Test_Failure : public std::runtime_error
+{
+public:
+	Test_Failure(const char *file, int line, const char *expr);
+};
+
+typedef void (*Test_Function)();
+
+/**
+ * Adds a test to the list run by eoserv-test, used through TEST_CASE
+ */
+struct Test_Register
+{
+	Test_Register(const char *name, Test_Function fn);
+};
+
+#define TEST_CHECK(expr) do { if (!(expr)) throw Test_Failure(__FILE__, __LINE__, #expr); } while (false)
+
+#define TEST_CASE(name) \
+	static void test_##name(); \
+	static Test_Register test_register_##name(#name, test_##name); \
+	static void test_##name()
+
+/**
+ * Removes a scratch file if it exists
+ */
+void test_remove(const std::string &filename);
+
+/**
+ * Scratch directory for one test, removed along with every file named through File() when it goes out of scope
+ */
+class Test_Dir
+{
+protected:
+	std::string path;
+	std::vector<std::string> files;
+
+public:
+	/**
+	 * @throw std::runtime_error if the directory can't be created
+	 */
+	explicit Test_Dir(const std::string &name);
+
+	Test_Dir(const Test_Dir &) = delete;
+	Test_Dir &operator=(const Test_Dir &) = delete;
+
+	/**
+	 * Directory path, ending in a separator
+	 */
+	const std::string &Path() const { return this->path; }
+
+	/**
+	 * Path to a file in the directory, which is removed with it
+	 */
+	std::string File(const std::string &filename);
+
+	~Test_Dir();
+};
+
+#endif // TEST_TEST_HPP_INCLUDED
@@ -6,15 +6,20 @@
 #include "timer.hpp"
 
 #include "database.hpp"
+#include "watchdog.hpp"
 
 #include "console.hpp"
 #include "socket.hpp"
+#include "trace.hpp"
 #include "util.hpp"
 
+#include <chrono>
+#include <cstdint>
 #include <ctime>
 #include <exception>
 #include <memory>
 #include <stdexcept>
+#include <utility>
 
 #include "platform.h"
 
@@ -125,6 +130,17 @@ Timer::Timer()
 	}
 #endif // TIMER_GETTICKCOUNT
 #endif // WIN32
+	if (!clock)
+		clock.reset(new Clock());
+
+	// A manual clock would never tick over while the resolution is measured
+	if (clock->Manual())
+	{
+		this->resolution = 0.0;
+		this->changed = true;
+		return;
+	}
+
 	double first = Timer::GetTime();
 	double cur;
 	double last = first;
@@ -163,6 +179,11 @@ void Timer::SetMaxDelta(int max_delta)
 		clock->SetMaxDelta(max_delta);
 }
 
+void Timer::SetClock(std::unique_ptr<Clock> &&new_clock)
+{
+	clock = std::move(new_clock);
+}
+
 void Timer::Tick()
 {
 	double currenttime = Timer::GetTime();
@@ -192,6 +213,14 @@ void Timer::Tick()
 				}
 			}
 
+			++this->callbacks;
+
+			// The callback may delete its own event
+			const char *name = timer->name;
+			bool timed = this->watchdog && this->watchdog->Enabled();
+			bool traced = Trace::recording.load(std::memory_order_relaxed);
+			auto start = (timed || traced) ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
 #ifndef DEBUG_EXCEPTIONS
 			try
 			{
@@ -230,6 +259,17 @@ void Timer::Tick()
 			}
 #endif // DEBUG_EXCEPTIONS
 
+			if (timed || traced)
+			{
+				auto end = std::chrono::steady_clock::now();
+
+				if (timed)
+					this->watchdog->Record("timer", name, std::uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()));
+
+				if (traced)
+					Trace::Record(name ? name : "TimeEvent", start, end);
+			}
+
 			if (timer->manager == 0)
 				delete timer;
 		}
@@ -275,12 +315,13 @@ Timer::~Timer()
 #endif // WIN32
 }
 
-TimeEvent::TimeEvent(TimerCallback callback, void *param, double speed, int lifetime)
+TimeEvent::TimeEvent(TimerCallback callback, void *param, double speed, int lifetime, const char *name)
 {
 	this->callback = callback;
 	this->param = param;
 	this->speed = speed;
 	this->lifetime = lifetime;
+	this->name = name;
 	this->manager = 0;
 }
 
@@ -8,6 +8,9 @@
 
 #include "fwd/timer.hpp"
 
+#include "fwd/watchdog.hpp"
+
+#include <cstdint>
 #include <memory>
 #include <set>
 
@@ -29,9 +32,34 @@ private:
 public:
 	Clock(int max_delta = 1000);
 
-	double GetTime();
+	virtual double GetTime();
 
 	void SetMaxDelta(int max_delta);
+
+	/**
+	 * Returns true if the clock only moves when told to, rather than following real time
+	 */
+	virtual bool Manual() const { return false; }
+
+	virtual ~Clock() = default;
+};
+
+/**
+ * Clock advanced by hand, so a simulation sees exactly the same times on every run
+ */
+class Manual_Clock : public Clock
+{
+private:
+	double now;
+
+public:
+	Manual_Clock(double start = 0.0) : now(start) { }
+
+	double GetTime() override { return this->now; }
+
+	void Advance(double seconds) { this->now += seconds; }
+
+	bool Manual() const override { return true; }
 };
 
 /**
@@ -68,6 +96,16 @@ public:
 
 	double resolution;
 
+	/**
+	 * Number of TimeEvent callbacks that have been called
+	 */
+	std::uint64_t callbacks = 0;
+
+	/**
+	 * If set, each callback's run time is reported to it
+	 */
+	Tick_Watchdog *watchdog = nullptr;
+
 	Timer();
 
 	/**
@@ -78,6 +116,11 @@ public:
 
 	static void SetMaxDelta(int max_delta);
 
+	/**
+	 * Replaces the clock read by GetTime, must be called before any Timer is created
+	 */
+	static void SetClock(std::unique_ptr<Clock> &&clock);
+
 	/**
 	 * Check all contained TimeEvent objects and call any which are ready
 	 */
@@ -135,10 +178,15 @@ struct TimeEvent
 	 */
 	int lifetime;
 
+	/**
+	 * Name the Tick_Watchdog reports the event under, must be a string literal
+	 */
+	const char *name;
+
 	/**
 	 * Construct a new TimeEvent object
 	 */
-	TimeEvent(TimerCallback callback, void *param, double speed, int lifetime = 1);
+	TimeEvent(TimerCallback callback, void *param, double speed, int lifetime = 1, const char *name = nullptr);
 
 	/**
 	 * Unregister the object from it's owning Timer object if it has one
@@ -0,0 +1,345 @@
+/* trace.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "trace.hpp"
+
+#include "console.hpp"
+#include "util.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace Trace
+{
+
+	std::atomic<bool> recording(false);
+
+	namespace
+	{
+
+		typedef std::chrono::steady_clock clock;
+
+		struct Event
+		{
+			const char *name;
+			clock::time_point start;
+			clock::time_point end;
+		};
+
+		/**
+		 * Single producer (the owning thread), single consumer (the flush thread)
+		 */
+		struct Ring
+		{
+			static const std::size_t size = 1 << 15;
+
+			std::vector<Event> events;
+			std::atomic<std::uint64_t> head;
+			std::atomic<std::uint64_t> tail;
+			std::atomic<std::uint64_t> dropped;
+			std::atomic<const char *> name;
+			std::atomic<bool> orphaned;
+			unsigned int tid;
+
+			Ring() : events(size), head(0), tail(0), dropped(0), name(nullptr), orphaned(false), tid(0) {}
+		};
+
+		struct State
+		{
+			std::mutex rings_mutex;
+			std::vector<std::shared_ptr<Ring>> rings;
+			unsigned int next_tid = 1;
+
+			std::mutex control_mutex;
+			std::thread flusher;
+			std::atomic<bool> active{false};
+
+			std::mutex stop_mutex;
+			std::condition_variable stop_cv;
+			bool stop = false;
+
+			// Only touched by the flush thread while a trace is running
+			std::FILE *file = nullptr;
+			std::string filename;
+			clock::time_point epoch;
+			std::uint64_t written = 0;
+			std::unordered_set<unsigned int> named;
+
+			~State()
+			{
+				Stop();
+			}
+		};
+
+		State &state()
+		{
+			static State s;
+			return s;
+		}
+
+		struct Thread_Ring
+		{
+			std::shared_ptr<Ring> ring;
+			const char *name = nullptr;
+
+			~Thread_Ring()
+			{
+				if (this->ring)
+					this->ring->orphaned = true;
+			}
+		};
+
+		thread_local Thread_Ring thread_ring;
+
+		Ring &local_ring()
+		{
+			if (!thread_ring.ring)
+			{
+				std::shared_ptr<Ring> ring = std::make_shared<Ring>();
+				ring->name = thread_ring.name;
+
+				State &s = state();
+				std::lock_guard<std::mutex> lock(s.rings_mutex);
+				ring->tid = s.next_tid++;
+				s.rings.push_back(ring);
+				thread_ring.ring = std::move(ring);
+			}
+
+			return *thread_ring.ring;
+		}
+
+		std::string json_escape(const char *str)
+		{
+			std::string result;
+
+			for (; *str; ++str)
+			{
+				if (*str == '"' || *str == '\\')
+					result += '\\';
+
+				if ((unsigned char)*str >= 0x20)
+					result += *str;
+			}
+
+			return result;
+		}
+
+		long long to_us(clock::duration d)
+		{
+			return (long long)std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+		}
+
+		void write_event(State &s, const std::string &json)
+		{
+			std::fputs(s.written++ ? ",\n" : "", s.file);
+			std::fputs(json.c_str(), s.file);
+		}
+
+		std::uint64_t drain(State &s)
+		{
+			std::vector<std::shared_ptr<Ring>> rings;
+			std::uint64_t dropped = 0;
+
+			{
+				std::lock_guard<std::mutex> lock(s.rings_mutex);
+				rings = s.rings;
+			}
+
+			UTIL_FOREACH_CREF(rings, ring)
+			{
+				std::uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+				std::uint64_t head = ring->head.load(std::memory_order_acquire);
+
+				dropped += ring->dropped.load(std::memory_order_relaxed);
+
+				if (tail != head && s.named.insert(ring->tid).second)
+				{
+					const char *name = ring->name.load();
+					std::string thread_name = name ? json_escape(name) : "thread " + util::to_string(int(ring->tid));
+
+					write_event(s, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + util::to_string(int(ring->tid))
+						+ ",\"args\":{\"name\":\"" + thread_name + "\"}}");
+				}
+
+				for (; tail != head; ++tail)
+				{
+					const Event &event = ring->events[tail & (Ring::size - 1)];
+
+					// Left over from a scope that was open when the previous trace ended
+					if (event.start < s.epoch)
+						continue;
+
+					char buffer[96];
+					std::snprintf(buffer, sizeof buffer, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%lld,\"dur\":%lld}",
+						ring->tid, to_us(event.start - s.epoch), to_us(event.end - event.start));
+
+					write_event(s, "{\"name\":\"" + json_escape(event.name) + buffer);
+				}
+
+				ring->tail.store(head, std::memory_order_release);
+			}
+
+			std::lock_guard<std::mutex> lock(s.rings_mutex);
+
+			// Rings of threads that have exited are dropped once they are empty
+			UTIL_IFOREACH(s.rings, it)
+			{
+				Ring &ring = **it;
+
+				if (ring.orphaned && ring.head.load() == ring.tail.load())
+				{
+					it = s.rings.erase(it);
+
+					if (it == s.rings.end())
+						break;
+				}
+			}
+
+			return dropped;
+		}
+
+		void flush_main(clock::time_point deadline)
+		{
+			State &s = state();
+			SetThreadName("trace");
+
+			while (true)
+			{
+				{
+					std::unique_lock<std::mutex> lock(s.stop_mutex);
+
+					if (s.stop_cv.wait_for(lock, std::chrono::milliseconds(100), [&]() { return s.stop; }))
+						break;
+				}
+
+				if (clock::now() >= deadline)
+					break;
+
+				drain(s);
+			}
+
+			recording = false;
+
+			std::uint64_t dropped = drain(s);
+
+			std::fputs("\n]}\n", s.file);
+			std::fclose(s.file);
+			s.file = nullptr;
+
+			Console::Out("Trace written to %s (%i events, %i dropped)", s.filename.c_str(), int(s.written), int(dropped));
+
+			s.active = false;
+		}
+
+	}
+
+	bool Start(const std::string &filename, double seconds)
+	{
+		State &s = state();
+		std::lock_guard<std::mutex> lock(s.control_mutex);
+
+		if (s.active)
+			return false;
+
+		if (s.flusher.joinable())
+			s.flusher.join();
+
+		std::FILE *file = std::fopen(filename.c_str(), "w");
+
+		if (!file)
+			return false;
+
+		std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+
+		s.file = file;
+		s.filename = filename;
+		s.written = 0;
+		s.named.clear();
+
+		{
+			std::lock_guard<std::mutex> rings_lock(s.rings_mutex);
+
+			UTIL_FOREACH_CREF(s.rings, ring)
+			{
+				ring->tail.store(ring->head.load());
+				ring->dropped = 0;
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> stop_lock(s.stop_mutex);
+			s.stop = false;
+		}
+
+		s.epoch = clock::now();
+		clock::time_point deadline = clock::time_point::max();
+
+		if (seconds > 0.0)
+			deadline = s.epoch + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(seconds));
+
+		s.active = true;
+		recording = true;
+		s.flusher = std::thread(flush_main, deadline);
+
+		return true;
+	}
+
+	void Stop()
+	{
+		State &s = state();
+		std::lock_guard<std::mutex> lock(s.control_mutex);
+
+		if (!s.flusher.joinable())
+			return;
+
+		{
+			std::lock_guard<std::mutex> stop_lock(s.stop_mutex);
+			s.stop = true;
+		}
+
+		s.stop_cv.notify_all();
+		s.flusher.join();
+	}
+
+	bool Active()
+	{
+		return state().active;
+	}
+
+	void SetThreadName(const char *name)
+	{
+		thread_ring.name = name;
+
+		if (thread_ring.ring)
+			thread_ring.ring->name = name;
+	}
+
+	void Record(const char *name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+	{
+		Ring &ring = local_ring();
+		std::uint64_t head = ring.head.load(std::memory_order_relaxed);
+
+		if (head - ring.tail.load(std::memory_order_acquire) >= Ring::size)
+		{
+			ring.dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		ring.events[head & (Ring::size - 1)] = Event{name, start, end};
+		ring.head.store(head + 1, std::memory_order_release);
+	}
+
+}
@@ -0,0 +1,77 @@
+/* trace.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef TRACE_HPP_INCLUDED
+#define TRACE_HPP_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#define TRACE_PASTE_AUX2(base, id) base##id
+#define TRACE_PASTE_AUX(base, id) TRACE_PASTE_AUX2(base, id)
+
+/**
+ * Records the rest of the enclosing block as a span, name must outlive the trace (a literal or a registered name)
+ */
+#define TRACE_SCOPE(name) Trace::Scope TRACE_PASTE_AUX(trace_scope_, __LINE__)(name)
+
+/**
+ * Span recorder which writes Chrome trace-event JSON, readable by chrome://tracing and Perfetto
+ * Each thread records in to its own ring buffer without locking. A background thread drains them to disk.
+ * While no trace is running a scope costs one relaxed atomic load.
+ */
+namespace Trace
+{
+
+	extern std::atomic<bool> recording;
+
+	/**
+	 * Starts writing a trace to filename, stopping by itself after the given number of seconds (0 for no limit)
+	 * Returns false if a trace is already running or the file could not be opened.
+	 */
+	bool Start(const std::string &filename, double seconds);
+
+	/**
+	 * Stops the current trace and waits for it to be written
+	 */
+	void Stop();
+
+	bool Active();
+
+	/**
+	 * Name shown for the calling thread in trace viewers, must be a literal
+	 */
+	void SetThreadName(const char *name);
+
+	void Record(const char *name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+	class Scope
+	{
+	private:
+		const char *name;
+		bool active;
+		std::chrono::steady_clock::time_point start;
+
+	public:
+		Scope(const char *name)
+			: name(name), active(recording.load(std::memory_order_relaxed))
+		{
+			if (this->active)
+				this->start = std::chrono::steady_clock::now();
+		}
+
+		Scope(const Scope &) = delete;
+
+		~Scope()
+		{
+			if (this->active)
+				Record(this->name, this->start, std::chrono::steady_clock::now());
+		}
+	};
+
+}
+
+#endif // TRACE_HPP_INCLUDED
@@ -11,6 +11,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <ctime>
+#include <random>
 #include <stdexcept>
 #include <string>
 #include <utility>
@@ -273,39 +274,20 @@ namespace util
 		return result;
 	}
 
-	struct rand_init
+	static std::mt19937 &rand_engine()
 	{
-		rand_init()
-		{
-			static bool initialized;
-
-			if (!initialized)
-			{
-				initialized = true;
-				init();
-			}
-		}
-
-		void init() const
-		{
-			std::srand(std::time(0));
-		}
-	};
+		static std::mt19937 engine(static_cast<std::mt19937::result_type>(std::time(0)));
+		return engine;
+	}
 
-	rand_init rand_init_instance;
+	void rand_seed(unsigned int seed)
+	{
+		rand_engine().seed(seed);
+	}
 
 	static unsigned long long_rand()
 	{
-		typedef unsigned long ul;
-#if RAND_MAX < 65535
-		return ul(std::rand() & 0xFF) << 24 | ul(std::rand() & 0xFF) << 16 | ul(std::rand() & 0xFF) << 8 | ul(std::rand() & 0xFF);
-#else
-#if RAND_MAX < 4294967295
-		return ul(std::rand() & 0xFFFF) << 16 | ul(std::rand() & 0xFFFF);
-#else
-		return ul(std::rand() & 0xFFFFFFFFU);
-#endif
-#endif
+		return static_cast<unsigned long>(rand_engine()());
 	}
 
 	int rand(int min, int max)
@@ -85,6 +85,11 @@ namespace util
 	int rand(int min, int max);
 	double rand(double min, double max);
 
+	/**
+	 * Restarts the sequence returned by rand, which is otherwise seeded from the time the server started
+	 */
+	void rand_seed(unsigned int seed);
+
 	double round(double);
 
 	std::string timeago(double time, double current_time);
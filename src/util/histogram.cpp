@@ -0,0 +1,100 @@
+/* util/histogram.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "histogram.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace util
+{
+
+	histogram::histogram()
+	{
+		this->reset();
+	}
+
+	std::size_t histogram::bucket_index(std::uint64_t value)
+	{
+		if (value < std::uint64_t(sub_buckets))
+			return std::size_t(value);
+
+		int exponent = 63;
+
+		while (!(value >> exponent))
+			--exponent;
+
+		if (exponent > max_exponent)
+			return num_buckets - 1;
+
+		std::size_t sub = std::size_t(value >> (exponent - sub_bucket_bits)) & (sub_buckets - 1);
+
+		return std::size_t(exponent - sub_bucket_bits + 1) * sub_buckets + sub;
+	}
+
+	std::uint64_t histogram::bucket_upper(std::size_t index)
+	{
+		if (index < std::size_t(sub_buckets))
+			return index;
+
+		int exponent = int(index / sub_buckets) + sub_bucket_bits - 1;
+		std::uint64_t sub = index % sub_buckets;
+		std::uint64_t width = std::uint64_t(1) << (exponent - sub_bucket_bits);
+
+		return (std::uint64_t(1) << exponent) + (sub + 1) * width - 1;
+	}
+
+	void histogram::record(std::uint64_t value)
+	{
+		++this->buckets[bucket_index(value)];
+		++this->total_count;
+		this->total_sum += value;
+		this->min_value = std::min(this->min_value, value);
+		this->max_value = std::max(this->max_value, value);
+	}
+
+	void histogram::merge(const histogram &other)
+	{
+		for (std::size_t i = 0; i < num_buckets; ++i)
+			this->buckets[i] += other.buckets[i];
+
+		this->total_count += other.total_count;
+		this->total_sum += other.total_sum;
+		this->min_value = std::min(this->min_value, other.min_value);
+		this->max_value = std::max(this->max_value, other.max_value);
+	}
+
+	void histogram::reset()
+	{
+		this->buckets.fill(0);
+		this->total_count = 0;
+		this->total_sum = 0;
+		this->min_value = UINT64_MAX;
+		this->max_value = 0;
+	}
+
+	std::uint64_t histogram::percentile(double p) const
+	{
+		if (this->total_count == 0)
+			return 0;
+
+		std::uint64_t target = std::uint64_t(double(this->total_count) * std::min(std::max(p, 0.0), 100.0) / 100.0 + 0.5);
+		target = std::max<std::uint64_t>(target, 1);
+
+		std::uint64_t seen = 0;
+
+		for (std::size_t i = 0; i < num_buckets; ++i)
+		{
+			seen += this->buckets[i];
+
+			if (seen >= target)
+				return std::min(bucket_upper(i), this->max_value);
+		}
+
+		return this->max_value;
+	}
+
+}
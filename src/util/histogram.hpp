@@ -0,0 +1,66 @@
+/* util/histogram.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef UTIL_HISTOGRAM_HPP_INCLUDED
+#define UTIL_HISTOGRAM_HPP_INCLUDED
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace util
+{
+
+	/**
+	 * Fixed-size log-linear histogram of non-negative integer samples (HDR-style)
+	 * Each power of two is split into 8 linear buckets, so bucket bounds are within 12.5% of any recorded value.
+	 * Recording a sample is a handful of integer operations and never allocates.
+	 */
+	class histogram
+	{
+	public:
+		static const int sub_bucket_bits = 3;
+		static const int sub_buckets = 1 << sub_bucket_bits;
+		static const int max_exponent = 40;
+		static const std::size_t num_buckets = (max_exponent - sub_bucket_bits + 2) * sub_buckets;
+
+	protected:
+		std::array<std::uint64_t, num_buckets> buckets;
+		std::uint64_t total_count;
+		std::uint64_t total_sum;
+		std::uint64_t min_value;
+		std::uint64_t max_value;
+
+	public:
+		histogram();
+
+		static std::size_t bucket_index(std::uint64_t value);
+
+		/**
+		 * Largest value that falls in a bucket
+		 */
+		static std::uint64_t bucket_upper(std::size_t index);
+
+		void record(std::uint64_t value);
+		void merge(const histogram &other);
+		void reset();
+
+		std::uint64_t count() const { return this->total_count; }
+		std::uint64_t sum() const { return this->total_sum; }
+		std::uint64_t min() const { return this->total_count ? this->min_value : 0; }
+		std::uint64_t max() const { return this->max_value; }
+		double mean() const { return this->total_count ? double(this->total_sum) / double(this->total_count) : 0.0; }
+
+		std::uint64_t bucket(std::size_t index) const { return this->buckets[index]; }
+
+		/**
+		 * Returns the upper bound of the bucket containing the given percentile (0-100)
+		 */
+		std::uint64_t percentile(double p) const;
+	};
+
+}
+
+#endif // UTIL_HISTOGRAM_HPP_INCLUDED
@@ -16,6 +16,7 @@
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "rpn_lex.hpp"
@@ -340,7 +341,8 @@ namespace util
 		{
 		start_of_loop:
 
-			const std::string &val = stack.top();
+			// Moved out, as a reference would dangle once the token is popped
+			std::string val = std::move(stack.top());
 			stack.pop();
 
 			for (std::size_t i = 0; i < sizeof(rpn_eval_funcs) / sizeof(rpn_eval_func); ++i)
@@ -389,4 +391,393 @@ namespace util
 		return argstack.top();
 	}
 
+
+	namespace
+	{
+
+		struct rpn_compile_op
+		{
+			char op;
+			const char *name;
+			std::size_t args;
+			rpn_program::opcode code;
+		};
+
+		// Matched in the same order as rpn_eval_funcs so tokens resolve to the same operation
+		const rpn_compile_op rpn_compile_ops[] = {
+			{'+', "add", 2, rpn_program::op_add},
+			{'-', "sub", 2, rpn_program::op_sub},
+			{'*', "mul", 2, rpn_program::op_mul},
+			{'/', "div", 2, rpn_program::op_div},
+			{'%', "mod", 2, rpn_program::op_mod},
+			{'&', "bitand", 2, rpn_program::op_bitand},
+			{'|', "bitor", 2, rpn_program::op_bitor},
+			{'^', "bitxor", 2, rpn_program::op_bitxor},
+			{'~', "bitnot", 1, rpn_program::op_bitnot},
+			{op_and, "and", 2, rpn_program::op_and},
+			{op_or, "or", 2, rpn_program::op_or},
+			{'!', "not", 1, rpn_program::op_not},
+			{op_neg, "neg", 1, rpn_program::op_neg},
+			{' ', "pow", 2, rpn_program::op_pow},
+			{' ', "sqrt", 1, rpn_program::op_sqrt},
+			{' ', "log", 1, rpn_program::op_log},
+			{' ', "exp", 1, rpn_program::op_exp},
+			{' ', "ln", 1, rpn_program::op_ln},
+			{' ', "sin", 1, rpn_program::op_sin},
+			{' ', "cos", 1, rpn_program::op_cos},
+			{' ', "tan", 1, rpn_program::op_tan},
+			{' ', "rand", 2, rpn_program::op_rand},
+			{' ', "min", 2, rpn_program::op_min},
+			{' ', "max", 2, rpn_program::op_max},
+			{' ', "ceil", 1, rpn_program::op_ceil},
+			{' ', "round", 1, rpn_program::op_round},
+			{' ', "floor", 1, rpn_program::op_floor},
+			{'<', "lt", 2, rpn_program::op_lt},
+			{op_lte, "lte", 2, rpn_program::op_lte},
+			{'=', "eq", 2, rpn_program::op_eq},
+			{op_ne, "ne", 2, rpn_program::op_ne},
+			{op_gte, "gte", 2, rpn_program::op_gte},
+			{'>', "gt", 2, rpn_program::op_gt},
+
+			{'?', "iif", 3, rpn_program::op_iif},
+		};
+
+		// Numbers can never be variable names, so they are parsed once here instead of on every evaluation
+		bool rpn_is_number(const std::string &tok)
+		{
+			return !tok.empty() && ((tok[0] >= '0' && tok[0] <= '9') || tok[0] == '.');
+		}
+
+		// Each operation is written once here and expanded into both the scalar and the batch evaluator
+		// a is the operand pushed last, which rpn_eval pops first, then b, then c
+#define RPN_UNARY_OPS(X) \
+		X(op_bitnot, ~d2i(a)) \
+		X(op_not, !d2i(a)) \
+		X(op_neg, -a) \
+		X(op_sqrt, std::sqrt(a)) \
+		X(op_log, std::log10(a)) \
+		X(op_exp, std::exp(a)) \
+		X(op_ln, std::log(a)) \
+		X(op_sin, std::sin(a)) \
+		X(op_cos, std::cos(a)) \
+		X(op_tan, std::tan(a)) \
+		X(op_ceil, std::ceil(a)) \
+		X(op_round, std::floor(a + 0.5)) \
+		X(op_floor, std::floor(a))
+
+#define RPN_BINARY_OPS(X) \
+		X(op_add, a + b) \
+		X(op_sub, a - b) \
+		X(op_mul, a * b) \
+		X(op_div, a / b) \
+		X(op_mod, d2i(a) % d2i(b)) \
+		X(op_bitand, d2i(a) & d2i(b)) \
+		X(op_bitor, d2i(a) | d2i(b)) \
+		X(op_bitxor, d2i(a) ^ d2i(b)) \
+		X(op_and, d2i(a) && d2i(b)) \
+		X(op_or, d2i(a) || d2i(b)) \
+		X(op_pow, std::pow(a, b)) \
+		X(op_rand, rand(a, b)) \
+		X(op_min, std::min(a, b)) \
+		X(op_max, std::max(a, b)) \
+		X(op_lt, a < b - rpn_cmp_epsilon) \
+		X(op_lte, a <= b + rpn_cmp_epsilon) \
+		X(op_eq, a >= b - rpn_cmp_epsilon_2 && a <= b + rpn_cmp_epsilon_2) \
+		X(op_ne, a < b - rpn_cmp_epsilon_2 || a > b + rpn_cmp_epsilon_2) \
+		X(op_gte, a >= b - rpn_cmp_epsilon) \
+		X(op_gt, a > b + rpn_cmp_epsilon)
+
+#define RPN_TERNARY_OPS(X) \
+		X(op_iif, d2i(a) ? b : c)
+
+		template <class Load>
+		double rpn_run(const rpn_program::instruction *begin, const rpn_program::instruction *end, Load load)
+		{
+			double stack[rpn_program::max_stack];
+			std::size_t sp = 0;
+
+			for (const rpn_program::instruction *ins = begin; ins != end; ++ins)
+			{
+				// t[-1] is the operand pushed last, which rpn_eval pops first
+				double *t = stack + sp;
+
+				switch (ins->op)
+				{
+					case rpn_program::op_const: stack[sp++] = ins->value; break;
+					case rpn_program::op_var: stack[sp++] = load(ins->slot); break;
+
+#define RPN_CASE(code, expr) case rpn_program::code: { double a = t[-1]; t[-1] = (expr); break; }
+					RPN_UNARY_OPS(RPN_CASE)
+#undef RPN_CASE
+
+#define RPN_CASE(code, expr) case rpn_program::code: { double a = t[-1], b = t[-2]; t[-2] = (expr); --sp; break; }
+					RPN_BINARY_OPS(RPN_CASE)
+#undef RPN_CASE
+
+#define RPN_CASE(code, expr) case rpn_program::code: { double a = t[-1], b = t[-2], c = t[-3]; t[-3] = (expr); sp -= 2; break; }
+					RPN_TERNARY_OPS(RPN_CASE)
+#undef RPN_CASE
+				}
+			}
+
+			return sp ? stack[sp - 1] : 0.0;
+		}
+
+		// Number of inputs the batch evaluator works through at a time, small enough to keep its value stack in cache
+		const std::size_t rpn_batch_lanes = 32;
+
+		void rpn_run_batch(const std::vector<rpn_program::instruction> &code, const double *const *columns, std::size_t count, double *out)
+		{
+			double stack[rpn_program::max_stack][rpn_batch_lanes];
+
+			for (std::size_t base = 0; base < count; base += rpn_batch_lanes)
+			{
+				std::size_t n = std::min(rpn_batch_lanes, count - base);
+				std::size_t sp = 0;
+
+				for (const rpn_program::instruction &ins : code)
+				{
+					switch (ins.op)
+					{
+						case rpn_program::op_const: std::fill_n(stack[sp++], n, ins.value); break;
+						case rpn_program::op_var: std::copy_n(columns[ins.slot] + base, n, stack[sp++]); break;
+
+#define RPN_CASE(code, expr) case rpn_program::code: { double *x = stack[sp - 1]; for (std::size_t i = 0; i < n; ++i) { double a = x[i]; x[i] = (expr); } break; }
+						RPN_UNARY_OPS(RPN_CASE)
+#undef RPN_CASE
+
+#define RPN_CASE(code, expr) case rpn_program::code: { double *x = stack[sp - 1], *y = stack[sp - 2]; for (std::size_t i = 0; i < n; ++i) { double a = x[i], b = y[i]; y[i] = (expr); } --sp; break; }
+						RPN_BINARY_OPS(RPN_CASE)
+#undef RPN_CASE
+
+#define RPN_CASE(code, expr) case rpn_program::code: { double *x = stack[sp - 1], *y = stack[sp - 2], *z = stack[sp - 3]; for (std::size_t i = 0; i < n; ++i) { double a = x[i], b = y[i], c = z[i]; z[i] = (expr); } sp -= 2; break; }
+						RPN_TERNARY_OPS(RPN_CASE)
+#undef RPN_CASE
+					}
+				}
+
+				if (sp)
+					std::copy_n(stack[sp - 1], n, out + base);
+				else
+					std::fill_n(out + base, n, 0.0);
+			}
+		}
+
+#undef RPN_TERNARY_OPS
+#undef RPN_BINARY_OPS
+#undef RPN_UNARY_OPS
+
+	}
+
+	rpn_program::rpn_program()
+		: underflow(false), uses_rand(false)
+	{
+	}
+
+	rpn_program::rpn_program(std::stack<std::string> stack)
+		: underflow(false), uses_rand(false)
+	{
+		this->compile(stack, nullptr);
+	}
+
+	rpn_program::rpn_program(std::stack<std::string> stack, const std::function<int(const std::string &)> &resolve)
+		: underflow(false), uses_rand(false)
+	{
+		this->compile(stack, &resolve);
+	}
+
+	void rpn_program::compile(std::stack<std::string> &stack, const std::function<int(const std::string &)> *resolve)
+	{
+		std::unordered_map<std::string, unsigned int> slot_index;
+		std::size_t depth = 0;
+
+		this->code.reserve(stack.size());
+
+		for (; !stack.empty(); stack.pop())
+		{
+			const std::string &tok = stack.top();
+			const rpn_compile_op *match = nullptr;
+
+			for (const rpn_compile_op &op : rpn_compile_ops)
+			{
+				if (tok == op.name || (op.op != ' ' && tok[0] == op.op))
+				{
+					match = &op;
+					break;
+				}
+			}
+
+			if (match)
+			{
+				if (depth < match->args)
+				{
+					// rpn_eval only notices this once it gets here, so neither does the compiled program
+					this->underflow = true;
+					break;
+				}
+
+				depth -= match->args - 1;
+
+				if (match->code == op_rand)
+					this->uses_rand = true;
+
+				this->code.push_back({match->code, 0, 0.0});
+				continue;
+			}
+
+			if (++depth > max_stack)
+				throw std::runtime_error("RPN expression too complex");
+
+			if (rpn_is_number(tok))
+			{
+				this->code.push_back({op_const, 0, tdparse(tok)});
+				continue;
+			}
+
+			int slot;
+
+			if (resolve)
+			{
+				slot = (*resolve)(tok);
+
+				if (slot < 0)
+				{
+					this->code.push_back({op_const, 0, tdparse(tok)});
+					continue;
+				}
+			}
+			else
+			{
+				slot = static_cast<int>(slot_index.insert({tok, static_cast<unsigned int>(this->var_names.size())}).first->second);
+			}
+
+			if (std::size_t(slot) >= this->var_names.size())
+			{
+				this->var_names.resize(slot + 1);
+				this->var_defaults.resize(slot + 1, 0.0);
+			}
+
+			this->var_names[slot] = tok;
+			this->var_defaults[slot] = tdparse(tok);
+
+			this->code.push_back({op_var, static_cast<unsigned int>(slot), 0.0});
+		}
+
+		if (!this->underflow)
+			this->optimize();
+	}
+
+	static std::size_t rpn_arity(rpn_program::opcode code)
+	{
+		for (const rpn_compile_op &op : rpn_compile_ops)
+		{
+			if (op.code == code)
+				return op.args;
+		}
+
+		return 0;
+	}
+
+	void rpn_program::optimize()
+	{
+		// Position in the optimized code where each value on the stack starts being computed
+		struct operand
+		{
+			std::size_t start;
+			bool constant;
+		};
+
+		std::vector<instruction> out;
+		std::vector<operand> operands;
+
+		out.reserve(this->code.size());
+
+		for (const instruction &ins : this->code)
+		{
+			if (ins.op == op_const || ins.op == op_var)
+			{
+				operands.push_back({out.size(), ins.op == op_const});
+				out.push_back(ins);
+				continue;
+			}
+
+			std::size_t args = rpn_arity(ins.op);
+			const operand *first = &operands[operands.size() - args];
+			const operand &last = operands.back();
+			std::size_t start = first->start;
+
+			bool constant = ins.op != op_rand && std::all_of(first, first + args, [](const operand &o) { return o.constant; });
+
+			// A constant operand is always a single op_const instruction
+			auto constant_is = [&](const operand &o, bool truth) { return o.constant && (d2i(out[o.start].value) != 0) == truth; };
+
+			if (constant)
+			{
+				out.push_back(ins);
+				double value = rpn_run(out.data() + start, out.data() + out.size(), [](unsigned int) { return 0.0; });
+				out.resize(start);
+				out.push_back({op_const, 0, value});
+			}
+			else if (ins.op == op_iif && last.constant)
+			{
+				const operand &then_branch = operands[operands.size() - 2];
+				bool take_then = constant_is(last, true);
+
+				std::size_t from = take_then ? then_branch.start : first->start;
+				std::size_t to = take_then ? last.start : then_branch.start;
+				constant = take_then ? then_branch.constant : first->constant;
+
+				out.erase(out.begin() + to, out.end());
+				out.erase(out.begin() + start, out.begin() + from);
+			}
+			else if ((ins.op == op_and && (constant_is(*first, false) || constant_is(last, false)))
+				  || (ins.op == op_or && (constant_is(*first, true) || constant_is(last, true))))
+			{
+				out.resize(start);
+				out.push_back({op_const, 0, ins.op == op_and ? 0.0 : 1.0});
+				constant = true;
+			}
+			else
+			{
+				out.push_back(ins);
+			}
+
+			operands.resize(operands.size() - args);
+			operands.push_back({start, constant});
+		}
+
+		this->code = std::move(out);
+	}
+
+	double rpn_program::eval(const double *frame) const
+	{
+		if (this->underflow)
+			throw std::runtime_error("RPN Stack underflow");
+
+		return rpn_run(this->code.data(), this->code.data() + this->code.size(), [frame](unsigned int slot)
+		{
+			return frame[slot];
+		});
+	}
+
+	void rpn_program::eval(const double *const *columns, std::size_t count, double *results) const
+	{
+		if (this->underflow)
+			throw std::runtime_error("RPN Stack underflow");
+
+		rpn_run_batch(this->code, columns, count, results);
+	}
+
+	double rpn_program::eval(const std::unordered_map<std::string, double> &vars) const
+	{
+		if (this->underflow)
+			throw std::runtime_error("RPN Stack underflow");
+
+		return rpn_run(this->code.data(), this->code.data() + this->code.size(), [this, &vars](unsigned int slot)
+		{
+			auto it = vars.find(this->var_names[slot]);
+			return (it != vars.end()) ? it->second : this->var_defaults[slot];
+		});
+	}
+
 }
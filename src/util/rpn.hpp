@@ -6,9 +6,12 @@
 #ifndef UTIL_RPN_HPP_INCLUDED
 #define UTIL_RPN_HPP_INCLUDED
 
+#include <cstddef>
+#include <functional>
 #include <stack>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace util
 {
@@ -20,6 +23,108 @@ namespace util
     std::stack<std::string> rpn_parse_v2(std::string expr);
     double rpn_eval(std::stack<std::string>, const std::unordered_map<std::string, double> &vars);
 
+    /**
+     * An RPN expression compiled to flat bytecode with its numbers pre-parsed and its variables numbered
+     * Produces the same results as rpn_eval on the stack it was compiled from, without allocating or parsing.
+     */
+    class rpn_program
+    {
+    public:
+        enum opcode : unsigned char
+        {
+            op_const,
+            op_var,
+
+            op_add, op_sub, op_mul, op_div, op_mod,
+            op_bitand, op_bitor, op_bitxor, op_bitnot,
+            op_and, op_or, op_not, op_neg,
+            op_pow, op_sqrt, op_log, op_exp, op_ln,
+            op_sin, op_cos, op_tan,
+            op_rand, op_min, op_max,
+            op_ceil, op_round, op_floor,
+            op_lt, op_lte, op_eq, op_ne, op_gte, op_gt,
+            op_iif
+        };
+
+        struct instruction
+        {
+            opcode op;
+            unsigned int slot;
+            double value;
+        };
+
+        /**
+         * Deepest value stack a program may need, deeper expressions are rejected by the compiler
+         */
+        static const std::size_t max_stack = 64;
+
+    protected:
+        std::vector<instruction> code;
+
+        std::vector<std::string> var_names;
+
+        // Value of each variable when it is not bound, matching rpn_eval's fallback of parsing the name as a number
+        std::vector<double> var_defaults;
+
+        bool underflow;
+        bool uses_rand;
+
+        void compile(std::stack<std::string> &stack, const std::function<int(const std::string &)> *resolve);
+
+        /**
+         * Folds operations on constants and drops iif branches and and/or operands that a constant makes unreachable
+         */
+        void optimize();
+
+    public:
+        rpn_program();
+
+        /**
+         * Compiles with each distinct variable numbered in order of appearance
+         * @throw std::runtime_error if the expression needs more than max_stack values
+         */
+        explicit rpn_program(std::stack<std::string> stack);
+
+        /**
+         * Compiles with variables placed in the slots returned by resolve
+         * Names that resolve to -1 can never be bound, so they are compiled as constants.
+         * @throw std::runtime_error if the expression needs more than max_stack values
+         */
+        rpn_program(std::stack<std::string> stack, const std::function<int(const std::string &)> &resolve);
+
+        const std::vector<instruction> &instructions() const { return this->code; }
+
+        /**
+         * Returns the number of values eval() reads from a frame, slots that are never read have an empty name
+         */
+        std::size_t slots() const { return this->var_names.size(); }
+        const std::string &slot_name(std::size_t slot) const { return this->var_names[slot]; }
+        double slot_default(std::size_t slot) const { return this->var_defaults[slot]; }
+
+        /**
+         * Returns false if the program calls rand() and so cannot be compared against another evaluation
+         */
+        bool deterministic() const { return !this->uses_rand; }
+
+        /**
+         * Evaluates the program with a value for every slot
+         * @throw std::runtime_error on stack underflow
+         */
+        double eval(const double *frame) const;
+
+        /**
+         * Evaluates the program looking each variable up by name
+         * @throw std::runtime_error on stack underflow
+         */
+        double eval(const std::unordered_map<std::string, double> &vars) const;
+
+        /**
+         * Evaluates the program over count sets of inputs at once, reading slot i of input n from columns[i][n]
+         * @throw std::runtime_error on stack underflow
+         */
+        void eval(const double *const *columns, std::size_t count, double *results) const;
+    };
+
 }
 
 #endif // UTIL_RPN_HPP_INCLUDED
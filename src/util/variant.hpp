@@ -17,6 +17,15 @@ namespace util
 	 */
 	class variant
 	{
+	public:
+		enum var_type
+		{
+			type_int,
+			type_float,
+			type_string,
+			type_bool
+		};
+
 	protected:
 		/**
 		 * Value stored as an integer.
@@ -38,14 +47,6 @@ namespace util
 		 */
 		mutable bool val_bool;
 
-		enum var_type
-		{
-			type_int,
-			type_float,
-			type_string,
-			type_bool
-		};
-
 		mutable bool cache_val[4];
 
 		/**
@@ -65,6 +66,11 @@ namespace util
 		static int int_length(int);
 
 	public:
+		/**
+		 * Return the type the value is stored as.
+		 */
+		var_type GetType() const { return this->type; }
+
 		/**
 		 * Return the value as an integer, casting if neccessary.
 		 */
@@ -0,0 +1,136 @@
+/* watchdog.cpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#include "watchdog.hpp"
+
+#include "eoclient.hpp"
+
+#include "console.hpp"
+#include "socket.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static std::uint64_t watchdog_us(std::chrono::steady_clock::duration d)
+{
+	return std::uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+}
+
+Tick_Watchdog::Tick_Watchdog()
+	: budget_us(0), long_ticks(0), suppressed(0)
+{
+	this->phases.reserve(8);
+	this->spans.reserve(64);
+}
+
+void Tick_Watchdog::SetBudget(double seconds)
+{
+	this->budget_us = std::uint64_t(std::max(seconds, 0.0) * 1000000.0);
+}
+
+void Tick_Watchdog::BeginTick()
+{
+	this->tick_start = this->mark = clock::now();
+	this->phases.clear();
+	this->spans.clear();
+}
+
+std::uint64_t Tick_Watchdog::Mark(const char *phase)
+{
+	clock::time_point now = clock::now();
+	std::uint64_t us = watchdog_us(now - this->mark);
+	this->mark = now;
+
+	if (this->Enabled())
+		this->phases.push_back({"phase", phase, us, false, 0, 0});
+
+	return us;
+}
+
+void Tick_Watchdog::Record(const char *kind, const char *name, std::uint64_t us, const EOClient *client)
+{
+	if (!this->Enabled())
+		return;
+
+	Span span{kind, name ? name : "unnamed", us, false, 0, 0};
+
+	if (client)
+	{
+		span.has_client = true;
+		span.client_id = client->id;
+		span.client_addr = client->GetRemoteAddr().GetInt();
+	}
+
+	this->spans.push_back(span);
+}
+
+std::uint64_t Tick_Watchdog::EndTick()
+{
+	clock::time_point now = clock::now();
+	std::uint64_t total_us = watchdog_us(now - this->tick_start);
+
+	if (this->Enabled() && total_us > this->budget_us)
+	{
+		++this->long_ticks;
+
+		// A server that is overloaded would otherwise log every tick
+		if (now - this->last_report < std::chrono::seconds(1))
+		{
+			++this->suppressed;
+		}
+		else
+		{
+			this->last_report = now;
+			this->Report(total_us);
+			this->suppressed = 0;
+		}
+	}
+
+	return total_us;
+}
+
+void Tick_Watchdog::Report(std::uint64_t total_us)
+{
+	char buffer[64];
+	std::string breakdown;
+
+	UTIL_FOREACH_CREF(this->phases, phase)
+	{
+		std::snprintf(buffer, sizeof buffer, "%s%s %.1fms", breakdown.empty() ? "" : ", ", phase.name, double(phase.us) / 1000.0);
+		breakdown += buffer;
+	}
+
+	Console::Wrn("Tick took %.1fms (budget %.1fms): %s", double(total_us) / 1000.0, double(this->budget_us) / 1000.0, breakdown.c_str());
+
+	if (this->suppressed > 0)
+		Console::Wrn("  %i more long ticks since the last report were not shown", int(this->suppressed));
+
+	std::sort(UTIL_RANGE(this->spans), [](const Span &a, const Span &b) { return a.us > b.us; });
+
+	for (std::size_t i = 0; i < std::min<std::size_t>(5, this->spans.size()); ++i)
+	{
+		const Span &span = this->spans[i];
+
+		// Anything under a tenth of the budget didn't cause the overrun
+		if (span.us * 10 < this->budget_us)
+			break;
+
+		if (span.has_client)
+		{
+			Console::Wrn("  %s %s: %.1fms (client %u, %s)", span.kind, span.name, double(span.us) / 1000.0,
+				span.client_id, IPAddress(span.client_addr).GetString().c_str());
+		}
+		else
+		{
+			Console::Wrn("  %s %s: %.1fms", span.kind, span.name, double(span.us) / 1000.0);
+		}
+	}
+}
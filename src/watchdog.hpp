@@ -0,0 +1,87 @@
+/* watchdog.hpp
+ * EOSERV is released under the zlib license.
+ * See LICENSE.txt for more info.
+ */
+
+#ifndef WATCHDOG_HPP_INCLUDED
+#define WATCHDOG_HPP_INCLUDED
+
+#include "fwd/watchdog.hpp"
+
+#include "fwd/eoclient.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Times each phase of a server tick and logs a breakdown of any tick that runs over budget
+ * Timer callbacks and packet handlers report their own durations, so a long tick can be blamed on them by name.
+ */
+class Tick_Watchdog
+{
+public:
+	struct Span
+	{
+		const char *kind;
+		const char *name;
+		std::uint64_t us;
+
+		/**
+		 * Client a packet handler ran for, copied since the client may be gone by the end of the tick
+		 */
+		bool has_client;
+		unsigned int client_id;
+		unsigned int client_addr;
+	};
+
+protected:
+	typedef std::chrono::steady_clock clock;
+
+	std::uint64_t budget_us;
+
+	clock::time_point tick_start;
+	clock::time_point mark;
+
+	std::vector<Span> phases;
+	std::vector<Span> spans;
+
+	std::uint64_t long_ticks;
+	std::uint64_t suppressed;
+	clock::time_point last_report;
+
+	void Report(std::uint64_t total_us);
+
+public:
+	Tick_Watchdog();
+
+	/**
+	 * Ticks taking longer than this are logged, 0 to disable
+	 */
+	void SetBudget(double seconds);
+
+	bool Enabled() const { return this->budget_us != 0; }
+
+	void BeginTick();
+
+	/**
+	 * Ends the current phase and starts the next one
+	 * @return Length of the phase that ended in microseconds
+	 */
+	std::uint64_t Mark(const char *phase);
+
+	/**
+	 * Records work done inside the current phase
+	 */
+	void Record(const char *kind, const char *name, std::uint64_t us, const EOClient *client = nullptr);
+
+	/**
+	 * @return Length of the whole tick in microseconds
+	 */
+	std::uint64_t EndTick();
+
+	std::uint64_t LongTicks() const { return this->long_ticks; }
+};
+
+#endif // WATCHDOG_HPP_INCLUDED
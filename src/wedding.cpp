@@ -51,7 +51,7 @@ void Wedding::StartTimer()
 {
 	if (!this->tick_timer)
 	{
-		this->tick_timer = new TimeEvent(wedding_tick, this, 1.5, Timer::FOREVER);
+		this->tick_timer = new TimeEvent(wedding_tick, this, 1.5, Timer::FOREVER, "wedding_tick");
 		this->map->world->timer.Register(this->tick_timer);
 	}
 }
@@ -223,7 +223,7 @@ void Wedding::Tick()
 			p1->fiance.clear();
 			p2->fiance.clear();
 
-			short ring_id = short(int(this->map->world->config["WeddingRing"]));
+			short ring_id = short(this->map->world->settings.GetInt(ConfigKey::WeddingRing));
 
 			if (ring_id)
 			{
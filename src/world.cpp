@@ -13,6 +13,8 @@
 #include "eodata.hpp"
 #include "eoplus.hpp"
 #include "eoserver.hpp"
+#include "eoserv_config.hpp"
+#include "formula_vars.hpp"
 #include "guild.hpp"
 #include "i18n.hpp"
 #include "map.hpp"
@@ -28,18 +30,21 @@
 #include "handlers/handlers.hpp"
 
 #include "console.hpp"
-#include "hash.hpp"
 #include "util.hpp"
 #include "util/rpn.hpp"
-#include "util/secure_string.hpp"
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cmath>
 #include <ctime>
+#include <exception>
+#include <future>
 #include <limits>
 #include <list>
+#include <map>
 #include <memory>
+#include <set>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
@@ -50,13 +55,13 @@ void world_spawn_npcs(void *world_void)
 {
 	World *world(static_cast<World *>(world_void));
 
-	double spawnrate = world->config["SpawnRate"];
+	double spawnrate = world->settings.GetFloat(ConfigKey::SpawnRate);
 	double current_time = Timer::GetTime();
 	UTIL_FOREACH(world->maps, map)
 	{
 		UTIL_FOREACH(map->npcs, npc)
 		{
-			if ((!npc->alive && npc->dead_since + (double(npc->spawn_time) * spawnrate) < current_time) && (!npc->ENF().child || (npc->parent && npc->parent->alive && world->config["RespawnBossChildren"])))
+			if ((!npc->alive && npc->dead_since + (double(npc->spawn_time) * spawnrate) < current_time) && (!npc->ENF().child || (npc->parent && npc->parent->alive && world->settings.GetBool(ConfigKey::RespawnBossChildren))))
 			{
 #ifdef DEBUG
 				Console::Dbg("Spawning NPC %i on map %i", npc->id, map->id);
@@ -95,9 +100,9 @@ void world_recover(void *world_void)
 		if (character->hp != character->maxhp)
 		{
 			if (character->sitting != SIT_STAND)
-				character->hp += character->maxhp * double(world->config["SitHPRecoverRate"]);
+				character->hp += character->maxhp * world->settings.GetFloat(ConfigKey::SitHPRecoverRate);
 			else
-				character->hp += character->maxhp * double(world->config["HPRecoverRate"]);
+				character->hp += character->maxhp * world->settings.GetFloat(ConfigKey::HPRecoverRate);
 
 			character->hp = std::min(character->hp, character->maxhp);
 			updated = true;
@@ -111,9 +116,9 @@ void world_recover(void *world_void)
 		if (character->tp != character->maxtp)
 		{
 			if (character->sitting != SIT_STAND)
-				character->tp += character->maxtp * double(world->config["SitTPRecoverRate"]);
+				character->tp += character->maxtp * world->settings.GetFloat(ConfigKey::SitTPRecoverRate);
 			else
-				character->tp += character->maxtp * double(world->config["TPRecoverRate"]);
+				character->tp += character->maxtp * world->settings.GetFloat(ConfigKey::TPRecoverRate);
 
 			character->tp = std::min(character->tp, character->maxtp);
 			updated = true;
@@ -140,7 +145,7 @@ void world_npc_recover(void *world_void)
 		{
 			if (npc->alive && npc->hp < npc->ENF().hp)
 			{
-				npc->hp += npc->ENF().hp * double(world->config["NPCRecoverRate"]);
+				npc->hp += npc->ENF().hp * world->settings.GetFloat(ConfigKey::NPCRecoverRate);
 
 				npc->hp = std::min(npc->hp, npc->ENF().hp);
 			}
@@ -168,7 +173,7 @@ void world_warp_suck(void *world_void)
 	World *world(static_cast<World *>(world_void));
 
 	double now = Timer::GetTime();
-	double delay = world->config["WarpSuck"];
+	double delay = world->settings.GetInt(ConfigKey::WarpSuck);
 
 	UTIL_FOREACH(world->maps, map)
 	{
@@ -223,7 +228,7 @@ void world_despawn_items(void *world_void)
 	restart_loop:
 		UTIL_FOREACH(map->items, item)
 		{
-			if (item->unprotecttime < (Timer::GetTime() - static_cast<double>(world->config["ItemDespawnRate"])))
+			if (item->unprotecttime < (Timer::GetTime() - world->settings.GetFloat(ConfigKey::ItemDespawnRate)))
 			{
 				map->DelItem(item->uid, 0);
 				goto restart_loop;
@@ -236,9 +241,11 @@ void world_timed_save(void *world_void)
 {
 	World *world = static_cast<World *>(world_void);
 
-	if (!world->config["TimedSave"])
+	if (!world->settings.GetFloat(ConfigKey::TimedSave))
 		return;
 
+	Database_Stats::Caller_Scope db_caller(world->db.stats, "TimedSave");
+
 	UTIL_FOREACH(world->characters, character)
 	{
 		character->Save();
@@ -249,6 +256,9 @@ void world_timed_save(void *world_void)
 	try
 	{
 		world->CommitDB();
+
+		// Everything in the journal is now in the database
+		world->journal.Truncate();
 	}
 	catch (Database_Exception &e)
 	{
@@ -292,13 +302,47 @@ void world_quakes(void *world_void)
 	}
 }
 
+void world_sync_journal(void *world_void)
+{
+	World *world = static_cast<World *>(world_void);
+
+	UTIL_FOREACH(world->characters, character)
+	{
+		character->WriteJournal(world->journal);
+	}
+
+	if (!world->journal.Sync())
+		Console::Wrn("Could not write to the journal file");
+}
+
+void world_expire_bans(void *world_void)
+{
+	World *world = static_cast<World *>(world_void);
+
+	world->bans.Expire(int(std::time(0)));
+}
+
+void world_poll_password_hasher(void *world_void)
+{
+	World *world = static_cast<World *>(world_void);
+
+	world->password_hasher.Poll();
+}
+
+void world_poll_reload(void *world_void)
+{
+	World *world = static_cast<World *>(world_void);
+
+	world->PollReload();
+}
+
 void World::UpdateConfig()
 {
-	this->timer.SetMaxDelta(this->config["ClockMaxDelta"]);
+	this->timer.SetMaxDelta(this->settings.GetInt(ConfigKey::ClockMaxDelta));
 
-	double rate_face = this->config["PacketRateFace"];
-	double rate_walk = this->config["PacketRateWalk"];
-	double rate_attack = this->config["PacketRateAttack"];
+	double rate_face = this->settings.GetFloat(ConfigKey::PacketRateFace);
+	double rate_walk = this->settings.GetFloat(ConfigKey::PacketRateWalk);
+	double rate_attack = this->settings.GetFloat(ConfigKey::PacketRateAttack);
 
 	Handlers::SetDelay(PACKET_FACE, PACKET_PLAYER, rate_face);
 
@@ -310,7 +354,7 @@ void World::UpdateConfig()
 
 	std::array<double, 7> npc_speed_table;
 
-	std::vector<std::string> rate_list = util::explode(',', this->config["NPCMovementRate"]);
+	std::vector<std::string> rate_list = util::explode(',', this->settings.GetString(ConfigKey::NPCMovementRate));
 
 	for (std::size_t i = 0; i < std::min<std::size_t>(7, rate_list.size()); ++i)
 	{
@@ -322,11 +366,30 @@ void World::UpdateConfig()
 
 	NPC::SetSpeedTable(npc_speed_table);
 
-	this->i18n.SetLangFile(this->config["ServerLanguage"]);
+	this->i18n.SetLangFile(this->settings.GetString(ConfigKey::ServerLanguage));
+
+	this->db.stats.SetSlowThreshold(this->settings.GetFloat(ConfigKey::SlowQueryThreshold));
+	this->db_pool.SetHealthCheckInterval(this->settings.GetFloat(ConfigKey::DBPoolHealthCheck));
+
+	Password_Hasher::Settings password_settings;
+	password_settings.salt = this->settings.GetString(ConfigKey::PasswordSalt);
+	password_settings.cost = std::max(1, std::min(20, this->settings.GetInt(ConfigKey::PasswordHashCost)));
+
+	std::string password_scheme = util::lowercase(this->settings.GetString(ConfigKey::PasswordHash));
+
+	if (password_scheme == "scrypt")
+		password_settings.scheme = Password_Hasher::Scrypt;
+	else if (password_scheme == "sha256")
+		password_settings.scheme = Password_Hasher::SHA256;
+	else
+		Console::Wrn("Unknown PasswordHash scheme: %s (using sha256)", password_scheme.c_str());
+
+	this->password_hasher.SetSettings(password_settings);
+	this->password_hasher.SetMaxPending(std::size_t(std::max(0, this->settings.GetInt(ConfigKey::PasswordHashQueue))));
 
 	this->instrument_ids.clear();
 
-	std::vector<std::string> instrument_list = util::explode(',', this->config["InstrumentItems"]);
+	std::vector<std::string> instrument_list = util::explode(',', this->settings.GetString(ConfigKey::InstrumentItems));
 	this->instrument_ids.reserve(instrument_list.size());
 
 	for (std::size_t i = 0; i < instrument_list.size(); ++i)
@@ -334,7 +397,7 @@ void World::UpdateConfig()
 		this->instrument_ids.push_back(int(util::tdparse(instrument_list[i])));
 	}
 
-	if (this->db.Pending() && !this->config["TimedSave"])
+	if (this->db.Pending() && !this->settings.GetFloat(ConfigKey::TimedSave))
 	{
 		try
 		{
@@ -349,7 +412,7 @@ void World::UpdateConfig()
 }
 
 World::World(std::array<std::string, 6> dbinfo, const Config &eoserv_config, const Config &admin_config)
-	: i18n(eoserv_config.find("ServerLanguage")->second), admin_count(0)
+	: i18n(eoserv_config.find("ServerLanguage")->second), password_hasher(int(eoserv_config.find("PasswordHashThreads")->second)), admin_count(0)
 {
 	if (int(this->timer.resolution * 1000.0) > 1)
 	{
@@ -361,6 +424,7 @@ World::World(std::array<std::string, 6> dbinfo, const Config &eoserv_config, con
 	}
 
 	this->config = eoserv_config;
+	this->settings.Load(this->config);
 	this->admin_config = admin_config;
 
 	Database::Engine engine;
@@ -385,24 +449,43 @@ World::World(std::array<std::string, 6> dbinfo, const Config &eoserv_config, con
 
 	Console::Out("Connecting to database (%s)...", dbdesc.c_str());
 	this->db.Connect(engine, dbinfo[1], util::to_int(dbinfo[5]), dbinfo[2], dbinfo[3], dbinfo[4]);
+
+	Database::SQLite_Options sqlite_options;
+
+	if (engine == Database::SQLite)
+	{
+		sqlite_options.wal = this->settings.GetBool(ConfigKey::SQLiteWAL);
+		sqlite_options.synchronous = util::lowercase(this->settings.GetString(ConfigKey::SQLiteSynchronous));
+		sqlite_options.cache_size = this->settings.GetInt(ConfigKey::SQLiteCacheSize);
+		sqlite_options.mmap_size = this->settings.GetInt(ConfigKey::SQLiteMmapSize);
+		sqlite_options.prepared_statements = this->settings.GetBool(ConfigKey::SQLitePreparedStatements);
+		this->db.SetSQLiteOptions(sqlite_options);
+	}
+
+	if (this->settings.GetInt(ConfigKey::DBPoolSize) > 0)
+	{
+		this->db_pool.Open(this->settings.GetInt(ConfigKey::DBPoolSize), engine, dbinfo[1], util::to_int(dbinfo[5]), dbinfo[2], dbinfo[3], dbinfo[4], sqlite_options);
+		Console::Out("Opened %i pooled database connections", int(this->db_pool.Size()));
+	}
+
 	this->BeginDB();
 
-	this->drops_config.Read(this->config["DropsFile"]);
-	this->shops_config.Read(this->config["ShopsFile"]);
-	this->arenas_config.Read(this->config["ArenasFile"]);
-	this->formulas_config.Read(this->config["FormulasFile"]);
-	this->home_config.Read(this->config["HomeFile"]);
-	this->skills_config.Read(this->config["SkillsFile"]);
+	this->drops_config.Read(this->settings.GetString(ConfigKey::DropsFile));
+	this->shops_config.Read(this->settings.GetString(ConfigKey::ShopsFile));
+	this->arenas_config.Read(this->settings.GetString(ConfigKey::ArenasFile));
+	this->formulas_config.Read(this->settings.GetString(ConfigKey::FormulasFile));
+	this->home_config.Read(this->settings.GetString(ConfigKey::HomeFile));
+	this->skills_config.Read(this->settings.GetString(ConfigKey::SkillsFile));
 
 	this->UpdateConfig();
 	this->LoadHome();
 
-	bool auto_split = this->config["AutoSplitPubFiles"];
+	bool auto_split = this->settings.GetBool(ConfigKey::AutoSplitPubFiles);
 
-	this->eif = new EIF(this->config["EIF"], auto_split);
-	this->enf = new ENF(this->config["ENF"], auto_split);
-	this->esf = new ESF(this->config["ESF"], auto_split);
-	this->ecf = new ECF(this->config["ECF"], auto_split);
+	this->eif = new EIF(this->settings.GetString(ConfigKey::EIF), auto_split);
+	this->enf = new ENF(this->settings.GetString(ConfigKey::ENF), auto_split);
+	this->esf = new ESF(this->settings.GetString(ConfigKey::ESF), auto_split);
+	this->ecf = new ECF(this->settings.GetString(ConfigKey::ECF), auto_split);
 
 	std::size_t num_npcs = this->enf->data.size();
 	this->npc_data.resize(num_npcs);
@@ -414,9 +497,9 @@ World::World(std::array<std::string, 6> dbinfo, const Config &eoserv_config, con
 			npc->LoadShopDrop();
 	}
 
-	this->maps.resize(static_cast<int>(this->config["Maps"]));
+	this->maps.resize(this->settings.GetInt(ConfigKey::Maps));
 	int loaded = 0;
-	for (int i = 0; i < static_cast<int>(this->config["Maps"]); ++i)
+	for (int i = 0; i < this->settings.GetInt(ConfigKey::Maps); ++i)
 	{
 		this->maps[i] = new Map(i + 1, this);
 		if (this->maps[i]->exists)
@@ -424,7 +507,7 @@ World::World(std::array<std::string, 6> dbinfo, const Config &eoserv_config, con
 	}
 	Console::Out("%i/%i maps loaded.", loaded, static_cast<int>(this->maps.size()));
 
-	short max_quest = static_cast<int>(this->config["Quests"]);
+	short max_quest = this->settings.GetInt(ConfigKey::Quests);
 
 	UTIL_FOREACH(this->enf->data, npc)
 	{
@@ -432,75 +515,79 @@ World::World(std::array<std::string, 6> dbinfo, const Config &eoserv_config, con
 			max_quest = std::max(max_quest, npc.vendor_id);
 	}
 
+	std::vector<short> quest_ids;
+
 	for (short i = 0; i <= max_quest; ++i)
-	{
-		try
-		{
-			std::shared_ptr<Quest> q = std::make_shared<Quest>(i, this);
-			this->quests.insert(std::make_pair(i, std::move(q)));
-		}
-		catch (...)
-		{
-		}
-	}
+		quest_ids.push_back(i);
+
+	this->quests = Quest::LoadAll(this, quest_ids);
 	Console::Out("%i/%i quests loaded.", static_cast<int>(this->quests.size()), max_quest);
 
 	this->last_character_id = 0;
 
-	TimeEvent *event = new TimeEvent(world_spawn_npcs, this, 1.0, Timer::FOREVER);
+	TimeEvent *event = new TimeEvent(world_spawn_npcs, this, 1.0, Timer::FOREVER, "world_spawn_npcs");
 	this->timer.Register(event);
 
-	event = new TimeEvent(world_act_npcs, this, 0.05, Timer::FOREVER);
+	event = new TimeEvent(world_act_npcs, this, 0.05, Timer::FOREVER, "world_act_npcs");
 	this->timer.Register(event);
 
-	if (int(this->config["RecoverSpeed"]) > 0)
+	if (this->settings.GetInt(ConfigKey::RecoverSpeed) > 0)
 	{
-		event = new TimeEvent(world_recover, this, double(this->config["RecoverSpeed"]), Timer::FOREVER);
+		event = new TimeEvent(world_recover, this, this->settings.GetFloat(ConfigKey::RecoverSpeed), Timer::FOREVER, "world_recover");
 		this->timer.Register(event);
 	}
 
-	if (int(this->config["NPCRecoverSpeed"]) > 0)
+	if (this->settings.GetInt(ConfigKey::NPCRecoverSpeed) > 0)
 	{
-		event = new TimeEvent(world_npc_recover, this, double(this->config["NPCRecoverSpeed"]), Timer::FOREVER);
+		event = new TimeEvent(world_npc_recover, this, this->settings.GetFloat(ConfigKey::NPCRecoverSpeed), Timer::FOREVER, "world_npc_recover");
 		this->timer.Register(event);
 	}
 
-	if (int(this->config["WarpSuck"]) > 0)
+	if (this->settings.GetInt(ConfigKey::WarpSuck) > 0)
 	{
-		event = new TimeEvent(world_warp_suck, this, 1.0, Timer::FOREVER);
+		event = new TimeEvent(world_warp_suck, this, 1.0, Timer::FOREVER, "world_warp_suck");
 		this->timer.Register(event);
 	}
 
-	if (this->config["ItemDespawn"])
+	if (this->settings.GetBool(ConfigKey::ItemDespawn))
 	{
-		event = new TimeEvent(world_despawn_items, this, static_cast<double>(this->config["ItemDespawnCheck"]), Timer::FOREVER);
+		event = new TimeEvent(world_despawn_items, this, this->settings.GetFloat(ConfigKey::ItemDespawnCheck), Timer::FOREVER, "world_despawn_items");
 		this->timer.Register(event);
 	}
 
-	if (this->config["TimedSave"])
+	if (this->settings.GetFloat(ConfigKey::TimedSave))
 	{
-		event = new TimeEvent(world_timed_save, this, static_cast<double>(this->config["TimedSave"]), Timer::FOREVER);
+		event = new TimeEvent(world_timed_save, this, this->settings.GetFloat(ConfigKey::TimedSave), Timer::FOREVER, "world_timed_save");
 		this->timer.Register(event);
 	}
 
-	if (this->config["SpikeTime"])
+	if (this->settings.GetFloat(ConfigKey::SpikeTime))
 	{
-		event = new TimeEvent(world_spikes, this, static_cast<double>(this->config["SpikeTime"]), Timer::FOREVER);
+		event = new TimeEvent(world_spikes, this, this->settings.GetFloat(ConfigKey::SpikeTime), Timer::FOREVER, "world_spikes");
 		this->timer.Register(event);
 	}
 
-	if (this->config["DrainTime"])
+	if (this->settings.GetFloat(ConfigKey::DrainTime))
 	{
-		event = new TimeEvent(world_drains, this, static_cast<double>(this->config["DrainTime"]), Timer::FOREVER);
+		event = new TimeEvent(world_drains, this, this->settings.GetFloat(ConfigKey::DrainTime), Timer::FOREVER, "world_drains");
 		this->timer.Register(event);
 	}
 
-	if (this->config["QuakeRate"])
+	if (this->settings.GetFloat(ConfigKey::QuakeRate))
 	{
-		event = new TimeEvent(world_quakes, this, static_cast<double>(this->config["QuakeRate"]), Timer::FOREVER);
+		event = new TimeEvent(world_quakes, this, this->settings.GetFloat(ConfigKey::QuakeRate), Timer::FOREVER, "world_quakes");
 		this->timer.Register(event);
 	}
 
+	event = new TimeEvent(world_expire_bans, this, 60.0, Timer::FOREVER, "world_expire_bans");
+	this->timer.Register(event);
+
+	event = new TimeEvent(world_poll_password_hasher, this, 0.01, Timer::FOREVER, "world_poll_password_hasher");
+	this->timer.Register(event);
+
+	event = new TimeEvent(world_poll_reload, this, 0.05, Timer::FOREVER, "world_poll_reload");
+	this->timer.Register(event);
+
 	exp_table[0] = 0;
 	for (std::size_t i = 1; i < this->exp_table.size(); ++i)
 	{
@@ -517,7 +604,7 @@ World::World(std::array<std::string, 6> dbinfo, const Config &eoserv_config, con
 
 void World::BeginDB()
 {
-	if (this->config["TimedSave"])
+	if (this->settings.GetFloat(ConfigKey::TimedSave))
 		this->db.BeginTransaction();
 }
 
@@ -527,11 +614,45 @@ void World::CommitDB()
 		this->db.Commit();
 }
 
+void World::OpenJournal()
+{
+	std::string filename = this->settings.GetString(ConfigKey::JournalFile);
+
+	if (filename.empty())
+		return;
+
+	if (!this->settings.GetFloat(ConfigKey::TimedSave))
+	{
+		Console::Wrn("JournalFile is ignored because TimedSave is disabled");
+		return;
+	}
+
+	std::size_t replayed = Journal::Replay(filename, this->db);
+
+	if (replayed > 0)
+	{
+		Console::Out("Recovered %i character changes from the journal", int(replayed));
+		this->CommitDB();
+		this->BeginDB();
+	}
+
+	if (!this->journal.Open(filename))
+	{
+		Console::Err("Could not open journal file: %s", filename.c_str());
+		return;
+	}
+
+	this->journal.Truncate();
+
+	TimeEvent *event = new TimeEvent(world_sync_journal, this, this->settings.GetFloat(ConfigKey::JournalSyncRate), Timer::FOREVER, "world_sync_journal");
+	this->timer.Register(event);
+}
+
 void World::UpdateAdminCount(int admin_count)
 {
 	this->admin_count = admin_count;
 
-	if (admin_count == 0 && this->config["FirstCharacterAdmin"])
+	if (admin_count == 0 && this->settings.GetBool(ConfigKey::FirstCharacterAdmin))
 	{
 		Console::Out("There are no admin characters!");
 		Console::Out("The next character created will be given HGM status!");
@@ -708,7 +829,7 @@ void World::Msg(Command_Source *from, std::string message, bool echo)
 {
 	std::string from_str = from ? from->SourceName() : "server";
 
-	message = util::text_cap(message, static_cast<int>(this->config["ChatMaxWidth"]) - util::text_width(util::ucfirst(from_str) + "  "));
+	message = util::text_cap(message, this->settings.GetInt(ConfigKey::ChatMaxWidth) - util::text_width(util::ucfirst(from_str) + "  "));
 
 	PacketBuilder builder(PACKET_TALK, PACKET_MSG, 2 + from_str.length() + message.length());
 	builder.AddBreakString(from_str);
@@ -731,7 +852,7 @@ void World::AdminMsg(Command_Source *from, std::string message, int minlevel, bo
 {
 	std::string from_str = from ? from->SourceName() : "server";
 
-	message = util::text_cap(message, static_cast<int>(this->config["ChatMaxWidth"]) - util::text_width(util::ucfirst(from_str) + "  "));
+	message = util::text_cap(message, this->settings.GetInt(ConfigKey::ChatMaxWidth) - util::text_width(util::ucfirst(from_str) + "  "));
 
 	PacketBuilder builder(PACKET_TALK, PACKET_ADMIN, 2 + from_str.length() + message.length());
 	builder.AddBreakString(from_str);
@@ -754,7 +875,7 @@ void World::AnnounceMsg(Command_Source *from, std::string message, bool echo)
 {
 	std::string from_str = from ? from->SourceName() : "server";
 
-	message = util::text_cap(message, static_cast<int>(this->config["ChatMaxWidth"]) - util::text_width(util::ucfirst(from_str) + "  "));
+	message = util::text_cap(message, this->settings.GetInt(ConfigKey::ChatMaxWidth) - util::text_width(util::ucfirst(from_str) + "  "));
 
 	PacketBuilder builder(PACKET_TALK, PACKET_ANNOUNCE, 2 + from_str.length() + message.length());
 	builder.AddBreakString(from_str);
@@ -775,7 +896,7 @@ void World::AnnounceMsg(Command_Source *from, std::string message, bool echo)
 
 void World::ServerMsg(std::string message)
 {
-	message = util::text_cap(message, static_cast<int>(this->config["ChatMaxWidth"]) - util::text_width("Server  "));
+	message = util::text_cap(message, this->settings.GetInt(ConfigKey::ChatMaxWidth) - util::text_width("Server  "));
 
 	PacketBuilder builder(PACKET_TALK, PACKET_SERVER, message.length());
 	builder.AddString(message);
@@ -788,7 +909,7 @@ void World::ServerMsg(std::string message)
 
 void World::AdminReport(Character *from, std::string reportee, std::string message)
 {
-	message = util::text_cap(message, static_cast<int>(this->config["ChatMaxWidth"]) - util::text_width(util::ucfirst(from->SourceName()) + "  reports: " + reportee + ", "));
+	message = util::text_cap(message, this->settings.GetInt(ConfigKey::ChatMaxWidth) - util::text_width(util::ucfirst(from->SourceName()) + "  reports: " + reportee + ", "));
 
 	PacketBuilder builder(PACKET_ADMININTERACT, PACKET_REPLY, 5 + from->SourceName().length() + message.length() + reportee.length());
 	builder.AddChar(2); // message type
@@ -805,7 +926,7 @@ void World::AdminReport(Character *from, std::string reportee, std::string messa
 		}
 	}
 
-	short boardid = static_cast<int>(this->config["AdminBoard"]) - 1;
+	short boardid = this->settings.GetInt(ConfigKey::AdminBoard) - 1;
 
 	if (static_cast<std::size_t>(boardid) < this->boards.size())
 	{
@@ -820,14 +941,14 @@ void World::AdminReport(Character *from, std::string reportee, std::string messa
 		newpost->body = message;
 		newpost->time = Timer::GetTime();
 
-		if (int(this->config["ReportChatLogSize"]) > 0)
+		if (this->settings.GetInt(ConfigKey::ReportChatLogSize) > 0)
 		{
 			chat_log_dump = from->GetChatLogDump();
 			newpost->body += "\r\n\r\n";
 			newpost->body += chat_log_dump;
 		}
 
-		if (this->config["LogReports"])
+		if (this->settings.GetBool(ConfigKey::LogReports))
 		{
 			try
 			{
@@ -847,7 +968,7 @@ void World::AdminReport(Character *from, std::string reportee, std::string messa
 
 		admin_board->posts.push_front(newpost);
 
-		if (admin_board->posts.size() > static_cast<std::size_t>(static_cast<int>(this->config["AdminBoardLimit"])))
+		if (admin_board->posts.size() > static_cast<std::size_t>(this->settings.GetInt(ConfigKey::AdminBoardLimit)))
 		{
 			admin_board->posts.pop_back();
 		}
@@ -856,7 +977,7 @@ void World::AdminReport(Character *from, std::string reportee, std::string messa
 
 void World::AdminRequest(Character *from, std::string message)
 {
-	message = util::text_cap(message, static_cast<int>(this->config["ChatMaxWidth"]) - util::text_width(util::ucfirst(from->SourceName()) + "  needs help: "));
+	message = util::text_cap(message, this->settings.GetInt(ConfigKey::ChatMaxWidth) - util::text_width(util::ucfirst(from->SourceName()) + "  needs help: "));
 
 	PacketBuilder builder(PACKET_ADMININTERACT, PACKET_REPLY, 4 + from->SourceName().length() + message.length());
 	builder.AddChar(1); // message type
@@ -872,7 +993,7 @@ void World::AdminRequest(Character *from, std::string message)
 		}
 	}
 
-	short boardid = static_cast<int>(this->server->world->config["AdminBoard"]) - 1;
+	short boardid = this->server->world->settings.GetInt(ConfigKey::AdminBoard) - 1;
 
 	if (static_cast<std::size_t>(boardid) < this->server->world->boards.size())
 	{
@@ -888,104 +1009,207 @@ void World::AdminRequest(Character *from, std::string message)
 
 		admin_board->posts.push_front(newpost);
 
-		if (admin_board->posts.size() > static_cast<std::size_t>(static_cast<int>(this->server->world->config["AdminBoardLimit"])))
+		if (admin_board->posts.size() > static_cast<std::size_t>(this->server->world->settings.GetInt(ConfigKey::AdminBoardLimit)))
 		{
 			admin_board->posts.pop_back();
 		}
 	}
 }
 
-void World::Rehash()
+struct World::Reload_Data
 {
-	this->config.Read("config.ini");
-	this->admin_config.Read("admin.ini");
-	this->drops_config.Read(this->config["DropsFile"]);
-	this->shops_config.Read(this->config["ShopsFile"]);
-	this->arenas_config.Read(this->config["ArenasFile"]);
-	this->formulas_config.Read(this->config["FormulasFile"]);
-	this->home_config.Read(this->config["HomeFile"]);
-	this->skills_config.Read(this->config["SkillsFile"]);
+	bool rehash = false;
+	bool pub = false;
+	bool quiet = true;
 
-	this->formulas_cache.clear();
+	Config config;
+	Config admin_config;
+	Config drops_config;
+	Config shops_config;
+	Config arenas_config;
+	Config formulas_config;
+	Config home_config;
+	Config skills_config;
 
-	this->UpdateConfig();
-	this->LoadHome();
-	this->server->UpdateConfig();
+	std::unique_ptr<EIF> eif;
+	std::unique_ptr<ENF> enf;
+	std::unique_ptr<ESF> esf;
+	std::unique_ptr<ECF> ecf;
 
-	UTIL_FOREACH(this->maps, map)
+	// Seconds spent parsing each file, printed once the reload is applied
+	std::vector<std::pair<std::string, double>> timings;
+
+	template <class F>
+	void Timed(const std::string &filename, F load)
 	{
-		map->LoadArena();
+		auto start = std::chrono::steady_clock::now();
+		load();
+		this->timings.emplace_back(filename, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
 	}
+};
 
-	UTIL_FOREACH_CREF(this->npc_data, npc)
+bool World::Rehash()
+{
+	if (this->reload.valid())
+		return false;
+
+	this->reload = std::async(std::launch::async, []()
 	{
-		if (npc->id != 0)
-			npc->LoadShopDrop();
-	}
+		std::unique_ptr<Reload_Data> data(new Reload_Data);
+		data->rehash = true;
+
+		// Any file that can't be read fails the whole reload, so a half-read config is never applied
+		auto read = [&data](Config &config, const std::string &filename)
+		{
+			data->Timed(filename, [&]()
+			{
+				if (!config.Read(filename, true))
+					throw std::runtime_error("Could not read " + filename);
+			});
+		};
+
+		read(data->config, "config.ini");
+		eoserv_config_validate_config(data->config);
+		read(data->admin_config, "admin.ini");
+		eoserv_config_validate_admin(data->admin_config);
+		read(data->drops_config, data->config["DropsFile"]);
+		read(data->shops_config, data->config["ShopsFile"]);
+		read(data->arenas_config, data->config["ArenasFile"]);
+		read(data->formulas_config, data->config["FormulasFile"]);
+		read(data->home_config, data->config["HomeFile"]);
+		read(data->skills_config, data->config["SkillsFile"]);
+
+		return data;
+	});
+
+	return true;
 }
 
-void World::ReloadPub(bool quiet)
+bool World::ReloadPub(bool quiet)
 {
-	auto eif_id = this->eif->rid;
-	auto enf_id = this->enf->rid;
-	auto esf_id = this->esf->rid;
-	auto ecf_id = this->ecf->rid;
-
-	bool auto_split = this->config["AutoSplitPubFiles"];
+	if (this->reload.valid())
+		return false;
 
-	this->eif->Read(this->config["EIF"], auto_split);
-	this->enf->Read(this->config["ENF"], auto_split);
-	this->esf->Read(this->config["ESF"], auto_split);
-	this->ecf->Read(this->config["ECF"], auto_split);
+	// Config isn't safe to read from another thread, so the file names are copied out first
+	bool auto_split = this->settings.GetBool(ConfigKey::AutoSplitPubFiles);
+	std::array<std::string, 4> files{{this->settings.GetString(ConfigKey::EIF), this->settings.GetString(ConfigKey::ENF), this->settings.GetString(ConfigKey::ESF), this->settings.GetString(ConfigKey::ECF)}};
 
-	if (eif_id != this->eif->rid || enf_id != this->enf->rid || esf_id != this->esf->rid || ecf_id != this->ecf->rid)
+	this->reload = std::async(std::launch::async, [quiet, auto_split, files]()
 	{
-		if (!quiet)
-		{
-			UTIL_FOREACH(this->characters, character)
-			{
-				character->ServerMsg("The server has been reloaded, please log out and in again.");
-			}
-		}
-	}
+		std::unique_ptr<Reload_Data> data(new Reload_Data);
+		data->pub = true;
+		data->quiet = quiet;
 
-	std::size_t current_npcs = this->npc_data.size();
-	std::size_t new_npcs = this->enf->data.size();
+		data->Timed(files[0], [&]() { data->eif.reset(new EIF(files[0], auto_split)); });
+		data->Timed(files[1], [&]() { data->enf.reset(new ENF(files[1], auto_split)); });
+		data->Timed(files[2], [&]() { data->esf.reset(new ESF(files[2], auto_split)); });
+		data->Timed(files[3], [&]() { data->ecf.reset(new ECF(files[3], auto_split)); });
 
-	this->npc_data.resize(new_npcs);
+		return data;
+	});
 
-	for (std::size_t i = current_npcs; i < new_npcs; ++i)
+	return true;
+}
+
+void World::PollReload()
+{
+	if (!this->reload.valid() || this->reload.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		return;
+
+	std::unique_ptr<Reload_Data> data;
+
+	try
 	{
-		npc_data[i]->LoadShopDrop();
+		data = this->reload.get();
 	}
+	catch (std::exception &e)
+	{
+		Console::Err("Reload failed, keeping the current files: %s", e.what());
+		return;
+	}
+
+	UTIL_FOREACH_CREF(data->timings, timing)
+		Console::Out("Parsed %s in %.1f ms", timing.first.c_str(), timing.second * 1000.0);
+
+	auto start = std::chrono::steady_clock::now();
+
+	this->ApplyReload(*data);
+
+	Console::Out("Reload applied in %.1f ms", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0);
 }
 
-void World::ReloadQuests()
+void World::ApplyReload(Reload_Data &data)
 {
-	// Back up character quest states
-	UTIL_FOREACH(this->characters, c)
+	if (data.rehash)
 	{
-		UTIL_FOREACH(c->quests, q)
-		{
-			if (!q.second)
-				continue;
+		std::swap(this->config, data.config);
+		std::swap(this->admin_config, data.admin_config);
+		std::swap(this->drops_config, data.drops_config);
+		std::swap(this->shops_config, data.shops_config);
+		std::swap(this->arenas_config, data.arenas_config);
+		std::swap(this->formulas_config, data.formulas_config);
+		std::swap(this->home_config, data.home_config);
+		std::swap(this->skills_config, data.skills_config);
+
+		this->settings.Load(this->config);
+		this->formulas_cache.clear();
+
+		this->UpdateConfig();
+		this->LoadHome();
+		this->server->UpdateConfig();
 
-			short quest_id = q.first;
-			std::string quest_name = q.second->StateName();
-			std::string progress = q.second->SerializeProgress();
+		UTIL_FOREACH(this->maps, map)
+		{
+			map->LoadArena();
+		}
 
-			c->quests_inactive.insert({quest_id, quest_name, progress});
+		UTIL_FOREACH_CREF(this->npc_data, npc)
+		{
+			if (npc->id != 0)
+				npc->LoadShopDrop();
 		}
 	}
 
-	// Clear character quest states
-	UTIL_FOREACH(this->characters, c)
+	if (data.pub)
 	{
-		c->quests.clear();
+		if (data.eif->rid != this->eif->rid || data.enf->rid != this->enf->rid || data.esf->rid != this->esf->rid || data.ecf->rid != this->ecf->rid)
+		{
+			if (!data.quiet)
+			{
+				UTIL_FOREACH(this->characters, character)
+				{
+					character->ServerMsg("The server has been reloaded, please log out and in again.");
+				}
+			}
+		}
+
+		// Handlers only run on this thread, so nothing can still be holding on to the old data
+		delete this->eif;
+		delete this->enf;
+		delete this->esf;
+		delete this->ecf;
+
+		this->eif = data.eif.release();
+		this->enf = data.enf.release();
+		this->esf = data.esf.release();
+		this->ecf = data.ecf.release();
+
+		std::size_t current_npcs = this->npc_data.size();
+		std::size_t new_npcs = this->enf->data.size();
+
+		this->npc_data.resize(new_npcs);
+
+		for (std::size_t i = current_npcs; i < new_npcs; ++i)
+			this->npc_data[i].reset(new NPC_Data(this, i));
 	}
 
-	// Reload all quests
-	short max_quest = static_cast<int>(this->config["Quests"]);
+	// New formulas or item and class data change everyone's stats at once
+	this->RecalculateStats();
+}
+
+void World::ReloadQuests()
+{
+	short max_quest = this->settings.GetInt(ConfigKey::Quests);
 
 	UTIL_FOREACH(this->enf->data, npc)
 	{
@@ -993,48 +1217,83 @@ void World::ReloadQuests()
 			max_quest = std::max(max_quest, npc.vendor_id);
 	}
 
+	std::vector<short> quest_ids;
+
 	for (short i = 0; i <= max_quest; ++i)
+		quest_ids.push_back(i);
+
+	// Reload quests that might still be loaded above the highest quest npc ID
+	UTIL_FOREACH(this->quests, q)
 	{
-		try
-		{
-			std::shared_ptr<Quest> q = std::make_shared<Quest>(i, this);
-			this->quests[i] = std::move(q);
-		}
-		catch (...)
-		{
-			this->quests.erase(i);
-		}
+		if (q.first > max_quest)
+			quest_ids.push_back(q.first);
 	}
 
-	// Reload quests that might still be loaded above the highest quest npc ID
-	UTIL_IFOREACH(this->quests, it)
+	std::map<short, std::shared_ptr<Quest>> quests = Quest::LoadAll(this, quest_ids, this->quests);
+
+	// Only quests that were added, removed or edited get new objects, everything else keeps its contexts
+	std::set<short> changed;
+
+	UTIL_FOREACH(this->quests, q)
 	{
-		if (it->first > max_quest)
+		auto it = quests.find(q.first);
+
+		if (it == quests.end() || it->second != q.second)
+			changed.insert(q.first);
+	}
+
+	UTIL_FOREACH(quests, q)
+	{
+		if (this->quests.find(q.first) == this->quests.end())
+			changed.insert(q.first);
+	}
+
+	// Back up character quest states
+	UTIL_FOREACH(this->characters, c)
+	{
+		for (auto it = c->quests.begin(); it != c->quests.end();)
 		{
-			try
+			if (!changed.count(it->first))
 			{
-				std::shared_ptr<Quest> q = std::make_shared<Quest>(it->first, this);
-				std::swap(it->second, q);
+				++it;
+				continue;
 			}
-			catch (...)
+
+			if (it->second)
 			{
-				it = this->quests.erase(it);
+				Character_QuestState state{it->first, it->second->StateName(), it->second->SerializeProgress()};
+				c->quests_inactive.erase(state);
+				c->quests_inactive.insert(std::move(state));
 			}
+
+			it = c->quests.erase(it);
+			c->QuestChanged();
 		}
 	}
 
+	this->quests.swap(quests);
+
 	// Restore character quest states
 	UTIL_FOREACH(this->characters, c)
 	{
-		c->quests.clear();
+		bool restored = false;
 
-		UTIL_FOREACH(c->quests_inactive, state)
+		for (auto state_it = c->quests_inactive.begin(); state_it != c->quests_inactive.end();)
 		{
+			const Character_QuestState &state = *state_it;
+
+			if (!changed.count(state.quest_id))
+			{
+				++state_it;
+				continue;
+			}
+
 			auto quest_it = this->quests.find(state.quest_id);
 
 			if (quest_it == this->quests.end())
 			{
 				Console::Wrn("Quest not found: %i. Marking as inactive.", state.quest_id);
+				++state_it;
 				continue;
 			}
 
@@ -1051,33 +1310,20 @@ void World::ReloadQuests()
 			{
 				Console::Wrn(ex.what());
 				Console::Wrn("Could not resume quest: %i. Marking as inactive.", state.quest_id);
-
-				if (!c->quests_inactive.insert(std::move(state)).second)
-					Console::Wrn("Duplicate inactive quest record dropped for quest: %i", state.quest_id);
-
+				++state_it;
 				continue;
 			}
 
-			auto result = c->quests.insert(std::make_pair(state.quest_id, std::move(quest_context)));
-
-			if (!result.second)
-			{
-				Console::Wrn("Duplicate quest record dropped for quest: %i", state.quest_id);
-				continue;
-			}
+			c->quests.insert(std::make_pair(state.quest_id, std::move(quest_context)));
+			state_it = c->quests_inactive.erase(state_it);
+			restored = true;
 		}
 
-		// Handle characters removed by quest rules
-		if (!c) // Replaced c->IsValid() with a null check
-		{
-			this->Logout(c);
-			continue;
-		}
-
-		c->CheckQuestRules();
+		if (restored)
+			c->CheckQuestRules();
 	}
 
-	Console::Out("%i/%i quests loaded.", this->quests.size(), max_quest);
+	Console::Out("%i/%i quests loaded, %i changed.", static_cast<int>(this->quests.size()), max_quest, static_cast<int>(changed.size()));
 }
 
 Character *World::GetCharacter(std::string name)
@@ -1219,18 +1465,18 @@ Character *World::CreateCharacter(Player *player, std::string name, Gender gende
 	std::string startmapinfo;
 	std::string startmapval;
 
-	if (static_cast<int>(this->config["StartMap"]))
+	if (this->settings.GetInt(ConfigKey::StartMap))
 	{
 		using namespace std;
 		startmapinfo = ", `map`, `x`, `y`";
-		snprintf(buffer, 1024, ",%i,%i,%i", static_cast<int>(this->config["StartMap"]), static_cast<int>(this->config["StartX"]), static_cast<int>(this->config["StartY"]));
+		snprintf(buffer, 1024, ",%i,%i,%i", this->settings.GetInt(ConfigKey::StartMap), this->settings.GetInt(ConfigKey::StartX), this->settings.GetInt(ConfigKey::StartY));
 		startmapval = buffer;
 	}
 
 	this->db.Query("INSERT INTO `characters` (`name`, `account`, `gender`, `hairstyle`, `haircolor`, `race`, `inventory`, `bank`, `paperdoll`, `spells`, `quest`, `vars`@) VALUES ('$','$',#,#,#,#,'$','','$','$','',''@)",
 				   startmapinfo.c_str(), name.c_str(), player->username.c_str(), gender, hairstyle, haircolor, race,
-				   static_cast<std::string>(this->config["StartItems"]).c_str(), static_cast<std::string>(gender ? this->config["StartEquipMale"] : this->config["StartEquipFemale"]).c_str(),
-				   static_cast<std::string>(this->config["StartSpells"]).c_str(), startmapval.c_str());
+				   this->settings.GetString(ConfigKey::StartItems).c_str(), (gender ? this->settings.GetString(ConfigKey::StartEquipMale) : this->settings.GetString(ConfigKey::StartEquipFemale)).c_str(),
+				   this->settings.GetString(ConfigKey::StartSpells).c_str(), startmapval.c_str());
 
 	return new Character(name, this);
 }
@@ -1240,53 +1486,32 @@ void World::DeleteCharacter(std::string name)
 	this->db.Query("DELETE FROM `characters` WHERE name = '$'", name.c_str());
 }
 
-Player *World::Login(const std::string &username, util::secure_string &&password)
-{
-	if (LoginCheck(username, std::move(password)) == LOGIN_WRONG_USERPASS)
-		return 0;
-
-	return new Player(username, this);
-}
-
 Player *World::Login(std::string username)
 {
 	return new Player(username, this);
 }
 
-LoginReply World::LoginCheck(const std::string &username, util::secure_string &&password)
+std::string World::GetPasswordHash(const std::string &username)
 {
-	{
-		util::secure_string password_buffer(std::move(std::string(this->config["PasswordSalt"]) + username + password.str()));
-		password = sha256(password_buffer.str());
-	}
-
-	Database_Result res = this->db.Query("SELECT 1 FROM `accounts` WHERE `username` = '$' AND `password` = '$'", username.c_str(), password.str().c_str());
+	Database_Result res = this->db.Query("SELECT `password` FROM `accounts` WHERE `username` = '$'", username.c_str());
 
 	if (res.empty())
-	{
-		return LOGIN_WRONG_USERPASS;
-	}
-	else if (this->PlayerOnline(username))
-	{
-		return LOGIN_LOGGEDIN;
-	}
-	else
-	{
-		return LOGIN_OK;
-	}
+		return std::string();
+
+	return res.front()[0].GetString();
 }
 
-bool World::CreatePlayer(const std::string &username, util::secure_string &&password,
+void World::SetPasswordHash(const std::string &username, const std::string &password_hash)
+{
+	this->db.Query("UPDATE `accounts` SET `password` = '$' WHERE username = '$'", password_hash.c_str(), username.c_str());
+}
+
+bool World::CreatePlayer(const std::string &username, const std::string &password_hash,
 						 const std::string &fullname, const std::string &location, const std::string &email,
 						 const std::string &computer, const std::string &hdid, const std::string &ip)
 {
-	{
-		util::secure_string password_buffer(std::move(std::string(this->config["PasswordSalt"]) + username + password.str()));
-		password = sha256(password_buffer.str());
-	}
-
 	Database_Result result = this->db.Query("INSERT INTO `accounts` (`username`, `password`, `fullname`, `location`, `email`, `computer`, `hdid`, `regip`, `created`) VALUES ('$','$','$','$','$','$','$','$',#)",
-											username.c_str(), password.str().c_str(), fullname.c_str(), location.c_str(), email.c_str(), computer.c_str(), hdid.c_str(), ip.c_str(), int(std::time(0)));
+											username.c_str(), password_hash.c_str(), fullname.c_str(), location.c_str(), email.c_str(), computer.c_str(), hdid.c_str(), ip.c_str(), int(std::time(0)));
 
 	return !result.Error();
 }
@@ -1333,29 +1558,29 @@ void World::Jail(Command_Source *from, Character *victim, bool announce)
 	if (announce)
 		this->ServerMsg(i18n.Format("announce_removed", victim->SourceName(), from ? from->SourceName() : "server", i18n.Format("jailed")));
 
-	bool bubbles = this->config["WarpBubbles"] && !victim->IsHideWarp();
+	bool bubbles = this->settings.GetBool(ConfigKey::WarpBubbles) && !victim->IsHideWarp();
 
 	Character *charfrom = dynamic_cast<Character *>(from);
 
 	if (charfrom && charfrom->IsHideWarp())
 		bubbles = false;
 
-	victim->Warp(static_cast<int>(this->config["JailMap"]), static_cast<int>(this->config["JailX"]), static_cast<int>(this->config["JailY"]), bubbles ? WARP_ANIMATION_ADMIN : WARP_ANIMATION_NONE);
+	victim->Warp(this->settings.GetInt(ConfigKey::JailMap), this->settings.GetInt(ConfigKey::JailX), this->settings.GetInt(ConfigKey::JailY), bubbles ? WARP_ANIMATION_ADMIN : WARP_ANIMATION_NONE);
 }
 
 void World::Unjail(Command_Source *from, Character *victim)
 {
-	bool bubbles = this->config["WarpBubbles"] && !victim->IsHideWarp();
+	bool bubbles = this->settings.GetBool(ConfigKey::WarpBubbles) && !victim->IsHideWarp();
 
 	Character *charfrom = dynamic_cast<Character *>(from);
 
 	if (charfrom && charfrom->IsHideWarp())
 		bubbles = false;
 
-	if (victim->mapid != static_cast<int>(this->config["JailMap"]))
+	if (victim->mapid != this->settings.GetInt(ConfigKey::JailMap))
 		return;
 
-	victim->Warp(static_cast<int>(this->config["JailMap"]), static_cast<int>(this->config["UnJailX"]), static_cast<int>(this->config["UnJailY"]), bubbles ? WARP_ANIMATION_ADMIN : WARP_ANIMATION_NONE);
+	victim->Warp(this->settings.GetInt(ConfigKey::JailMap), this->settings.GetInt(ConfigKey::UnJailX), this->settings.GetInt(ConfigKey::UnJailY), bubbles ? WARP_ANIMATION_ADMIN : WARP_ANIMATION_NONE);
 }
 
 void World::Ban(Command_Source *from, Character *victim, int duration, bool announce)
@@ -1365,26 +1590,45 @@ void World::Ban(Command_Source *from, Character *victim, int duration, bool anno
 	if (announce)
 		this->ServerMsg(i18n.Format("announce_removed", victim->SourceName(), from_str, i18n.Format("banned")));
 
+	int expires = (duration == -1) ? 0 : int(std::time(0) + duration);
+	IPAddress address = victim->player->client->GetRemoteAddr();
+
 	std::string query("INSERT INTO bans (username, ip, hdid, expires, setter) VALUES ");
 
 	query += "('" + db.Escape(victim->player->username) + "', ";
-	query += util::to_string(static_cast<int>(victim->player->client->GetRemoteAddr())) + ", ";
+	query += util::to_string(static_cast<int>(address)) + ", ";
 	query += util::to_string(victim->player->client->hdid) + ", ";
+	query += util::to_string(expires);
+	query += ", '" + db.Escape(from_str) + "')";
 
-	if (duration == -1)
+	try
 	{
-		query += "0";
+		this->db.Query(query.c_str());
 	}
-	else
+	catch (Database_Exception &e)
 	{
-		query += util::to_string(int(std::time(0) + duration));
+		Console::Err("Could not save ban to database.");
+		Console::Err("%s", e.error());
 	}
 
-	query += ", '" + db.Escape(from_str) + "')";
+	this->bans.AddUsername(victim->player->username, expires);
+	this->bans.AddIP(address, 32, expires);
+
+	if (victim->player->client->hdid != 0)
+		this->bans.AddHDID(victim->player->client->hdid, expires);
+
+	victim->player->client->Close();
+}
+
+void World::BanIP(Command_Source *from, std::uint32_t address, int prefix, int duration)
+{
+	std::string from_str = from ? from->SourceName() : "server";
+	int expires = (duration == -1) ? 0 : int(std::time(0) + duration);
 
 	try
 	{
-		this->db.Query(query.c_str());
+		this->db.Query("INSERT INTO bans (username, ip, ip_prefix, hdid, expires, setter) VALUES ('', #, #, 0, #, '$')",
+					   static_cast<int>(address), prefix, expires, from_str.c_str());
 	}
 	catch (Database_Exception &e)
 	{
@@ -1392,50 +1636,76 @@ void World::Ban(Command_Source *from, Character *victim, int duration, bool anno
 		Console::Err("%s", e.error());
 	}
 
-	victim->player->client->Close();
-}
+	this->bans.AddIP(address, prefix, expires);
 
-void World::Mute(Command_Source *from, Character *victim, bool announce)
-{
-	if (announce && !this->config["SilentMute"])
-		this->ServerMsg(i18n.Format("announce_muted", victim->SourceName(), from ? from->SourceName() : "server", i18n.Format("banned")));
+	UTIL_FOREACH(this->server->clients, client)
+	{
+		IPAddress remote_addr = client->GetRemoteAddr();
 
-	victim->Mute(from);
+		if (this->bans.Check(0, &remote_addr, 0, int(std::time(0))) != -1)
+			client->Close();
+	}
 }
 
-int World::CheckBan(const std::string *username, const IPAddress *address, const int *hdid)
+bool World::Unban(const std::string &username)
 {
-	std::string query("SELECT COALESCE(MAX(expires),-1) AS expires FROM bans WHERE (");
-
-	if (!username && !address && !hdid)
+	try
 	{
-		return -1;
-	}
+		Database_Result res = this->db.Query("DELETE FROM bans WHERE username = '$'", username.c_str());
+
+		// The rows removed also carried the IP and HDID bans that went with the username
+		this->bans.Load(this->db);
 
-	if (username)
+		return res.AffectedRows() > 0;
+	}
+	catch (Database_Exception &e)
 	{
-		query += "username = '";
-		query += db.Escape(*username);
-		query += "' OR ";
+		Console::Err("Could not remove ban from database.");
+		Console::Err("%s", e.error());
+		return false;
 	}
+}
 
-	if (address)
+bool World::UnbanIP(std::uint32_t address, int prefix)
+{
+	try
 	{
-		query += "ip = ";
-		query += util::to_string(static_cast<int>(*const_cast<IPAddress *>(address)));
-		query += " OR ";
-	}
+		Database_Result res;
+
+		if (prefix == 32)
+			res = this->db.Query("DELETE FROM bans WHERE ip = # AND (ip_prefix IS NULL OR ip_prefix = 32)", static_cast<int>(address));
+		else
+			res = this->db.Query("DELETE FROM bans WHERE ip = # AND ip_prefix = #", static_cast<int>(address), prefix);
 
-	if (hdid)
+		// The rows removed also carried the username and HDID bans that went with the address
+		this->bans.Load(this->db);
+
+		return res.AffectedRows() > 0;
+	}
+	catch (Database_Exception &e)
 	{
-		query += "hdid = ";
-		query += util::to_string(*hdid);
-		query += " OR ";
+		Console::Err("Could not remove ban from database.");
+		Console::Err("%s", e.error());
+		return false;
 	}
+}
+
+void World::Mute(Command_Source *from, Character *victim, bool announce)
+{
+	if (announce && !this->settings.GetBool(ConfigKey::SilentMute))
+		this->ServerMsg(i18n.Format("announce_muted", victim->SourceName(), from ? from->SourceName() : "server", i18n.Format("banned")));
+
+	victim->Mute(from);
+}
 
-	Database_Result res = db.Query((query.substr(0, query.length() - 4) + ") AND (expires > # OR expires = 0)").c_str(), int(std::time(0)));
+void World::LoadBans()
+{
+	this->bans.Load(this->db);
+}
 
-	return static_cast<int>(res[0]["expires"]);
+int World::CheckBan(const std::string *username, const IPAddress *address, const int *hdid)
+{
+	return this->bans.Check(username, address, hdid, int(std::time(0)));
 }
 
 static std::list<int> PKExceptUnserialize(std::string serialized)
@@ -1465,7 +1735,7 @@ bool World::PKExcept(const Map *map)
 
 bool World::PKExcept(int mapid)
 {
-	if (mapid == static_cast<int>(this->config["JailMap"]))
+	if (mapid == this->settings.GetInt(ConfigKey::JailMap))
 	{
 		return true;
 	}
@@ -1475,7 +1745,7 @@ bool World::PKExcept(int mapid)
 		return true;
 	}
 
-	std::list<int> except_list = PKExceptUnserialize(this->config["PKExcept"]);
+	std::list<int> except_list = PKExceptUnserialize(this->settings.GetString(ConfigKey::PKExcept));
 
 	return std::find(except_list.begin(), except_list.end(), mapid) != except_list.end();
 }
@@ -1485,21 +1755,117 @@ bool World::IsInstrument(int graphic_id)
 	return std::find(UTIL_RANGE(this->instrument_ids), graphic_id) != this->instrument_ids.end();
 }
 
-double World::EvalFormula(const std::string &name, const std::unordered_map<std::string, double> &vars)
+const util::rpn_program &World::Formula(const std::string &name)
 {
 	auto cache_it = this->formulas_cache.find(name);
 
-	if (cache_it != this->formulas_cache.end())
-		return util::rpn_eval(cache_it->second, vars);
+	if (cache_it == this->formulas_cache.end())
+	{
+		auto parser = formula_parser(this->formulas_config);
+		cache_it = this->formulas_cache.insert({std::string(name), util::rpn_program(parser(this->formulas_config[name]), Formula_Frame::Resolve)}).first;
+	}
+
+	return cache_it->second;
+}
+
+double World::EvalFormula(const std::string &name, const Formula_Frame &frame)
+{
+	const util::rpn_program &formula = this->Formula(name);
+
+	double result = formula.eval(frame.data());
+
+#ifdef DEBUG
+	// Check the compiled formula against the reference evaluator
+	if (formula.deterministic())
+	{
+		std::unordered_map<std::string, double> vars;
+		frame.Export(vars);
 
-	std::stack<std::string> (*parser)(std::string expr) = util::rpn_parse_v2;
+		double expected = util::rpn_eval(formula_parser(this->formulas_config)(this->formulas_config[name]), vars);
+
+		if (result != expected && !(std::isnan(result) && std::isnan(expected)))
+			Console::Wrn("Formula %s evaluated to %f, expected %f", name.c_str(), result, expected);
+	}
+#endif // DEBUG
+
+	return result;
+}
 
-	if (int(this->formulas_config["Version"]) < 2)
-		parser = util::rpn_parse;
+void World::EvalFormula(const std::string &name, const Formula_Batch &batch, std::size_t first, std::size_t count, double *results)
+{
+	this->Formula(name).eval(batch.Columns(first).data(), count, results);
+}
+
+void World::RecalculateStats()
+{
+	std::vector<Character *> characters(UTIL_RANGE(this->characters));
+
+	// Characters of the same class family share class formulas, so they are kept next to each other
+	std::stable_sort(UTIL_RANGE(characters), [this](Character *a, Character *b)
+	{
+		return this->ecf->Get(a->clas).type < this->ecf->Get(b->clas).type;
+	});
+
+	// Only characters whose stats change are told about it
+	auto stats = [](const Character *character)
+	{
+		return std::array<int, 15>{{character->display_str, character->display_intl, character->display_wis, character->display_agi,
+			character->display_con, character->display_cha, character->maxhp, character->maxtp, character->maxsp, character->maxweight,
+			character->mindam, character->maxdam, character->accuracy, character->evade, character->armor}};
+	};
 
-	auto result = this->formulas_cache.insert({std::string(name), parser(this->formulas_config[name])});
+	std::size_t n = characters.size();
+	Formula_Batch batch(n);
+	std::vector<std::array<int, 15>> before(n);
 
-	return util::rpn_eval(result.first->second, vars);
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		Formula_Frame frame;
+		before[i] = stats(characters[i]);
+		characters[i]->PrepareStats();
+		characters[i]->FormulaVars(frame);
+		batch.Store(i, frame);
+	}
+
+	std::vector<Character::Stat_Formulas> formulas(n);
+	std::vector<double> results(n);
+
+	auto eval = [&](const std::string &name, std::size_t first, std::size_t count, double Character::Stat_Formulas::*field)
+	{
+		this->EvalFormula(name, batch, first, count, results.data());
+
+		for (std::size_t i = 0; i < count; ++i)
+			formulas[first + i].*field = results[i];
+	};
+
+	eval("hp", 0, n, &Character::Stat_Formulas::hp);
+	eval("tp", 0, n, &Character::Stat_Formulas::tp);
+	eval("sp", 0, n, &Character::Stat_Formulas::sp);
+	eval("weight", 0, n, &Character::Stat_Formulas::weight);
+
+	for (std::size_t first = 0, last; first < n; first = last)
+	{
+		int type = this->ecf->Get(characters[first]->clas).type;
+
+		for (last = first + 1; last < n && this->ecf->Get(characters[last]->clas).type == type; ++last)
+			;
+
+		std::string class_formula = "class." + util::to_string(type);
+
+		eval(class_formula + ".damage", first, last - first, &Character::Stat_Formulas::damage);
+		eval(class_formula + ".defence", first, last - first, &Character::Stat_Formulas::defence);
+		eval(class_formula + ".accuracy", first, last - first, &Character::Stat_Formulas::accuracy);
+		eval(class_formula + ".evade", first, last - first, &Character::Stat_Formulas::evade);
+	}
+
+	for (std::size_t i = 0; i < n; ++i)
+		characters[i]->ApplyStats(formulas[i]);
+
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		if (stats(characters[i]) != before[i])
+			characters[i]->SendStats();
+	}
 }
 
 World::~World()
@@ -1526,8 +1892,9 @@ World::~World()
 
 	delete this->guildmanager;
 
-	if (this->config["TimedSave"])
+	if (this->settings.GetFloat(ConfigKey::TimedSave))
 	{
 		this->db.Commit();
+		this->journal.Truncate();
 	}
 }
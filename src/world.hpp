@@ -12,26 +12,34 @@
 #include "fwd/command_source.hpp"
 #include "fwd/eodata.hpp"
 #include "fwd/eoserver.hpp"
+#include "fwd/formula_vars.hpp"
 #include "fwd/guild.hpp"
 #include "fwd/map.hpp"
 #include "fwd/npc_data.hpp"
 #include "fwd/party.hpp"
 #include "fwd/player.hpp"
 #include "fwd/quest.hpp"
+#include "ban_index.hpp"
 #include "config.hpp"
 #include "database.hpp"
+#include "database_pool.hpp"
+#include "eoserv_config.hpp"
 #include "i18n.hpp"
+#include "journal.hpp"
 #include "map.hpp"
+#include "password_hasher.hpp"
 #include "timer.hpp"
 
 #include "fwd/socket.hpp"
+#include "util/rpn.hpp"
 #include "util/secure_string.hpp"
 
 #include <array>
+#include <cstdint>
+#include <future>
 #include <list>
 #include <map>
 #include <memory>
-#include <stack>
 #include <string>
 #include <vector>
 
@@ -83,7 +91,15 @@ class World
 protected:
 	int last_character_id;
 
+	/**
+	 * Files parsed by a background rehash or pub reload, waiting to be swapped in
+	 */
+	struct Reload_Data;
+
+	std::future<std::unique_ptr<Reload_Data>> reload;
+
 	void UpdateConfig();
+	void ApplyReload(Reload_Data &data);
 
 public:
 	Timer timer;
@@ -91,6 +107,11 @@ public:
 	EOServer *server;
 	Database db;
 
+	/**
+	 * Extra connections for independent reads that may run off the main thread, empty unless DBPoolSize is set
+	 */
+	Database_Pool db_pool;
+
 	GuildManager *guildmanager;
 
 	EIF *eif;
@@ -101,6 +122,12 @@ public:
 	std::vector<std::unique_ptr<NPC_Data>> npc_data;
 
 	Config config;
+
+	/**
+	 * Typed values of the registered keys in config, refreshed on rehash
+	 */
+	Config_Registry settings;
+
 	Config admin_config;
 	Config drops_config;
 	Config shops_config;
@@ -109,7 +136,7 @@ public:
 	Config home_config;
 	Config skills_config;
 
-	std::unordered_map<std::string, std::stack<std::string>> formulas_cache;
+	std::unordered_map<std::string, util::rpn_program> formulas_cache;
 
 	I18N i18n;
 
@@ -121,6 +148,12 @@ public:
 
 	std::array<Board *, 8> boards;
 
+	Ban_Index bans;
+
+	Password_Hasher password_hasher;
+
+	Journal journal;
+
 	std::array<int, 254> exp_table;
 	std::vector<int> instrument_ids;
 
@@ -131,6 +164,12 @@ public:
 	void BeginDB();
 	void CommitDB();
 
+	/**
+	 * Replays any journal left over from a crash and starts journaling character changes
+	 * @throw Database_Exception
+	 */
+	void OpenJournal();
+
 	void UpdateAdminCount(int admin_count);
 	void IncAdminCount() { UpdateAdminCount(this->admin_count + 1); }
 	void DecAdminCount() { UpdateAdminCount(this->admin_count - 1); }
@@ -157,16 +196,34 @@ public:
 	void Reboot();
 	void Reboot(int seconds, std::string reason);
 
-	void Rehash();
-	void ReloadPub(bool quiet = false);
+	/**
+	 * Starts re-reading config.ini and the files it names on a background thread
+	 * The new values are swapped in by PollReload() between ticks. Returns false if a reload is already running.
+	 */
+	bool Rehash();
+
+	/**
+	 * Starts re-reading the pub files on a background thread, returns false if a reload is already running
+	 */
+	bool ReloadPub(bool quiet = false);
+
+	/**
+	 * Applies a finished background reload, called from a timer on the game thread
+	 */
+	void PollReload();
+
 	void ReloadQuests();
 
 	void Kick(Command_Source *from, Character *victim, bool announce = true);
 	void Jail(Command_Source *from, Character *victim, bool announce = true);
 	void Unjail(Command_Source *from, Character *victim);
 	void Ban(Command_Source *from, Character *victim, int duration, bool announce = true);
+	void BanIP(Command_Source *from, std::uint32_t address, int prefix, int duration);
+	bool Unban(const std::string &username);
+	bool UnbanIP(std::uint32_t address, int prefix);
 	void Mute(Command_Source *from, Character *victim, bool announce = true);
 
+	void LoadBans();
 	int CheckBan(const std::string *username, const IPAddress *address, const int *hdid);
 
 	Character *GetCharacter(std::string name);
@@ -183,11 +240,15 @@ public:
 	Character *CreateCharacter(Player *, std::string name, Gender, int hairstyle, int haircolor, Skin);
 	void DeleteCharacter(std::string name);
 
-	Player *Login(const std::string &username, util::secure_string &&password);
 	Player *Login(std::string username);
-	LoginReply LoginCheck(const std::string &username, util::secure_string &&password);
 
-	bool CreatePlayer(const std::string &username, util::secure_string &&password,
+	/**
+	 * Returns the stored password hash of an account, or an empty string if it does not exist
+	 */
+	std::string GetPasswordHash(const std::string &username);
+	void SetPasswordHash(const std::string &username, const std::string &password_hash);
+
+	bool CreatePlayer(const std::string &username, const std::string &password_hash,
 					  const std::string &fullname, const std::string &location, const std::string &email,
 					  const std::string &computer, const std::string &hdid, const std::string &ip);
 
@@ -199,7 +260,22 @@ public:
 
 	bool IsInstrument(int graphic_id);
 
-	double EvalFormula(const std::string &name, const std::unordered_map<std::string, double> &vars);
+	/**
+	 * Returns the compiled form of a formula from formulas.ini, compiling it on first use
+	 */
+	const util::rpn_program &Formula(const std::string &name);
+
+	double EvalFormula(const std::string &name, const Formula_Frame &frame);
+
+	/**
+	 * Evaluates a formula for count lanes of a batch starting at first
+	 */
+	void EvalFormula(const std::string &name, const Formula_Batch &batch, std::size_t first, std::size_t count, double *results);
+
+	/**
+	 * Re-evaluates the stat formulas of every online character together and sends each their new stats
+	 */
+	void RecalculateStats();
 
 	~World();
 };
@@ -0,0 +1,5 @@
+ALTER TABLE `bans`
+    ADD COLUMN `ip_prefix` INTEGER DEFAULT NULL;
+
+ALTER TABLE `accounts`
+    MODIFY `password` VARCHAR(128) NOT NULL;